@@ -6,6 +6,7 @@
 SRC_EXTMOD_C += \
 	extmod/modasyncio.c \
 	extmod/modbinascii.c \
+	extmod/moddeflate.c \
 	extmod/modhashlib.c \
 	extmod/modheapq.c \
 	extmod/modjson.c \
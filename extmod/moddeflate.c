@@ -37,6 +37,8 @@
 
 #if MICROPY_PY_DEFLATE
 
+#define UZLIB_CONF_CRC32_SLICE8 (MICROPY_UZLIB_CRC32_SLICE8)
+#define UZLIB_CONF_SIMD (MICROPY_UZLIB_SIMD)
 #include "lib/uzlib/uzlib.h"
 
 #if 0 // print debugging info
@@ -58,15 +60,28 @@ typedef enum {
 // to the smallest window size (faster compression, less RAM usage, etc).
 const int DEFLATEIO_DEFAULT_WBITS = 8;
 
+#if MICROPY_PY_DEFLATE_COMPRESS
+// Number of hash chain entries to try for each match at compression levels
+// 1-9, levels 4 and up also use lazy matching.  Level 0 (the default) uses no
+// hash chains and searches the whole window, which needs the least RAM.
+static const uint16_t deflateio_max_chain[] = { 4, 8, 32, 16, 32, 128, 256, 1024, 4096 };
+#define DEFLATEIO_LAZY_LEVEL (4)
+
+// The hash tables have a quarter as many entries as the window has bytes, so
+// with two bytes per entry they take as much RAM as the window itself.
+#define DEFLATEIO_HASH_BITS(wbits) ((wbits) - 2)
+#endif
+
 typedef struct {
     void *window;
-    uzlib_uncomp_t decomp;
+    TINF_DATA decomp;
     bool eof;
 } mp_obj_deflateio_read_t;
 
 #if MICROPY_PY_DEFLATE_COMPRESS
 typedef struct {
     void *window;
+    uint16_t *hash;
     size_t input_len;
     uint32_t input_checksum;
     uzlib_lz77_state_t lz77;
@@ -78,6 +93,7 @@ typedef struct {
     mp_obj_t stream;
     uint8_t format : 2;
     uint8_t window_bits : 4;
+    uint8_t level : 4;
     bool close : 1;
     mp_obj_deflateio_read_t *read;
     #if MICROPY_PY_DEFLATE_COMPRESS
@@ -85,8 +101,8 @@ typedef struct {
     #endif
 } mp_obj_deflateio_t;
 
-static int deflateio_read_stream(void *data) {
-    mp_obj_deflateio_t *self = data;
+static int deflateio_read_stream(TINF_DATA *decomp) {
+    mp_obj_deflateio_t *self = decomp->self;
     const mp_stream_p_t *stream = mp_get_stream(self->stream);
     int err;
     byte c;
@@ -109,7 +125,7 @@ static bool deflateio_init_read(mp_obj_deflateio_t *self) {
 
     self->read = m_new_obj(mp_obj_deflateio_read_t);
     memset(&self->read->decomp, 0, sizeof(self->read->decomp));
-    self->read->decomp.source_read_data = self;
+    self->read->decomp.self = self;
     self->read->decomp.source_read_cb = deflateio_read_stream;
     self->read->eof = false;
 
@@ -180,6 +196,11 @@ static bool deflateio_init_write(mp_obj_deflateio_t *self) {
     self->write->window = m_new(uint8_t, window_len);
 
     uzlib_lz77_init(&self->write->lz77, self->write->window, window_len);
+    if (self->level > 0) {
+        self->write->hash = m_new(uint16_t, 2 << DEFLATEIO_HASH_BITS(wbits));
+        uzlib_lz77_init_hash(&self->write->lz77, self->write->hash, DEFLATEIO_HASH_BITS(wbits),
+            deflateio_max_chain[self->level - 1], self->level >= DEFLATEIO_LAZY_LEVEL);
+    }
     self->write->lz77.dest_write_data = self;
     self->write->lz77.dest_write_cb = deflateio_out_byte;
 
@@ -215,8 +236,8 @@ static bool deflateio_init_write(mp_obj_deflateio_t *self) {
 #endif
 
 static mp_obj_t deflateio_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args_in) {
-    // args: stream, format=NONE, wbits=0, close=False
-    mp_arg_check_num(n_args, n_kw, 1, 4, false);
+    // args: stream, format=NONE, wbits=0, close=False, level=0
+    mp_arg_check_num(n_args, n_kw, 1, 5, false);
 
     mp_int_t format = n_args > 1 ? mp_obj_get_int(args_in[1]) : DEFLATEIO_FORMAT_AUTO;
     mp_int_t wbits = n_args > 2 ? mp_obj_get_int(args_in[2]) : 0;
@@ -227,6 +248,12 @@ static mp_obj_t deflateio_make_new(const mp_obj_type_t *type, size_t n_args, siz
     if (wbits != 0 && (wbits < 5 || wbits > 15)) {
         mp_raise_ValueError(MP_ERROR_TEXT("wbits"));
     }
+    #if MICROPY_PY_DEFLATE_COMPRESS
+    mp_int_t level = n_args > 4 ? mp_obj_get_int(args_in[4]) : 0;
+    if (level < 0 || level > 9) {
+        mp_raise_ValueError(MP_ERROR_TEXT("level"));
+    }
+    #endif
 
     mp_obj_deflateio_t *self = mp_obj_malloc(mp_obj_deflateio_t, type);
     self->stream = args_in[0];
@@ -234,6 +261,7 @@ static mp_obj_t deflateio_make_new(const mp_obj_type_t *type, size_t n_args, siz
     self->window_bits = wbits;
     self->read = NULL;
     #if MICROPY_PY_DEFLATE_COMPRESS
+    self->level = level;
     self->write = NULL;
     #endif
     self->close = n_args > 3 ? mp_obj_is_true(args_in[3]) : false;
@@ -256,7 +284,7 @@ static mp_uint_t deflateio_read(mp_obj_t o_in, void *buf, mp_uint_t size, int *e
     self->read->decomp.dest = buf;
     self->read->decomp.dest_limit = (uint8_t *)buf + size;
     int st = uzlib_uncompress_chksum(&self->read->decomp);
-    if (st == UZLIB_DONE) {
+    if (st == TINF_DONE) {
         self->read->eof = true;
     }
     if (st < 0) {
@@ -401,12 +429,15 @@ MP_REGISTER_MODULE(MP_QSTR_deflate, mp_module_deflate);
 #endif // !MICROPY_ENABLE_DYNRUNTIME
 
 // Source files #include'd here to make sure they're compiled in
-// only if the module is enabled.
+// only if the module is enabled.  The zlib module includes the decompressor
+// and the checksums as well, so they're only needed here without it.
 
+#if !MICROPY_PY_ZLIB
 #include "lib/uzlib/tinflate.c"
-#include "lib/uzlib/header.c"
 #include "lib/uzlib/adler32.c"
 #include "lib/uzlib/crc32.c"
+#endif
+#include "lib/uzlib/header.c"
 
 #if MICROPY_PY_DEFLATE_COMPRESS
 #include "lib/uzlib/lz77.c"
@@ -58,6 +58,31 @@ typedef struct _mp_obj_match_t {
 } mp_obj_match_t;
 
 static mp_obj_t mod_re_compile(size_t n_args, const mp_obj_t *args);
+
+// Run the compiled pattern on subj.  Short subjects are run with the bit-state
+// backtracker in a small buffer on the C stack, anything it doesn't have room
+// for with the Pike VM, whose scratch memory is allocated on first use and
+// kept in *pike_mem for further calls.  The caller frees it with re_free_mem.
+static int re_exec_prog(mp_obj_re_t *self, Subject *subj, const char **caps, int caps_num, bool is_anchored, void **pike_mem) {
+    #if MICROPY_PY_RE_BACKTRACK_MEM
+    unsigned int bt_mem[MICROPY_PY_RE_BACKTRACK_MEM / sizeof(unsigned int)];
+    int res = re1_5_backtrack(&self->re, subj, caps, caps_num, is_anchored, bt_mem, sizeof(bt_mem));
+    if (res >= 0) {
+        return res;
+    }
+    #endif
+    if (*pike_mem == NULL) {
+        *pike_mem = mp_nonlocal_alloc(re1_5_pikevm_sizemem(&self->re, caps_num));
+    }
+    return re1_5_pikevm(&self->re, subj, caps, caps_num, is_anchored, *pike_mem);
+}
+
+static void re_free_mem(mp_obj_re_t *self, int caps_num, void *pike_mem) {
+    if (pike_mem != NULL) {
+        mp_nonlocal_free(pike_mem, re1_5_pikevm_sizemem(&self->re, caps_num));
+    }
+}
+
 #if !MICROPY_ENABLE_DYNRUNTIME
 static const mp_obj_type_t re_type;
 #endif
@@ -241,7 +266,9 @@ static mp_obj_t re_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
     mp_obj_match_t *match = m_new_obj_var(mp_obj_match_t, caps, char *, caps_num);
     // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
     memset((char *)match->caps, 0, caps_num * sizeof(char *));
-    int res = re1_5_recursiveloopprog(&self->re, &subj, match->caps, caps_num, is_anchored);
+    void *pike_mem = NULL;
+    int res = re_exec_prog(self, &subj, match->caps, caps_num, is_anchored, &pike_mem);
+    re_free_mem(self, caps_num, pike_mem);
     if (res == 0) {
         m_del_var(mp_obj_match_t, caps, char *, caps_num, match);
         return mp_const_none;
@@ -279,10 +306,11 @@ static mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
 
     mp_obj_t retval = mp_obj_new_list(0, NULL);
     const char **caps = mp_local_alloc(caps_num * sizeof(char *));
+    void *pike_mem = NULL;
     while (true) {
         // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
         memset((char **)caps, 0, caps_num * sizeof(char *));
-        int res = re1_5_recursiveloopprog(&self->re, &subj, caps, caps_num, false);
+        int res = re_exec_prog(self, &subj, caps, caps_num, false, &pike_mem);
 
         // if we didn't have a match, or had an empty match, it's time to stop
         if (!res || caps[0] == caps[1]) {
@@ -299,6 +327,7 @@ static mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
             break;
         }
     }
+    re_free_mem(self, caps_num, pike_mem);
     // cast is a workaround for a bug in msvc (see above)
     mp_local_free((char **)caps);
 
@@ -338,11 +367,12 @@ static mp_obj_t re_sub_helper(size_t n_args, const mp_obj_t *args) {
     match->base.type = (mp_obj_type_t *)&match_type;
     match->num_matches = caps_num / 2; // caps_num counts start and end pointers
     match->str = where;
+    void *pike_mem = NULL;
 
     for (;;) {
         // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
         memset((char *)match->caps, 0, caps_num * sizeof(char *));
-        int res = re1_5_recursiveloopprog(&self->re, &subj, match->caps, caps_num, false);
+        int res = re_exec_prog(self, &subj, match->caps, caps_num, false, &pike_mem);
 
         // If we didn't have a match, or had an empty match, it's time to stop
         if (!res || match->caps[0] == match->caps[1]) {
@@ -410,6 +440,7 @@ static mp_obj_t re_sub_helper(size_t n_args, const mp_obj_t *args) {
         }
     }
 
+    re_free_mem(self, caps_num, pike_mem);
     mp_local_free(match);
 
     if (vstr_return.buf == NULL) {
@@ -510,7 +541,8 @@ MP_REGISTER_EXTENSIBLE_MODULE(MP_QSTR_re, mp_module_re);
 #define re1_5_fatal(x) assert(!x)
 
 #include "lib/re1.5/compilecode.c"
-#include "lib/re1.5/recursiveloop.c"
+#include "lib/re1.5/backtrack.c"
+#include "lib/re1.5/pikevm.c"
 #include "lib/re1.5/charclass.c"
 
 #if MICROPY_PY_RE_DEBUG
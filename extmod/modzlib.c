@@ -36,6 +36,8 @@
 #if MICROPY_PY_ZLIB
 
 #define UZLIB_CONF_PARANOID_CHECKS (1)
+#define UZLIB_CONF_CRC32_SLICE8 (MICROPY_UZLIB_CRC32_SLICE8)
+#define UZLIB_CONF_SIMD (MICROPY_UZLIB_SIMD)
 #include "lib/uzlib/uzlib.h"
 
 #if 0 // print debugging info
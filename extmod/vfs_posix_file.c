@@ -41,9 +41,22 @@
 #include <poll.h>
 #endif
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP && !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define VFS_POSIX_FILE_MMAP (1)
+#else
+#define VFS_POSIX_FILE_MMAP (0)
+#endif
+
 typedef struct _mp_obj_vfs_posix_file_t {
     mp_obj_base_t base;
     int fd;
+    #if VFS_POSIX_FILE_MMAP
+    // A mapping of the file from MP_STREAM_GET_ROM_DATA, released on close.
+    void *map_data;
+    size_t map_len;
+    #endif
 } mp_obj_vfs_posix_file_t;
 
 #if MICROPY_CPYTHON_COMPAT
@@ -93,6 +106,9 @@ mp_obj_t mp_vfs_posix_file_open(const mp_obj_type_t *type, mp_obj_t file_in, mp_
 
     mp_obj_vfs_posix_file_t *o = mp_obj_malloc_with_finaliser(mp_obj_vfs_posix_file_t, type);
     o->fd = -1; // In case open() fails below, initialise this as a "closed" file object.
+    #if VFS_POSIX_FILE_MMAP
+    o->map_data = NULL;
+    #endif
 
     mp_obj_t fid = file_in;
 
@@ -187,6 +203,12 @@ static mp_uint_t vfs_posix_file_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_
             return 0;
         }
         case MP_STREAM_CLOSE:
+            #if VFS_POSIX_FILE_MMAP
+            if (o->map_data != NULL) {
+                munmap(o->map_data, o->map_len);
+                o->map_data = NULL;
+            }
+            #endif
             if (o->fd >= 0) {
                 MP_THREAD_GIL_EXIT();
                 close(o->fd);
@@ -196,6 +218,43 @@ static mp_uint_t vfs_posix_file_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_
             return 0;
         case MP_STREAM_GET_FILENO:
             return o->fd;
+        #if VFS_POSIX_FILE_MMAP
+        case MP_STREAM_GET_ROM_DATA: {
+            // Map the file into memory, until the file is closed.
+            if (o->map_data != NULL) {
+                *(const byte **)arg = o->map_data;
+                return o->map_len;
+            }
+            struct stat st;
+            if (fstat(o->fd, &st) != 0) {
+                *errcode = errno;
+                return MP_STREAM_ERROR;
+            }
+            if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+                *errcode = EINVAL;
+                return MP_STREAM_ERROR;
+            }
+            void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, o->fd, 0);
+            if (data == MAP_FAILED) {
+                *errcode = errno;
+                return MP_STREAM_ERROR;
+            }
+            o->map_data = data;
+            o->map_len = st.st_size;
+            *(const byte **)arg = data;
+            return st.st_size;
+        }
+        case MP_STREAM_KEEP_ROM_DATA:
+            // Code loaded from the mapping runs from it, so never release it.
+            // The file must then not be truncated or rewritten in place while
+            // the program is running, but deleting or replacing it is fine.
+            if (o->map_data == NULL) {
+                *errcode = EINVAL;
+                return MP_STREAM_ERROR;
+            }
+            o->map_data = NULL;
+            return 0;
+        #endif
         #if MICROPY_PY_SELECT && !MICROPY_PY_SELECT_POSIX_OPTIMISATIONS
         case MP_STREAM_POLL: {
             #ifdef _WIN32
@@ -279,9 +338,9 @@ static const mp_stream_p_t vfs_posix_textio_stream_p = {
 
 #if MICROPY_PY_SYS_STDIO_BUFFER
 
-mp_obj_vfs_posix_file_t mp_sys_stdin_buffer_obj = {{&mp_type_vfs_posix_fileio}, STDIN_FILENO};
-mp_obj_vfs_posix_file_t mp_sys_stdout_buffer_obj = {{&mp_type_vfs_posix_fileio}, STDOUT_FILENO};
-mp_obj_vfs_posix_file_t mp_sys_stderr_buffer_obj = {{&mp_type_vfs_posix_fileio}, STDERR_FILENO};
+mp_obj_vfs_posix_file_t mp_sys_stdin_buffer_obj = {.base = {&mp_type_vfs_posix_fileio}, .fd = STDIN_FILENO};
+mp_obj_vfs_posix_file_t mp_sys_stdout_buffer_obj = {.base = {&mp_type_vfs_posix_fileio}, .fd = STDOUT_FILENO};
+mp_obj_vfs_posix_file_t mp_sys_stderr_buffer_obj = {.base = {&mp_type_vfs_posix_fileio}, .fd = STDERR_FILENO};
 
 // Forward declarations.
 mp_obj_vfs_posix_file_t mp_sys_stdin_obj;
@@ -332,8 +391,8 @@ MP_DEFINE_CONST_OBJ_TYPE(
     locals_dict, &vfs_posix_rawfile_locals_dict
     );
 
-mp_obj_vfs_posix_file_t mp_sys_stdin_obj = {{&mp_type_vfs_posix_textio}, STDIN_FILENO};
-mp_obj_vfs_posix_file_t mp_sys_stdout_obj = {{&mp_type_vfs_posix_textio}, STDOUT_FILENO};
-mp_obj_vfs_posix_file_t mp_sys_stderr_obj = {{&mp_type_vfs_posix_textio}, STDERR_FILENO};
+mp_obj_vfs_posix_file_t mp_sys_stdin_obj = {.base = {&mp_type_vfs_posix_textio}, .fd = STDIN_FILENO};
+mp_obj_vfs_posix_file_t mp_sys_stdout_obj = {.base = {&mp_type_vfs_posix_textio}, .fd = STDOUT_FILENO};
+mp_obj_vfs_posix_file_t mp_sys_stderr_obj = {.base = {&mp_type_vfs_posix_textio}, .fd = STDERR_FILENO};
 
 #endif // MICROPY_VFS_POSIX
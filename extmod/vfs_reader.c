@@ -76,13 +76,15 @@ static void mp_reader_vfs_close(void *data) {
     m_del_obj(mp_reader_vfs_t, reader);
 }
 
-void mp_reader_new_file(mp_reader_t *reader, qstr filename) {
+static mp_obj_t mp_reader_vfs_open(qstr filename) {
     mp_obj_t args[2] = {
         MP_OBJ_NEW_QSTR(filename),
         MP_OBJ_NEW_QSTR(MP_QSTR_rb),
     };
-    mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), &args[0], (mp_map_t *)&mp_const_empty_map);
+    return mp_vfs_open(MP_ARRAY_SIZE(args), &args[0], (mp_map_t *)&mp_const_empty_map);
+}
 
+static void mp_reader_vfs_new(mp_reader_t *reader, mp_obj_t file) {
     const mp_stream_p_t *stream_p = mp_get_stream(file);
     int errcode = 0;
     mp_uint_t bufsize = stream_p->ioctl(file, MP_STREAM_GET_BUFFER_SIZE, 0, &errcode);
@@ -107,4 +109,24 @@ void mp_reader_new_file(mp_reader_t *reader, qstr filename) {
     reader->close = mp_reader_vfs_close;
 }
 
+void mp_reader_new_file(mp_reader_t *reader, qstr filename) {
+    mp_reader_vfs_new(reader, mp_reader_vfs_open(filename));
+}
+
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+// As mp_reader_new_file, but if the file can give its data in memory then read
+// it from there, so it can be used in place (see mp_reader_new_rom).
+void mp_reader_new_file_rom(mp_reader_t *reader, qstr filename) {
+    mp_obj_t file = mp_reader_vfs_open(filename);
+    const byte *data = NULL;
+    int errcode;
+    mp_uint_t len = mp_get_stream(file)->ioctl(file, MP_STREAM_GET_ROM_DATA, (uintptr_t)&data, &errcode);
+    if (len == MP_STREAM_ERROR || data == NULL) {
+        mp_reader_vfs_new(reader, file);
+    } else {
+        mp_reader_new_rom(reader, file, data, len);
+    }
+}
+#endif
+
 #endif // MICROPY_READER_VFS
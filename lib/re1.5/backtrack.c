@@ -0,0 +1,168 @@
+// Copyright 2007-2009 Russ Cox.  All Rights Reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include "re1.5.h"
+
+// Bit-state backtracker: explores the threads one at a time in priority
+// order like a recursive backtracker, but with an explicit job stack instead of
+// recursion, and a bitmap of the (pc, position) states already tried.  A
+// state that was tried before failed to reach Match then and will fail again
+// now, so each one is run at most once and the time is linear in the subject
+// length times the program length.  The bitmap needs that many bits, so this
+// is meant for short subjects: when mem is too small it gives up and returns
+// -1, and the caller should use re1_5_pikevm instead.
+
+typedef struct Job Job;
+
+struct Job
+{
+	int pc;		// pc to run, or ~n to restore sub[n]
+	int arg;	// position to run at, or what to restore sub[n] to (0 for nil)
+};
+
+int
+re1_5_backtrack(ByteProg *prog, Subject *input, const char **subp, int nsubp, int is_anchored, void *mem, int memsize)
+{
+	const char *code = prog->insts;
+	const char *begin = input->begin;
+	int len = input->end - begin;
+	unsigned int *visited = mem;
+	Job *stack;
+	int nvisited, nstack, n, pc, pos, off, bit, i, skip;
+	const char *sp;
+
+	// The +1 is for the position at the end of the subject.
+	if(len + 1 > memsize * 8 / prog->bytelen)
+		return -1;
+	nvisited = (prog->bytelen * (len + 1) + 31) / 32;
+	nstack = (memsize - nvisited * (int)sizeof(*visited)) / (int)sizeof(Job);
+	if(nstack < 1)
+		return -1;
+	stack = (Job*)(visited + nvisited);
+	memset(visited, 0, nvisited * sizeof(*visited));
+
+	// A pattern starting with ^ can only match at the start of the subject.
+	if(code[NON_ANCHORED_PREFIX + 2] == Bol)
+		is_anchored = 1;
+
+	sp = begin;
+	skip = !is_anchored && _re1_5_canskip(prog);
+	if(skip) {
+		sp = _re1_5_nextstart(prog, sp, input->end);
+		if(sp == nil)
+			return 0;
+	}
+
+	for(;;) {
+		// Try a match starting at sp.
+		for(i = 0; i < nsubp; i++)
+			subp[i] = nil;
+		stack[0].pc = NON_ANCHORED_PREFIX;
+		stack[0].arg = sp - begin;
+		n = 1;
+		while(n > 0) {
+			n--;
+			pc = stack[n].pc;
+			pos = stack[n].arg;
+			if(pc < 0) {
+				subp[~pc] = pos == 0 ? nil : begin + pos - 1;
+				continue;
+			}
+			for(;;) {
+				bit = pos * prog->bytelen + pc;
+				if(visited[bit / 32] & (1U << (bit % 32)))
+					break;
+				visited[bit / 32] |= 1U << (bit % 32);
+
+				if(inst_is_consumer(code[pc]) && pos >= len)
+					break;
+				switch(code[pc]) {
+				case Char:
+					if(begin[pos] != code[pc + 1])
+						break;
+					pc += 2;
+					pos++;
+					continue;
+				case Any:
+					pc++;
+					pos++;
+					continue;
+				case Class:
+				case ClassNot:
+					if(!_re1_5_classmatch(code + pc + 1, begin + pos))
+						break;
+					pc += 2 + *(unsigned char*)(code + pc + 1) * 2;
+					pos++;
+					continue;
+				case NamedClass:
+					if(!_re1_5_namedclassmatch(code + pc + 1, begin + pos))
+						break;
+					pc += 2;
+					pos++;
+					continue;
+				case Match:
+					return 1;
+				case Jmp:
+					pc += 2 + (signed char)code[pc + 1];
+					continue;
+				case Split:
+					if(n == nstack)
+						goto overflow;
+					stack[n].pc = pc + 2 + (signed char)code[pc + 1];
+					stack[n++].arg = pos;
+					pc += 2;
+					continue;
+				case RSplit:
+					if(n == nstack)
+						goto overflow;
+					stack[n].pc = pc + 2;
+					stack[n++].arg = pos;
+					pc += 2 + (signed char)code[pc + 1];
+					continue;
+				case Save:
+					off = (unsigned char)code[pc + 1];
+					pc += 2;
+					if(off >= nsubp)
+						continue;
+					if(n == nstack)
+						goto overflow;
+					stack[n].pc = ~off;
+					stack[n++].arg = subp[off] == nil ? 0 : subp[off] - begin + 1;
+					subp[off] = begin + pos;
+					continue;
+				case Bol:
+					if(begin + pos != input->begin_line)
+						break;
+					pc++;
+					continue;
+				case Eol:
+					if(pos != len)
+						break;
+					pc++;
+					continue;
+				default:
+					re1_5_fatal("backtrack");
+					break;
+				}
+				break;
+			}
+		}
+
+		// No match from here, move on to the next start position.  The
+		// states visited so far failed and still will, so keep the bitmap.
+		if(is_anchored || sp >= input->end)
+			return 0;
+		sp++;
+		if(skip) {
+			sp = _re1_5_nextstart(prog, sp, input->end);
+			if(sp == nil)
+				return 0;
+		}
+	}
+
+overflow:
+	for(i = 0; i < nsubp; i++)
+		subp[i] = nil;
+	return -1;
+}
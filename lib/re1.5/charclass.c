@@ -39,3 +39,50 @@ int _re1_5_namedclassmatch(const char *pc, const char *sp)
     }
     return off;
 }
+
+int _re1_5_canskip(ByteProg *prog)
+{
+    // A search can skip the positions where the first instruction can't
+    // match, if every match has to start with it.
+    switch (prog->insts[NON_ANCHORED_PREFIX + 2]) {
+    case Char:
+    case Class:
+    case ClassNot:
+    case NamedClass:
+        return 1;
+    }
+    return 0;
+}
+
+const char *_re1_5_nextstart(ByteProg *prog, const char *sp, const char *end)
+{
+    // Find the next position at or after sp where a match may start
+    const char *pc = prog->insts + NON_ANCHORED_PREFIX + 2;
+
+    if (prog->prefix == 0) {
+        // Starts with a class, test it at each position
+        for (; sp < end; sp++) {
+            if (*pc == NamedClass ? _re1_5_namedclassmatch(pc + 1, sp) : _re1_5_classmatch(pc + 1, sp)) {
+                return sp;
+            }
+        }
+        return nil;
+    }
+
+    // Starts with a run of Char instructions, so the chars are 2 apart
+    while (end - sp >= prog->prefix) {
+        sp = memchr(sp, pc[1], end - sp - prog->prefix + 1);
+        if (sp == nil) {
+            return nil;
+        }
+        int i = 1;
+        while (i < prog->prefix && sp[i] == pc[1 + 2 * i]) {
+            i++;
+        }
+        if (i == prog->prefix) {
+            return sp;
+        }
+        sp++;
+    }
+    return nil;
+}
@@ -251,6 +251,13 @@ int re1_5_compilecode(ByteProg *prog, const char *re)
     prog->insts[prog->bytelen++] = Match;
     prog->len++;
 
+    // Count the Char instructions straight after "Save 0", a search only
+    // needs to try the positions where these chars occur.
+    prog->prefix = 0;
+    for (int pc = NON_ANCHORED_PREFIX + 2; prog->insts[pc] == Char; pc += 2) {
+        prog->prefix++;
+    }
+
     return 0;
 }
 
@@ -0,0 +1,224 @@
+// Copyright 2007-2009 Russ Cox.  All Rights Reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include "re1.5.h"
+
+// Pike VM: runs all the threads of the program in lock step over the
+// subject, so each input char is looked at once per thread and the time is
+// linear in the subject length.  Threads are kept in priority order and a
+// thread which matches cuts off all the lower priority ones, which gives the
+// same (leftmost-first) results as the backtracking executors.
+
+typedef struct ThreadList ThreadList;
+typedef struct PikeVM PikeVM;
+
+struct ThreadList
+{
+	int n;
+	int *pc;
+	const char **sub;	// nsubp entries per thread
+};
+
+struct PikeVM
+{
+	ByteProg *prog;
+	Subject *input;
+	int nsubp;
+	unsigned int gen;
+	unsigned int *mark;	// gen at which each pc was last added
+	const char **sub;	// captures of the thread being added
+	int *stackpc;		// pending branches, or ~n to restore sub[n]
+	const char **stacksub;	// value to restore sub[n] to
+};
+
+// Follow jumps, splits, saves and asserts from pc at input position sp,
+// and add the consumer and match instructions reached to l, in priority
+// order.  Each pc is visited at most once per input position, so l never
+// holds more than prog->len threads, and the stack of pending branches and
+// saves can't get deeper than that either.
+static void
+addthread(PikeVM *vm, ThreadList *l, int pc, const char *sp)
+{
+	char *code = vm->prog->insts;
+	int n = 0;
+	int i, off;
+
+	for(;;) {
+		if(vm->mark[pc] != vm->gen) {
+			vm->mark[pc] = vm->gen;
+			switch(code[pc]) {
+			case Jmp:
+				pc += 2 + (signed char)code[pc + 1];
+				continue;
+			case Split:
+				vm->stackpc[n++] = pc + 2 + (signed char)code[pc + 1];
+				pc += 2;
+				continue;
+			case RSplit:
+				vm->stackpc[n++] = pc + 2;
+				pc += 2 + (signed char)code[pc + 1];
+				continue;
+			case Save:
+				off = (unsigned char)code[pc + 1];
+				pc += 2;
+				if(off < vm->nsubp) {
+					vm->stackpc[n] = ~off;
+					vm->stacksub[n++] = vm->sub[off];
+					vm->sub[off] = sp;
+				}
+				continue;
+			case Bol:
+				if(sp != vm->input->begin_line)
+					break;
+				pc++;
+				continue;
+			case Eol:
+				if(sp != vm->input->end)
+					break;
+				pc++;
+				continue;
+			default: {
+				const char **sub = l->sub + l->n * vm->nsubp;
+				for(i = 0; i < vm->nsubp; i++)
+					sub[i] = vm->sub[i];
+				l->pc[l->n++] = pc;
+				break;
+			}
+			}
+		}
+
+		// This path is done, continue with the most recent pending branch,
+		// undoing the saves made since it was pushed.
+		for(;;) {
+			if(n == 0)
+				return;
+			pc = vm->stackpc[--n];
+			if(pc >= 0)
+				break;
+			vm->sub[~pc] = vm->stacksub[n];
+		}
+	}
+}
+
+int
+re1_5_pikevm_sizemem(ByteProg *prog, int nsubp)
+{
+	return ((2 * prog->len + 1) * nsubp + prog->len) * sizeof(const char *)
+		+ (3 * prog->len + prog->bytelen) * sizeof(int);
+}
+
+int
+re1_5_pikevm(ByteProg *prog, Subject *input, const char **subp, int nsubp, int is_anchored, void *mem)
+{
+	// Search is implemented by starting a new thread at each position, so
+	// always skip the code which does it by looping.
+	int start = NON_ANCHORED_PREFIX;
+	ThreadList list[2], *clist, *nlist, *tmp;
+	PikeVM vm;
+	const char *sp, *code, **sub;
+	int i, j, pc, next, ok, matched, skip;
+
+	vm.prog = prog;
+	vm.input = input;
+	vm.nsubp = nsubp;
+	vm.sub = mem;
+	list[0].sub = vm.sub + nsubp;
+	list[1].sub = list[0].sub + prog->len * nsubp;
+	vm.stacksub = list[1].sub + prog->len * nsubp;
+	list[0].pc = (int*)(vm.stacksub + prog->len);
+	list[1].pc = list[0].pc + prog->len;
+	vm.stackpc = list[1].pc + prog->len;
+	vm.mark = (unsigned int*)(vm.stackpc + prog->len);
+	memset(vm.mark, 0, prog->bytelen * sizeof(*vm.mark));
+	vm.gen = 1;
+
+	// A pattern starting with ^ can only match at the start of the subject.
+	if(prog->insts[start + 2] == Bol)
+		is_anchored = 1;
+
+	sp = input->begin;
+	skip = !is_anchored && _re1_5_canskip(prog);
+	if(skip) {
+		sp = _re1_5_nextstart(prog, sp, input->end);
+		if(sp == nil)
+			return 0;
+	}
+
+	clist = &list[0];
+	nlist = &list[1];
+	clist->n = 0;
+	for(j = 0; j < nsubp; j++)
+		vm.sub[j] = nil;
+	addthread(&vm, clist, start, sp);
+	matched = 0;
+
+	for(;;) {
+		vm.gen++;
+		nlist->n = 0;
+		for(i = 0; i < clist->n; i++) {
+			pc = clist->pc[i];
+			code = prog->insts + pc;
+			sub = clist->sub + i * nsubp;
+			if(*code == Match) {
+				for(j = 0; j < nsubp; j++)
+					subp[j] = sub[j];
+				matched = 1;
+				// Cut off the lower priority threads.
+				break;
+			}
+			if(sp >= input->end)
+				continue;
+			switch(*code) {
+			case Char:
+				ok = *sp == code[1];
+				next = pc + 2;
+				break;
+			case Any:
+				ok = 1;
+				next = pc + 1;
+				break;
+			case Class:
+			case ClassNot:
+				ok = _re1_5_classmatch(code + 1, sp);
+				next = pc + 2 + *(unsigned char*)(code + 1) * 2;
+				break;
+			case NamedClass:
+				ok = _re1_5_namedclassmatch(code + 1, sp);
+				next = pc + 2;
+				break;
+			default:
+				re1_5_fatal("pikevm");
+				ok = 0;
+				next = 0;
+				break;
+			}
+			if(ok) {
+				for(j = 0; j < nsubp; j++)
+					vm.sub[j] = sub[j];
+				addthread(&vm, nlist, next, sp + 1);
+			}
+		}
+		if(sp >= input->end)
+			break;
+		sp++;
+		if(!matched && !is_anchored) {
+			if(nlist->n == 0 && skip) {
+				// Nothing in progress, skip to where the next match may start.
+				sp = _re1_5_nextstart(prog, sp, input->end);
+				if(sp == nil)
+					break;
+				vm.gen++;
+			}
+			for(j = 0; j < nsubp; j++)
+				vm.sub[j] = nil;
+			addthread(&vm, nlist, start, sp);
+		}
+		else if(nlist->n == 0)
+			break;
+		tmp = clist;
+		clist = nlist;
+		nlist = tmp;
+	}
+	return matched;
+}
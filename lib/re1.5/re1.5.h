@@ -66,6 +66,7 @@ struct ByteProg
 	int bytelen;
 	int len;
 	int sub;
+	int prefix;	// number of literal chars every match starts with
 	char insts[0];
 };
 
@@ -142,9 +143,9 @@ struct Subject {
 #define HANDLE_ANCHORED(bytecode, is_anchored) ((is_anchored) ? (bytecode) + NON_ANCHORED_PREFIX : (bytecode))
 #define RE15_CLASS_NAMED_CLASS_INDICATOR 0
 
-int re1_5_backtrack(ByteProg*, Subject*, const char**, int, int);
-int re1_5_pikevm(ByteProg*, Subject*, const char**, int, int);
-int re1_5_recursiveloopprog(ByteProg*, Subject*, const char**, int, int);
+int re1_5_backtrack(ByteProg*, Subject*, const char**, int, int, void*, int);
+int re1_5_pikevm_sizemem(ByteProg*, int);
+int re1_5_pikevm(ByteProg*, Subject*, const char**, int, int, void*);
 int re1_5_recursiveprog(ByteProg*, Subject*, const char**, int, int);
 int re1_5_thompsonvm(ByteProg*, Subject*, const char**, int, int);
 
@@ -154,5 +155,7 @@ void re1_5_dumpcode(ByteProg *prog);
 void cleanmarks(ByteProg *prog);
 int _re1_5_classmatch(const char *pc, const char *sp);
 int _re1_5_namedclassmatch(const char *pc, const char *sp);
+int _re1_5_canskip(ByteProg *prog);
+const char *_re1_5_nextstart(ByteProg *prog, const char *sp, const char *end);
 
 #endif /*_RE1_5_REGEXP__H*/
@@ -38,6 +38,10 @@
 
 #include "tinf.h"
 
+#if UZLIB_CONF_SIMD && defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 #define A32_BASE 65521
 #define A32_NMAX 5552
 
@@ -53,6 +57,34 @@ uint32_t uzlib_adler32(const void *data, unsigned int length, uint32_t prev_sum
       int k = length < A32_NMAX ? length : A32_NMAX;
       int i;
 
+#if UZLIB_CONF_SIMD && defined(__x86_64__)
+      /* Over a block of 16 bytes, s1 grows by their sum and s2 by 16 times
+         the old s1 plus the bytes weighted 16 down to 1.  Sum each of these
+         in 32-bit lanes and add the lanes up at the end. */
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i w_lo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+      const __m128i w_hi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+      __m128i vs1 = _mm_cvtsi32_si128(s1);
+      __m128i vs2 = _mm_cvtsi32_si128(s2);
+      __m128i vps = zero;
+
+      for (i = k / 16; i; --i, buf += 16)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i *)buf);
+         vps = _mm_add_epi32(vps, vs1);
+         vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(v, zero));
+         vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), w_lo));
+         vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), w_hi));
+      }
+
+      vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(vps, 4));
+      vs1 = _mm_add_epi32(vs1, _mm_shuffle_epi32(vs1, 0x4e));
+      vs1 = _mm_add_epi32(vs1, _mm_shuffle_epi32(vs1, 0xb1));
+      vs2 = _mm_add_epi32(vs2, _mm_shuffle_epi32(vs2, 0x4e));
+      vs2 = _mm_add_epi32(vs2, _mm_shuffle_epi32(vs2, 0xb1));
+      s1 = _mm_cvtsi128_si32(vs1);
+      s2 = _mm_cvtsi128_si32(vs2);
+#else
       for (i = k / 16; i; --i, buf += 16)
       {
          s1 += buf[0];  s2 += s1; s1 += buf[1];  s2 += s1;
@@ -65,6 +97,7 @@ uint32_t uzlib_adler32(const void *data, unsigned int length, uint32_t prev_sum
          s1 += buf[12]; s2 += s1; s1 += buf[13]; s2 += s1;
          s1 += buf[14]; s2 += s1; s1 += buf[15]; s2 += s1;
       }
+#endif
 
       for (i = k % 16; i; --i) { s1 += *buf++; s2 += s1; }
 
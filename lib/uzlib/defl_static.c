@@ -0,0 +1,130 @@
+/*
+ * Deflate block encoding with the fixed (static) Huffman codes, used by the
+ * LZ77 compressor in lz77.c to write out literals and matches.
+ *
+ * Copyright (c) uzlib authors
+ *
+ * This software is provided 'as-is', without any express
+ * or implied warranty.  In no event will the authors be
+ * held liable for any damages arising from the use of
+ * this software.
+ *
+ * Permission is granted to anyone to use this software
+ * for any purpose, including commercial applications,
+ * and to alter it and redistribute it freely, subject to
+ * the following restrictions:
+ *
+ * 1. The origin of this software must not be
+ *    misrepresented; you must not claim that you
+ *    wrote the original software. If you use this
+ *    software in a product, an acknowledgment in
+ *    the product documentation would be appreciated
+ *    but is not required.
+ *
+ * 2. Altered source versions must be plainly marked
+ *    as such, and must not be misrepresented as
+ *    being the original software.
+ *
+ * 3. This notice may not be removed or altered from
+ *    any source distribution.
+ */
+
+#include <assert.h>
+
+#include "uzlib.h"
+
+// Base lengths and number of extra bits of the length codes 257-285.
+static const uint16_t defl_length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t defl_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+// Base distances and number of extra bits of the distance codes 0-29.
+static const uint16_t defl_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t defl_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+// Write nbits bits, least significant first, flushing whole bytes out.
+static void uzlib_outbits(uzlib_lz77_state_t *state, unsigned long bits, int nbits) {
+    assert(state->noutbits + nbits <= 32);
+    state->outbits |= bits << state->noutbits;
+    state->noutbits += nbits;
+    while (state->noutbits >= 8) {
+        state->dest_write_cb(state->dest_write_data, state->outbits & 0xff);
+        state->outbits >>= 8;
+        state->noutbits -= 8;
+    }
+}
+
+// Write a Huffman code, which is stored most significant bit first.
+static void uzlib_outcode(uzlib_lz77_state_t *state, unsigned int code, int nbits) {
+    unsigned int rev = 0;
+    for (int i = 0; i < nbits; ++i) {
+        rev = rev << 1 | (code & 1);
+        code >>= 1;
+    }
+    uzlib_outbits(state, rev, nbits);
+}
+
+// Write a symbol of the fixed literal/length code.
+static void uzlib_outsym(uzlib_lz77_state_t *state, unsigned int sym) {
+    if (sym <= 143) {
+        uzlib_outcode(state, 0x30 + sym, 8);
+    } else if (sym <= 255) {
+        uzlib_outcode(state, 0x190 + sym - 144, 9);
+    } else if (sym <= 279) {
+        uzlib_outcode(state, sym - 256, 7);
+    } else {
+        uzlib_outcode(state, 0xc0 + sym - 280, 8);
+    }
+}
+
+void uzlib_start_block(uzlib_lz77_state_t *state) {
+    // Final block (1), fixed Huffman codes (01).
+    uzlib_outbits(state, 3, 3);
+}
+
+void uzlib_finish_block(uzlib_lz77_state_t *state) {
+    // End of block, then pad out to a whole byte.
+    uzlib_outsym(state, 256);
+    if (state->noutbits > 0) {
+        uzlib_outbits(state, 0, 8 - state->noutbits);
+    }
+}
+
+void uzlib_literal(uzlib_lz77_state_t *state, unsigned char c) {
+    uzlib_outsym(state, c);
+}
+
+// Write a match of len bytes, from 3 to 258, starting distance bytes back.
+void uzlib_match(uzlib_lz77_state_t *state, int distance, int len) {
+    assert(len >= 3 && len <= 258);
+    assert(distance >= 1 && distance <= 32768);
+
+    int i = 28;
+    while (len < defl_length_base[i]) {
+        --i;
+    }
+    uzlib_outsym(state, 257 + i);
+    if (defl_length_extra[i]) {
+        uzlib_outbits(state, len - defl_length_base[i], defl_length_extra[i]);
+    }
+
+    i = 29;
+    while (distance < defl_dist_base[i]) {
+        --i;
+    }
+    uzlib_outcode(state, i, 5);
+    if (defl_dist_extra[i]) {
+        uzlib_outbits(state, distance - defl_dist_base[i], defl_dist_extra[i]);
+    }
+}
@@ -1,14 +1,24 @@
 /*
  * Simple LZ77 streaming compressor.
  *
- * The scheme implemented here doesn't use a hash table and instead does a brute
- * force search in the history for a previous string.  It is relatively slow
- * (but still O(N)) but gives good compression and minimal memory usage.  For a
- * small history window (eg 256 bytes) it's not too slow and compresses well.
+ * By default the scheme implemented here doesn't use a hash table and instead
+ * does a brute force search in the history for a previous string.  It is
+ * relatively slow (but still O(N)) but gives good compression and minimal
+ * memory usage.  For a small history window (eg 256 bytes) it's not too slow and
+ * compresses well.
+ *
+ * For larger windows uzlib_lz77_init_hash() can be used to give it hash chains:
+ * for each hash of a 3-byte string the most recent position it occurred at, and
+ * for each recent position the previous position with the same hash.  A search
+ * then only follows the chain for the string being matched, up to max_chain
+ * positions.  The tables take 4 << hash_bits bytes, and the chains only reach
+ * back 1 << hash_bits positions, so they can be kept smaller than the window.
  *
  * MIT license; Copyright (c) 2021 Damien P. George
  */
 
+#include <stddef.h>
+
 #include "uzlib.h"
 
 #include "defl_static.c"
@@ -16,6 +26,8 @@
 #define MATCH_LEN_MIN (3)
 #define MATCH_LEN_MAX (258)
 
+#define HASH_NONE (0)
+
 // hist should be a preallocated buffer of hist_max size bytes.
 // hist_max should be greater than 0 a power of 2 (ie 1, 2, 4, 8, ...).
 // It's possible to pass in hist=NULL, and then the history window will be taken from the
@@ -28,6 +40,47 @@ void uzlib_lz77_init(uzlib_lz77_state_t *state, uint8_t *hist, size_t hist_max)
     state->hist_len = 0;
 }
 
+// Use hash chains to find matches, must be called after uzlib_lz77_init.
+// hash_buf should be a preallocated buffer of 2 << hash_bits entries, where
+// hash_bits is at least 1 and 1 << hash_bits is at most hist_max, and hist_max
+// can be at most 32768.  max_chain is the number of previous positions to try
+// for each match, and if lazy is true then a match is only taken if the next
+// position doesn't start a longer one.
+void uzlib_lz77_init_hash(uzlib_lz77_state_t *state, uint16_t *hash_buf, unsigned int hash_bits, unsigned int max_chain, bool lazy) {
+    size_t hash_len = (size_t)1 << hash_bits;
+    memset(hash_buf, 0, 2 * hash_len * sizeof(uint16_t));
+    state->hash_head = hash_buf;
+    state->hash_prev = hash_buf + hash_len;
+    state->hash_mask = hash_len - 1;
+    state->hash_shift = 32 - hash_bits;
+    state->hash_max_chain = max_chain;
+    state->hash_lazy = lazy;
+    state->hash_base = 0;
+    state->hash_pos = 0;
+}
+
+// Get the byte at the given position, counting back from the end of the
+// history if pos is negative, or forwards into src otherwise.
+static inline uint8_t uzlib_lz77_byte(uzlib_lz77_state_t *state, const uint8_t *src, ptrdiff_t pos) {
+    if (pos < 0) {
+        return state->hist_buf[(state->hist_start + state->hist_len + pos) & (state->hist_max - 1)];
+    } else {
+        return src[pos];
+    }
+}
+
+// Get the length of the match between src[ahead:len] and the data starting
+// dist bytes before it, in the history followed by src.
+static inline size_t uzlib_lz77_match_len(uzlib_lz77_state_t *state, const uint8_t *src, size_t len, size_t ahead, size_t dist) {
+    size_t max_len = MIN(len - ahead, MATCH_LEN_MAX);
+    ptrdiff_t pos = ahead - dist;
+    size_t match_len = 0;
+    while (match_len < max_len && src[ahead + match_len] == uzlib_lz77_byte(state, src, pos + match_len)) {
+        ++match_len;
+    }
+    return match_len;
+}
+
 // Search back in the history for the maximum match of the given src data,
 // with support for searching beyond the end of the history and into the src buffer
 // (effectively the history and src buffer are concatenated).
@@ -35,18 +88,7 @@ static size_t uzlib_lz77_search_max_match(uzlib_lz77_state_t *state, const uint8
     size_t longest_len = 0;
     for (size_t hist_search = 0; hist_search < state->hist_len; ++hist_search) {
         // Search for a match.
-        size_t match_len;
-        for (match_len = 0; match_len <= MATCH_LEN_MAX && match_len < len; ++match_len) {
-            uint8_t hist;
-            if (hist_search + match_len < state->hist_len) {
-                hist = state->hist_buf[(state->hist_start + hist_search + match_len) & (state->hist_max - 1)];
-            } else {
-                hist = src[hist_search + match_len - state->hist_len];
-            }
-            if (src[match_len] != hist) {
-                break;
-            }
-        }
+        size_t match_len = uzlib_lz77_match_len(state, src, len, 0, state->hist_len - hist_search);
 
         // Take this match if its length is at least the minimum, and larger than previous matches.
         // If the length is the same as the previous longest then take this match as well, because
@@ -60,13 +102,119 @@ static size_t uzlib_lz77_search_max_match(uzlib_lz77_state_t *state, const uint8
     return longest_len;
 }
 
+// Multiplicative hash of the 3 bytes at pos, taking the top hash_bits bits of
+// the product so that all the bytes affect the result.
+static inline size_t uzlib_lz77_hash(uzlib_lz77_state_t *state, const uint8_t *src, ptrdiff_t pos) {
+    uint32_t h = (uint32_t)uzlib_lz77_byte(state, src, pos) << 16
+        | (uint32_t)uzlib_lz77_byte(state, src, pos + 1) << 8
+        | uzlib_lz77_byte(state, src, pos + 2);
+    return (uint32_t)(h * 0x9e3779b1) >> state->hash_shift;
+}
+
+// Add all the positions before src[ahead] which aren't in the hash chains yet.
+// Positions are stored relative to hash_base, plus 1 so that 0 can mean none.
+static void uzlib_lz77_hash_insert(uzlib_lz77_state_t *state, const uint8_t *src, size_t ahead) {
+    size_t end = state->hist_total + ahead;
+    if (state->hash_pos + state->hist_len < state->hist_total) {
+        // Skip positions which have already gone out of the window.
+        state->hash_pos = state->hist_total - state->hist_len;
+    }
+    for (; state->hash_pos < end; ++state->hash_pos) {
+        if (state->hash_pos - state->hash_base + 1 >= 2 * state->hist_max) {
+            // Out of values, forget everything that is at least a window
+            // behind and shift the rest down (in both head and prev).
+            for (size_t i = 0; i < 2 * (state->hash_mask + 1); ++i) {
+                uint16_t v = state->hash_head[i];
+                state->hash_head[i] = v > state->hist_max ? v - state->hist_max : HASH_NONE;
+            }
+            state->hash_base += state->hist_max;
+        }
+        size_t h = uzlib_lz77_hash(state, src, state->hash_pos - state->hist_total);
+        state->hash_prev[state->hash_pos & state->hash_mask] = state->hash_head[h];
+        state->hash_head[h] = state->hash_pos - state->hash_base + 1;
+    }
+}
+
+// Search the hash chain for the maximum match of src[ahead:len], treating
+// src[:ahead] as if it was already in the history.
+static size_t uzlib_lz77_search_hash(uzlib_lz77_state_t *state, const uint8_t *src, size_t len, size_t ahead, size_t *longest_offset) {
+    if (len - ahead < MATCH_LEN_MIN) {
+        return 0;
+    }
+    uzlib_lz77_hash_insert(state, src, ahead);
+
+    size_t cur = state->hist_total + ahead;
+    size_t max_dist = MIN(state->hist_len + ahead, state->hist_max);
+    size_t longest_len = 0;
+    size_t last_dist = 0;
+    uint16_t v = state->hash_head[uzlib_lz77_hash(state, src, ahead)];
+    for (unsigned int chain = state->hash_max_chain; chain > 0 && v != HASH_NONE; --chain) {
+        size_t dist = cur - (state->hash_base + v - 1);
+        if (dist <= last_dist || dist > max_dist) {
+            // Went past the start of the window, or to a stale entry (a
+            // chain link that has since been reused for a newer position).
+            break;
+        }
+        last_dist = dist;
+        size_t match_len = uzlib_lz77_match_len(state, src, len, ahead, dist);
+        // The chain goes back in time, so only a longer match is better.
+        if (match_len >= MATCH_LEN_MIN && match_len > longest_len) {
+            longest_len = match_len;
+            *longest_offset = dist;
+            if (match_len == MATCH_LEN_MAX) {
+                break;
+            }
+        }
+        v = state->hash_prev[(cur - dist) & state->hash_mask];
+    }
+
+    return longest_len;
+}
+
+static inline size_t uzlib_lz77_search(uzlib_lz77_state_t *state, const uint8_t *src, size_t len, size_t *longest_offset) {
+    if (state->hash_head == NULL) {
+        return uzlib_lz77_search_max_match(state, src, len, longest_offset);
+    } else {
+        return uzlib_lz77_search_hash(state, src, len, 0, longest_offset);
+    }
+}
+
+// Push the bytes into the history buffer.
+static void uzlib_lz77_push(uzlib_lz77_state_t *state, const uint8_t *src, size_t len) {
+    size_t mask = state->hist_max - 1;
+    state->hist_total += len;
+    while (len--) {
+        uint8_t b = *src++;
+        state->hist_buf[(state->hist_start + state->hist_len) & mask] = b;
+        if (state->hist_len == state->hist_max) {
+            state->hist_start = (state->hist_start + 1) & mask;
+        } else {
+            ++state->hist_len;
+        }
+    }
+}
+
 // Compress the given chunk of data.
 void uzlib_lz77_compress(uzlib_lz77_state_t *state, const uint8_t *src, unsigned len) {
     const uint8_t *top = src + len;
     while (src < top) {
         // Look for a match in the history window.
         size_t match_offset = 0;
-        size_t match_len = uzlib_lz77_search_max_match(state, src, top - src, &match_offset);
+        size_t match_len = uzlib_lz77_search(state, src, top - src, &match_offset);
+
+        // With lazy matching, emit a literal instead if the next byte starts
+        // a longer match, and then check the byte after that.
+        while (state->hash_lazy && match_len != 0 && match_len < MATCH_LEN_MAX) {
+            size_t next_offset;
+            size_t next_len = uzlib_lz77_search_hash(state, src, top - src, 1, &next_offset);
+            if (next_len <= match_len) {
+                break;
+            }
+            uzlib_literal(state, *src);
+            uzlib_lz77_push(state, src++, 1);
+            match_offset = next_offset;
+            match_len = next_len;
+        }
 
         // Encode the literal byte or the match.
         if (match_len == 0) {
@@ -76,16 +224,7 @@ void uzlib_lz77_compress(uzlib_lz77_state_t *state, const uint8_t *src, unsigned
             uzlib_match(state, match_offset, match_len);
         }
 
-        // Push the bytes into the history buffer.
-        size_t mask = state->hist_max - 1;
-        while (match_len--) {
-            uint8_t b = *src++;
-            state->hist_buf[(state->hist_start + state->hist_len) & mask] = b;
-            if (state->hist_len == state->hist_max) {
-                state->hist_start = (state->hist_start + 1) & mask;
-            } else {
-                ++state->hist_len;
-            }
-        }
+        uzlib_lz77_push(state, src, match_len);
+        src += match_len;
     }
 }
@@ -143,6 +143,12 @@ int  TINFCC uzlib_uncompress_chksum(TINF_DATA *d);
 int TINFCC uzlib_zlib_parse_header(TINF_DATA *d);
 int TINFCC uzlib_gzip_parse_header(TINF_DATA *d);
 
+/* header types returned by uzlib_parse_zlib_gzip_header */
+#define UZLIB_HEADER_ZLIB 0
+#define UZLIB_HEADER_GZIP 1
+
+int TINFCC uzlib_parse_zlib_gzip_header(TINF_DATA *d, int *wbits);
+
 /* Compression API */
 
 typedef const uint8_t *uzlib_hash_entry_t;
@@ -157,6 +163,36 @@ struct uzlib_comp {
 
 void TINFCC uzlib_compress(struct uzlib_comp *c, const uint8_t *src, unsigned slen);
 
+typedef struct {
+    void *dest_write_data;
+    void (*dest_write_cb)(void *data, uint8_t byte);
+    unsigned long outbits;
+    int noutbits;
+    uint8_t *hist_buf;
+    size_t hist_max;
+    size_t hist_start;
+    size_t hist_len;
+    size_t hist_total;
+    uint16_t *hash_head;
+    uint16_t *hash_prev;
+    size_t hash_mask;
+    unsigned int hash_shift;
+    size_t hash_base;
+    size_t hash_pos;
+    unsigned int hash_max_chain;
+    bool hash_lazy;
+} uzlib_lz77_state_t;
+
+void uzlib_lz77_init(uzlib_lz77_state_t *state, uint8_t *hist, size_t hist_max);
+void uzlib_lz77_init_hash(uzlib_lz77_state_t *state, uint16_t *hash_buf, unsigned int hash_bits, unsigned int max_chain, bool lazy);
+void uzlib_lz77_compress(uzlib_lz77_state_t *state, const uint8_t *src, unsigned len);
+
+/* Fixed Huffman block encoding for uzlib_lz77_compress, in defl_static.c */
+void uzlib_start_block(uzlib_lz77_state_t *state);
+void uzlib_finish_block(uzlib_lz77_state_t *state);
+void uzlib_literal(uzlib_lz77_state_t *state, unsigned char c);
+void uzlib_match(uzlib_lz77_state_t *state, int distance, int len);
+
 /* Checksum API */
 
 /* prev_sum is previous value for incremental computation, 1 initially */
@@ -19,4 +19,16 @@
 #define UZLIB_CONF_PARANOID_CHECKS 0
 #endif
 
+#ifndef UZLIB_CONF_CRC32_SLICE8
+/* Compute CRC32 8 bytes at a time with 8KB of lookup tables, instead of
+   half a byte at a time with a 64 byte table. */
+#define UZLIB_CONF_CRC32_SLICE8 0
+#endif
+
+#ifndef UZLIB_CONF_SIMD
+/* Use SIMD instructions for the checksums where available: SSE2 for
+   Adler32, and PCLMULQDQ for CRC32 if the CPU has it, on x86_64. */
+#define UZLIB_CONF_SIMD 0
+#endif
+
 #endif /* UZLIB_CONF_H_INCLUDED */
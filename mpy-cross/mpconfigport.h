@@ -73,6 +73,8 @@
 #define MICROPY_WARNINGS            (1)
 
 #define MICROPY_FLOAT_IMPL          (MICROPY_FLOAT_IMPL_DOUBLE)
+// float literals must be parsed to the same value as the target would parse them
+#define MICROPY_FLOAT_EXACT_CONVERSION (1)
 #define MICROPY_CPYTHON_COMPAT      (1)
 // CIRCUITPY-CHANGE
 #define MICROPY_PY_ASYNC_AWAIT      (1)
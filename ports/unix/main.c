@@ -175,18 +175,20 @@ static int execute_from_lexer(int source_kind, const void *source, mp_parse_inpu
         }
         #endif
 
-        mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
-
+        mp_obj_t module_fun;
         #if defined(MICROPY_UNIX_COVERAGE)
         // allow to print the parse tree in the coverage build
         if (mp_verbose_flag >= 3) {
+            mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
             printf("----------------\n");
             mp_parse_node_print(&mp_plat_print, parse_tree.root, 0);
             printf("----------------\n");
-        }
+            module_fun = mp_compile(&parse_tree, source_name, is_repl);
+        } else
         #endif
-
-        mp_obj_t module_fun = mp_compile(&parse_tree, source_name, is_repl);
+        {
+            module_fun = mp_parse_compile(lex, input_kind, is_repl);
+        }
 
         if (!compile_only) {
             // execute it
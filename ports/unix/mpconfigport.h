@@ -113,6 +113,11 @@ typedef long mp_off_t;
 // Always enable GC.
 #define MICROPY_ENABLE_GC           (1)
 
+// Use helper threads to mark large heaps.
+#if MICROPY_PY_THREAD && !defined(MICROPY_GC_PARALLEL_MARK)
+#define MICROPY_GC_PARALLEL_MARK    (1)
+#endif
+
 #if !(defined(MICROPY_GCREGS_SETJMP) || defined(__x86_64__) || defined(__i386__) || defined(__thumb2__) || defined(__thumb__) || defined(__arm__))
 // Fall back to setjmp() implementation for discovery of GC pointers in registers.
 #define MICROPY_GCREGS_SETJMP (1)
@@ -160,6 +165,21 @@ typedef long mp_off_t;
 
 #define MICROPY_ALLOC_PATH_MAX      (PATH_MAX)
 
+// Use the fast zlib checksums, RAM and ROM are plentiful.
+#define MICROPY_UZLIB_CRC32_SLICE8  (1)
+#if defined(__x86_64__)
+#define MICROPY_UZLIB_SIMD          (1)
+#endif
+
+// Let deflate.DeflateIO compress as well as decompress.
+#ifndef MICROPY_PY_DEFLATE_COMPRESS
+#define MICROPY_PY_DEFLATE_COMPRESS (1)
+#endif
+
+// Threads schedule callbacks without taking the global atomic section lock.
+#define MICROPY_SCHEDULER_LOCK_FREE (1)
+#define MICROPY_SCHEDULER_PRIORITIES (2)
+
 // Ensure builtinimport.c works with -m.
 #define MICROPY_MODULE_OVERRIDE_MAIN_IMPORT (1)
 
@@ -38,6 +38,7 @@
 #include <signal.h>
 #include <sched.h>
 #include <semaphore.h>
+#include <unistd.h>
 
 #include "shared/runtime/gchelper.h"
 
@@ -183,6 +184,80 @@ void mp_thread_gc_others(void) {
     mp_thread_unix_end_atomic_section();
 }
 
+#if MICROPY_GC_PARALLEL_MARK
+
+// Helper threads for mp_thread_gc_parallel.  They are not Python threads: they
+// are started on first use, block all signals, and otherwise sleep until the
+// next collection.
+static pthread_mutex_t gc_helper_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gc_helper_cond = PTHREAD_COND_INITIALIZER;
+static size_t gc_helper_count;
+static size_t gc_helper_running;
+static unsigned int gc_helper_generation;
+static void (*gc_helper_worker)(size_t id);
+
+static void *gc_helper_thread(void *arg) {
+    size_t id = (size_t)arg;
+    unsigned int generation = 0;
+    pthread_mutex_lock(&gc_helper_mutex);
+    for (;;) {
+        while (generation == gc_helper_generation) {
+            pthread_cond_wait(&gc_helper_cond, &gc_helper_mutex);
+        }
+        generation = gc_helper_generation;
+        void (*worker)(size_t) = gc_helper_worker;
+        pthread_mutex_unlock(&gc_helper_mutex);
+        worker(id);
+        pthread_mutex_lock(&gc_helper_mutex);
+        if (--gc_helper_running == 0) {
+            pthread_cond_broadcast(&gc_helper_cond);
+        }
+    }
+    return NULL;
+}
+
+void mp_thread_gc_parallel(void (*worker)(size_t id), size_t max_workers) {
+    static long n_cpus = 0;
+    if (n_cpus == 0) {
+        n_cpus = MAX(1, sysconf(_SC_NPROCESSORS_ONLN));
+    }
+    // Workers spin while waiting for work, so don't use more than there are CPUs.
+    max_workers = MIN(max_workers, (size_t)n_cpus);
+
+    pthread_mutex_lock(&gc_helper_mutex);
+    if (gc_helper_count + 1 < max_workers) {
+        // New threads inherit the signal mask, so block everything while creating them.
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &old);
+        while (gc_helper_count + 1 < max_workers) {
+            pthread_t id;
+            if (pthread_create(&id, NULL, gc_helper_thread, (void *)(gc_helper_count + 1)) != 0) {
+                // Carry on with the threads there are.
+                break;
+            }
+            pthread_detach(id);
+            gc_helper_count += 1;
+        }
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    gc_helper_worker = worker;
+    gc_helper_running = gc_helper_count;
+    gc_helper_generation += 1;
+    pthread_cond_broadcast(&gc_helper_cond);
+    pthread_mutex_unlock(&gc_helper_mutex);
+
+    worker(0);
+
+    pthread_mutex_lock(&gc_helper_mutex);
+    while (gc_helper_running > 0) {
+        pthread_cond_wait(&gc_helper_cond, &gc_helper_mutex);
+    }
+    pthread_mutex_unlock(&gc_helper_mutex);
+}
+
+#endif // MICROPY_GC_PARALLEL_MARK
+
 mp_state_thread_t *mp_thread_get_state(void) {
     return (mp_state_thread_t *)pthread_getspecific(tls_key);
 }
@@ -33,6 +33,7 @@
 
 #include "py/mphal.h"
 #include "py/mpthread.h"
+#include "py/profile.h"
 #include "py/runtime.h"
 #include "extmod/misc.h"
 
@@ -96,6 +97,36 @@ void mp_hal_set_interrupt_char(int c) {
     }
 }
 
+#if MICROPY_PY_MICROPYTHON_PROF_SAMPLING && !defined(_WIN32)
+
+static void prof_sighandler(int signum) {
+    (void)signum;
+    int saved_errno = errno;
+    mp_prof_sample();
+    errno = saved_errno;
+}
+
+// Use the CPU-time profiling timer so that only time spent running counts.
+void mp_hal_prof_sample_timer(mp_uint_t interval_us) {
+    struct itimerval it = { 0 };
+    if (interval_us > 0) {
+        // The handler stays installed after the timer is stopped, so that a
+        // late signal does not terminate the process.  Block SIGINT while it
+        // runs, because KeyboardInterrupt may be raised from that handler.
+        struct sigaction sa;
+        sa.sa_flags = SA_RESTART;
+        sa.sa_handler = prof_sighandler;
+        sigemptyset(&sa.sa_mask);
+        sigaddset(&sa.sa_mask, SIGINT);
+        sigaction(SIGPROF, &sa, NULL);
+        it.it_interval.tv_sec = interval_us / 1000000;
+        it.it_interval.tv_usec = interval_us % 1000000;
+        it.it_value = it.it_interval;
+    }
+    setitimer(ITIMER_PROF, &it, NULL);
+}
+#endif
+
 // CIRCUITPY-CHANGE
 bool mp_hal_is_interrupted(void) {
     return false;
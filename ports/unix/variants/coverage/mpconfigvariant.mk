@@ -30,6 +30,7 @@ SRC_BITMAP := \
 	shared-bindings/__future__/__init__.c \
 	shared-bindings/aesio/aes.c \
 	shared-bindings/aesio/__init__.c \
+	shared-bindings/arrayops/__init__.c \
 	shared-bindings/audiocore/__init__.c \
 	shared-bindings/audiocore/RawSample.c \
 	shared-bindings/audiocore/WaveFile.c \
@@ -53,6 +54,7 @@ SRC_BITMAP := \
 	shared-bindings/jpegio/JpegDecoder.c \
 	shared-bindings/locale/__init__.c \
 	shared-bindings/rainbowio/__init__.c \
+	shared-bindings/struct/Struct.c \
 	shared-bindings/struct/__init__.c \
 	shared-bindings/synthio/__init__.c \
 	shared-bindings/synthio/Math.c \
@@ -72,6 +74,7 @@ SRC_BITMAP := \
 	shared-bindings/zlib/__init__.c \
 	shared-module/aesio/aes.c \
 	shared-module/aesio/__init__.c \
+	shared-module/arrayops/__init__.c \
 	shared-module/audiocore/__init__.c \
 	shared-module/audiocore/RawSample.c \
 	shared-module/audiocore/WaveFile.c \
@@ -94,6 +97,7 @@ SRC_BITMAP := \
 	shared-module/jpegio/JpegDecoder.c \
 	shared-module/os/getenv.c \
 	shared-module/rainbowio/__init__.c \
+	shared-module/struct/Struct.c \
 	shared-module/struct/__init__.c \
 	shared-module/synthio/__init__.c \
 	shared-module/synthio/Math.c \
@@ -136,6 +140,7 @@ $(BUILD)/lib/mp3/src/buffers.o: CFLAGS += -include "shared-module/audiomp3/__ini
 
 CFLAGS += \
 	-DCIRCUITPY_AESIO=1 \
+	-DCIRCUITPY_ARRAYOPS=1 \
 	-DCIRCUITPY_AUDIOCORE=1 \
 	-DCIRCUITPY_AUDIOEFFECTS=1 \
 	-DCIRCUITPY_AUDIODELAYS=1 \
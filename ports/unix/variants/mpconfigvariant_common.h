@@ -82,6 +82,12 @@
 // Return number of collected objects from gc.collect().
 #define MICROPY_PY_GC_COLLECT_RETVAL   (1)
 
+// Enable the sampling profiler, micropython.prof_start() etc.
+#define MICROPY_PY_MICROPYTHON_PROF_SAMPLING (1)
+
+// Sweep incrementally after collections triggered by allocation.
+#define MICROPY_GC_INCREMENTAL_SWEEP   (1)
+
 // Enable detailed error messages and warnings.
 #define MICROPY_ERROR_REPORTING     (MICROPY_ERROR_REPORTING_DETAILED)
 #define MICROPY_WARNINGS               (1)
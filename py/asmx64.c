@@ -73,6 +73,7 @@
 #define OPCODE_SAR_RM64_CL       (0xd3) /* /7 */
 // #define OPCODE_CMP_I32_WITH_RM32 (0x81) /* /7 */
 // #define OPCODE_CMP_I8_WITH_RM32  (0x83) /* /7 */
+#define OPCODE_CMP_I8_WITH_RM64  (0x83) /* /7 */
 #define OPCODE_CMP_R64_WITH_RM64 (0x39) /* /r */
 // #define OPCODE_CMP_RM32_WITH_R32 (0x3b)
 #define OPCODE_TEST_R8_WITH_RM8  (0x84) /* /r */
@@ -539,6 +540,54 @@ void asm_x64_jcc_label(asm_x64_t *as, int jcc_type, mp_uint_t label) {
     }
 }
 
+// Emits a loop that applies an SSE2 operation to 16 bytes at a time, with the
+// destination pointer in RDI, the source pointers in RSI and RDX (RDX is unused
+// by unary operations) and the number of elements of elem_size bytes in RCX.
+// The loop stops when fewer than 16 bytes remain, leaving the pointers advanced
+// past the processed elements and RCX holding the number of elements left over.
+// Uses XMM0 and XMM1.
+void asm_x64_sse2_loop(asm_x64_t *as, int op, int elem_size) {
+    bool is_bswap = op == ASM_X64_SSE2_BSWAP16 || op == ASM_X64_SSE2_BSWAP32;
+    int vec_elems = 16 / elem_size;
+
+    // Size of the loop body, which starts after the cmp and jb and ends with the
+    // jmp back to the cmp.
+    int body_size = 4 + (is_bswap ? 18 : 12) + 4 + 4 + 4 + 4 + 2;
+    if (op == ASM_X64_SSE2_BSWAP32) {
+        body_size += 10;
+    }
+
+    asm_x64_write_byte_3(as, REX_PREFIX | REX_W, OPCODE_CMP_I8_WITH_RM64, MODRM_R64(7) | MODRM_RM_REG | MODRM_RM_R64(ASM_X64_REG_RCX));
+    asm_x64_write_byte_1(as, vec_elems); // cmp rcx, vec_elems
+    asm_x64_write_byte_2(as, OPCODE_JCC_REL8 | ASM_X64_CC_JB, body_size); // jb past the loop
+    asm_x64_write_word32(as, 0x066f0ff3); // movdqu xmm0, [rsi]
+    if (is_bswap) {
+        if (op == ASM_X64_SSE2_BSWAP32) {
+            // swap the 16-bit halves of each 32-bit element
+            asm_x64_write_byte_1(as, 0xf2);
+            asm_x64_write_word32(as, 0xb1c0700f); // pshuflw xmm0, xmm0, 0xb1
+            asm_x64_write_byte_1(as, 0xf3);
+            asm_x64_write_word32(as, 0xb1c0700f); // pshufhw xmm0, xmm0, 0xb1
+        }
+        asm_x64_write_word32(as, 0xc86f0f66); // movdqa xmm1, xmm0
+        asm_x64_write_byte_1(as, OP_SIZE_PREFIX);
+        asm_x64_write_word32(as, 0x08f0710f); // psllw xmm0, 8
+        asm_x64_write_byte_1(as, OP_SIZE_PREFIX);
+        asm_x64_write_word32(as, 0x08d1710f); // psrlw xmm1, 8
+        asm_x64_write_word32(as, 0xc1eb0f66); // por xmm0, xmm1
+    } else {
+        asm_x64_write_word32(as, 0x0a6f0ff3); // movdqu xmm1, [rdx]
+        asm_x64_write_word32(as, 0xc1000f66 | op << 16); // op xmm0, xmm1
+        asm_x64_write_word32(as, 0x10c28348); // add rdx, 16
+    }
+    asm_x64_write_word32(as, 0x077f0ff3); // movdqu [rdi], xmm0
+    asm_x64_write_word32(as, 0x10c68348); // add rsi, 16
+    asm_x64_write_word32(as, 0x10c78348); // add rdi, 16
+    asm_x64_write_byte_3(as, REX_PREFIX | REX_W, OPCODE_SUB_I8_FROM_RM64, MODRM_R64(5) | MODRM_RM_REG | MODRM_RM_R64(ASM_X64_REG_RCX));
+    asm_x64_write_byte_1(as, vec_elems); // sub rcx, vec_elems
+    asm_x64_write_byte_2(as, OPCODE_JMP_REL8, -(4 + 2 + body_size)); // jmp to the cmp
+}
+
 void asm_x64_entry(asm_x64_t *as, int num_locals) {
     assert(num_locals >= 0);
     asm_x64_push_r64(as, ASM_X64_REG_RBP);
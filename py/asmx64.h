@@ -73,6 +73,16 @@
 #define ASM_X64_CC_JLE (0xe) // less or equal, signed
 #define ASM_X64_CC_JG  (0xf) // greater, signed
 
+// SSE2 operations for asm_x64_sse2_loop, the packed integer ones are opcodes
+#define ASM_X64_SSE2_PADDB   (0xfc)
+#define ASM_X64_SSE2_PADDW   (0xfd)
+#define ASM_X64_SSE2_PADDD   (0xfe)
+#define ASM_X64_SSE2_PADDUSB (0xdc)
+#define ASM_X64_SSE2_PADDUSW (0xdd)
+#define ASM_X64_SSE2_PMULHUW (0xe4)
+#define ASM_X64_SSE2_BSWAP16 (0x100) // unary, byte swap each 16-bit element
+#define ASM_X64_SSE2_BSWAP32 (0x101) // unary, byte swap each 32-bit element
+
 typedef struct _asm_x64_t {
     mp_asm_base_t base;
     int num_locals;
@@ -122,6 +132,7 @@ void asm_x64_mov_r64_to_local(asm_x64_t *as, int src_r64, int dest_local_num);
 void asm_x64_mov_local_addr_to_r64(asm_x64_t *as, int local_num, int dest_r64);
 void asm_x64_mov_reg_pcrel(asm_x64_t *as, int dest_r64, mp_uint_t label);
 void asm_x64_call_ind(asm_x64_t *as, size_t fun_id, int temp_r32);
+void asm_x64_sse2_loop(asm_x64_t *as, int op, int elem_size);
 
 // Holds a pointer to mp_fun_table
 #define ASM_X64_REG_FUN_TABLE ASM_X64_REG_RBP
@@ -329,8 +329,10 @@ void mp_setup_code_state(mp_code_state_t *code_state, size_t n_args, size_t n_kw
     #if MICROPY_STACKLESS
     code_state->prev = NULL;
     #endif
-    #if MICROPY_PY_SYS_SETTRACE
+    #if MICROPY_CODE_STATE_CHAIN
     code_state->prev_state = NULL;
+    #endif
+    #if MICROPY_PY_SYS_SETTRACE
     code_state->frame = NULL;
     #endif
     mp_setup_code_state_helper(code_state, n_args, n_kw, args);
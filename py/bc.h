@@ -216,6 +216,11 @@ typedef struct _mp_module_constants_t {
 typedef struct _mp_module_context_t {
     mp_obj_module_t module;
     mp_module_constants_t constants;
+    #if MICROPY_OPT_INLINE_CACHE
+    // Map slot hints for name lookups in the bytecode, one per entry in
+    // constants.qstr_table.  NULL if the module has none (eg it is frozen).
+    uint16_t *inline_cache;
+    #endif
 } mp_module_context_t;
 
 // Outer level struct defining a compiled module.
@@ -250,8 +255,10 @@ typedef struct _mp_code_state_t {
     #if MICROPY_STACKLESS
     struct _mp_code_state_t *prev;
     #endif
-    #if MICROPY_PY_SYS_SETTRACE
+    #if MICROPY_CODE_STATE_CHAIN
     struct _mp_code_state_t *prev_state;
+    #endif
+    #if MICROPY_PY_SYS_SETTRACE
     struct _mp_obj_frame_t *frame;
     #endif
     // Variable-length
@@ -302,7 +309,14 @@ static inline void mp_module_context_alloc_tables(mp_module_context_t *context,
     #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
     size_t nq = (n_qstr * sizeof(qstr_short_t) + sizeof(mp_uint_t) - 1) / sizeof(mp_uint_t);
     size_t no = n_obj;
+    #if MICROPY_OPT_INLINE_CACHE
+    size_t nc = (n_qstr * sizeof(uint16_t) + sizeof(mp_uint_t) - 1) / sizeof(mp_uint_t);
+    mp_uint_t *mem = m_new(mp_uint_t, nq + no + nc);
+    context->inline_cache = (uint16_t *)(mem + nq + no);
+    memset(context->inline_cache, 0, nc * sizeof(mp_uint_t));
+    #else
     mp_uint_t *mem = m_new(mp_uint_t, nq + no);
+    #endif
     context->constants.qstr_table = (qstr_short_t *)mem;
     context->constants.obj_table = (mp_obj_t *)(mem + nq);
     #else
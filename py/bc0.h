@@ -52,13 +52,14 @@
 #define MP_BC_FORMAT(op) ((0x000003a4 >> (2 * ((op) >> 4))) & 3)
 
 // Load, Store, Delete, Import, Make, Build, Unpack, Call, Jump, Exception, For, sTack, Return, Yield, Op
+// (lowercase letters are superinstructions)
 #define MP_BC_BASE_RESERVED                 (0x00) // ----------------
 #define MP_BC_BASE_QSTR_O                   (0x10) // LLLLLLSSSDDII---
 #define MP_BC_BASE_VINT_E                   (0x20) // MMLLLLSSDDBBBBBB
-#define MP_BC_BASE_VINT_O                   (0x30) // UUMMCCCC--------
-#define MP_BC_BASE_JUMP_E                   (0x40) // J-JJJJJEEEEF----
+#define MP_BC_BASE_VINT_O                   (0x30) // UUMMCCCCF-------
+#define MP_BC_BASE_JUMP_E                   (0x40) // JjJJJJJEEEEFffF-
 #define MP_BC_BASE_BYTE_O                   (0x50) // LLLLSSDTTTTTEEFF
-#define MP_BC_BASE_BYTE_E                   (0x60) // --BREEEYYI------
+#define MP_BC_BASE_BYTE_E                   (0x60) // lsBREEEYYI------
 #define MP_BC_LOAD_CONST_SMALL_INT_MULTI    (0x70) // LLLLLLLLLLLLLLLL
 //                                          (0x80) // LLLLLLLLLLLLLLLL
 //                                          (0x90) // LLLLLLLLLLLLLLLL
@@ -159,4 +160,22 @@
 #define MP_BC_IMPORT_FROM                   (MP_BC_BASE_QSTR_O + 0x0c) // qstr
 #define MP_BC_IMPORT_STAR                   (MP_BC_BASE_BYTE_E + 0x09)
 
+// Superinstructions, generated by the peephole stage of the bytecode emitter
+// from common opcode sequences.  They are only emitted for code that is run in
+// place, never for code that is saved to a .mpy file, so are not part of the
+// .mpy format.
+#define MP_BC_LOAD_FAST_PAIR                (MP_BC_BASE_BYTE_E + 0x00) // byte: 2 local nums, first in high nibble
+#define MP_BC_INCR_FAST                     (MP_BC_BASE_BYTE_E + 0x01) // byte: local num; then signed var-int
+#define MP_BC_COMPARE_POP_JUMP              (MP_BC_BASE_JUMP_E + 0x01) // signed relative bytecode offset; then a byte
+#define MP_BC_FOR_RANGE_JUMP                (MP_BC_BASE_JUMP_E + 0x0c) // signed relative bytecode offset; then a byte
+#define MP_BC_FOR_RANGE_CONST_JUMP          (MP_BC_BASE_JUMP_E + 0x0d) // signed relative bytecode offset; then a byte and signed var-int
+
+// Counted range loops, which like superinstructions are not part of the .mpy format.
+#define MP_BC_GET_ITER_RANGE                (MP_BC_BASE_VINT_O + 0x08) // uint
+#define MP_BC_FOR_ITER_RANGE                (MP_BC_BASE_JUMP_E + 0x0e) // unsigned relative bytecode offset
+
+// Flag in the extra byte of MP_BC_COMPARE_POP_JUMP to jump if the comparison is
+// true, rather than false.  The remaining bits hold the comparison binary op.
+#define MP_BC_COMPARE_POP_JUMP_IF_TRUE      (0x80)
+
 #endif // MICROPY_INCLUDED_PY_BC0_H
@@ -116,6 +116,9 @@ endif
 ifeq ($(CIRCUITPY_ANALOGIO),1)
 SRC_PATTERNS += analogio/%
 endif
+ifeq ($(CIRCUITPY_ARRAYOPS),1)
+SRC_PATTERNS += arrayops/%
+endif
 ifeq ($(CIRCUITPY_ATEXIT),1)
 SRC_PATTERNS += atexit/%
 endif
@@ -619,6 +622,7 @@ SRC_SHARED_MODULE_ALL = \
 	_stage/__init__.c \
 	aesio/__init__.c \
 	aesio/aes.c \
+	arrayops/__init__.c \
 	atexit/__init__.c \
 	audiocore/RawSample.c \
 	audiocore/WaveFile.c \
@@ -713,6 +717,7 @@ SRC_SHARED_MODULE_ALL = \
 	sharpdisplay/__init__.c \
 	socket/__init__.c \
 	storage/__init__.c \
+	struct/Struct.c \
 	struct/__init__.c \
 	supervisor/__init__.c \
 	supervisor/StatusBar.c \
@@ -859,6 +864,9 @@ SRC_MOD += $(addprefix lib/uzlib/, \
 	crc32.c \
 )
 $(BUILD)/lib/uzlib/tinflate.o: CFLAGS += -Wno-missing-braces -Wno-missing-prototypes
+# crc32.c is built on its own here, not #include'd by modzlib.c, so it needs
+# the option passed in directly.
+$(BUILD)/lib/uzlib/crc32.o: CFLAGS += -DUZLIB_CONF_CRC32_SLICE8=$(CIRCUITPY_UZLIB_CRC32_SLICE8)
 endif
 
 # All possible sources are listed here, and are filtered by SRC_PATTERNS.
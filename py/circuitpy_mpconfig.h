@@ -93,6 +93,9 @@ extern void common_hal_mcu_enable_interrupts(void);
 #define MICROPY_OPT_COMPUTED_GOTO_SAVE_SPACE (CIRCUITPY_COMPUTED_GOTO_SAVE_SPACE)
 #define MICROPY_OPT_LOAD_ATTR_FAST_PATH  (CIRCUITPY_OPT_LOAD_ATTR_FAST_PATH)
 #define MICROPY_OPT_MAP_LOOKUP_CACHE  (CIRCUITPY_OPT_MAP_LOOKUP_CACHE)
+#define MICROPY_OPT_INLINE_CACHE  (CIRCUITPY_OPT_INLINE_CACHE)
+#define MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS (CIRCUITPY_OPT_BYTECODE_SUPERINSTRUCTIONS)
+#define MICROPY_OPT_COUNTED_RANGE_LOOP (CIRCUITPY_OPT_COUNTED_RANGE_LOOP)
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (CIRCUITPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE)
 #define MICROPY_PERSISTENT_CODE_LOAD     (1)
 
@@ -116,9 +119,16 @@ extern void common_hal_mcu_enable_interrupts(void);
 #define MICROPY_PY_BUILTINS_SLICE_ATTRS  (1)
 #define MICROPY_PY_BUILTINS_SLICE_INDICES (1)
 #define MICROPY_PY_BUILTINS_STR_UNICODE  (1)
+#define MICROPY_PY_LIST_SORT_STABLE      (CIRCUITPY_FULL_BUILD)
+#define MICROPY_MAP_COMPACT              (CIRCUITPY_FULL_BUILD)
+#define MICROPY_FLOAT_EXACT_CONVERSION   (CIRCUITPY_FLOAT_EXACT_CONVERSION)
+#define MICROPY_COMP_STREAMING           (CIRCUITPY_FULL_BUILD)
+#define MICROPY_EMIT_NATIVE_REG_ALLOC    (CIRCUITPY_FULL_BUILD)
+#define MICROPY_EMIT_NATIVE_SIMD         (CIRCUITPY_FULL_BUILD)
 
 #define MICROPY_PY_BINASCII             (CIRCUITPY_BINASCII)
 #define MICROPY_PY_BINASCII_CRC32       (CIRCUITPY_BINASCII && CIRCUITPY_ZLIB)
+#define MICROPY_UZLIB_CRC32_SLICE8      (CIRCUITPY_UZLIB_CRC32_SLICE8)
 #define MICROPY_PY_CMATH                 (0)
 #define MICROPY_PY_COLLECTIONS           (CIRCUITPY_COLLECTIONS)
 #define MICROPY_PY_DESCRIPTORS           (1)
@@ -90,6 +90,11 @@ CFLAGS += -DMICROPY_PY_SELECT_SELECT=$(MICROPY_PY_SELECT_SELECT)
 CIRCUITPY_AESIO ?= $(CIRCUITPY_FULL_BUILD)
 CFLAGS += -DCIRCUITPY_AESIO=$(CIRCUITPY_AESIO)
 
+# Compute the AES S-box without secret-dependent table lookups, at a large cost
+# in speed.
+CIRCUITPY_AESIO_CONSTANT_TIME ?= 0
+CFLAGS += -DCIRCUITPY_AESIO_CONSTANT_TIME=$(CIRCUITPY_AESIO_CONSTANT_TIME)
+
 # TODO: CIRCUITPY_ALARM will gradually be added to as many ports as possible
 # so make this 1 or CIRCUITPY_FULL_BUILD eventually
 CIRCUITPY_ALARM ?= 0
@@ -107,6 +112,10 @@ CFLAGS += -DCIRCUITPY_ANALOGIO=$(CIRCUITPY_ANALOGIO)
 CIRCUITPY_ARRAY ?= 1
 CFLAGS += -DCIRCUITPY_ARRAY=$(CIRCUITPY_ARRAY)
 
+# Bulk operations on whole arrays. Off by default because of their size (~6k).
+CIRCUITPY_ARRAYOPS ?= 0
+CFLAGS += -DCIRCUITPY_ARRAYOPS=$(CIRCUITPY_ARRAYOPS)
+
 CIRCUITPY_ATEXIT ?= $(CIRCUITPY_FULL_BUILD)
 CFLAGS += -DCIRCUITPY_ATEXIT=$(CIRCUITPY_ATEXIT)
 
@@ -292,6 +301,11 @@ CFLAGS += -DCIRCUITPY_ESPCAMERA=$(CIRCUITPY_ESPCAMERA)
 CIRCUITPY__EVE ?= 0
 CFLAGS += -DCIRCUITPY__EVE=$(CIRCUITPY__EVE)
 
+# Correctly rounded conversions between floats and strings, with the shortest
+# repr that round-trips. Costs about 6k of flash, so boards must opt in.
+CIRCUITPY_FLOAT_EXACT_CONVERSION ?= 0
+CFLAGS += -DCIRCUITPY_FLOAT_EXACT_CONVERSION=$(CIRCUITPY_FLOAT_EXACT_CONVERSION)
+
 CIRCUITPY_FLOPPYIO ?= 0
 CFLAGS += -DCIRCUITPY_FLOPPYIO=$(CIRCUITPY_FLOPPYIO)
 
@@ -400,6 +414,15 @@ CFLAGS += -DCIRCUITPY_OPT_LOAD_ATTR_FAST_PATH=$(CIRCUITPY_OPT_LOAD_ATTR_FAST_PAT
 CIRCUITPY_OPT_MAP_LOOKUP_CACHE ?= $(CIRCUITPY_FULL_BUILD)
 CFLAGS += -DCIRCUITPY_OPT_MAP_LOOKUP_CACHE=$(CIRCUITPY_OPT_MAP_LOOKUP_CACHE)
 
+CIRCUITPY_OPT_INLINE_CACHE ?= $(CIRCUITPY_FULL_BUILD)
+CFLAGS += -DCIRCUITPY_OPT_INLINE_CACHE=$(CIRCUITPY_OPT_INLINE_CACHE)
+
+CIRCUITPY_OPT_BYTECODE_SUPERINSTRUCTIONS ?= $(CIRCUITPY_FULL_BUILD)
+CFLAGS += -DCIRCUITPY_OPT_BYTECODE_SUPERINSTRUCTIONS=$(CIRCUITPY_OPT_BYTECODE_SUPERINSTRUCTIONS)
+
+CIRCUITPY_OPT_COUNTED_RANGE_LOOP ?= $(CIRCUITPY_FULL_BUILD)
+CFLAGS += -DCIRCUITPY_OPT_COUNTED_RANGE_LOOP=$(CIRCUITPY_OPT_COUNTED_RANGE_LOOP)
+
 CIRCUITPY_OS ?= 1
 CFLAGS += -DCIRCUITPY_OS=$(CIRCUITPY_OS)
 
@@ -654,6 +677,10 @@ CFLAGS += -DCIRCUITPY_USTACK=$(CIRCUITPY_USTACK)
 CIRCUITPY_ZLIB ?= $(CIRCUITPY_FULL_BUILD)
 CFLAGS += -DCIRCUITPY_ZLIB=$(CIRCUITPY_ZLIB)
 
+# Compute zlib and binascii CRC32s 8 bytes at a time, with 8KiB of tables
+CIRCUITPY_UZLIB_CRC32_SLICE8 ?= 0
+CFLAGS += -DCIRCUITPY_UZLIB_CRC32_SLICE8=$(CIRCUITPY_UZLIB_CRC32_SLICE8)
+
 # ulab numerics library
 CIRCUITPY_ULAB ?= $(CIRCUITPY_FULL_BUILD)
 CFLAGS += -DCIRCUITPY_ULAB=$(CIRCUITPY_ULAB)
@@ -188,12 +188,27 @@ typedef struct _compiler_t {
     const emit_method_table_t *emit_method_table;   // current emit method table
     #endif
 
+    #if MICROPY_EMIT_NATIVE
+    emit_t *emit_native;                            // emitter for native code, created when first needed
+    #endif
+
     #if MICROPY_EMIT_INLINE_ASM
     emit_inline_asm_t *emit_inline_asm;                                   // current emitter for inline asm
     const emit_inline_asm_method_table_t *emit_inline_asm_method_table;   // current emit method table for inline asm
     #endif
 
     mp_emit_common_t emit_common;
+
+    #if MICROPY_COMP_STREAMING
+    // state for compiling the module scope one top-level statement at a time
+    bool is_streaming;
+    uint16_t module_num_children;
+    uint16_t module_children_alloc;
+    mp_raw_code_t **module_children;
+    emit_t *emit_bc;
+    emit_t *emit_module;
+    qstr source_file;
+    #endif
 } compiler_t;
 
 #if MICROPY_COMP_ALLOW_TOP_LEVEL_AWAIT
@@ -1243,6 +1258,14 @@ static void compile_declare_global(compiler_t *comp, mp_parse_node_t pn, id_info
     }
     id_info->kind = ID_INFO_KIND_GLOBAL_EXPLICIT;
 
+    #if MICROPY_COMP_STREAMING
+    if (comp->is_streaming) {
+        // some of the module-level code may already be emitted, so leave all of it
+        // to access the name as it would without this declaration (as CPython does)
+        return;
+    }
+    #endif
+
     // if the id exists in the global scope, set its kind to EXPLICIT_GLOBAL
     id_info = scope_find_global(comp->scope_cur, id_info->qst);
     if (id_info != NULL) {
@@ -1513,6 +1536,7 @@ static void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
             mp_parse_node_t pn_range_end;
             mp_parse_node_t pn_range_step;
             bool optimize = false;
+            bool const_step = true;
             if (1 <= n_args && n_args <= 3) {
                 optimize = true;
                 if (n_args == 1) {
@@ -1527,27 +1551,54 @@ static void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
                     pn_range_start = args[0];
                     pn_range_end = args[1];
                     pn_range_step = args[2];
-                    // the step must be a non-zero constant integer to do the optimisation
+                    // the step must be a non-zero constant integer to do the compile-time optimisation
                     if (!MP_PARSE_NODE_IS_SMALL_INT(pn_range_step)
                         || MP_PARSE_NODE_LEAF_SMALL_INT(pn_range_step) == 0) {
-                        optimize = false;
+                        const_step = false;
                     }
                 }
                 // arguments must be able to be compiled as standard expressions
-                if (optimize && MP_PARSE_NODE_IS_STRUCT(pn_range_start)) {
-                    int k = MP_PARSE_NODE_STRUCT_KIND((mp_parse_node_struct_t *)pn_range_start);
-                    if (k == PN_arglist_star || k == PN_arglist_dbl_star || k == PN_argument) {
-                        optimize = false;
+                for (size_t i = 0; i < n_args; ++i) {
+                    if (MP_PARSE_NODE_IS_STRUCT(args[i])) {
+                        int k = MP_PARSE_NODE_STRUCT_KIND((mp_parse_node_struct_t *)args[i]);
+                        if (k == PN_arglist_star || k == PN_arglist_dbl_star || k == PN_argument) {
+                            optimize = false;
+                        }
                     }
                 }
-                if (optimize && MP_PARSE_NODE_IS_STRUCT(pn_range_end)) {
-                    int k = MP_PARSE_NODE_STRUCT_KIND((mp_parse_node_struct_t *)pn_range_end);
-                    if (k == PN_arglist_star || k == PN_arglist_dbl_star || k == PN_argument) {
-                        optimize = false;
-                    }
+            }
+            #if MICROPY_OPT_COUNTED_RANGE_LOOP
+            // in bytecode use a counted loop, which checks at runtime that range is the builtin
+            if (optimize && (comp->scope_cur->emit_options == MP_EMIT_OPT_NONE
+                || comp->scope_cur->emit_options == MP_EMIT_OPT_BYTECODE)) {
+                START_BREAK_CONTINUE_BLOCK
+                comp->break_label |= MP_EMIT_BREAK_FROM_FOR;
+
+                uint pop_label = comp_next_label(comp);
+
+                compile_node(comp, pns_it->nodes[0]); // range
+                for (size_t i = 0; i < n_args; ++i) {
+                    compile_node(comp, args[i]);
                 }
+                EMIT_ARG(get_iter_range, n_args);
+                EMIT_ARG(label_assign, continue_label);
+                EMIT_ARG(for_iter_range, pop_label);
+                c_assign(comp, pns->nodes[0], ASSIGN_STORE); // variable
+                compile_node(comp, pns->nodes[2]); // body
+                EMIT_ARG(jump, continue_label);
+                EMIT_ARG(label_assign, pop_label);
+                EMIT(for_iter_end);
+
+                // break/continue apply to outer loop (if any) in the else block
+                END_BREAK_CONTINUE_BLOCK
+
+                compile_node(comp, pns->nodes[3]); // else (may be empty)
+
+                EMIT_ARG(label_assign, break_label);
+                return;
             }
-            if (optimize) {
+            #endif
+            if (optimize && const_step) {
                 compile_for_stmt_optimised_range(comp, pns->nodes[0], pn_range_start, pn_range_end, pn_range_step, pns->nodes[2], pns->nodes[3]);
                 return;
             }
@@ -3426,6 +3477,11 @@ static void scope_compute_things(scope_t *scope) {
             if (scope->emit_options == MP_EMIT_OPT_VIPER
                 && mp_native_type_from_qstr(id->qst) >= MP_NATIVE_TYPE_INT) {
                 // A casting operator in viper mode, not a real global reference
+            #if MICROPY_EMIT_NATIVE_SIMD
+            } else if (scope->emit_options == MP_EMIT_OPT_VIPER
+                       && mp_native_simd_from_qstr(id->qst) >= 0) {
+                // A SIMD intrinsic in viper mode, not a real global reference
+            #endif
             } else {
                 scope->scope_flags |= MP_SCOPE_FLAG_REFGLOBALS;
             }
@@ -3481,37 +3537,15 @@ static void scope_compute_things(scope_t *scope) {
     }
 }
 
-#if !MICROPY_PERSISTENT_CODE_SAVE
-static
-#endif
-void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool is_repl, mp_compiled_module_t *cm) {
-    // put compiler state on the stack, it's relatively small
-    compiler_t comp_state = {0};
-    compiler_t *comp = &comp_state;
-
-    comp->is_repl = is_repl;
-    comp->break_label = INVALID_LABEL;
-    comp->continue_label = INVALID_LABEL;
-    mp_emit_common_init(&comp->emit_common, source_file);
-
-    // create the module scope
-    #if MICROPY_EMIT_NATIVE
-    const uint emit_opt = MP_STATE_VM(default_emit_opt);
-    #else
-    const uint emit_opt = MP_EMIT_OPT_NONE;
-    #endif
-    scope_t *module_scope = scope_new_and_link(comp, SCOPE_MODULE, parse_tree->root, emit_opt);
-
-    // create standard emitter; it's used at least for MP_PASS_SCOPE
-    emit_t *emit_bc = emit_bc_new(&comp->emit_common);
-
-    // compile MP_PASS_SCOPE
+// Run MP_PASS_SCOPE on the given scope and all the scopes after it, including
+// those that are created along the way, and return the number of labels needed.
+static uint compile_scopes_pass_scope(compiler_t *comp, scope_t *scope, emit_t *emit_bc) {
     comp->emit = emit_bc;
     #if MICROPY_EMIT_NATIVE
     comp->emit_method_table = &emit_bc_method_table;
     #endif
     uint max_num_labels = 0;
-    for (scope_t *s = comp->scope_head; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
+    for (scope_t *s = scope; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
         #if MICROPY_EMIT_INLINE_ASM
         if (s->emit_options == MP_EMIT_OPT_ASM) {
             compile_scope_inline_asm(comp, s, MP_PASS_SCOPE);
@@ -3536,18 +3570,17 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
     }
 
     // compute some things related to scope and identifiers
-    for (scope_t *s = comp->scope_head; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
+    for (scope_t *s = scope; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
         scope_compute_things(s);
     }
 
-    // set max number of labels now that it's calculated
-    emit_bc_set_max_num_labels(emit_bc, max_num_labels);
+    return max_num_labels;
+}
 
-    // compile MP_PASS_STACK_SIZE, MP_PASS_CODE_SIZE, MP_PASS_EMIT
-    #if MICROPY_EMIT_NATIVE
-    emit_t *emit_native = NULL;
-    #endif
-    for (scope_t *s = comp->scope_head; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
+// Run MP_PASS_STACK_SIZE, MP_PASS_CODE_SIZE and MP_PASS_EMIT on the given scope
+// and all the scopes after it.
+static void compile_scopes_emit(compiler_t *comp, scope_t *scope, emit_t *emit_bc, uint max_num_labels) {
+    for (scope_t *s = scope; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
         #if MICROPY_EMIT_INLINE_ASM
         if (s->emit_options == MP_EMIT_OPT_ASM) {
             // inline assembly
@@ -3582,11 +3615,11 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
                 #if MICROPY_EMIT_NATIVE
                 case MP_EMIT_OPT_NATIVE_PYTHON:
                 case MP_EMIT_OPT_VIPER:
-                    if (emit_native == NULL) {
-                        emit_native = NATIVE_EMITTER(new)(&comp->emit_common, &comp->compile_error, &comp->next_label, max_num_labels);
+                    if (comp->emit_native == NULL) {
+                        comp->emit_native = NATIVE_EMITTER(new)(&comp->emit_common, &comp->compile_error, &comp->next_label, max_num_labels);
                     }
                     comp->emit_method_table = NATIVE_EMITTER_TABLE;
-                    comp->emit = emit_native;
+                    comp->emit = comp->emit_native;
                     break;
                 #endif // MICROPY_EMIT_NATIVE
 
@@ -3614,14 +3647,68 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
             }
         }
     }
+}
+
+static void compile_error_add_traceback(compiler_t *comp, qstr source_file) {
+    // if there is no line number for the error then use the line
+    // number for the start of this scope
+    compile_error_set_line(comp, comp->scope_cur->pn);
+    // add a traceback to the exception using relevant source info
+    mp_obj_exception_add_traceback(comp->compile_error, source_file,
+        comp->compile_error_line, comp->scope_cur->simple_name);
+}
+
+static void compile_free_native_emitters(compiler_t *comp) {
+    #if MICROPY_EMIT_NATIVE
+    if (comp->emit_native != NULL) {
+        NATIVE_EMITTER(free)(comp->emit_native);
+        comp->emit_native = NULL;
+    }
+    #endif
+    #if MICROPY_EMIT_INLINE_ASM
+    if (comp->emit_inline_asm != NULL) {
+        ASM_EMITTER(free)(comp->emit_inline_asm);
+        comp->emit_inline_asm = NULL;
+    }
+    #endif
+    (void)comp;
+}
+
+#if !MICROPY_PERSISTENT_CODE_SAVE
+static
+#endif
+void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool is_repl, mp_compiled_module_t *cm) {
+    // put compiler state on the stack, it's relatively small
+    compiler_t comp_state = {0};
+    compiler_t *comp = &comp_state;
+
+    comp->is_repl = is_repl;
+    comp->break_label = INVALID_LABEL;
+    comp->continue_label = INVALID_LABEL;
+    mp_emit_common_init(&comp->emit_common, source_file);
+
+    // create the module scope
+    #if MICROPY_EMIT_NATIVE
+    const uint emit_opt = MP_STATE_VM(default_emit_opt);
+    #else
+    const uint emit_opt = MP_EMIT_OPT_NONE;
+    #endif
+    scope_t *module_scope = scope_new_and_link(comp, SCOPE_MODULE, parse_tree->root, emit_opt);
+
+    // create standard emitter; it's used at least for MP_PASS_SCOPE
+    emit_t *emit_bc = emit_bc_new(&comp->emit_common);
+
+    // compile MP_PASS_SCOPE
+    uint max_num_labels = compile_scopes_pass_scope(comp, comp->scope_head, emit_bc);
+
+    // set max number of labels now that it's calculated
+    emit_bc_set_max_num_labels(emit_bc, max_num_labels);
+
+    // compile MP_PASS_STACK_SIZE, MP_PASS_CODE_SIZE, MP_PASS_EMIT
+    compile_scopes_emit(comp, comp->scope_head, emit_bc, max_num_labels);
 
     if (comp->compile_error != MP_OBJ_NULL) {
-        // if there is no line number for the error then use the line
-        // number for the start of this scope
-        compile_error_set_line(comp, comp->scope_cur->pn);
-        // add a traceback to the exception using relevant source info
-        mp_obj_exception_add_traceback(comp->compile_error, source_file,
-            comp->compile_error_line, comp->scope_cur->simple_name);
+        compile_error_add_traceback(comp, source_file);
     }
 
     // construct the global qstr/const table for this module
@@ -3629,7 +3716,7 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
     #if MICROPY_PERSISTENT_CODE_SAVE
     cm->has_native = false;
     #if MICROPY_EMIT_NATIVE
-    if (emit_native != NULL) {
+    if (comp->emit_native != NULL) {
         cm->has_native = true;
     }
     #endif
@@ -3660,16 +3747,7 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
     // free the emitters
 
     emit_bc_free(emit_bc);
-    #if MICROPY_EMIT_NATIVE
-    if (emit_native != NULL) {
-        NATIVE_EMITTER(free)(emit_native);
-    }
-    #endif
-    #if MICROPY_EMIT_INLINE_ASM
-    if (comp->emit_inline_asm != NULL) {
-        ASM_EMITTER(free)(comp->emit_inline_asm);
-    }
-    #endif
+    compile_free_native_emitters(comp);
 
     // free the parse tree
     mp_parse_tree_clear(parse_tree);
@@ -3695,4 +3773,172 @@ mp_obj_t mp_compile(mp_parse_tree_t *parse_tree, qstr source_file, bool is_repl)
     return mp_make_function_from_proto_fun(cm.rc, cm.context, NULL);
 }
 
+#if MICROPY_COMP_STREAMING
+
+// Compile a segment of the module scope: a top-level statement, or the return at
+// the end of the module if pn is null.  The children of the module are numbered
+// across all its segments, so its array of them is grown for each segment.
+static bool compile_module_segment(compiler_t *comp, mp_parse_node_t pn, bool is_first, pass_kind_t pass) {
+    scope_t *scope = comp->scope_head;
+    comp->pass = pass;
+    comp->scope_cur = scope;
+    comp->next_label = 0;
+
+    mp_emit_common_t *emit_common = &comp->emit_common;
+    if (pass == MP_PASS_CODE_SIZE && emit_common->ct_cur_child > comp->module_children_alloc) {
+        comp->module_children = m_renew(mp_raw_code_t *, comp->module_children, comp->module_children_alloc, emit_common->ct_cur_child);
+        comp->module_children_alloc = emit_common->ct_cur_child;
+    }
+    emit_common->pass = pass;
+    emit_common->children = comp->module_children;
+    emit_common->ct_cur_child = comp->module_num_children;
+
+    EMIT_ARG(start_pass, pass, scope);
+    if (MP_PARSE_NODE_IS_NULL(pn)) {
+        EMIT_ARG(load_const_tok, MP_TOKEN_KW_NONE);
+        EMIT(return_value);
+    } else {
+        if (is_first && !comp->is_repl) {
+            check_for_doc_string(comp, pn);
+        }
+        compile_node(comp, pn);
+    }
+    return EMIT(end_pass);
+}
+
+// Run all the passes on a segment of the module scope.
+static void compile_module_segment_emit(compiler_t *comp, mp_parse_node_t pn, bool is_first) {
+    comp->emit = comp->emit_module;
+    #if MICROPY_EMIT_NATIVE
+    comp->emit_method_table = &emit_bc_method_table;
+    #endif
+    compile_module_segment(comp, pn, is_first, MP_PASS_STACK_SIZE);
+    if (comp->compile_error == MP_OBJ_NULL) {
+        compile_module_segment(comp, pn, is_first, MP_PASS_CODE_SIZE);
+    }
+    if (comp->compile_error == MP_OBJ_NULL) {
+        while (!compile_module_segment(comp, pn, is_first, MP_PASS_EMIT)) {
+        }
+        comp->module_num_children = comp->emit_common.ct_cur_child;
+    }
+}
+
+// Called by the parser with each top-level statement.  The statement is compiled
+// completely, along with all the scopes it creates, which are then freed, so all
+// that's kept is their raw code, the statement's code for the module scope, and
+// the names used by the module scope.
+static void compile_stream_stmt(void *env, mp_parse_node_t pn) {
+    compiler_t *comp = env;
+    if (comp->compile_error != MP_OBJ_NULL) {
+        // carry on parsing without compiling, so that a syntax error later in the
+        // file takes precedence, as it does when the whole file is parsed first
+        return;
+    }
+
+    scope_t *module_scope = comp->scope_head;
+    bool is_first = MP_PARSE_NODE_IS_NULL(module_scope->pn);
+    module_scope->pn = pn;
+
+    // compile MP_PASS_SCOPE for the statement and then for the new scopes
+    comp->emit = comp->emit_bc;
+    #if MICROPY_EMIT_NATIVE
+    comp->emit_method_table = &emit_bc_method_table;
+    #endif
+    compile_module_segment(comp, pn, is_first, MP_PASS_SCOPE);
+    uint max_num_labels = comp->next_label;
+    uint max_num_labels_new_scopes = compile_scopes_pass_scope(comp, module_scope->next, comp->emit_bc);
+    emit_bc_set_max_num_labels(comp->emit_bc, max_num_labels_new_scopes);
+    emit_bc_set_max_num_labels(comp->emit_module, max_num_labels);
+
+    // compile the remaining passes for the new scopes and then for the statement
+    compile_scopes_emit(comp, module_scope->next, comp->emit_bc, max_num_labels_new_scopes);
+    if (comp->compile_error == MP_OBJ_NULL) {
+        compile_module_segment_emit(comp, pn, is_first);
+    }
+
+    if (comp->compile_error != MP_OBJ_NULL) {
+        compile_error_add_traceback(comp, comp->source_file);
+    }
+
+    // the native emitters are sized for the labels of this statement
+    compile_free_native_emitters(comp);
+
+    // free the new scopes
+    for (scope_t *s = module_scope->next; s;) {
+        scope_t *next = s->next;
+        scope_free(s);
+        s = next;
+    }
+    module_scope->next = NULL;
+}
+
+static mp_obj_t compile_streaming(mp_lexer_t *lex, qstr source_file, bool is_repl) {
+    // put compiler state on the stack, it's relatively small
+    compiler_t comp_state = {0};
+    compiler_t *comp = &comp_state;
+
+    comp->is_repl = is_repl;
+    comp->break_label = INVALID_LABEL;
+    comp->continue_label = INVALID_LABEL;
+    comp->is_streaming = true;
+    comp->source_file = source_file;
+    mp_emit_common_init(&comp->emit_common, source_file);
+
+    // create the module scope, which starts with no code, and its emitter
+    scope_t *module_scope = scope_new_and_link(comp, SCOPE_MODULE, MP_PARSE_NODE_NULL, MP_EMIT_OPT_NONE);
+    comp->emit_bc = emit_bc_new(&comp->emit_common);
+    comp->emit_module = emit_bc_new(&comp->emit_common);
+    emit_bc_start_segments(comp->emit_module);
+
+    // parse and compile the statements, then finish the module with a return
+    mp_parse_streaming(lex, compile_stream_stmt, comp);
+    if (comp->compile_error == MP_OBJ_NULL) {
+        compile_module_segment_emit(comp, MP_PARSE_NODE_NULL, false);
+        emit_bc_end_segments(comp->emit_module);
+    }
+
+    mp_compiled_module_t cm;
+    cm.context = m_new_obj(mp_module_context_t);
+    cm.context->module.globals = mp_globals_get();
+    cm.rc = module_scope->raw_code;
+    if (comp->compile_error == MP_OBJ_NULL) {
+        mp_emit_common_populate_module_context(&comp->emit_common, source_file, cm.context);
+    }
+
+    // free the emitters and the module scope
+    emit_bc_free(comp->emit_bc);
+    emit_bc_free(comp->emit_module);
+    scope_free(module_scope);
+
+    if (comp->compile_error != MP_OBJ_NULL) {
+        nlr_raise(comp->compile_error);
+    }
+
+    // return function that executes the outer module
+    return mp_make_function_from_proto_fun(cm.rc, cm.context, NULL);
+}
+
+#endif // MICROPY_COMP_STREAMING
+
+mp_obj_t mp_parse_compile(mp_lexer_t *lex, mp_parse_input_kind_t input_kind, bool is_repl) {
+    qstr source_file = lex->source_name;
+    #if MICROPY_COMP_STREAMING
+    if (input_kind == MP_PARSE_FILE_INPUT
+        #if MICROPY_EMIT_NATIVE
+        // the module scope can only be emitted in segments as bytecode
+        && MP_STATE_VM(default_emit_opt) != MP_EMIT_OPT_NATIVE_PYTHON
+        && MP_STATE_VM(default_emit_opt) != MP_EMIT_OPT_VIPER
+        #endif
+        #if MICROPY_DEBUG_PRINTERS
+        // printing the raw code needs all the scopes at the end
+        && mp_verbose_flag < 2
+        #endif
+        ) {
+        return compile_streaming(lex, source_file, is_repl);
+    }
+    #endif
+    mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
+    return mp_compile(&parse_tree, source_file, is_repl);
+}
+
 #endif // MICROPY_ENABLE_COMPILER
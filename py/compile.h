@@ -40,6 +40,11 @@ extern bool mp_compile_allow_top_level_await;
 // mp_globals_get() will be used for the context
 mp_obj_t mp_compile(mp_parse_tree_t *parse_tree, qstr source_file, bool is_repl);
 
+// parse and compile the input from the lexer, with the same semantics as mp_compile
+// file input is compiled as it's parsed if MICROPY_COMP_STREAMING is enabled, so
+// only the parse tree of the current top-level statement is kept in memory
+mp_obj_t mp_parse_compile(mp_lexer_t *lex, mp_parse_input_kind_t input_kind, bool is_repl);
+
 #if MICROPY_PERSISTENT_CODE_SAVE
 // this has the same semantics as mp_compile
 void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool is_repl, mp_compiled_module_t *cm);
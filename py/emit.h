@@ -148,6 +148,10 @@ typedef struct _emit_method_table_t {
     void (*get_iter)(emit_t *emit, bool use_stack);
     void (*for_iter)(emit_t *emit, mp_uint_t label);
     void (*for_iter_end)(emit_t *emit);
+    #if MICROPY_OPT_COUNTED_RANGE_LOOP
+    void (*get_iter_range)(emit_t *emit, mp_uint_t n_args);
+    void (*for_iter_range)(emit_t *emit, mp_uint_t label);
+    #endif
     void (*pop_except_jump)(emit_t *emit, mp_uint_t label, bool within_exc_handler);
     void (*unary_op)(emit_t *emit, mp_unary_op_t op);
     void (*binary_op)(emit_t *emit, mp_binary_op_t op);
@@ -215,6 +219,10 @@ emit_t *emit_native_xtensa_new(mp_emit_common_t *emit_common, mp_obj_t *error_sl
 emit_t *emit_native_xtensawin_new(mp_emit_common_t *emit_common, mp_obj_t *error_slot, uint *label_slot, mp_uint_t max_num_labels);
 
 void emit_bc_set_max_num_labels(emit_t *emit, mp_uint_t max_num_labels);
+#if MICROPY_COMP_STREAMING
+void emit_bc_start_segments(emit_t *emit);
+void emit_bc_end_segments(emit_t *emit);
+#endif
 
 void emit_bc_free(emit_t *emit);
 void emit_native_x64_free(emit_t *emit);
@@ -262,6 +270,10 @@ void mp_emit_bc_end_finally(emit_t *emit);
 void mp_emit_bc_get_iter(emit_t *emit, bool use_stack);
 void mp_emit_bc_for_iter(emit_t *emit, mp_uint_t label);
 void mp_emit_bc_for_iter_end(emit_t *emit);
+#if MICROPY_OPT_COUNTED_RANGE_LOOP
+void mp_emit_bc_get_iter_range(emit_t *emit, mp_uint_t n_args);
+void mp_emit_bc_for_iter_range(emit_t *emit, mp_uint_t label);
+#endif
 void mp_emit_bc_pop_except_jump(emit_t *emit, mp_uint_t label, bool within_exc_handler);
 void mp_emit_bc_unary_op(emit_t *emit, mp_unary_op_t op);
 void mp_emit_bc_binary_op(emit_t *emit, mp_binary_op_t op);
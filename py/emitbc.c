@@ -40,6 +40,24 @@
 
 #define DUMMY_DATA_SIZE (MP_ENCODE_UINT_MAX_BYTES)
 
+#if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+// Opcode sequences tracked by the peephole stage, which may be fused with the
+// opcode(s) that follow them into a superinstruction.
+enum {
+    PEEP_NONE,
+    PEEP_LOAD_FAST, // LOAD_FAST local
+    PEEP_LOAD_FAST_CONST, // LOAD_FAST local; LOAD_CONST_SMALL_INT arg
+    PEEP_LOAD_FAST_CONST_OP, // LOAD_FAST local; LOAD_CONST_SMALL_INT arg; BINARY_OP INPLACE_ADD/SUBTRACT
+    PEEP_COMPARE, // BINARY_OP op, where op is a comparison
+    PEEP_DUP_TOP, // DUP_TOP
+    PEEP_DUP_TOP_CONST, // DUP_TOP; LOAD_CONST_SMALL_INT arg
+    PEEP_DUP_TOP_CONST_COMPARE, // DUP_TOP; LOAD_CONST_SMALL_INT arg; BINARY_OP op
+    PEEP_DUP_TOP_TWO, // DUP_TOP_TWO
+    PEEP_DUP_TOP_TWO_ROT_TWO, // DUP_TOP_TWO; ROT_TWO
+    PEEP_DUP_TOP_TWO_ROT_TWO_COMPARE, // DUP_TOP_TWO; ROT_TWO; BINARY_OP op
+};
+#endif
+
 struct _emit_t {
     // Accessed as mp_obj_t, so must be aligned as such, and we rely on the
     // memory allocator returning a suitably aligned pointer.
@@ -69,10 +87,38 @@ struct _emit_t {
     size_t bytecode_offset;
     size_t bytecode_size;
     byte *code_base; // stores both byte code and code info
+    byte *bytecode_base; // start of the byte code
     bool overflow;
 
     size_t n_info;
     size_t n_cell;
+
+    #if MICROPY_COMP_STREAMING
+    // A scope can be emitted as a sequence of segments, each compiled separately
+    // with its own passes, which are concatenated by emit_bc_end_segments.  The
+    // code info (just line numbers) and byte code of the segments then have their
+    // own buffers, and these record where the current segment starts.
+    bool segmented;
+    mp_uint_t segment_source_line_offset;
+    mp_uint_t segment_source_line;
+    size_t segment_code_info_offset;
+    size_t segment_bytecode_offset;
+    size_t code_info_alloc;
+    size_t bytecode_alloc;
+    #endif
+
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    // The sequence of opcodes just emitted that may be fused with the next one,
+    // the bytecode offset it starts at, and its operands.  This is reset by any
+    // write of bytecode and by anything that ends a straight-line sequence of
+    // opcodes (a label or new line-number entry), so decisions are the same on
+    // each pass and fused opcodes never contain a jump target.
+    uint8_t peep_kind;
+    uint8_t peep_local;
+    uint8_t peep_op;
+    size_t peep_offset;
+    mp_int_t peep_arg;
+    #endif
 };
 
 emit_t *emit_bc_new(mp_emit_common_t *emit_common) {
@@ -82,11 +128,19 @@ emit_t *emit_bc_new(mp_emit_common_t *emit_common) {
 }
 
 void emit_bc_set_max_num_labels(emit_t *emit, mp_uint_t max_num_labels) {
-    emit->max_num_labels = max_num_labels;
-    emit->label_offsets = m_new(size_t, emit->max_num_labels);
+    if (max_num_labels > emit->max_num_labels) {
+        emit->label_offsets = m_renew(size_t, emit->label_offsets, emit->max_num_labels, max_num_labels);
+        emit->max_num_labels = max_num_labels;
+    }
 }
 
 void emit_bc_free(emit_t *emit) {
+    #if MICROPY_COMP_STREAMING
+    if (emit->segmented) {
+        m_del(byte, emit->code_base, emit->code_info_alloc);
+        m_del(byte, emit->bytecode_base, emit->bytecode_alloc);
+    }
+    #endif
     m_del(size_t, emit->label_offsets, emit->max_num_labels);
     m_del_obj(emit_t, emit);
 }
@@ -145,6 +199,9 @@ static void emit_write_code_info_bytes_lines(emit_t *emit, mp_uint_t bytes_to_sk
 // all functions must go through this one to emit byte code
 static uint8_t *emit_get_cur_to_write_bytecode(void *emit_in, size_t num_bytes_to_write) {
     emit_t *emit = emit_in;
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    emit->peep_kind = PEEP_NONE;
+    #endif
     if (emit->suppress) {
         return emit->dummy_data;
     }
@@ -153,7 +210,7 @@ static uint8_t *emit_get_cur_to_write_bytecode(void *emit_in, size_t num_bytes_t
         return emit->dummy_data;
     } else {
         assert(emit->bytecode_offset + num_bytes_to_write <= emit->bytecode_size);
-        byte *c = emit->code_base + emit->code_info_size + emit->bytecode_offset;
+        byte *c = emit->bytecode_base + emit->bytecode_offset;
         emit->bytecode_offset += num_bytes_to_write;
         return c;
     }
@@ -171,9 +228,7 @@ static void emit_write_bytecode_byte(emit_t *emit, int stack_adj, byte b1) {
 }
 
 // Similar to mp_encode_uint(), just some extra handling to encode sign
-static void emit_write_bytecode_byte_int(emit_t *emit, int stack_adj, byte b1, mp_int_t num) {
-    emit_write_bytecode_byte(emit, stack_adj, b1);
-
+static void emit_write_bytecode_int(emit_t *emit, mp_int_t num) {
     // We store each 7 bits in a separate byte, and that's how many bytes needed
     byte buf[MP_ENCODE_UINT_MAX_BYTES];
     byte *p = buf + sizeof(buf);
@@ -197,6 +252,11 @@ static void emit_write_bytecode_byte_int(emit_t *emit, int stack_adj, byte b1, m
     *c = *p;
 }
 
+static void emit_write_bytecode_byte_int(emit_t *emit, int stack_adj, byte b1, mp_int_t num) {
+    emit_write_bytecode_byte(emit, stack_adj, b1);
+    emit_write_bytecode_int(emit, num);
+}
+
 static void emit_write_bytecode_byte_uint(emit_t *emit, int stack_adj, byte b, mp_uint_t val) {
     emit_write_bytecode_byte(emit, stack_adj, b);
     mp_encode_uint(emit, emit_get_cur_to_write_bytecode, val);
@@ -235,7 +295,12 @@ static void emit_write_bytecode_byte_label(emit_t *emit, int stack_adj, byte b1,
     }
 
     // Determine if the jump offset is signed or unsigned, based on the opcode.
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    const bool is_signed = b1 <= MP_BC_POP_JUMP_IF_FALSE
+        || b1 == MP_BC_FOR_RANGE_JUMP || b1 == MP_BC_FOR_RANGE_CONST_JUMP;
+    #else
     const bool is_signed = b1 <= MP_BC_POP_JUMP_IF_FALSE;
+    #endif
 
     // Default to a 2-byte encoding (the largest) with an unknown jump offset.
     unsigned int jump_encoding_size = 1;
@@ -280,34 +345,63 @@ static void emit_write_bytecode_byte_label(emit_t *emit, int stack_adj, byte b1,
     }
 }
 
+#if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+// Record that the opcode just emitted, or the sequence ending with it, may be
+// fused with what follows.  Nothing is recorded for dead code.
+static void emit_peep_set(emit_t *emit, uint8_t kind, size_t offset) {
+    if (!emit->suppress) {
+        emit->peep_kind = kind;
+        emit->peep_offset = offset;
+    }
+}
+#endif
+
+// Write local state size, exception stack size, scope flags and number of arguments
+static void emit_write_code_info_prelude_sig(emit_t *emit, scope_t *scope) {
+    mp_uint_t n_state = scope->num_locals + scope->stack_size;
+    if (n_state == 0) {
+        // Need at least 1 entry in the state, in the case an exception is
+        // propagated through this function, the exception is returned in
+        // the highest slot in the state (fastn[0], see vm.c).
+        n_state = 1;
+    }
+    #if MICROPY_DEBUG_VM_STACK_OVERFLOW
+    // An extra slot in the stack is needed to detect VM stack overflow
+    n_state += 1;
+    #endif
+
+    size_t n_exc_stack = scope->exc_stack_size;
+    MP_BC_PRELUDE_SIG_ENCODE(n_state, n_exc_stack, scope, emit_write_code_info_byte, emit);
+}
+
 void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     emit->pass = pass;
     emit->stack_size = 0;
     emit->suppress = false;
     emit->scope = scope;
+    emit->overflow = false;
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    emit->peep_kind = PEEP_NONE;
+    #endif
+
+    #if MICROPY_COMP_STREAMING
+    if (emit->segmented) {
+        // Carry on from the end of the previous segment.  The prelude is written
+        // when the segments are joined together.
+        emit->last_source_line_offset = emit->segment_source_line_offset;
+        emit->last_source_line = emit->segment_source_line;
+        emit->bytecode_offset = emit->segment_bytecode_offset;
+        emit->code_info_offset = emit->segment_code_info_offset;
+        return;
+    }
+    #endif
+
     emit->last_source_line_offset = 0;
     emit->last_source_line = 1;
     emit->bytecode_offset = 0;
     emit->code_info_offset = 0;
-    emit->overflow = false;
-
-    // Write local state size, exception stack size, scope flags and number of arguments
-    {
-        mp_uint_t n_state = scope->num_locals + scope->stack_size;
-        if (n_state == 0) {
-            // Need at least 1 entry in the state, in the case an exception is
-            // propagated through this function, the exception is returned in
-            // the highest slot in the state (fastn[0], see vm.c).
-            n_state = 1;
-        }
-        #if MICROPY_DEBUG_VM_STACK_OVERFLOW
-        // An extra slot in the stack is needed to detect VM stack overflow
-        n_state += 1;
-        #endif
 
-        size_t n_exc_stack = scope->exc_stack_size;
-        MP_BC_PRELUDE_SIG_ENCODE(n_state, n_exc_stack, scope, emit_write_code_info_byte, emit);
-    }
+    emit_write_code_info_prelude_sig(emit, scope);
 
     // Write number of cells and size of the source code info
     if (emit->pass >= MP_PASS_CODE_SIZE) {
@@ -347,6 +441,123 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     }
 }
 
+#if MICROPY_COMP_STREAMING
+void emit_bc_start_segments(emit_t *emit) {
+    emit->segmented = true;
+    emit->segment_source_line_offset = 0;
+    emit->segment_source_line = 1;
+    emit->segment_code_info_offset = 0;
+    emit->segment_bytecode_offset = 0;
+    emit->code_info_size = 0;
+    emit->bytecode_size = 0;
+}
+
+static byte *emit_bc_grow_segment_buffer(byte *buf, size_t *alloc, size_t size) {
+    if (size > *alloc) {
+        // grow by half as much again, so that appending many segments is cheap
+        size_t new_alloc = size + size / 2;
+        buf = m_renew(byte, buf, *alloc, new_alloc);
+        *alloc = new_alloc;
+    }
+    return buf;
+}
+
+static bool emit_bc_end_segment_pass(emit_t *emit) {
+    if (emit->pass == MP_PASS_CODE_SIZE) {
+        // make room for this segment after the previous ones
+        emit->code_info_size = emit->code_info_offset;
+        emit->bytecode_size = emit->bytecode_offset;
+        emit->code_base = emit_bc_grow_segment_buffer(emit->code_base, &emit->code_info_alloc, emit->code_info_size);
+        emit->bytecode_base = emit_bc_grow_segment_buffer(emit->bytecode_base, &emit->bytecode_alloc, emit->bytecode_size);
+    } else if (emit->pass == MP_PASS_EMIT) {
+        // as in mp_emit_bc_end_pass, the segment can shrink, requiring another pass
+        if (emit->code_info_offset != emit->code_info_size
+            || emit->bytecode_offset != emit->bytecode_size) {
+            emit->code_info_size = emit->code_info_offset;
+            emit->bytecode_size = emit->bytecode_offset;
+            return false;
+        }
+
+        if (emit->overflow) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("bytecode overflow"));
+        }
+
+        // the next segment follows on from this one
+        emit->segment_source_line_offset = emit->last_source_line_offset;
+        emit->segment_source_line = emit->last_source_line;
+        emit->segment_code_info_offset = emit->code_info_offset;
+        emit->segment_bytecode_offset = emit->bytecode_offset;
+    }
+    return true;
+}
+
+// Write the prelude for a scope made of segments, which has no arguments or cells.
+static void emit_write_code_info_segments_prelude(emit_t *emit, scope_t *scope, size_t n_info) {
+    emit->code_info_offset = 0;
+    emit_write_code_info_prelude_sig(emit, scope);
+    size_t n_cell = 0;
+    MP_BC_PRELUDE_SIZE_ENCODE(n_info, n_cell, emit_write_code_info_byte, emit);
+    emit_write_code_info_qstr(emit, scope->simple_name);
+}
+
+// Join the segments emitted so far into the final code for the scope, with the
+// prelude in front, and assign it to the raw code of the scope.  The children of
+// the scope are those in the emit common state as at the end of the last segment.
+void emit_bc_end_segments(emit_t *emit) {
+    scope_t *scope = emit->scope;
+    assert(scope->num_pos_args + scope->num_kwonly_args == 0);
+    byte *line_info = emit->code_base;
+    size_t line_info_len = emit->segment_code_info_offset;
+    byte *bytecode = emit->bytecode_base;
+    size_t bytecode_len = emit->segment_bytecode_offset;
+
+    // the source code info is the name of the scope followed by the line info
+    emit->pass = MP_PASS_CODE_SIZE;
+    emit->code_info_offset = 0;
+    emit_write_code_info_qstr(emit, scope->simple_name);
+    size_t n_info = emit->code_info_offset + line_info_len;
+
+    // compute the size of the prelude, then write it at the start of the code
+    emit_write_code_info_segments_prelude(emit, scope, n_info);
+    size_t prelude_len = emit->code_info_offset;
+    size_t code_len = prelude_len + line_info_len + bytecode_len;
+    emit->pass = MP_PASS_EMIT;
+    emit->code_base = m_new(byte, code_len);
+    emit->code_info_size = prelude_len;
+    emit_write_code_info_segments_prelude(emit, scope, n_info);
+    memcpy(emit->code_base + prelude_len, line_info, line_info_len);
+    memcpy(emit->code_base + prelude_len + line_info_len, bytecode, bytecode_len);
+
+    m_del(byte, line_info, emit->code_info_alloc);
+    m_del(byte, bytecode, emit->bytecode_alloc);
+    emit->segmented = false;
+
+    #if MICROPY_DEBUG_PRINTERS
+    scope->raw_code_data_len = code_len;
+    #endif
+
+    mp_emit_glue_assign_bytecode(scope->raw_code, emit->code_base,
+        emit->emit_common->children,
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        code_len,
+        emit->emit_common->ct_cur_child,
+        #endif
+        scope->scope_flags);
+}
+#endif
+
+// Whether the bytecode of a scope is likely to outlive the compilation.  The
+// code of a function is, but module-level code, and any class body or
+// comprehension that it runs, is run once and then becomes garbage.
+static bool emit_bc_scope_is_long_lived(scope_t *scope) {
+    for (; scope != NULL; scope = scope->parent) {
+        if (scope->kind == SCOPE_FUNCTION || scope->kind == SCOPE_LAMBDA) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool mp_emit_bc_end_pass(emit_t *emit) {
     if (emit->pass == MP_PASS_SCOPE) {
         return true;
@@ -355,6 +566,12 @@ bool mp_emit_bc_end_pass(emit_t *emit) {
     // check stack is back to zero size
     assert(emit->stack_size == 0);
 
+    #if MICROPY_COMP_STREAMING
+    if (emit->segmented) {
+        return emit_bc_end_segment_pass(emit);
+    }
+    #endif
+
     // Calculate size of source code info section
     emit->n_info = emit->code_info_offset - emit->n_info;
 
@@ -373,7 +590,14 @@ bool mp_emit_bc_end_pass(emit_t *emit) {
         // calculate size of total code-info + bytecode, in bytes
         emit->code_info_size = emit->code_info_offset;
         emit->bytecode_size = emit->bytecode_offset;
-        emit->code_base = m_new0(byte, emit->code_info_size + emit->bytecode_size);
+        size_t code_len = emit->code_info_size + emit->bytecode_size;
+        if (emit_bc_scope_is_long_lived(emit->scope)) {
+            emit->code_base = m_new_long_lived(byte, code_len);
+            memset(emit->code_base, 0, code_len);
+        } else {
+            emit->code_base = m_new0(byte, code_len);
+        }
+        emit->bytecode_base = emit->code_base + emit->code_info_size;
 
     } else if (emit->pass == MP_PASS_EMIT) {
         // Code info and/or bytecode can shrink during this pass.
@@ -386,6 +610,7 @@ bool mp_emit_bc_end_pass(emit_t *emit) {
             // compiler to do another pass with these updated sizes.
             emit->code_info_size = emit->code_info_offset;
             emit->bytecode_size = emit->bytecode_offset;
+            emit->bytecode_base = emit->code_base + emit->code_info_size;
             return false;
         }
 
@@ -436,6 +661,10 @@ void mp_emit_bc_set_source_line(emit_t *emit, mp_uint_t source_line) {
         emit_write_code_info_bytes_lines(emit, bytes_to_skip, lines_to_skip);
         emit->last_source_line_offset = emit->bytecode_offset;
         emit->last_source_line = source_line;
+        #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+        // Don't fuse opcodes across the start of a line.
+        emit->peep_kind = PEEP_NONE;
+        #endif
     }
     #else
     (void)emit;
@@ -448,6 +677,11 @@ void mp_emit_bc_label_assign(emit_t *emit, mp_uint_t l) {
     // should be emitted (until another unconditional flow control).
     emit->suppress = false;
 
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    // A label can be jumped to so must not end up inside a superinstruction.
+    emit->peep_kind = PEEP_NONE;
+    #endif
+
     if (emit->pass == MP_PASS_SCOPE) {
         return;
     }
@@ -486,6 +720,9 @@ void mp_emit_bc_load_const_tok(emit_t *emit, mp_token_kind_t tok) {
 
 void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     assert(MP_SMALL_INT_FITS(arg));
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    uint8_t peep_kind = emit->peep_kind;
+    #endif
     if (-MP_BC_LOAD_CONST_SMALL_INT_MULTI_EXCESS <= arg
         && arg < MP_BC_LOAD_CONST_SMALL_INT_MULTI_NUM - MP_BC_LOAD_CONST_SMALL_INT_MULTI_EXCESS) {
         emit_write_bytecode_byte(emit, 1,
@@ -493,6 +730,12 @@ void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     } else {
         emit_write_bytecode_byte_int(emit, 1, MP_BC_LOAD_CONST_SMALL_INT, arg);
     }
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    if (peep_kind == PEEP_LOAD_FAST || peep_kind == PEEP_DUP_TOP) {
+        emit_peep_set(emit, peep_kind + 1, emit->peep_offset);
+        emit->peep_arg = arg;
+    }
+    #endif
 }
 
 void mp_emit_bc_load_const_str(emit_t *emit, qstr qst) {
@@ -511,11 +754,29 @@ void mp_emit_bc_load_local(emit_t *emit, qstr qst, mp_uint_t local_num, int kind
     MP_STATIC_ASSERT(MP_BC_LOAD_FAST_N + MP_EMIT_IDOP_LOCAL_FAST == MP_BC_LOAD_FAST_N);
     MP_STATIC_ASSERT(MP_BC_LOAD_FAST_N + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_LOAD_DEREF);
     (void)qst;
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 15
+        && emit->peep_kind == PEEP_LOAD_FAST && emit->peep_local <= 15) {
+        // LOAD_FAST a; LOAD_FAST b -> LOAD_FAST_PAIR ab
+        byte b = emit->peep_local << 4 | local_num;
+        emit->bytecode_offset = emit->peep_offset;
+        emit_write_bytecode_byte(emit, 1, MP_BC_LOAD_FAST_PAIR);
+        emit_write_bytecode_raw_byte(emit, b);
+        return;
+    }
+    size_t offset = emit->bytecode_offset;
+    #endif
     if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 15) {
         emit_write_bytecode_byte(emit, 1, MP_BC_LOAD_FAST_MULTI + local_num);
     } else {
         emit_write_bytecode_byte_uint(emit, 1, MP_BC_LOAD_FAST_N + kind, local_num);
     }
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 0x7f) {
+        emit_peep_set(emit, PEEP_LOAD_FAST, offset);
+        emit->peep_local = local_num;
+    }
+    #endif
 }
 
 void mp_emit_bc_load_global(emit_t *emit, qstr qst, int kind) {
@@ -562,6 +823,21 @@ void mp_emit_bc_store_local(emit_t *emit, qstr qst, mp_uint_t local_num, int kin
     MP_STATIC_ASSERT(MP_BC_STORE_FAST_N + MP_EMIT_IDOP_LOCAL_FAST == MP_BC_STORE_FAST_N);
     MP_STATIC_ASSERT(MP_BC_STORE_FAST_N + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_STORE_DEREF);
     (void)qst;
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST
+        && emit->peep_kind == PEEP_LOAD_FAST_CONST_OP && emit->peep_local == local_num) {
+        // LOAD_FAST a; LOAD_CONST_SMALL_INT n; BINARY_OP INPLACE_ADD/SUBTRACT; STORE_FAST a
+        //  -> INCR_FAST a n
+        // The top bit of the local number selects subtraction.
+        byte b = local_num | (emit->peep_op == MP_BINARY_OP_INPLACE_SUBTRACT ? 0x80 : 0);
+        mp_int_t arg = emit->peep_arg;
+        emit->bytecode_offset = emit->peep_offset;
+        emit_write_bytecode_byte(emit, -1, MP_BC_INCR_FAST);
+        emit_write_bytecode_raw_byte(emit, b);
+        emit_write_bytecode_int(emit, arg);
+        return;
+    }
+    #endif
     if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 15) {
         emit_write_bytecode_byte(emit, -1, MP_BC_STORE_FAST_MULTI + local_num);
     } else {
@@ -590,10 +866,16 @@ void mp_emit_bc_delete_global(emit_t *emit, qstr qst, int kind) {
 
 void mp_emit_bc_dup_top(emit_t *emit) {
     emit_write_bytecode_byte(emit, 1, MP_BC_DUP_TOP);
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    emit_peep_set(emit, PEEP_DUP_TOP, emit->bytecode_offset - 1);
+    #endif
 }
 
 void mp_emit_bc_dup_top_two(emit_t *emit) {
     emit_write_bytecode_byte(emit, 2, MP_BC_DUP_TOP_TWO);
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    emit_peep_set(emit, PEEP_DUP_TOP_TWO, emit->bytecode_offset - 1);
+    #endif
 }
 
 void mp_emit_bc_pop_top(emit_t *emit) {
@@ -601,7 +883,15 @@ void mp_emit_bc_pop_top(emit_t *emit) {
 }
 
 void mp_emit_bc_rot_two(emit_t *emit) {
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    uint8_t peep_kind = emit->peep_kind;
+    #endif
     emit_write_bytecode_byte(emit, 0, MP_BC_ROT_TWO);
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    if (peep_kind == PEEP_DUP_TOP_TWO) {
+        emit_peep_set(emit, PEEP_DUP_TOP_TWO_ROT_TWO, emit->peep_offset);
+    }
+    #endif
 }
 
 void mp_emit_bc_rot_three(emit_t *emit) {
@@ -614,6 +904,37 @@ void mp_emit_bc_jump(emit_t *emit, mp_uint_t label) {
 }
 
 void mp_emit_bc_pop_jump_if(emit_t *emit, bool cond, mp_uint_t label) {
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    uint8_t peep_kind = emit->peep_kind;
+    byte op = emit->peep_op;
+    if (cond && peep_kind == PEEP_DUP_TOP_CONST_COMPARE) {
+        // DUP_TOP; LOAD_CONST_SMALL_INT n; BINARY_OP op; POP_JUMP_IF_TRUE label
+        //  -> FOR_RANGE_CONST_JUMP label op n
+        mp_int_t arg = emit->peep_arg;
+        emit->bytecode_offset = emit->peep_offset;
+        emit_write_bytecode_byte_label(emit, -1, MP_BC_FOR_RANGE_CONST_JUMP, label);
+        emit_write_bytecode_raw_byte(emit, op);
+        emit_write_bytecode_int(emit, arg);
+        return;
+    }
+    if (cond && peep_kind == PEEP_DUP_TOP_TWO_ROT_TWO_COMPARE) {
+        // DUP_TOP_TWO; ROT_TWO; BINARY_OP op; POP_JUMP_IF_TRUE label
+        //  -> FOR_RANGE_JUMP label op
+        emit->bytecode_offset = emit->peep_offset;
+        emit_write_bytecode_byte_label(emit, -1, MP_BC_FOR_RANGE_JUMP, label);
+        emit_write_bytecode_raw_byte(emit, op);
+        return;
+    }
+    if (peep_kind == PEEP_COMPARE || peep_kind == PEEP_DUP_TOP_CONST_COMPARE
+        || peep_kind == PEEP_DUP_TOP_TWO_ROT_TWO_COMPARE) {
+        // BINARY_OP op; POP_JUMP_IF_TRUE/FALSE label -> COMPARE_POP_JUMP label op
+        // The comparison is always the last opcode of the sequence.
+        emit->bytecode_offset -= 1;
+        emit_write_bytecode_byte_label(emit, -1, MP_BC_COMPARE_POP_JUMP, label);
+        emit_write_bytecode_raw_byte(emit, op | (cond ? MP_BC_COMPARE_POP_JUMP_IF_TRUE : 0));
+        return;
+    }
+    #endif
     if (cond) {
         emit_write_bytecode_byte_label(emit, -1, MP_BC_POP_JUMP_IF_TRUE, label);
     } else {
@@ -683,6 +1004,18 @@ void mp_emit_bc_for_iter_end(emit_t *emit) {
     mp_emit_bc_adjust_stack_size(emit, -MP_OBJ_ITER_BUF_NSLOTS);
 }
 
+#if MICROPY_OPT_COUNTED_RANGE_LOOP
+void mp_emit_bc_get_iter_range(emit_t *emit, mp_uint_t n_args) {
+    // The range function and its arguments are replaced by the loop state.
+    int stack_adj = MP_OBJ_ITER_BUF_NSLOTS - 1 - n_args;
+    emit_write_bytecode_byte_uint(emit, stack_adj, MP_BC_GET_ITER_RANGE, n_args);
+}
+
+void mp_emit_bc_for_iter_range(emit_t *emit, mp_uint_t label) {
+    emit_write_bytecode_byte_label(emit, 1, MP_BC_FOR_ITER_RANGE, label);
+}
+#endif
+
 void mp_emit_bc_pop_except_jump(emit_t *emit, mp_uint_t label, bool within_exc_handler) {
     (void)within_exc_handler;
     emit_write_bytecode_byte_label(emit, 0, MP_BC_POP_EXCEPT_JUMP, label);
@@ -702,10 +1035,27 @@ void mp_emit_bc_binary_op(emit_t *emit, mp_binary_op_t op) {
         invert = true;
         op = MP_BINARY_OP_IS;
     }
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    uint8_t peep_kind = emit->peep_kind;
+    #endif
     emit_write_bytecode_byte(emit, -1, MP_BC_BINARY_OP_MULTI + op);
     if (invert) {
         emit_write_bytecode_byte(emit, 0, MP_BC_UNARY_OP_MULTI + MP_UNARY_OP_NOT);
     }
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    if (op <= MP_BINARY_OP_NOT_EQUAL) {
+        if (peep_kind == PEEP_DUP_TOP_CONST || peep_kind == PEEP_DUP_TOP_TWO_ROT_TWO) {
+            emit_peep_set(emit, peep_kind + 1, emit->peep_offset);
+        } else {
+            emit_peep_set(emit, PEEP_COMPARE, emit->bytecode_offset - 1);
+        }
+        emit->peep_op = op;
+    } else if ((op == MP_BINARY_OP_INPLACE_ADD || op == MP_BINARY_OP_INPLACE_SUBTRACT)
+               && peep_kind == PEEP_LOAD_FAST_CONST) {
+        emit_peep_set(emit, PEEP_LOAD_FAST_CONST_OP, emit->peep_offset);
+        emit->peep_op = op;
+    }
+    #endif
 }
 
 void mp_emit_bc_build(emit_t *emit, mp_uint_t n_args, int kind) {
@@ -866,6 +1216,10 @@ const emit_method_table_t emit_bc_method_table = {
     mp_emit_bc_get_iter,
     mp_emit_bc_for_iter,
     mp_emit_bc_for_iter_end,
+    #if MICROPY_OPT_COUNTED_RANGE_LOOP
+    mp_emit_bc_get_iter_range,
+    mp_emit_bc_for_iter_range,
+    #endif
     mp_emit_bc_pop_except_jump,
     mp_emit_bc_unary_op,
     mp_emit_bc_binary_op,
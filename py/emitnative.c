@@ -230,6 +230,7 @@ typedef enum {
 
     VTYPE_UNBOUND = 0x60 | MP_NATIVE_TYPE_OBJ,
     VTYPE_BUILTIN_CAST = 0x70 | MP_NATIVE_TYPE_OBJ,
+    VTYPE_BUILTIN_SIMD = 0x80 | MP_NATIVE_TYPE_OBJ,
 } vtype_kind_t;
 
 static qstr vtype_to_qstr(vtype_kind_t vtype) {
@@ -275,6 +276,29 @@ typedef struct _exc_stack_entry_t {
     uint16_t is_active : 1;
 } exc_stack_entry_t;
 
+// Value of local_reg for a local that is not held in a register
+#define LOCAL_REG_NONE (0xff)
+
+#if MICROPY_EMIT_NATIVE_REG_ALLOC
+
+#define LIVE_POS_NONE ((mp_uint_t)-1)
+
+// How much more an access to a local within a loop counts, per level of nesting
+#define LIVE_WEIGHT_LOOP (8)
+#define LIVE_WEIGHT_MAX ((mp_uint_t)-1 / LIVE_WEIGHT_LOOP)
+
+// The live range of a local, in units of accesses to locals, labels and jumps
+// during MP_PASS_STACK_SIZE.  It runs from the first to the last access, extended
+// to cover all of any loop that it's used in.
+typedef struct _local_live_t {
+    mp_uint_t start;
+    mp_uint_t end;
+    mp_uint_t last_use;
+    mp_uint_t weight;
+} local_live_t;
+
+#endif
+
 struct _emit_t {
     mp_emit_common_t *emit_common;
     mp_obj_t *error_slot;
@@ -286,6 +310,13 @@ struct _emit_t {
 
     mp_uint_t local_vtype_alloc;
     vtype_kind_t *local_vtype;
+    uint8_t *local_reg;
+
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    local_live_t *local_live;
+    mp_uint_t live_pos;
+    mp_uint_t *label_live_pos;
+    #endif
 
     mp_uint_t stack_info_alloc;
     stack_info_t *stack_info;
@@ -326,10 +357,18 @@ emit_t *EXPORT_FUN(new)(mp_emit_common_t * emit_common, mp_obj_t *error_slot, ui
     emit->exc_stack = m_new(exc_stack_entry_t, emit->exc_stack_alloc);
     emit->as = m_new0(ASM_T, 1);
     mp_asm_base_init(&emit->as->base, max_num_labels);
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    emit->label_live_pos = m_new(mp_uint_t, max_num_labels);
+    #endif
     return emit;
 }
 
 void EXPORT_FUN(free)(emit_t * emit) {
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    m_del(mp_uint_t, emit->label_live_pos, emit->as->base.max_num_labels);
+    m_del(local_live_t, emit->local_live, emit->local_vtype_alloc);
+    #endif
+    m_del(uint8_t, emit->local_reg, emit->local_vtype_alloc);
     mp_asm_base_deinit(&emit->as->base, false);
     m_del_obj(ASM_T, emit->as);
     m_del(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc);
@@ -391,6 +430,149 @@ static void emit_native_mov_reg_qstr_obj(emit_t *emit, int reg_dest, qstr qst) {
         emit_native_mov_state_reg((emit), (local_num), (reg_temp)); \
     } while (false)
 
+#if MICROPY_EMIT_NATIVE_REG_ALLOC
+
+// Start finding the live ranges of the locals, in MP_PASS_STACK_SIZE.  The arguments
+// and closed over variables are live from the start of the function.
+static void emit_native_live_start(emit_t *emit, mp_uint_t num_args) {
+    scope_t *scope = emit->scope;
+    emit->live_pos = 0;
+    for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+        local_live_t *live = &emit->local_live[i];
+        live->start = i < num_args ? 0 : LIVE_POS_NONE;
+        live->end = 0;
+        live->last_use = 0;
+        live->weight = 0;
+    }
+    for (mp_uint_t i = 0; i < scope->id_info_len; i++) {
+        id_info_t *id = &scope->id_info[i];
+        if (id->kind == ID_INFO_KIND_CELL) {
+            emit->local_live[id->local_num].start = 0;
+        }
+    }
+    memset(emit->label_live_pos, 0, emit->as->base.max_num_labels * sizeof(mp_uint_t));
+}
+
+static void emit_native_live_use(emit_t *emit, mp_uint_t local_num) {
+    if (emit->pass == MP_PASS_STACK_SIZE) {
+        local_live_t *live = &emit->local_live[local_num];
+        mp_uint_t pos = ++emit->live_pos;
+        if (live->start == LIVE_POS_NONE) {
+            live->start = pos;
+        }
+        live->end = pos;
+        live->last_use = pos;
+        if (live->weight < LIVE_WEIGHT_MAX) {
+            live->weight += 1;
+        }
+    }
+}
+
+static void emit_native_live_label(emit_t *emit, mp_uint_t label) {
+    if (emit->pass == MP_PASS_STACK_SIZE) {
+        emit->label_live_pos[label] = ++emit->live_pos;
+    }
+}
+
+// A jump back to an earlier label closes a loop: any local used in the loop must
+// keep its value over the whole loop, and is more worth keeping in a register.
+static void emit_native_live_jump(emit_t *emit, mp_uint_t label) {
+    if (emit->pass == MP_PASS_STACK_SIZE && emit->label_live_pos[label] != 0) {
+        mp_uint_t loop_start = emit->label_live_pos[label];
+        mp_uint_t loop_end = ++emit->live_pos;
+        for (mp_uint_t i = 0; i < emit->scope->num_locals; i++) {
+            local_live_t *live = &emit->local_live[i];
+            if (live->start != LIVE_POS_NONE && live->end >= loop_start) {
+                if (live->start > loop_start) {
+                    live->start = loop_start;
+                }
+                live->end = loop_end;
+                if (live->last_use >= loop_start && live->weight < LIVE_WEIGHT_MAX) {
+                    live->weight *= LIVE_WEIGHT_LOOP;
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+// Choose the locals to hold in registers, for the passes after MP_PASS_STACK_SIZE.
+static void emit_native_alloc_local_regs(emit_t *emit) {
+    scope_t *scope = emit->scope;
+    for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+        emit->local_reg[i] = LOCAL_REG_NONE;
+    }
+    if (!CAN_USE_REGS_FOR_LOCALS(emit)) {
+        return;
+    }
+
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    // Linear scan over the live ranges in order of their start.  When there's no
+    // free register the local with the lowest weight goes without, and only viper
+    // locals share registers, because native code can load a local before it's
+    // stored and must then see the value of that local and not another one.
+    #define LIVE_START(live) (emit->do_viper_types ? (live)->start : 0)
+    uint16_t active[MAX_REGS_FOR_LOCAL_VARS];
+    for (int r = 0; r < MAX_REGS_FOR_LOCAL_VARS; r++) {
+        active[r] = 0xffff;
+    }
+    mp_uint_t prev_start = 0;
+    mp_int_t prev_local = -1;
+    for (;;) {
+        // find the next live range, ordered by start then by local number
+        mp_int_t cur = -1;
+        for (mp_uint_t i = 0; i < scope->num_locals; i++) {
+            local_live_t *live = &emit->local_live[i];
+            if (live->start == LIVE_POS_NONE) {
+                continue;
+            }
+            mp_uint_t start = LIVE_START(live);
+            if ((start > prev_start || (start == prev_start && (mp_int_t)i > prev_local))
+                && (cur < 0 || start < LIVE_START(&emit->local_live[cur]))) {
+                cur = i;
+            }
+        }
+        if (cur < 0) {
+            break;
+        }
+        local_live_t *cur_live = &emit->local_live[cur];
+        prev_start = LIVE_START(cur_live);
+        prev_local = cur;
+
+        // free the registers of live ranges that ended before this one starts,
+        // and find the free register, or else the active local with lowest weight
+        int r_cur = -1;
+        for (int r = 0; r < MAX_REGS_FOR_LOCAL_VARS; r++) {
+            if (active[r] != 0xffff && emit->local_live[active[r]].end < LIVE_START(cur_live)) {
+                active[r] = 0xffff;
+            }
+            if (active[r] == 0xffff) {
+                if (r_cur < 0 || active[r_cur] != 0xffff) {
+                    r_cur = r;
+                }
+            } else if (r_cur < 0 || (active[r_cur] != 0xffff
+                                     && emit->local_live[active[r]].weight < emit->local_live[active[r_cur]].weight)) {
+                r_cur = r;
+            }
+        }
+        if (active[r_cur] != 0xffff) {
+            if (emit->local_live[active[r_cur]].weight >= cur_live->weight) {
+                continue;
+            }
+            emit->local_reg[active[r_cur]] = LOCAL_REG_NONE;
+        }
+        active[r_cur] = cur;
+        emit->local_reg[cur] = reg_local_table[r_cur];
+    }
+    #undef LIVE_START
+    #else
+    for (int i = 0; i < MAX_REGS_FOR_LOCAL_VARS && i < scope->num_locals; i++) {
+        emit->local_reg[i] = reg_local_table[i];
+    }
+    #endif
+}
+
 static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     DEBUG_printf("start_pass(pass=%u, scope=%p)\n", pass, scope);
 
@@ -402,6 +584,10 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
     // allocate memory for keeping track of the types of locals
     if (emit->local_vtype_alloc < scope->num_locals) {
         emit->local_vtype = m_renew(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc, scope->num_locals);
+        emit->local_reg = m_renew(uint8_t, emit->local_reg, emit->local_vtype_alloc, scope->num_locals);
+        #if MICROPY_EMIT_NATIVE_REG_ALLOC
+        emit->local_live = m_renew(local_live_t, emit->local_live, emit->local_vtype_alloc, scope->num_locals);
+        #endif
         emit->local_vtype_alloc = scope->num_locals;
     }
 
@@ -433,6 +619,16 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         emit->local_vtype[i] = emit->do_viper_types ? VTYPE_UNBOUND : VTYPE_PYOBJ;
     }
 
+    // the locals to hold in registers are chosen once their live ranges are known
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    if (pass == MP_PASS_STACK_SIZE) {
+        emit_native_live_start(emit, num_args);
+    }
+    #endif
+    if (pass <= MP_PASS_CODE_SIZE) {
+        emit_native_alloc_local_regs(emit);
+    }
+
     // values on stack begin unbound
     for (mp_uint_t i = 0; i < emit->stack_info_alloc; i++) {
         emit->stack_info[i].kind = STACK_VALUE;
@@ -459,17 +655,6 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         // Work out size of state (locals plus stack)
         // n_state counts all stack and locals, even those in registers
         emit->n_state = scope->num_locals + scope->stack_size;
-        int num_locals_in_regs = 0;
-        if (CAN_USE_REGS_FOR_LOCALS(emit)) {
-            num_locals_in_regs = scope->num_locals;
-            if (num_locals_in_regs > MAX_REGS_FOR_LOCAL_VARS) {
-                num_locals_in_regs = MAX_REGS_FOR_LOCAL_VARS;
-            }
-            // Need a spot for REG_LOCAL_LAST (see below)
-            if (scope->num_pos_args >= MAX_REGS_FOR_LOCAL_VARS + 1) {
-                --num_locals_in_regs;
-            }
-        }
 
         // Work out where the locals and Python stack start within the C stack
         if (NEED_GLOBAL_EXC_HANDLER(emit)) {
@@ -483,7 +668,7 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         }
 
         // Entry to function
-        ASM_ENTRY(emit->as, emit->stack_start + emit->n_state - num_locals_in_regs);
+        ASM_ENTRY(emit->as, emit->stack_start + emit->n_state);
 
         #if N_X86
         asm_x86_mov_arg_to_r32(emit->as, 0, REG_PARENT_ARG_1);
@@ -531,15 +716,18 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
                 r = REG_RET;
             }
             // REG_LOCAL_LAST points to the args array so be sure not to overwrite it if it's still needed
-            if (i < MAX_REGS_FOR_LOCAL_VARS && CAN_USE_REGS_FOR_LOCALS(emit) && (i != MAX_REGS_FOR_LOCAL_VARS - 1 || emit->scope->num_pos_args == MAX_REGS_FOR_LOCAL_VARS)) {
-                ASM_MOV_REG_REG(emit->as, reg_local_table[i], r);
+            int reg_local = emit->local_reg[i];
+            if (reg_local != LOCAL_REG_NONE && (reg_local != REG_LOCAL_LAST || i == emit->scope->num_pos_args - 1)) {
+                ASM_MOV_REG_REG(emit->as, reg_local, r);
             } else {
                 emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, i), r);
             }
         }
         // Get local from the stack back into REG_LOCAL_LAST if this reg couldn't be written to above
-        if (emit->scope->num_pos_args >= MAX_REGS_FOR_LOCAL_VARS + 1 && CAN_USE_REGS_FOR_LOCALS(emit)) {
-            ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_LAST, LOCAL_IDX_LOCAL_VAR(emit, MAX_REGS_FOR_LOCAL_VARS - 1));
+        for (int i = 0; i < emit->scope->num_pos_args - 1; i++) {
+            if (emit->local_reg[i] == REG_LOCAL_LAST) {
+                ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_LAST, LOCAL_IDX_LOCAL_VAR(emit, i));
+            }
         }
 
         emit_native_global_exc_entry(emit);
@@ -639,8 +827,10 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
 
         // cache some locals in registers, but only if no exception handlers
         if (CAN_USE_REGS_FOR_LOCALS(emit)) {
-            for (int i = 0; i < MAX_REGS_FOR_LOCAL_VARS && i < scope->num_locals; ++i) {
-                ASM_MOV_REG_LOCAL(emit->as, reg_local_table[i], LOCAL_IDX_LOCAL_VAR(emit, i));
+            for (int i = 0; i < scope->num_locals; ++i) {
+                if (emit->local_reg[i] != LOCAL_REG_NONE) {
+                    ASM_MOV_REG_LOCAL(emit->as, emit->local_reg[i], LOCAL_IDX_LOCAL_VAR(emit, i));
+                }
             }
         }
 
@@ -1171,6 +1361,9 @@ static void emit_native_label_assign(emit_t *emit, mp_uint_t l) {
     // need to commit stack because we can jump here from elsewhere
     need_stack_settled(emit);
     mp_asm_base_label_assign(&emit->as->base, l);
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    emit_native_live_label(emit, l);
+    #endif
     emit_post(emit);
 
     if (is_finally) {
@@ -1420,8 +1613,11 @@ static void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
         EMIT_NATIVE_VIPER_TYPE_ERROR(emit, MP_ERROR_TEXT("local '%q' used before type known"), qst);
     }
     emit_native_pre(emit);
-    if (local_num < MAX_REGS_FOR_LOCAL_VARS && CAN_USE_REGS_FOR_LOCALS(emit)) {
-        emit_post_push_reg(emit, vtype, reg_local_table[local_num]);
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    emit_native_live_use(emit, local_num);
+    #endif
+    if (emit->local_reg[local_num] != LOCAL_REG_NONE) {
+        emit_post_push_reg(emit, vtype, emit->local_reg[local_num]);
     } else {
         need_reg_single(emit, REG_TEMP0, 0);
         emit_native_mov_reg_state(emit, REG_TEMP0, LOCAL_IDX_LOCAL_VAR(emit, local_num));
@@ -1464,6 +1660,14 @@ static void emit_native_load_global(emit_t *emit, qstr qst, int kind) {
                 emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, native_type);
                 return;
             }
+            #if MICROPY_EMIT_NATIVE_SIMD
+            // check for SIMD intrinsics
+            int simd_op = mp_native_simd_from_qstr(qst);
+            if (simd_op >= 0) {
+                emit_post_push_imm(emit, VTYPE_BUILTIN_SIMD, simd_op);
+                return;
+            }
+            #endif
         }
     }
     emit_call_with_qstr_arg(emit, MP_F_LOAD_NAME + kind, qst, REG_ARG_1);
@@ -1644,8 +1848,11 @@ static void emit_native_load_subscr(emit_t *emit) {
 
 static void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     vtype_kind_t vtype;
-    if (local_num < MAX_REGS_FOR_LOCAL_VARS && CAN_USE_REGS_FOR_LOCALS(emit)) {
-        emit_pre_pop_reg(emit, &vtype, reg_local_table[local_num]);
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    emit_native_live_use(emit, local_num);
+    #endif
+    if (emit->local_reg[local_num] != LOCAL_REG_NONE) {
+        emit_pre_pop_reg(emit, &vtype, emit->local_reg[local_num]);
     } else {
         emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
         emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, local_num), REG_TEMP0);
@@ -1998,6 +2205,9 @@ static void emit_native_jump(emit_t *emit, mp_uint_t label) {
     emit_native_pre(emit);
     // need to commit stack because we are jumping elsewhere
     need_stack_settled(emit);
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    emit_native_live_jump(emit, label);
+    #endif
     ASM_JUMP(emit->as, label);
     emit_post(emit);
     mp_asm_base_suppress_code(&emit->as->base);
@@ -2028,6 +2238,9 @@ static void emit_native_jump_helper(emit_t *emit, bool cond, mp_uint_t label, bo
     }
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
+    #if MICROPY_EMIT_NATIVE_REG_ALLOC
+    emit_native_live_jump(emit, label);
+    #endif
     // Emit the jump
     if (cond) {
         ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label, vtype == VTYPE_PYOBJ);
@@ -2270,6 +2483,16 @@ static void emit_native_for_iter(emit_t *emit, mp_uint_t label) {
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
+#if MICROPY_OPT_COUNTED_RANGE_LOOP
+static void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_uint_t n_keyword, mp_uint_t star_flags);
+
+static void emit_native_get_iter_range(emit_t *emit, mp_uint_t n_args) {
+    // There's no counted loop in native code, just iterate over the result of the call.
+    emit_native_call_function(emit, n_args, 0, 0);
+    emit_native_get_iter(emit, true);
+}
+#endif
+
 static void emit_native_for_iter_end(emit_t *emit) {
     // adjust stack counter (we get here from for_iter ending, which popped the value for us)
     emit_native_pre(emit);
@@ -2736,6 +2959,81 @@ static void emit_native_make_closure(emit_t *emit, scope_t *scope, mp_uint_t n_c
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
+#if MICROPY_EMIT_NATIVE_SIMD
+// Viper SIMD intrinsic: simd_xxx(dst, a, b, n) or simd_bswap(dst, src, n), where
+// the pointers all have the same type, which gives the element size, and n is
+// the number of elements.
+static void emit_native_call_simd(emit_t *emit, mp_uint_t n_args) {
+    mp_uint_t op = peek_stack(emit, n_args)->data.u_imm;
+    vtype_kind_t vtype_ptr = VTYPE_PTR_NONE;
+    mp_uint_t size_log2 = 0;
+    bool valid = n_args == (op == MP_NATIVE_SIMD_BSWAP ? 3 : 4);
+    if (valid) {
+        vtype_kind_t vtype_n = peek_vtype(emit, 0);
+        vtype_ptr = peek_vtype(emit, n_args - 1);
+        valid = vtype_n == VTYPE_INT || vtype_n == VTYPE_UINT;
+        for (mp_uint_t i = 1; i < n_args; ++i) {
+            valid = valid && peek_vtype(emit, i) == vtype_ptr;
+        }
+    }
+    if (vtype_ptr == VTYPE_PTR16) {
+        size_log2 = 1;
+    } else if (vtype_ptr == VTYPE_PTR32) {
+        size_log2 = 2;
+    } else if (vtype_ptr != VTYPE_PTR8) {
+        valid = false;
+    }
+    if (op == MP_NATIVE_SIMD_ADD_SAT) {
+        valid = valid && size_log2 <= 1;
+    } else if (op == MP_NATIVE_SIMD_MULHI) {
+        valid = valid && size_log2 == 1;
+    } else if (op == MP_NATIVE_SIMD_BSWAP) {
+        valid = valid && size_log2 >= 1;
+    }
+    if (!valid) {
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+            MP_ERROR_TEXT("can't do SIMD op on '%q'"), vtype_to_qstr(vtype_ptr));
+        adjust_stack(emit, -(mp_int_t)n_args - 1);
+        emit_post_push_imm(emit, VTYPE_PTR_NONE, 0);
+        return;
+    }
+    op |= size_log2 << MP_NATIVE_SIMD_SIZE_SHIFT;
+
+    // The helper function takes the arguments from the Python stack.
+    need_stack_settled(emit);
+    adjust_stack(emit, -(mp_int_t)n_args - 1);
+    mp_uint_t args_local_num = emit->stack_start + emit->stack_size + 1;
+
+    #if N_X64
+    // Process whole 16-byte vectors inline, then let the helper do the rest.
+    static const uint8_t sse2_op[4][3] = {
+        [MP_NATIVE_SIMD_ADD] = {ASM_X64_SSE2_PADDB, ASM_X64_SSE2_PADDW, ASM_X64_SSE2_PADDD},
+        [MP_NATIVE_SIMD_ADD_SAT] = {ASM_X64_SSE2_PADDUSB, ASM_X64_SSE2_PADDUSW},
+        [MP_NATIVE_SIMD_MULHI] = {0, ASM_X64_SSE2_PMULHUW},
+    };
+    mp_uint_t kind = op & ((1 << MP_NATIVE_SIMD_SIZE_SHIFT) - 1);
+    emit_native_mov_reg_state(emit, REG_ARG_1, args_local_num);
+    emit_native_mov_reg_state(emit, REG_ARG_2, args_local_num + 1);
+    emit_native_mov_reg_state(emit, REG_ARG_3, args_local_num + 2);
+    if (kind == MP_NATIVE_SIMD_BSWAP) {
+        ASM_MOV_REG_REG(emit->as, REG_ARG_4, REG_ARG_3);
+        asm_x64_sse2_loop(emit->as, size_log2 == 1 ? ASM_X64_SSE2_BSWAP16 : ASM_X64_SSE2_BSWAP32, 1 << size_log2);
+    } else {
+        emit_native_mov_reg_state(emit, REG_ARG_4, args_local_num + 3);
+        asm_x64_sse2_loop(emit->as, sse2_op[kind][size_log2], 1 << size_log2);
+        emit_native_mov_state_reg(emit, args_local_num + 2, REG_ARG_3);
+    }
+    emit_native_mov_state_reg(emit, args_local_num, REG_ARG_1);
+    emit_native_mov_state_reg(emit, args_local_num + 1, REG_ARG_2);
+    emit_native_mov_state_reg(emit, args_local_num + n_args - 1, REG_ARG_4);
+    #endif
+
+    emit_native_mov_reg_state_addr(emit, REG_ARG_2, args_local_num);
+    emit_call_with_imm_arg(emit, MP_F_VIPER_SIMD, op, REG_ARG_1);
+    emit_post_push_imm(emit, VTYPE_PTR_NONE, 0);
+}
+#endif
+
 static void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_uint_t n_keyword, mp_uint_t star_flags) {
     DEBUG_printf("call_function(n_pos=" UINT_FMT ", n_kw=" UINT_FMT ", star_flags=" UINT_FMT ")\n", n_positional, n_keyword, star_flags);
 
@@ -2744,6 +3042,13 @@ static void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_u
 
     emit_native_pre(emit);
     vtype_kind_t vtype_fun = peek_vtype(emit, n_positional + 2 * n_keyword);
+    #if MICROPY_EMIT_NATIVE_SIMD
+    if (vtype_fun == VTYPE_BUILTIN_SIMD) {
+        assert(n_keyword == 0 && !star_flags);
+        emit_native_call_simd(emit, n_positional);
+        return;
+    }
+    #endif
     if (vtype_fun == VTYPE_BUILTIN_CAST) {
         // casting operator
         assert(n_positional == 1 && n_keyword == 0);
@@ -3016,6 +3321,10 @@ const emit_method_table_t EXPORT_FUN(method_table) = {
     emit_native_get_iter,
     emit_native_for_iter,
     emit_native_for_iter_end,
+    #if MICROPY_OPT_COUNTED_RANGE_LOOP
+    emit_native_get_iter_range,
+    emit_native_for_iter,
+    #endif
     emit_native_pop_except_jump,
     emit_native_unary_op,
     emit_native_binary_op,
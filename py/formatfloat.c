@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
 #include "py/formatfloat.h"
 
 /***********************************************************************
@@ -100,6 +101,1013 @@ static inline int fp_expval(FPTYPE x) {
     return (int)((fb.i >> MP_FLOAT_FRAC_BITS) & (~(0xFFFFFFFF << MP_FLOAT_EXP_BITS))) - MP_FLOAT_EXP_OFFSET;
 }
 
+#if MICROPY_FLOAT_EXACT_CONVERSION
+
+/***********************************************************************
+
+  Correctly rounded conversions between floats and decimal strings.
+
+  The shortest digits that convert back to the same float, used by repr,
+  come from Grisu3 (Florian Loitsch, "Printing Floating-Point Numbers
+  Quickly and Accurately with Integers", PLDI 2010), which works with
+  64-bit integers and a small table of powers of ten and succeeds for all
+  but about 0.5% of doubles.  For those, and for digits at a given
+  precision, the value is converted exactly as in Dragon4, with fixed
+  size bignums on the stack.  These are only a few words long for the
+  magnitudes that are usually printed, so this is cheap too.
+
+  Parsing reads up to 19 significant digits into an integer.  When that
+  and the power of ten are exact floats a single multiply or divide gives
+  the correctly rounded result.  Otherwise it is scaled by a cached power
+  of ten while keeping track of the error, as in the double-conversion
+  library, and only if that cannot decide the rounding is the input
+  compared exactly with the point halfway between the two candidates.
+
+  None of this allocates on the heap.
+
+***********************************************************************/
+
+#define FP_HIDDEN_BIT ((uint64_t)1 << MP_FLOAT_FRAC_BITS)
+#define FP_DENORMAL_EXP (1 - MP_FLOAT_EXP_BIAS - MP_FLOAT_FRAC_BITS)
+#define FP_MAX_EXP ((1 << MP_FLOAT_EXP_BITS) - 2 - MP_FLOAT_EXP_BIAS - MP_FLOAT_FRAC_BITS)
+
+#if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+#define FP_BIGNUM_WORDS (8)
+#define FP_SHORTEST_MAX (12)
+#define FP_EXACT_POW10_MAX (10)
+#define FP_DEC_MAG_MIN (-45)
+#define FP_DEC_MAG_MAX (39)
+#define FP_CACHED_MIN_K (-68)
+#else
+#define FP_BIGNUM_WORDS (36)
+#define FP_SHORTEST_MAX (20)
+#define FP_EXACT_POW10_MAX (22)
+#define FP_DEC_MAG_MIN (-324)
+#define FP_DEC_MAG_MAX (309)
+#define FP_CACHED_MIN_K (-348)
+#endif
+
+// Range of binary exponents of the scaled value in Grisu digit generation.
+#define FP_GRISU_ALPHA (-60)
+#define FP_GRISU_GAMMA (-32)
+
+static const uint32_t fp_pow10_u32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+// Powers of ten which are exactly representable.
+static const FPTYPE fp_pow10_exact[] = {
+    FPCONST(1e0), FPCONST(1e1), FPCONST(1e2), FPCONST(1e3), FPCONST(1e4), FPCONST(1e5),
+    FPCONST(1e6), FPCONST(1e7), FPCONST(1e8), FPCONST(1e9), FPCONST(1e10),
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    #endif
+};
+
+// A 64-bit float without a sign or hidden bit: f * 2^e.
+typedef struct _fp_diy_t {
+    uint64_t f;
+    int e;
+} fp_diy_t;
+
+// 10^k rounded to f * 2^e, with f normalised, for every eighth k.
+typedef struct _fp_cached_power_t {
+    uint64_t f;
+    int16_t e;
+    int16_t k;
+} fp_cached_power_t;
+
+static const fp_cached_power_t fp_cached_powers[] = {
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    {0xfa8fd5a0081c0288, -1220, -348}, {0xbaaee17fa23ebf76, -1193, -340},
+    {0x8b16fb203055ac76, -1166, -332}, {0xcf42894a5dce35ea, -1140, -324},
+    {0x9a6bb0aa55653b2d, -1113, -316}, {0xe61acf033d1a45df, -1087, -308},
+    {0xab70fe17c79ac6ca, -1060, -300}, {0xff77b1fcbebcdc4f, -1034, -292},
+    {0xbe5691ef416bd60c, -1007, -284}, {0x8dd01fad907ffc3c, -980, -276},
+    {0xd3515c2831559a83, -954, -268}, {0x9d71ac8fada6c9b5, -927, -260},
+    {0xea9c227723ee8bcb, -901, -252}, {0xaecc49914078536d, -874, -244},
+    {0x823c12795db6ce57, -847, -236}, {0xc21094364dfb5637, -821, -228},
+    {0x9096ea6f3848984f, -794, -220}, {0xd77485cb25823ac7, -768, -212},
+    {0xa086cfcd97bf97f4, -741, -204}, {0xef340a98172aace5, -715, -196},
+    {0xb23867fb2a35b28e, -688, -188}, {0x84c8d4dfd2c63f3b, -661, -180},
+    {0xc5dd44271ad3cdba, -635, -172}, {0x936b9fcebb25c996, -608, -164},
+    {0xdbac6c247d62a584, -582, -156}, {0xa3ab66580d5fdaf6, -555, -148},
+    {0xf3e2f893dec3f126, -529, -140}, {0xb5b5ada8aaff80b8, -502, -132},
+    {0x87625f056c7c4a8b, -475, -124}, {0xc9bcff6034c13053, -449, -116},
+    {0x964e858c91ba2655, -422, -108}, {0xdff9772470297ebd, -396, -100},
+    {0xa6dfbd9fb8e5b88f, -369, -92}, {0xf8a95fcf88747d94, -343, -84},
+    {0xb94470938fa89bcf, -316, -76},
+    #endif
+    {0x8a08f0f8bf0f156b, -289, -68}, {0xcdb02555653131b6, -263, -60},
+    {0x993fe2c6d07b7fac, -236, -52}, {0xe45c10c42a2b3b06, -210, -44},
+    {0xaa242499697392d3, -183, -36}, {0xfd87b5f28300ca0e, -157, -28},
+    {0xbce5086492111aeb, -130, -20}, {0x8cbccc096f5088cc, -103, -12},
+    {0xd1b71758e219652c, -77, -4}, {0x9c40000000000000, -50, 4},
+    {0xe8d4a51000000000, -24, 12}, {0xad78ebc5ac620000, 3, 20},
+    {0x813f3978f8940984, 30, 28}, {0xc097ce7bc90715b3, 56, 36},
+    {0x8f7e32ce7bea5c70, 83, 44}, {0xd5d238a4abe98068, 109, 52},
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+    {0x9f4f2726179a2245, 136, 60}, {0xed63a231d4c4fb27, 162, 68},
+    {0xb0de65388cc8ada8, 189, 76}, {0x83c7088e1aab65db, 216, 84},
+    {0xc45d1df942711d9a, 242, 92}, {0x924d692ca61be758, 269, 100},
+    {0xda01ee641a708dea, 295, 108}, {0xa26da3999aef774a, 322, 116},
+    {0xf209787bb47d6b85, 348, 124}, {0xb454e4a179dd1877, 375, 132},
+    {0x865b86925b9bc5c2, 402, 140}, {0xc83553c5c8965d3d, 428, 148},
+    {0x952ab45cfa97a0b3, 455, 156}, {0xde469fbd99a05fe3, 481, 164},
+    {0xa59bc234db398c25, 508, 172}, {0xf6c69a72a3989f5c, 534, 180},
+    {0xb7dcbf5354e9bece, 561, 188}, {0x88fcf317f22241e2, 588, 196},
+    {0xcc20ce9bd35c78a5, 614, 204}, {0x98165af37b2153df, 641, 212},
+    {0xe2a0b5dc971f303a, 667, 220}, {0xa8d9d1535ce3b396, 694, 228},
+    {0xfb9b7cd9a4a7443c, 720, 236}, {0xbb764c4ca7a44410, 747, 244},
+    {0x8bab8eefb6409c1a, 774, 252}, {0xd01fef10a657842c, 800, 260},
+    {0x9b10a4e5e9913129, 827, 268}, {0xe7109bfba19c0c9d, 853, 276},
+    {0xac2820d9623bf429, 880, 284}, {0x80444b5e7aa7cf85, 907, 292},
+    {0xbf21e44003acdd2d, 933, 300}, {0x8e679c2f5e44ff8f, 960, 308},
+    {0xd433179d9c8cb841, 986, 316}, {0x9e19db92b4e31ba9, 1013, 324},
+    {0xeb96bf6ebadf77d9, 1039, 332}, {0xaf87023b9bf0ee6b, 1066, 340},
+    #endif
+};
+
+#define FP_CACHED_POWERS_NUM (sizeof(fp_cached_powers) / sizeof(fp_cached_powers[0]))
+
+static int fp_clz64(uint64_t x) {
+    int n = 0;
+    if (!(x >> 32)) {
+        n += 32;
+        x <<= 32;
+    }
+    if (!(x >> 48)) {
+        n += 16;
+        x <<= 16;
+    }
+    if (!(x >> 56)) {
+        n += 8;
+        x <<= 8;
+    }
+    if (!(x >> 60)) {
+        n += 4;
+        x <<= 4;
+    }
+    if (!(x >> 62)) {
+        n += 2;
+        x <<= 2;
+    }
+    if (!(x >> 63)) {
+        n += 1;
+    }
+    return n;
+}
+
+// Returns floor(a * log10(2)), for |a| <= 1650.
+static int fp_floor_log10_pow2(int a) {
+    if (a >= 0) {
+        return (a * 78913) >> 18;
+    } else {
+        return -((-a * 78913) >> 18) - 1;
+    }
+}
+
+// Splits a positive finite f into m * 2^e.
+static uint64_t fp_decompose(FPTYPE f, int *e) {
+    mp_float_union_t fb = {f};
+    uint64_t m = fb.i & (FP_HIDDEN_BIT - 1);
+    int biased = (fb.i >> MP_FLOAT_FRAC_BITS) & ((1 << MP_FLOAT_EXP_BITS) - 1);
+    if (biased == 0) {
+        *e = FP_DENORMAL_EXP;
+        return m;
+    }
+    *e = biased + FP_DENORMAL_EXP - 1;
+    return m | FP_HIDDEN_BIT;
+}
+
+// Returns m * 2^e, which must be exactly representable unless it is out of range.
+static FPTYPE fp_compose(uint64_t m, int e) {
+    while (m >= 2 * FP_HIDDEN_BIT) {
+        m >>= 1;
+        ++e;
+    }
+    while (m != 0 && m < FP_HIDDEN_BIT && e > FP_DENORMAL_EXP) {
+        m <<= 1;
+        --e;
+    }
+    if (m == 0 || e < FP_DENORMAL_EXP) {
+        return 0;
+    }
+    if (e > FP_MAX_EXP) {
+        return (FPTYPE)INFINITY;
+    }
+    mp_float_union_t fb;
+    fb.i = m & (FP_HIDDEN_BIT - 1);
+    if (m >= FP_HIDDEN_BIT) {
+        fb.i |= (mp_float_uint_t)(e - FP_DENORMAL_EXP + 1) << MP_FLOAT_FRAC_BITS;
+    }
+    return fb.f;
+}
+
+static fp_diy_t fp_diy_normalize(uint64_t f, int e) {
+    int shift = fp_clz64(f);
+    fp_diy_t x = {f << shift, e - shift};
+    return x;
+}
+
+// Returns x * y rounded to 64 bits.
+static fp_diy_t fp_diy_mul(fp_diy_t x, fp_diy_t y) {
+    uint64_t a = x.f >> 32, b = x.f & 0xffffffff;
+    uint64_t c = y.f >> 32, d = y.f & 0xffffffff;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t mid = (bd >> 32) + (ad & 0xffffffff) + (bc & 0xffffffff) + ((uint64_t)1 << 31);
+    fp_diy_t r = {ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64};
+    return r;
+}
+
+/******************************************************************************/
+// bignums
+
+typedef struct _fp_bignum_t {
+    size_t len;
+    uint32_t d[FP_BIGNUM_WORDS];
+} fp_bignum_t;
+
+static void bn_set(fp_bignum_t *b, uint64_t v) {
+    b->d[0] = (uint32_t)v;
+    b->d[1] = (uint32_t)(v >> 32);
+    b->len = b->d[1] ? 2 : b->d[0] ? 1 : 0;
+}
+
+static void bn_shl(fp_bignum_t *b, unsigned int n) {
+    if (b->len == 0) {
+        return;
+    }
+    size_t words = n / 32;
+    unsigned int bits = n % 32;
+    assert(b->len + words + 1 <= FP_BIGNUM_WORDS);
+    uint32_t carry = 0;
+    if (bits == 0) {
+        for (size_t i = b->len; i-- > 0;) {
+            b->d[i + words] = b->d[i];
+        }
+    } else {
+        carry = b->d[b->len - 1] >> (32 - bits);
+        for (size_t i = b->len - 1; i > 0; i--) {
+            b->d[i + words] = (b->d[i] << bits) | (b->d[i - 1] >> (32 - bits));
+        }
+        b->d[words] = b->d[0] << bits;
+    }
+    memset(b->d, 0, words * sizeof(uint32_t));
+    b->len += words;
+    if (carry != 0) {
+        b->d[b->len++] = carry;
+    }
+}
+
+static void bn_mul_u32(fp_bignum_t *b, uint32_t m) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < b->len; i++) {
+        carry += (uint64_t)b->d[i] * m;
+        b->d[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry != 0) {
+        assert(b->len < FP_BIGNUM_WORDS);
+        b->d[b->len++] = (uint32_t)carry;
+    }
+}
+
+static void bn_mul_pow10(fp_bignum_t *b, unsigned int n) {
+    // 10^n = 5^n * 2^n, and 5^n is multiplied in as few words as possible
+    unsigned int k = n;
+    for (; k >= 9; k -= 9) {
+        bn_mul_u32(b, 1953125); // 5^9
+    }
+    if (k != 0) {
+        bn_mul_u32(b, fp_pow10_u32[k] >> k);
+    }
+    bn_shl(b, n);
+}
+
+static void bn_add(fp_bignum_t *a, const fp_bignum_t *b) {
+    size_t n = a->len > b->len ? a->len : b->len;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (uint64_t)(i < a->len ? a->d[i] : 0) + (i < b->len ? b->d[i] : 0);
+        a->d[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    a->len = n;
+    if (carry != 0) {
+        assert(a->len < FP_BIGNUM_WORDS);
+        a->d[a->len++] = (uint32_t)carry;
+    }
+}
+
+// Subtracts b from a, which must not be less than b.
+static void bn_sub(fp_bignum_t *a, const fp_bignum_t *b) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < a->len; i++) {
+        uint64_t t = (uint64_t)a->d[i] - (i < b->len ? b->d[i] : 0) - borrow;
+        a->d[i] = (uint32_t)t;
+        borrow = (t >> 32) & 1;
+    }
+    while (a->len > 0 && a->d[a->len - 1] == 0) {
+        a->len--;
+    }
+}
+
+static int bn_cmp(const fp_bignum_t *a, const fp_bignum_t *b) {
+    if (a->len != b->len) {
+        return a->len < b->len ? -1 : 1;
+    }
+    for (size_t i = a->len; i-- > 0;) {
+        if (a->d[i] != b->d[i]) {
+            return a->d[i] < b->d[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// Compares a + b with c.
+static int bn_add_cmp(const fp_bignum_t *a, const fp_bignum_t *b, const fp_bignum_t *c) {
+    fp_bignum_t t = *a;
+    bn_add(&t, b);
+    return bn_cmp(&t, c);
+}
+
+// Returns r / s, which must be less than 10, and sets r to r % s.
+static int bn_divmod(fp_bignum_t *r, const fp_bignum_t *s) {
+    int q = 0;
+    while (bn_cmp(r, s) >= 0) {
+        bn_sub(r, s);
+        ++q;
+    }
+    return q;
+}
+
+/******************************************************************************/
+// exact digit generation
+
+// The value being converted is r / s * 10^(dp - 1), with r / s in [1, 10)
+// once set up.  mplus and mminus are the distances, on the same scale, to the
+// boundaries of the interval of numbers that round to the value.
+typedef struct _fp_dragon_t {
+    fp_bignum_t r, s, mplus, mminus;
+    int dp;
+} fp_dragon_t;
+
+// Sets up d for the value mant * 2^e2, with margins in units of 2^e2.  The
+// upper boundary belongs to the interval if even is true.
+static void fp_dragon_init(fp_dragon_t *d, uint64_t mant, int e2, unsigned int mplus, unsigned int mminus, bool even) {
+    // the value is at least 10^(k - 1) and less than 10^(k + 1)
+    int k = fp_floor_log10_pow2(e2 + 63 - fp_clz64(mant)) + 1;
+    bn_set(&d->r, mant);
+    bn_set(&d->s, 1);
+    bn_set(&d->mplus, mplus);
+    bn_set(&d->mminus, mminus);
+    if (e2 >= 0) {
+        bn_shl(&d->r, e2);
+        bn_shl(&d->mplus, e2);
+        bn_shl(&d->mminus, e2);
+    } else {
+        bn_shl(&d->s, -e2);
+    }
+    if (k >= 0) {
+        bn_mul_pow10(&d->s, k);
+    } else {
+        bn_mul_pow10(&d->r, -k);
+        bn_mul_pow10(&d->mplus, -k);
+        bn_mul_pow10(&d->mminus, -k);
+    }
+    int c = bn_add_cmp(&d->r, &d->mplus, &d->s);
+    if (c > 0 || (c == 0 && even)) {
+        d->dp = k + 1;
+    } else {
+        d->dp = k;
+        bn_mul_u32(&d->r, 10);
+        bn_mul_u32(&d->mplus, 10);
+        bn_mul_u32(&d->mminus, 10);
+    }
+}
+
+// Writes the value rounded to n significant digits, half to even, to buf and
+// returns n.  If n is 0 then the value is rounded to a multiple of 10^dp,
+// giving either no digits or "1".
+static int fp_dragon_digits(fp_dragon_t *d, char *buf, int n) {
+    if (n == 0) {
+        fp_bignum_t half = d->s;
+        bn_mul_u32(&half, 5);
+        if (bn_cmp(&d->r, &half) > 0) {
+            buf[0] = '1';
+            d->dp++;
+            return 1;
+        }
+        return 0;
+    }
+    int digit;
+    for (int i = 0;; i++) {
+        digit = bn_divmod(&d->r, &d->s);
+        if (i == n - 1) {
+            break;
+        }
+        buf[i] = '0' + digit;
+        bn_mul_u32(&d->r, 10);
+    }
+    bn_shl(&d->r, 1);
+    int c = bn_cmp(&d->r, &d->s);
+    if (c > 0 || (c == 0 && (digit & 1))) {
+        ++digit;
+    }
+    buf[n - 1] = '0' + digit;
+    for (int i = n - 1; i > 0 && buf[i] > '9'; i--) {
+        buf[i] = '0';
+        buf[i - 1]++;
+    }
+    if (buf[0] > '9') {
+        buf[0] = '1';
+        d->dp++;
+    }
+    return n;
+}
+
+// Writes the shortest digits that lie within the margins and returns how many.
+static int fp_dragon_shortest(fp_dragon_t *d, char *buf, bool even) {
+    for (int n = 0;;) {
+        int digit = bn_divmod(&d->r, &d->s);
+        int c = bn_cmp(&d->r, &d->mminus);
+        bool low = c < 0 || (c == 0 && even);
+        c = bn_add_cmp(&d->r, &d->mplus, &d->s);
+        bool high = c > 0 || (c == 0 && even);
+        if (!low && !high) {
+            buf[n++] = '0' + digit;
+            bn_mul_u32(&d->r, 10);
+            bn_mul_u32(&d->mplus, 10);
+            bn_mul_u32(&d->mminus, 10);
+            continue;
+        }
+        if (low && high) {
+            // both digit and digit + 1 are in range, so take the closer one
+            bn_shl(&d->r, 1);
+            c = bn_cmp(&d->r, &d->s);
+            if (c > 0 || (c == 0 && (digit & 1))) {
+                ++digit;
+            }
+        } else if (high) {
+            ++digit;
+        }
+        buf[n++] = '0' + digit;
+        return n;
+    }
+}
+
+/******************************************************************************/
+// Grisu3
+
+static bool fp_grisu_round_weed(char *buf, int len, uint64_t distance_too_high_w,
+    uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa, uint64_t unit) {
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+    // Move the last digit down while that brings the result closer to w.
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa
+           && (rest + ten_kappa < small_distance || small_distance - rest >= rest + ten_kappa - small_distance)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+    // If another digit could still be closer then it's not known which is closest.
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa
+        && (rest + ten_kappa < big_distance || big_distance - rest > rest + ten_kappa - big_distance)) {
+        return false;
+    }
+    // The result must be safely inside the unsafe interval.
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Generates the shortest digits for w, given its boundaries, returning how many
+// there are, or 0 if it can't be sure they are right.
+static int fp_grisu_digit_gen(fp_diy_t low, fp_diy_t w, fp_diy_t high, char *buf, int *kappa) {
+    uint64_t unit = 1;
+    uint64_t too_low = low.f - unit;
+    uint64_t too_high = high.f + unit;
+    uint64_t unsafe_interval = too_high - too_low;
+    int shift = -w.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint32_t integrals = (uint32_t)(too_high >> shift);
+    uint64_t fractionals = too_high & (one - 1);
+    int k = 0;
+    while (k < 10 && integrals >= fp_pow10_u32[k]) {
+        ++k;
+    }
+    uint32_t divisor = fp_pow10_u32[k - 1];
+    int len = 0;
+    while (k > 0) {
+        buf[len++] = '0' + integrals / divisor;
+        integrals %= divisor;
+        --k;
+        uint64_t rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe_interval) {
+            *kappa = k;
+            return fp_grisu_round_weed(buf, len, too_high - w.f, unsafe_interval, rest,
+                (uint64_t)divisor << shift, unit) ? len : 0;
+        }
+        divisor /= 10;
+    }
+    for (;;) {
+        if (len == FP_SHORTEST_MAX) {
+            return 0;
+        }
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        buf[len++] = '0' + (fractionals >> shift);
+        fractionals &= one - 1;
+        --k;
+        if (fractionals < unsafe_interval) {
+            *kappa = k;
+            return fp_grisu_round_weed(buf, len, (too_high - w.f) * unit, unsafe_interval, fractionals,
+                one, unit) ? len : 0;
+        }
+    }
+}
+
+static int fp_grisu3(uint64_t m, int e, char *buf, int *dp) {
+    fp_diy_t w = fp_diy_normalize(m, e);
+    fp_diy_t high = fp_diy_normalize((m << 1) + 1, e - 1);
+    fp_diy_t low;
+    if (m == FP_HIDDEN_BIT && e > FP_DENORMAL_EXP) {
+        low.f = (m << 2) - 1;
+        low.e = e - 2;
+    } else {
+        low.f = (m << 1) - 1;
+        low.e = e - 1;
+    }
+    low.f <<= low.e - high.e;
+    low.e = high.e;
+
+    // Find the cached power that brings the exponent of w into the range
+    // [FP_GRISU_ALPHA, FP_GRISU_GAMMA]; the powers are spaced closely enough
+    // that there is always one.
+    int min_exp = FP_GRISU_ALPHA - (w.e + 64);
+    int i = (fp_floor_log10_pow2(min_exp + 63) + 1 - FP_CACHED_MIN_K + 7) / 8;
+    if (i < 0) {
+        i = 0;
+    } else if (i >= (int)FP_CACHED_POWERS_NUM) {
+        i = FP_CACHED_POWERS_NUM - 1;
+    }
+    while (i > 0 && fp_cached_powers[i - 1].e >= min_exp) {
+        --i;
+    }
+    while (fp_cached_powers[i].e < min_exp) {
+        ++i;
+    }
+    const fp_cached_power_t *c = &fp_cached_powers[i];
+    assert(c->e <= FP_GRISU_GAMMA - (w.e + 64));
+    fp_diy_t ten_k = {c->f, c->e};
+
+    int kappa;
+    int n = fp_grisu_digit_gen(fp_diy_mul(low, ten_k), fp_diy_mul(w, ten_k), fp_diy_mul(high, ten_k), buf, &kappa);
+    *dp = n + kappa - c->k;
+    return n;
+}
+
+// Writes the shortest digits which convert back to m * 2^e, returning how many.
+static int fp_shortest(uint64_t m, int e, char *buf, int *dp) {
+    int n = fp_grisu3(m, e, buf, dp);
+    if (n == 0) {
+        // Work in units of a quarter of the spacing of floats at m, so that the
+        // margins are whole numbers.
+        fp_dragon_t d;
+        unsigned int mminus = m == FP_HIDDEN_BIT && e > FP_DENORMAL_EXP ? 1 : 2;
+        fp_dragon_init(&d, m << 2, e - 2, 2, mminus, !(m & 1));
+        n = fp_dragon_shortest(&d, buf, !(m & 1));
+        *dp = d.dp;
+    }
+    return n;
+}
+
+/******************************************************************************/
+// formatting
+
+// Returns the length of the digits in layout, see below.
+static int fp_layout_len(int n, int dp, int frac, bool sci) {
+    int len = frac > 0 ? frac + 1 : 0;
+    if (sci) {
+        int x = n > 0 ? dp - 1 : 0;
+        return len + 5 + (x >= 100 || x <= -100);
+    }
+    return len + (n > 0 && dp > 0 ? dp : 1);
+}
+
+// Writes the value 0.digits * 10^dp, given as n digits, to s with frac digits
+// after the point, in exponent form if sci is true.  The digits may be in the
+// same buffer, after s, as long as they end no earlier than the result does.
+static char *fp_layout(char *s, const char *digits, int n, int dp, int frac, bool sci, char e_char) {
+    if (sci) {
+        *s++ = n > 0 ? digits[0] : '0';
+        if (frac > 0) {
+            *s++ = '.';
+            for (int i = 1; i <= frac; i++) {
+                *s++ = i < n ? digits[i] : '0';
+            }
+        }
+        int x = n > 0 ? dp - 1 : 0;
+        *s++ = e_char;
+        if (x < 0) {
+            *s++ = '-';
+            x = -x;
+        } else {
+            *s++ = '+';
+        }
+        if (x >= 100) {
+            *s++ = '0' + x / 100;
+        }
+        *s++ = '0' + x / 10 % 10;
+        *s++ = '0' + x % 10;
+    } else {
+        if (n == 0 || dp <= 0) {
+            *s++ = '0';
+        } else {
+            for (int i = 0; i < dp; i++) {
+                *s++ = i < n ? digits[i] : '0';
+            }
+        }
+        if (frac > 0) {
+            *s++ = '.';
+            for (int i = dp; i < dp + frac; i++) {
+                *s++ = i >= 0 && i < n ? digits[i] : '0';
+            }
+        }
+    }
+    return s;
+}
+
+int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, char sign) {
+
+    char *s = buf;
+
+    if (buf_size <= FPMIN_BUF_SIZE) {
+        // FPMIN_BUF_SIZE is the minimum size needed to store any FP number.
+        // If the buffer does not have enough room for this (plus null terminator)
+        // then don't try to format the float.
+
+        if (buf_size >= 2) {
+            *s++ = '?';
+        }
+        if (buf_size >= 1) {
+            *s = '\0';
+        }
+        return buf_size >= 2;
+    }
+    if (fp_signbit(f) && !fp_isnan(f)) {
+        *s++ = '-';
+        f = -f;
+    } else {
+        if (sign) {
+            *s++ = sign;
+        }
+    }
+
+    // buf_remaining contains bytes available for digits and exponent.
+    // It is buf_size minus room for the sign and null byte.
+    int buf_remaining = buf_size - 1 - (s - buf);
+
+    {
+        char uc = fmt & 0x20;
+        if (fp_isinf(f)) {
+            *s++ = 'I' ^ uc;
+            *s++ = 'N' ^ uc;
+            *s++ = 'F' ^ uc;
+            goto ret;
+        } else if (fp_isnan(f)) {
+            *s++ = 'N' ^ uc;
+            *s++ = 'A' ^ uc;
+            *s++ = 'N' ^ uc;
+        ret:
+            *s = '\0';
+            return s - buf;
+        }
+    }
+
+    if (prec < 0) {
+        prec = 6;
+    }
+    char e_char = 'E' | (fmt & 0x20);   // e_char will match case of fmt
+    fmt |= 0x20; // Force fmt to be lowercase
+
+    // Digits are generated at the end of buf and then moved into place.
+    char *top = s + buf_remaining;
+    char *digits = top;
+    int n, dp, frac;
+    bool sci;
+    int e;
+    uint64_t m = fp_decompose(f, &e);
+
+    if (fmt == 'r') {
+        // The shortest digits that convert back to f, in exponent form if the
+        // exponent is less than -4 or at least prec, like 'g'.
+        char tmp[FP_SHORTEST_MAX];
+        if (m == 0) {
+            n = 0;
+            dp = 1;
+        } else {
+            n = fp_shortest(m, e, tmp, &dp);
+        }
+        sci = dp - 1 < -4 || dp - 1 >= prec;
+        frac = sci ? n - 1 : n - dp;
+        if (fp_layout_len(n, dp, frac, sci) <= buf_remaining) {
+            digits -= n;
+            memcpy(digits, tmp, n);
+            goto layout;
+        }
+        // Not enough room, so round to fewer digits instead.
+        fmt = 'g';
+        prec = n;
+    }
+
+    if (fmt == 'e') {
+        if (prec > buf_remaining - FPMIN_BUF_SIZE) {
+            prec = buf_remaining - FPMIN_BUF_SIZE;
+        }
+    } else if (fmt == 'g') {
+        if (prec == 0) {
+            prec = 1;
+        }
+        if (prec + (FPMIN_BUF_SIZE - 1) > buf_remaining) {
+            prec = buf_remaining - (FPMIN_BUF_SIZE - 1);
+        }
+    }
+
+    for (;;) {
+        if (prec < 0) {
+            // This can happen when the prec is trimmed to prevent buffer overflow
+            prec = 0;
+        }
+
+        // Find where the point goes before rounding.  The value is at least
+        // 10^(dp - 1) and less than 10^dp.
+        fp_dragon_t d;
+        if (m == 0) {
+            dp = 1;
+        } else {
+            fp_dragon_init(&d, m, e, 0, 0, true);
+            dp = d.dp;
+        }
+
+        int count;
+        if (fmt == 'f' && dp - 1 >= buf_remaining) {
+            // Too big to fit in the buffer in fixed point.
+            fmt = 'e';
+            if (prec > buf_remaining - FPMIN_BUF_SIZE) {
+                prec = buf_remaining - FPMIN_BUF_SIZE;
+                continue;
+            }
+        }
+        if (fmt == 'e') {
+            sci = true;
+            count = prec + 1;
+            frac = prec;
+        } else if (fmt == 'f') {
+            sci = false;
+            if (prec > 0 && prec + (dp > 0 ? dp : 1) + 1 > buf_remaining) {
+                prec = buf_remaining - (dp > 0 ? dp : 1) - 1;
+                continue;
+            }
+            count = dp + prec;
+            frac = prec;
+        } else {
+            // The choice of fixed point is made before rounding, so that for
+            // example 9.9 with a precision of 1 gives 10.
+            sci = dp - 1 < -4 || dp - 1 >= prec;
+            count = prec;
+            frac = sci ? prec - 1 : prec - dp;
+        }
+
+        if (m == 0 || count < 0) {
+            n = 0;
+        } else {
+            digits = top - (count > 0 ? count : 1);
+            n = fp_dragon_digits(&d, digits, count);
+            digits = top - n;
+            dp = d.dp;
+        }
+        if (fp_layout_len(n, dp, frac, sci) <= buf_remaining) {
+            break;
+        }
+        // Rounding up added a digit which doesn't fit.
+        if (fmt == 'f' && prec == 0) {
+            fmt = 'e';
+        } else if (fmt != 'g' || prec > 1) {
+            --prec;
+        }
+    }
+
+    if (fmt == 'g') {
+        // Remove trailing zeros and a trailing decimal point
+        while (frac > 0) {
+            int i = sci ? frac : dp + frac - 1;
+            if (i >= 0 && i < n && digits[i] != '0') {
+                break;
+            }
+            --frac;
+        }
+    }
+
+layout:
+    s = fp_layout(s, digits, n, dp, frac, sci, e_char);
+    *s = '\0';
+
+    // verify that we did not overrun the input buffer
+    assert((size_t)(s + 1 - buf) <= buf_size);
+
+    return s - buf;
+}
+
+/******************************************************************************/
+// parsing
+
+// Returns the next digit in str, skipping anything else, or -1 at top.
+static int fp_next_digit(const char **str, const char *top) {
+    while (*str < top) {
+        char c = *(*str)++;
+        if ('0' <= c && c <= '9') {
+            return c - '0';
+        }
+    }
+    return -1;
+}
+
+// Returns guess, or the next float up if the value of the digits at str,
+// 0.digits * 10^dp, is nearer to that.  The value must be at least guess and
+// no more than the next float up.
+static FPTYPE fp_parse_decide(FPTYPE guess, const char *str, const char *top, int dp) {
+    mp_float_union_t fb = {guess};
+    if (fp_isinf(guess)) {
+        fb.i--;
+    }
+    int e;
+    uint64_t m = fp_decompose(fb.f, &e);
+
+    // compare the digits with those of the point halfway to the next float
+    fp_dragon_t d;
+    fp_dragon_init(&d, (m << 1) + 1, e - 1, 0, 0, true);
+    int c = dp - d.dp;
+    while (c == 0) {
+        int h = bn_divmod(&d.r, &d.s);
+        int digit = fp_next_digit(&str, top);
+        if (digit < 0) {
+            // the digits ended, so they are less unless the halfway point ends too
+            c = h != 0 || d.r.len != 0 ? -1 : 0;
+            break;
+        }
+        c = digit - h;
+        if (c == 0 && d.r.len == 0) {
+            // the halfway point ended, so the digits are more if any are left
+            while ((digit = fp_next_digit(&str, top)) >= 0) {
+                if (digit != 0) {
+                    c = 1;
+                    break;
+                }
+            }
+            break;
+        }
+        bn_mul_u32(&d.r, 10);
+    }
+    if (c > 0 || (c == 0 && (m & 1))) {
+        fb.i++;
+    }
+    return fb.f;
+}
+
+mp_float_t mp_parse_float_digits(const char *str, const char *top, int exp) {
+    // Read up to 19 significant digits into sig.  Index the digits from 0 and
+    // find the first significant one, the last one read into sig, and the last
+    // non-zero one.
+    uint64_t sig = 0;
+    int nsig = 0;
+    int n_intg = 0;
+    int idx = 0;
+    int idx_first = -1, idx_sig = -1, idx_last = -1;
+    int next_digit = 0;
+    const char *first = top;
+    bool in_frac = false;
+    for (const char *p = str; p < top; p++) {
+        if (*p == '.') {
+            in_frac = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9') {
+            continue;
+        }
+        int digit = *p - '0';
+        if (!in_frac) {
+            ++n_intg;
+        }
+        if (idx_first < 0 && digit != 0) {
+            idx_first = idx;
+            first = p;
+        }
+        if (idx_first >= 0) {
+            if (nsig < 19) {
+                sig = sig * 10 + digit;
+                ++nsig;
+                idx_sig = idx;
+            } else if (idx == idx_sig + 1) {
+                next_digit = digit;
+            }
+            if (digit != 0) {
+                idx_last = idx;
+            }
+        }
+        ++idx;
+    }
+    if (idx_first < 0) {
+        return 0;
+    }
+
+    // The value is at least 10^(dp - 1) and less than 10^dp, and it's sig *
+    // 10^exp10 if no digits were left out.
+    int dp = n_intg - idx_first + exp;
+    if (dp > FP_DEC_MAG_MAX) {
+        return (mp_float_t)INFINITY;
+    } else if (dp < FP_DEC_MAG_MIN) {
+        return 0;
+    }
+    int exp10 = n_intg - 1 - idx_sig + exp;
+    bool truncated = idx_last > idx_sig;
+
+    if (!truncated && sig <= 2 * FP_HIDDEN_BIT && exp10 >= -FP_EXACT_POW10_MAX && exp10 <= FP_EXACT_POW10_MAX) {
+        // Both sig and the power of ten are exact, so this is correctly rounded.
+        if (exp10 < 0) {
+            return (FPTYPE)sig / fp_pow10_exact[-exp10];
+        } else {
+            return (FPTYPE)sig * fp_pow10_exact[exp10];
+        }
+    }
+
+    // The error of x is tracked in eighths of its last bit.
+    uint64_t error = 0;
+    if (truncated) {
+        if (next_digit >= 5) {
+            ++sig;
+        }
+        error = 4;
+    }
+    const fp_cached_power_t *c = &fp_cached_powers[(exp10 - FP_CACHED_MIN_K) / 8];
+    int adjust = exp10 - c->k;
+    if (adjust > 0 && sig <= UINT64_MAX / fp_pow10_u32[adjust]) {
+        sig *= fp_pow10_u32[adjust];
+        error *= fp_pow10_u32[adjust];
+        adjust = 0;
+    }
+    fp_diy_t x = fp_diy_normalize(sig, 0);
+    error <<= -x.e;
+    if (adjust > 0) {
+        x = fp_diy_mul(x, fp_diy_normalize(fp_pow10_u32[adjust], 0));
+        error += 4;
+    }
+    fp_diy_t ten_k = {c->f, c->e};
+    x = fp_diy_mul(x, ten_k);
+    // Add the error of the cached power, the product of the errors, and
+    // rounding the product.
+    error += 4 + (error != 0) + 4;
+    int shift = fp_clz64(x.f);
+    x.f <<= shift;
+    x.e -= shift;
+    error <<= shift;
+
+    // Work out how many of the low bits of x are lost when rounding to a float,
+    // which is more than usual for subnormals.
+    int order = 64 + x.e;
+    int mant_bits;
+    if (order >= FP_DENORMAL_EXP + MP_FLOAT_FRAC_BITS + 1) {
+        mant_bits = MP_FLOAT_FRAC_BITS + 1;
+    } else if (order <= FP_DENORMAL_EXP) {
+        mant_bits = 0;
+    } else {
+        mant_bits = order - FP_DENORMAL_EXP;
+    }
+    int lost = 64 - mant_bits;
+    if (lost + 3 >= 64) {
+        // keep room for the eighths
+        shift = lost + 3 - 64 + 1;
+        x.f >>= shift;
+        x.e += shift;
+        error = (error >> shift) + 1 + 8;
+        lost -= shift;
+    }
+    uint64_t lost_bits = (x.f & (((uint64_t)1 << lost) - 1)) * 8;
+    uint64_t half = ((uint64_t)1 << (lost - 1)) * 8;
+    uint64_t rounded = x.f >> lost;
+    if (lost_bits >= half + error) {
+        ++rounded;
+    }
+    FPTYPE guess = fp_compose(rounded, x.e + lost);
+    if (error < half && (lost_bits <= half - error || lost_bits >= half + error)) {
+        return guess;
+    }
+
+    // Too close to halfway to tell, but guess is either right or one too small.
+    return fp_parse_decide(guess, first, top, dp);
+}
+
+#else
+
 int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, char sign) {
 
     char *s = buf;
@@ -423,4 +1431,6 @@ int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, ch
     return s - buf;
 }
 
+#endif // MICROPY_FLOAT_EXACT_CONVERSION
+
 #endif // MICROPY_FLOAT_IMPL != MICROPY_FLOAT_IMPL_NONE
@@ -30,6 +30,13 @@
 
 #if MICROPY_PY_BUILTINS_FLOAT
 int mp_format_float(mp_float_t f, char *buf, size_t bufSize, char fmt, int prec, char sign);
+#if MICROPY_FLOAT_EXACT_CONVERSION
+// With fmt 'r' mp_format_float gives the shortest digits that convert back to
+// f, using exponent form when the exponent is less than -4 or at least prec.
+// mp_parse_float_digits converts the digits in str..top, ignoring any other
+// characters and taking the first '.' as the point, times 10^exp.
+mp_float_t mp_parse_float_digits(const char *str, const char *top, int exp);
+#endif
 #endif
 
 #endif // MICROPY_INCLUDED_PY_FORMATFLOAT_H
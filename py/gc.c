@@ -89,6 +89,14 @@
 #define ATB_2_IS_FREE(a) (((a) & ATB_MASK_2) == 0)
 #define ATB_3_IS_FREE(a) (((a) & ATB_MASK_3) == 0)
 
+// Operate on all 4 entries of an ATB at once: the low bit of each entry is
+// selected by ATB_LOW_BITS, so HEAD entries are those with only the low bit
+// set and MARK entries are those with both bits set.
+#define ATB_LOW_BITS (0x55)
+#define ATB_HEADS(a) ((a) & ~((a) >> 1) & ATB_LOW_BITS)
+#define ATB_MARKS(a) ((a) & ((a) >> 1) & ATB_LOW_BITS)
+#define ATB_MARKS_TO_HEADS(a) ((a) & ~(ATB_MARKS(a) << 1))
+
 #if MICROPY_GC_SPLIT_HEAP
 #define NEXT_AREA(area) ((area)->next)
 #else
@@ -106,6 +114,20 @@
 #define BLOCK_FROM_PTR(area, ptr) (((byte *)(ptr) - area->gc_pool_start) / BYTES_PER_BLOCK)
 #define PTR_FROM_BLOCK(area, block) (((block) * BYTES_PER_BLOCK + (uintptr_t)area->gc_pool_start))
 
+#if MICROPY_GC_ALLOC_SIZE_CLASSES
+#define SIZE_CLASS_BLOCKS(k) ((size_t)1 << (k))
+#endif
+
+#if MICROPY_GC_INCREMENTAL_SWEEP
+#define SWEEP_DONE ((size_t)-1)
+// While an incremental sweep is pending, live chains in the part of an area
+// that is yet to be swept still have their head marked.
+#define ATB_IS_ALLOCATED_HEAD(area, block) (ATB_GET_KIND(area, block) == AT_HEAD \
+    || (ATB_GET_KIND(area, block) == AT_MARK && (block) >= (area)->gc_sweep_block))
+#else
+#define ATB_IS_ALLOCATED_HEAD(area, block) (ATB_GET_KIND(area, block) == AT_HEAD)
+#endif
+
 // After the ATB, there must be a byte filled with AT_FREE so that gc_mark_tree
 // cannot erroneously conclude that a block extends past the end of the GC heap
 // due to bit patterns in the FTB (or first block, if finalizers are disabled)
@@ -189,6 +211,18 @@ static void gc_setup_area(mp_state_mem_area_t *area, void *start, void *end) {
     area->gc_last_free_atb_index = 0;
     area->gc_last_used_block = 0;
 
+    #if MICROPY_GC_ALLOC_SIZE_CLASSES
+    memset(area->gc_size_class_atb_index, 0, sizeof(area->gc_size_class_atb_index));
+    #endif
+
+    #if MICROPY_GC_LONG_LIVED
+    area->gc_long_lived_atb_index = area->gc_alloc_table_byte_len;
+    #endif
+
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    area->gc_sweep_block = SWEEP_DONE;
+    #endif
+
     #if MICROPY_GC_SPLIT_HEAP
     area->next = NULL;
     #endif
@@ -236,6 +270,10 @@ void gc_init(void *start, void *end) {
     #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
     mp_thread_mutex_init(&MP_STATE_MEM(gc_mutex));
     #endif
+
+    #if MICROPY_GC_PARALLEL_MARK
+    mp_thread_mutex_init(&MP_STATE_MEM(gc_mark_mutex));
+    #endif
 }
 
 #if MICROPY_GC_SPLIT_HEAP
@@ -520,12 +558,279 @@ static void gc_deal_with_stack_overflow(void) {
     }
 }
 
+#if MICROPY_GC_PARALLEL_MARK
+
+#if !MICROPY_PY_THREAD
+#error MICROPY_GC_PARALLEL_MARK requires MICROPY_PY_THREAD
+#endif
+
+#include <stdlib.h>
+
+// Parallel marking.  The collecting thread marks the roots as usual but only
+// puts them in a shared pool, then several threads trace from that pool at
+// once.  Each thread traces from its own mark stack and hands part of it back
+// to the pool when another thread is idle.  Heads are marked atomically, so
+// exactly one thread traces each block.
+
+#define GC_MARK_LOAD(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define GC_MARK_STORE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+
+// Size of the buffer holding the pool followed by the mark stacks.
+#define GC_MARK_BUF_ENTRIES (MICROPY_ALLOC_GC_MARK_POOL_SIZE + MICROPY_GC_PARALLEL_MARK_THREADS * MICROPY_ALLOC_GC_MARK_STACK_SIZE)
+
+// Mark the given block if it is an unmarked head.  Returns true if this
+// thread marked it, and so must trace its children.
+static inline bool gc_mark_head_atomic(mp_state_mem_area_t *area, size_t block) {
+    byte *atb = &area->gc_alloc_table_start[block / BLOCKS_PER_ATB];
+    if (((__atomic_load_n(atb, __ATOMIC_RELAXED) >> BLOCK_SHIFT(block)) & 3) != AT_HEAD) {
+        return false;
+    }
+    byte old = __atomic_fetch_or(atb, AT_TAIL << BLOCK_SHIFT(block), __ATOMIC_RELAXED);
+    return ((old >> BLOCK_SHIFT(block)) & 3) == AT_HEAD;
+}
+
+// Move the oldest half of a mark stack to the pool, as far as it fits.
+// Returns the new depth of the stack.
+static size_t gc_mark_share(gc_mark_entry_t *stack, size_t sp) {
+    mp_thread_mutex_lock(&MP_STATE_MEM(gc_mark_mutex), 1);
+    size_t len = MP_STATE_MEM(gc_mark_pool_len);
+    size_t n = MIN(sp / 2, MICROPY_ALLOC_GC_MARK_POOL_SIZE - len);
+    memcpy(&MP_STATE_MEM(gc_mark_pool)[len], stack, n * sizeof(gc_mark_entry_t));
+    GC_MARK_STORE(MP_STATE_MEM(gc_mark_pool_len), len + n);
+    mp_thread_mutex_unlock(&MP_STATE_MEM(gc_mark_mutex));
+    memmove(stack, stack + n, (sp - n) * sizeof(gc_mark_entry_t));
+    return sp - n;
+}
+
+// Fill an empty mark stack from the pool.  A thread counts as active while it
+// has work taken from the pool.  Returns the new depth of the stack.
+static size_t gc_mark_take(gc_mark_entry_t *stack, bool *active) {
+    mp_thread_mutex_lock(&MP_STATE_MEM(gc_mark_mutex), 1);
+    size_t len = MP_STATE_MEM(gc_mark_pool_len);
+    size_t n = MIN(len, MICROPY_ALLOC_GC_MARK_STACK_SIZE / 2);
+    memcpy(stack, &MP_STATE_MEM(gc_mark_pool)[len - n], n * sizeof(gc_mark_entry_t));
+    GC_MARK_STORE(MP_STATE_MEM(gc_mark_pool_len), len - n);
+    if (*active != (n > 0)) {
+        *active = n > 0;
+        GC_MARK_STORE(MP_STATE_MEM(gc_mark_active), MP_STATE_MEM(gc_mark_active) + (n > 0 ? 1 : -1));
+    }
+    mp_thread_mutex_unlock(&MP_STATE_MEM(gc_mark_mutex));
+    return n;
+}
+
+// Run by each marking thread, with id from 0 up to the number of threads.
+// Returns once the pool is empty and no thread has any work left, which can
+// only change by a thread with work sharing it.
+static void gc_mark_worker(size_t id) {
+    gc_mark_entry_t *stack = MP_STATE_MEM(gc_mark_pool) + MICROPY_ALLOC_GC_MARK_POOL_SIZE + id * MICROPY_ALLOC_GC_MARK_STACK_SIZE;
+    size_t sp = 0;
+    bool active = false;
+    __atomic_fetch_add(&MP_STATE_MEM(gc_mark_workers), 1, __ATOMIC_ACQ_REL);
+    for (;;) {
+        if (sp == 0) {
+            sp = gc_mark_take(stack, &active);
+            if (sp == 0) {
+                while (GC_MARK_LOAD(MP_STATE_MEM(gc_mark_pool_len)) == 0) {
+                    if (GC_MARK_LOAD(MP_STATE_MEM(gc_mark_active)) == 0) {
+                        return;
+                    }
+                }
+                continue;
+            }
+        }
+
+        // pop the next block off the stack
+        sp -= 1;
+        #if MICROPY_GC_SPLIT_HEAP
+        mp_state_mem_area_t *area = stack[sp].area;
+        #else
+        mp_state_mem_area_t *area = &MP_STATE_MEM(area);
+        #endif
+        size_t block = stack[sp].block;
+
+        // work out number of consecutive blocks in the chain starting with this one
+        size_t n_blocks = 0;
+        do {
+            n_blocks += 1;
+        } while (ATB_GET_KIND(area, block + n_blocks) == AT_TAIL);
+
+        // check this block's children
+        void **ptrs = (void **)PTR_FROM_BLOCK(area, block);
+        for (size_t i = n_blocks * BYTES_PER_BLOCK / sizeof(void *); i > 0; i--, ptrs++) {
+            void *ptr = *ptrs;
+            #if MICROPY_GC_SPLIT_HEAP
+            mp_state_mem_area_t *ptr_area = gc_get_ptr_area(ptr);
+            if (!ptr_area) {
+                continue;
+            }
+            #else
+            if (!VERIFY_PTR(ptr)) {
+                continue;
+            }
+            mp_state_mem_area_t *ptr_area = area;
+            #endif
+            size_t ptr_block = BLOCK_FROM_PTR(ptr_area, ptr);
+            if (!gc_mark_head_atomic(ptr_area, ptr_block)) {
+                continue;
+            }
+            if (sp == MICROPY_ALLOC_GC_MARK_STACK_SIZE) {
+                sp = gc_mark_share(stack, sp);
+                if (sp == MICROPY_ALLOC_GC_MARK_STACK_SIZE) {
+                    // The pool is full too, so leave this block to
+                    // gc_deal_with_stack_overflow.
+                    GC_MARK_STORE(MP_STATE_MEM(gc_stack_overflow), 1);
+                    continue;
+                }
+            }
+            #if MICROPY_GC_SPLIT_HEAP
+            stack[sp].area = ptr_area;
+            #endif
+            stack[sp].block = ptr_block;
+            sp += 1;
+        }
+
+        // Give some of this thread's work to any idle thread.
+        if (sp > 1 && GC_MARK_LOAD(MP_STATE_MEM(gc_mark_pool_len)) == 0
+            && GC_MARK_LOAD(MP_STATE_MEM(gc_mark_active)) < GC_MARK_LOAD(MP_STATE_MEM(gc_mark_workers))) {
+            sp = gc_mark_share(stack, sp);
+        }
+    }
+}
+
+// Trace the children of all blocks in the pool.
+static void gc_trace_parallel(void) {
+    MP_STATE_MEM(gc_mark_workers) = 0;
+    MP_STATE_MEM(gc_mark_active) = 0;
+    mp_thread_gc_parallel(gc_mark_worker, MICROPY_GC_PARALLEL_MARK_THREADS);
+}
+
+#endif // MICROPY_GC_PARALLEL_MARK
+
+#if MICROPY_GC_ALLOC_SIZE_CLASSES
+// Called when blocks starting at first_block have been freed.  They may join
+// with free blocks before them, but a run of 2**k free blocks that was not
+// already accounted for can start at most 2**k - 1 blocks earlier.
+static void gc_size_class_freed(mp_state_mem_area_t *area, size_t first_block) {
+    for (size_t k = 1; k <= MICROPY_GC_ALLOC_SIZE_CLASSES; k++) {
+        size_t start = first_block < SIZE_CLASS_BLOCKS(k) ? 0 : first_block - (SIZE_CLASS_BLOCKS(k) - 1);
+        if (start / BLOCKS_PER_ATB < area->gc_size_class_atb_index[k - 1]) {
+            area->gc_size_class_atb_index[k - 1] = start / BLOCKS_PER_ATB;
+        }
+    }
+}
+#endif
+
+#if MICROPY_GC_LONG_LIVED
+// Called when blocks up to and including last_block have been freed, so the
+// search for long-lived allocations must start at or after them.
+static void gc_long_lived_freed(mp_state_mem_area_t *area, size_t last_block) {
+    area->gc_long_lived_atb_index = MAX(area->gc_long_lived_atb_index, last_block / BLOCKS_PER_ATB + 1);
+}
+#endif
+
+// Sweep the blocks of an area starting at block, which must not be in the
+// middle of a chain that is being freed.  Stops at the first chain boundary
+// at or after stop_block and returns the block it stopped at.  Blocks which
+// remain in use are recorded in *last_used_block.
+static size_t gc_sweep_blocks(mp_state_mem_area_t *area, size_t block, size_t stop_block, size_t *last_used_block) {
+    // free unmarked heads and their tails
+    int free_tail = 0;
+    for (; block < stop_block || (free_tail && ATB_GET_KIND(area, block) == AT_TAIL); block++) {
+        MICROPY_GC_HOOK_LOOP(block);
+        #if MICROPY_GC_FAST_SWEEP
+        // If we are at the start of an ATB and it has no unmarked heads,
+        // and isn't continuing a chain being freed, then nothing in it
+        // needs freeing: just turn its marks back into heads in one go.
+        // Entries past stop_block are handled here too, which is fine as
+        // the sweep may stop at any chain boundary.
+        if (block % BLOCKS_PER_ATB == 0 && !free_tail) {
+            byte *atb = &area->gc_alloc_table_start[block / BLOCKS_PER_ATB];
+            byte a = *atb;
+            if (ATB_HEADS(a) == 0) {
+                if (a != 0) {
+                    *atb = ATB_MARKS_TO_HEADS(a);
+                    size_t last = BLOCKS_PER_ATB - 1;
+                    while (((a >> BLOCK_SHIFT(last)) & 3) == AT_FREE) {
+                        last -= 1;
+                    }
+                    *last_used_block = block + last;
+                } else {
+                    // Skip over the rest of a free run, a word of ATB entries
+                    // at a time once aligned.  There is usually a long one
+                    // between short-lived objects and the long-lived ones at
+                    // the end of the area.
+                    byte *atb_end = &area->gc_alloc_table_start[(stop_block + BLOCKS_PER_ATB - 1) / BLOCKS_PER_ATB];
+                    for (atb += 1; atb < atb_end && ((uintptr_t)atb & (sizeof(mp_uint_t) - 1)) != 0 && *atb == 0; atb++) {
+                    }
+                    if (((uintptr_t)atb & (sizeof(mp_uint_t) - 1)) == 0) {
+                        for (; atb + sizeof(mp_uint_t) <= atb_end && *(mp_uint_t *)atb == 0; atb += sizeof(mp_uint_t)) {
+                        }
+                    }
+                    block = (atb - 1 - area->gc_alloc_table_start) * BLOCKS_PER_ATB;
+                }
+                block += BLOCKS_PER_ATB - 1;
+                continue;
+            }
+        }
+        #endif
+        switch (ATB_GET_KIND(area, block)) {
+            case AT_HEAD:
+                #if MICROPY_ENABLE_FINALISER
+                if (FTB_GET(area, block)) {
+                    mp_obj_base_t *obj = (mp_obj_base_t *)PTR_FROM_BLOCK(area, block);
+                    if (obj->type != NULL) {
+                        // if the object has a type then see if it has a __del__ method
+                        mp_obj_t dest[2];
+                        mp_load_method_maybe(MP_OBJ_FROM_PTR(obj), MP_QSTR___del__, dest);
+                        if (dest[0] != MP_OBJ_NULL) {
+                            // load_method returned a method, execute it in a protected environment
+                            #if MICROPY_ENABLE_SCHEDULER
+                            mp_sched_lock();
+                            #endif
+                            mp_call_function_1_protected(dest[0], dest[1]);
+                            #if MICROPY_ENABLE_SCHEDULER
+                            mp_sched_unlock();
+                            #endif
+                        }
+                    }
+                    // clear finaliser flag
+                    FTB_CLEAR(area, block);
+                }
+                #endif
+                free_tail = 1;
+                DEBUG_printf("gc_sweep(%p)\n", (void *)PTR_FROM_BLOCK(area, block));
+                #if MICROPY_PY_GC_COLLECT_RETVAL
+                MP_STATE_MEM(gc_collected)++;
+                #endif
+                // fall through to free the head
+                MP_FALLTHROUGH
+
+            case AT_TAIL:
+                if (free_tail) {
+                    ATB_ANY_TO_FREE(area, block);
+                    #if CLEAR_ON_SWEEP
+                    memset((void *)PTR_FROM_BLOCK(area, block), 0, BYTES_PER_BLOCK);
+                    #endif
+                } else {
+                    *last_used_block = block;
+                }
+                break;
+
+            case AT_MARK:
+                ATB_MARK_TO_HEAD(area, block);
+                free_tail = 0;
+                *last_used_block = block;
+                break;
+        }
+    }
+
+    return block;
+}
+
 static void gc_sweep(void) {
     #if MICROPY_PY_GC_COLLECT_RETVAL
     MP_STATE_MEM(gc_collected) = 0;
     #endif
-    // free unmarked heads and their tails
-    int free_tail = 0;
     #if MICROPY_GC_SPLIT_HEAP_AUTO
     mp_state_mem_area_t *prev_area = NULL;
     #endif
@@ -536,60 +841,7 @@ static void gc_sweep(void) {
         }
 
         size_t last_used_block = 0;
-
-        for (size_t block = 0; block < end_block; block++) {
-            MICROPY_GC_HOOK_LOOP(block);
-            switch (ATB_GET_KIND(area, block)) {
-                case AT_HEAD:
-                    #if MICROPY_ENABLE_FINALISER
-                    if (FTB_GET(area, block)) {
-                        mp_obj_base_t *obj = (mp_obj_base_t *)PTR_FROM_BLOCK(area, block);
-                        if (obj->type != NULL) {
-                            // if the object has a type then see if it has a __del__ method
-                            mp_obj_t dest[2];
-                            mp_load_method_maybe(MP_OBJ_FROM_PTR(obj), MP_QSTR___del__, dest);
-                            if (dest[0] != MP_OBJ_NULL) {
-                                // load_method returned a method, execute it in a protected environment
-                                #if MICROPY_ENABLE_SCHEDULER
-                                mp_sched_lock();
-                                #endif
-                                mp_call_function_1_protected(dest[0], dest[1]);
-                                #if MICROPY_ENABLE_SCHEDULER
-                                mp_sched_unlock();
-                                #endif
-                            }
-                        }
-                        // clear finaliser flag
-                        FTB_CLEAR(area, block);
-                    }
-                    #endif
-                    free_tail = 1;
-                    DEBUG_printf("gc_sweep(%p)\n", (void *)PTR_FROM_BLOCK(area, block));
-                    #if MICROPY_PY_GC_COLLECT_RETVAL
-                    MP_STATE_MEM(gc_collected)++;
-                    #endif
-                    // fall through to free the head
-                    MP_FALLTHROUGH
-
-                case AT_TAIL:
-                    if (free_tail) {
-                        ATB_ANY_TO_FREE(area, block);
-                        #if CLEAR_ON_SWEEP
-                        memset((void *)PTR_FROM_BLOCK(area, block), 0, BYTES_PER_BLOCK);
-                        #endif
-                    } else {
-                        last_used_block = block;
-                    }
-                    break;
-
-                case AT_MARK:
-                    ATB_MARK_TO_HEAD(area, block);
-                    free_tail = 0;
-                    last_used_block = block;
-                    break;
-            }
-        }
-
+        gc_sweep_blocks(area, 0, end_block, &last_used_block);
         area->gc_last_used_block = last_used_block;
 
         #if MICROPY_GC_SPLIT_HEAP_AUTO
@@ -605,14 +857,97 @@ static void gc_sweep(void) {
     }
 }
 
+#if MICROPY_GC_INCREMENTAL_SWEEP
+// Continue a pending incremental sweep for at least n_blocks blocks (or
+// until it is complete).  Must be called with the GC locked.
+static void gc_sweep_slice(size_t n_blocks) {
+    #if MICROPY_GC_SPLIT_HEAP
+    // Blocks may be freed in any area, see comment in gc_free.
+    MP_STATE_MEM(gc_last_free_area) = &MP_STATE_MEM(area);
+    #endif
+    for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
+        if (area->gc_sweep_block == SWEEP_DONE) {
+            continue;
+        }
+        // Allocations made since the sweep started can raise gc_last_used_block,
+        // so the end of the sweep is recomputed for each slice.
+        size_t start_block = area->gc_sweep_block;
+        size_t end_block = MIN(area->gc_last_used_block + 1, area->gc_alloc_table_byte_len * BLOCKS_PER_ATB);
+        size_t block = start_block;
+        if (block < end_block) {
+            size_t stop_block = end_block - block > n_blocks ? block + n_blocks : end_block;
+            block = gc_sweep_blocks(area, block, stop_block, &area->gc_sweep_last_used);
+
+            // The blocks just swept may have been freed, so let gc_alloc find them.
+            if (start_block / BLOCKS_PER_ATB < area->gc_last_free_atb_index) {
+                area->gc_last_free_atb_index = start_block / BLOCKS_PER_ATB;
+            }
+            #if MICROPY_GC_ALLOC_SIZE_CLASSES
+            gc_size_class_freed(area, start_block);
+            #endif
+            #if MICROPY_GC_LONG_LIVED
+            gc_long_lived_freed(area, block - 1);
+            #endif
+        }
+        if (block < end_block) {
+            // Out of budget, continue from here next time.
+            area->gc_sweep_block = block;
+            return;
+        }
+        area->gc_last_used_block = area->gc_sweep_last_used;
+        area->gc_sweep_block = SWEEP_DONE;
+        n_blocks -= MIN(n_blocks, block - start_block);
+        if (n_blocks == 0 && NEXT_AREA(area) != NULL) {
+            return;
+        }
+    }
+    MP_STATE_MEM(gc_sweep_pending) = false;
+}
+
+// Complete any pending incremental sweep.
+static void gc_sweep_finish(void) {
+    if (MP_STATE_MEM(gc_sweep_pending)) {
+        MP_STATE_THREAD(gc_lock_depth)++;
+        gc_sweep_slice(SIZE_MAX);
+        MP_STATE_THREAD(gc_lock_depth)--;
+    }
+}
+
+// Run a collection and leave its sweep to be done incrementally.
+static void gc_collect_incremental(void) {
+    MP_STATE_MEM(gc_sweep_incremental) = true;
+    gc_collect();
+    MP_STATE_MEM(gc_sweep_incremental) = false;
+}
+#else
+#define gc_collect_incremental gc_collect
+#endif
+
 void gc_collect_start(void) {
     GC_ENTER();
     MP_STATE_THREAD(gc_lock_depth)++;
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    // Marking relies on all heads being unmarked to begin with.
+    gc_sweep_finish();
+    #endif
     #if MICROPY_GC_ALLOC_THRESHOLD
     MP_STATE_MEM(gc_alloc_amount) = 0;
     #endif
     MP_STATE_MEM(gc_stack_overflow) = 0;
 
+    #if MICROPY_GC_PARALLEL_MARK
+    size_t heap_size = 0;
+    for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
+        heap_size += area->gc_pool_end - area->gc_pool_start;
+    }
+    MP_STATE_MEM(gc_mark_parallel) = false;
+    MP_STATE_MEM(gc_mark_pool_len) = 0;
+    if (heap_size >= MICROPY_GC_PARALLEL_MARK_MIN_HEAP) {
+        MP_STATE_MEM(gc_mark_pool) = MICROPY_GC_PARALLEL_MARK_MALLOC(GC_MARK_BUF_ENTRIES * sizeof(gc_mark_entry_t));
+        MP_STATE_MEM(gc_mark_parallel) = MP_STATE_MEM(gc_mark_pool) != NULL;
+    }
+    #endif
+
     // Trace root pointers.  This relies on the root pointers being organised
     // correctly in the mp_state_ctx structure.  We scan nlr_top, dict_locals,
     // dict_globals, then the root pointer section of mp_state_vm.
@@ -671,6 +1006,17 @@ void gc_collect_root(void **ptrs, size_t len) {
         if (ATB_GET_KIND(area, block) == AT_HEAD) {
             // An unmarked head: mark it, and mark all its children
             ATB_HEAD_TO_MARK(area, block);
+            #if MICROPY_GC_PARALLEL_MARK
+            if (MP_STATE_MEM(gc_mark_parallel) && MP_STATE_MEM(gc_mark_pool_len) < MICROPY_ALLOC_GC_MARK_POOL_SIZE) {
+                // Its children are traced later, by gc_trace_parallel.
+                gc_mark_entry_t *entry = &MP_STATE_MEM(gc_mark_pool)[MP_STATE_MEM(gc_mark_pool_len)++];
+                #if MICROPY_GC_SPLIT_HEAP
+                entry->area = area;
+                #endif
+                entry->block = block;
+                continue;
+            }
+            #endif
             #if MICROPY_GC_SPLIT_HEAP
             gc_mark_subtree(area, block);
             #else
@@ -681,13 +1027,44 @@ void gc_collect_root(void **ptrs, size_t len) {
 }
 
 void gc_collect_end(void) {
+    #if MICROPY_GC_PARALLEL_MARK
+    if (MP_STATE_MEM(gc_mark_parallel)) {
+        MP_STATE_MEM(gc_mark_parallel) = false;
+        if (MP_STATE_MEM(gc_mark_pool_len) > 0) {
+            gc_trace_parallel();
+        }
+        MICROPY_GC_PARALLEL_MARK_FREE(MP_STATE_MEM(gc_mark_pool));
+        MP_STATE_MEM(gc_mark_pool) = NULL;
+    }
+    #endif
     gc_deal_with_stack_overflow();
-    gc_sweep();
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    if (MP_STATE_MEM(gc_sweep_incremental)) {
+        // Leave the sweep to be done a slice at a time by gc_alloc.
+        for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
+            area->gc_sweep_block = 0;
+            area->gc_sweep_last_used = 0;
+        }
+        MP_STATE_MEM(gc_sweep_pending) = true;
+        #if MICROPY_PY_GC_COLLECT_RETVAL
+        MP_STATE_MEM(gc_collected) = 0;
+        #endif
+    } else
+    #endif
+    {
+        gc_sweep();
+    }
     #if MICROPY_GC_SPLIT_HEAP
     MP_STATE_MEM(gc_last_free_area) = &MP_STATE_MEM(area);
     #endif
     for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
         area->gc_last_free_atb_index = 0;
+        #if MICROPY_GC_ALLOC_SIZE_CLASSES
+        memset(area->gc_size_class_atb_index, 0, sizeof(area->gc_size_class_atb_index));
+        #endif
+        #if MICROPY_GC_LONG_LIVED
+        area->gc_long_lived_atb_index = area->gc_alloc_table_byte_len;
+        #endif
     }
     MP_STATE_THREAD(gc_lock_depth)--;
     GC_EXIT();
@@ -696,12 +1073,18 @@ void gc_collect_end(void) {
 void gc_sweep_all(void) {
     GC_ENTER();
     MP_STATE_THREAD(gc_lock_depth)++;
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    gc_sweep_finish();
+    #endif
     MP_STATE_MEM(gc_stack_overflow) = 0;
     gc_collect_end();
 }
 
 void gc_info(gc_info_t *info) {
     GC_ENTER();
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    gc_sweep_finish();
+    #endif
     info->total = 0;
     info->used = 0;
     info->free = 0;
@@ -781,6 +1164,11 @@ bool gc_alloc_possible(void) {
 
 void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
     bool has_finaliser = alloc_flags & GC_ALLOC_FLAG_HAS_FINALISER;
+    #if MICROPY_GC_LONG_LIVED
+    bool long_lived = alloc_flags & GC_ALLOC_FLAG_LONG_LIVED;
+    #else
+    const bool long_lived = false;
+    #endif
     size_t n_blocks = ((n_bytes + BYTES_PER_BLOCK - 1) & (~(BYTES_PER_BLOCK - 1))) / BYTES_PER_BLOCK;
     DEBUG_printf("gc_alloc(" UINT_FMT " bytes -> " UINT_FMT " blocks)\n", n_bytes, n_blocks);
 
@@ -796,6 +1184,16 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
 
     GC_ENTER();
 
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    // Each allocation pays for a slice of any pending sweep.
+    size_t sweep_slice = MICROPY_GC_INCREMENTAL_SWEEP_SLICE;
+    if (MP_STATE_MEM(gc_sweep_pending)) {
+        MP_STATE_THREAD(gc_lock_depth)++;
+        gc_sweep_slice(sweep_slice);
+        MP_STATE_THREAD(gc_lock_depth)--;
+    }
+    #endif
+
     mp_state_mem_area_t *area;
     size_t i;
     size_t end_block;
@@ -806,10 +1204,21 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
     bool added = false;
     #endif
 
+    #if MICROPY_GC_ALLOC_SIZE_CLASSES
+    // Find the largest size class k with 2**k <= n_blocks (0 means none).
+    size_t size_class = 0;
+    while (size_class < MICROPY_GC_ALLOC_SIZE_CLASSES && SIZE_CLASS_BLOCKS(size_class + 1) <= n_blocks) {
+        size_class += 1;
+    }
+    // Only an allocation of exactly 2**k blocks learns about size class k
+    // (and larger ones) from where its search ends.
+    bool size_class_exact = size_class > 0 && n_blocks == SIZE_CLASS_BLOCKS(size_class);
+    #endif
+
     #if MICROPY_GC_ALLOC_THRESHOLD
     if (!collected && MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
         GC_EXIT();
-        gc_collect();
+        gc_collect_incremental();
         collected = 1;
         GC_ENTER();
     }
@@ -831,7 +1240,49 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
         // look for a run of n_blocks available blocks
         for (; area != NULL; area = NEXT_AREA(area), i = 0) {
             n_free = 0;
-            for (i = area->gc_last_free_atb_index; i < area->gc_alloc_table_byte_len; i++) {
+            #if MICROPY_GC_LONG_LIVED
+            if (long_lived) {
+                // Search down from the end of the area, so long-lived objects
+                // pack together at the top of the heap.  Unswept blocks are
+                // either free already or not, so the whole area can be used.
+                // The search starts below the blocks known to be in use, and
+                // the first ATB entry that has a free block becomes the new
+                // starting point: everything above it is in use.
+                size_t top = 0;
+                for (i = area->gc_long_lived_atb_index; i-- > 0;) {
+                    MICROPY_GC_HOOK_LOOP(i);
+                    byte a = area->gc_alloc_table_start[i];
+                    if (top == 0 && (~a & ~(a >> 1) & ATB_LOW_BITS) != 0) {
+                        top = i + 1;
+                        area->gc_long_lived_atb_index = top;
+                    }
+                    // *FORMAT-OFF*
+                    if (ATB_3_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 3 + n_blocks - 1; goto found; } } else { n_free = 0; }
+                    if (ATB_2_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 2 + n_blocks - 1; goto found; } } else { n_free = 0; }
+                    if (ATB_1_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 1 + n_blocks - 1; goto found; } } else { n_free = 0; }
+                    if (ATB_0_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 0 + n_blocks - 1; goto found; } } else { n_free = 0; }
+                    // *FORMAT-ON*
+                }
+                area->gc_long_lived_atb_index = top;
+                continue;
+            }
+            #endif
+            i = area->gc_last_free_atb_index;
+            #if MICROPY_GC_ALLOC_SIZE_CLASSES
+            if (size_class > 0) {
+                i = MAX(i, area->gc_size_class_atb_index[size_class - 1]);
+            }
+            #endif
+            size_t scan_end = area->gc_alloc_table_byte_len;
+            #if MICROPY_GC_INCREMENTAL_SWEEP
+            // Only search the part of the area that has been swept.  The rest
+            // is mostly garbage that is not free yet, and scanning over it for
+            // every allocation would cost more than sweeping it.
+            if (area->gc_sweep_block != SWEEP_DONE) {
+                scan_end = MIN(scan_end, (area->gc_sweep_block + BLOCKS_PER_ATB - 1) / BLOCKS_PER_ATB);
+            }
+            #endif
+            for (; i < scan_end; i++) {
                 MICROPY_GC_HOOK_LOOP(i);
                 byte a = area->gc_alloc_table_start[i];
                 // *FORMAT-OFF*
@@ -842,6 +1293,15 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
                 // *FORMAT-ON*
             }
 
+            #if MICROPY_GC_ALLOC_SIZE_CLASSES
+            // No free run of this size class, or any larger, in this area.
+            if (size_class_exact && scan_end == area->gc_alloc_table_byte_len) {
+                for (size_t k = size_class; k <= MICROPY_GC_ALLOC_SIZE_CLASSES; k++) {
+                    area->gc_size_class_atb_index[k - 1] = area->gc_alloc_table_byte_len;
+                }
+            }
+            #endif
+
             // No free blocks found on this heap. Mark this heap as
             // filled, so we won't try to find free space here again until
             // space is freed.
@@ -852,6 +1312,18 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
             #endif
         }
 
+        #if MICROPY_GC_INCREMENTAL_SWEEP
+        if (MP_STATE_MEM(gc_sweep_pending)) {
+            // Garbage from the last collection may not have been freed yet.
+            // Sweep some more (twice as much each time) and look again.
+            sweep_slice *= 2;
+            MP_STATE_THREAD(gc_lock_depth)++;
+            gc_sweep_slice(sweep_slice);
+            MP_STATE_THREAD(gc_lock_depth)--;
+            continue;
+        }
+        #endif
+
         GC_EXIT();
         // nothing found!
         if (collected) {
@@ -869,7 +1341,7 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
             return NULL;
         }
         DEBUG_printf("gc_alloc(" UINT_FMT "): no free mem, triggering GC\n", n_bytes);
-        gc_collect();
+        gc_collect_incremental();
         collected = 1;
         GC_ENTER();
     }
@@ -884,14 +1356,25 @@ found:
     // next scan.  To reduce fragmentation, we only do this if we were looking
     // for a single free block, which guarantees that there are no free blocks
     // before this one.  Also, whenever we free or shink a block we must check
-    // if this index needs adjusting (see gc_realloc and gc_free).
-    if (n_free == 1) {
+    // if this index needs adjusting (see gc_realloc and gc_free).  None of this
+    // holds for a long-lived allocation, which was searched for from the end.
+    if (n_free == 1 && !long_lived) {
         #if MICROPY_GC_SPLIT_HEAP
         MP_STATE_MEM(gc_last_free_area) = area;
         #endif
         area->gc_last_free_atb_index = (i + 1) / BLOCKS_PER_ATB;
     }
 
+    #if MICROPY_GC_ALLOC_SIZE_CLASSES
+    // This was the first run of n_blocks free blocks, so all runs of this size
+    // class (and larger) start at or after it.
+    if (size_class_exact && !long_lived) {
+        for (size_t k = size_class; k <= MICROPY_GC_ALLOC_SIZE_CLASSES; k++) {
+            area->gc_size_class_atb_index[k - 1] = MAX(area->gc_size_class_atb_index[k - 1], start_block / BLOCKS_PER_ATB);
+        }
+    }
+    #endif
+
     // CIRCUITPY-CHANGE
     #ifdef LOG_HEAP_ACTIVITY
     gc_log_change(start_block, end_block - start_block + 1);
@@ -902,6 +1385,17 @@ found:
     // mark first block as used head
     ATB_FREE_TO_HEAD(area, start_block);
 
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    if (start_block >= area->gc_sweep_block) {
+        // The pending sweep hasn't reached this block yet, so mark it to
+        // stop the sweep from freeing it.
+        ATB_HEAD_TO_MARK(area, start_block);
+    }
+    if (area->gc_sweep_block != SWEEP_DONE) {
+        area->gc_sweep_last_used = MAX(area->gc_sweep_last_used, end_block);
+    }
+    #endif
+
     // mark rest of blocks as used tail
     // TODO for a run of many blocks can make this more efficient
     for (size_t bl = start_block + 1; bl <= end_block; bl++) {
@@ -1002,7 +1496,7 @@ void gc_free(void *ptr) {
     #endif
 
     size_t block = BLOCK_FROM_PTR(area, ptr);
-    assert(ATB_GET_KIND(area, block) == AT_HEAD);
+    assert(ATB_IS_ALLOCATED_HEAD(area, block));
 
     #if MICROPY_ENABLE_FINALISER
     FTB_CLEAR(area, block);
@@ -1028,6 +1522,10 @@ void gc_free(void *ptr) {
         area->gc_last_free_atb_index = block / BLOCKS_PER_ATB;
     }
 
+    #if MICROPY_GC_ALLOC_SIZE_CLASSES
+    gc_size_class_freed(area, block);
+    #endif
+
     // CIRCUITPY-CHANGE
     #ifdef LOG_HEAP_ACTIVITY
     gc_log_change(start_block, 0);
@@ -1039,6 +1537,10 @@ void gc_free(void *ptr) {
         block += 1;
     } while (ATB_GET_KIND(area, block) == AT_TAIL);
 
+    #if MICROPY_GC_LONG_LIVED
+    gc_long_lived_freed(area, block - 1);
+    #endif
+
     GC_EXIT();
 
     #if EXTENSIVE_HEAP_PROFILING
@@ -1062,7 +1564,7 @@ size_t gc_nbytes(const void *ptr) {
 
     if (area) {
         size_t block = BLOCK_FROM_PTR(area, ptr);
-        if (ATB_GET_KIND(area, block) == AT_HEAD) {
+        if (ATB_IS_ALLOCATED_HEAD(area, block)) {
             // work out number of consecutive blocks in the chain starting with this on
             size_t n_blocks = 0;
             do {
@@ -1137,7 +1639,7 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     area = &MP_STATE_MEM(area);
     #endif
     size_t block = BLOCK_FROM_PTR(area, ptr);
-    assert(ATB_GET_KIND(area, block) == AT_HEAD);
+    assert(ATB_IS_ALLOCATED_HEAD(area, block));
 
     // compute number of new blocks that are requested
     size_t new_blocks = (n_bytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
@@ -1193,6 +1695,14 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
             area->gc_last_free_atb_index = (block + new_blocks) / BLOCKS_PER_ATB;
         }
 
+        #if MICROPY_GC_ALLOC_SIZE_CLASSES
+        gc_size_class_freed(area, block + new_blocks);
+        #endif
+
+        #if MICROPY_GC_LONG_LIVED
+        gc_long_lived_freed(area, block + n_blocks - 1);
+        #endif
+
         GC_EXIT();
 
         #if EXTENSIVE_HEAP_PROFILING
@@ -1221,6 +1731,11 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
         }
 
         area->gc_last_used_block = MAX(area->gc_last_used_block, end_block);
+        #if MICROPY_GC_INCREMENTAL_SWEEP
+        if (area->gc_sweep_block != SWEEP_DONE) {
+            area->gc_sweep_last_used = MAX(area->gc_sweep_last_used, end_block);
+        }
+        #endif
 
         GC_EXIT();
 
@@ -1290,6 +1805,9 @@ void gc_dump_info(const mp_print_t *print) {
 
 void gc_dump_alloc_table(const mp_print_t *print) {
     GC_ENTER();
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    gc_sweep_finish();
+    #endif
     static const size_t DUMP_BYTES_PER_LINE = 64;
     for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
         #if !EXTENSIVE_HEAP_PROFILING
@@ -73,6 +73,8 @@ void gc_sweep_all(void);
 
 enum {
     GC_ALLOC_FLAG_HAS_FINALISER = 1,
+    // A hint that the allocation will likely live as long as the VM.
+    GC_ALLOC_FLAG_LONG_LIVED = 2,
 };
 
 void *gc_alloc(size_t n_bytes, unsigned int alloc_flags);
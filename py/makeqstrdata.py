@@ -408,6 +408,25 @@ def escape_bytes(qstr, qbytes):
         return "".join(("\\x%02x" % b) for b in qbytes)
 
 
+# Build an open-addressing hash table of the given qstr hashes (indexed by
+# qstr id), with linear probing from slot (hash & (size - 1)).  The size is a
+# power of two that keeps the table at most 3/4 full, and 0 marks an empty
+# slot (qstr id 0 is MP_QSTRnull, which is never looked up).
+def make_hash_index(hashes):
+    size = 1
+    while size * 3 < len(hashes) * 4:
+        size *= 2
+    index = [0] * size
+    for id, qhash in enumerate(hashes):
+        if id == 0:
+            continue
+        slot = qhash & (size - 1)
+        while index[slot]:
+            slot = (slot + 1) & (size - 1)
+        index[slot] = id
+    return index
+
+
 def make_bytes(cfg_bytes_len, cfg_bytes_hash, qstr):
     qbytes = bytes_cons(qstr, "utf8")
     qlen = len(qbytes)
@@ -432,10 +451,14 @@ def print_qstr_data(qcfgs, qstrs, translations):
     # add NULL qstr with no hash or data
     print('QDEF0(MP_QSTRnull, 0, 0, "")')
 
+    # hashes of the qstrs in each pool, in the order of their ids
+    pool_hashes = ([0], [])
+
     # add static qstrs to the first unsorted pool
     for qstr in static_qstr_list:
         qbytes = make_bytes(cfg_bytes_len, cfg_bytes_hash, qstr)
         print("QDEF0(MP_QSTR_%s, %s)" % (qstr_escape(qstr), qbytes))
+        pool_hashes[0].append(compute_hash(bytes_cons(qstr, "utf8"), cfg_bytes_hash))
 
     # CIRCUITPY-CHANGE: track total qstr size
     total_qstr_size = 0
@@ -446,6 +469,7 @@ def print_qstr_data(qcfgs, qstrs, translations):
         qbytes = make_bytes(cfg_bytes_len, cfg_bytes_hash, qstr)
         pool = 0 if qstr in unsorted_qstr_list else 1
         print("QDEF%d(MP_QSTR_%s, %s)" % (pool, ident, qbytes))
+        pool_hashes[pool].append(compute_hash(bytes_cons(qstr, "utf8"), cfg_bytes_hash))
 
         # CIRCUITPY-CHANGE: track total qstr size
         total_qstr_size += len(qstr)
@@ -457,6 +481,14 @@ def print_qstr_data(qcfgs, qstrs, translations):
     for i, original in enumerate(sorted(translations)):
         print('TRANSLATION("{}", {})'.format(original, i))
 
+    # index the qstrs above by hash, for qstr_find_strn
+    index = make_hash_index(pool_hashes[0] + pool_hashes[1])
+    print()
+    print("#ifdef QINDEX")
+    for i in range(0, len(index), 16):
+        print(" ".join("QINDEX(%d)" % id for id in index[i : i + 16]))
+    print("#endif")
+
     print()
     print("// {} bytes worth of qstr".format(total_qstr_size))
 
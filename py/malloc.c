@@ -58,6 +58,7 @@
 #undef realloc
 #define malloc(b) gc_alloc((b), false)
 #define malloc_with_finaliser(b) gc_alloc((b), true)
+#define malloc_long_lived(b) gc_alloc((b), GC_ALLOC_FLAG_LONG_LIVED)
 #define free gc_free
 #define realloc(ptr, n) gc_realloc(ptr, n, true)
 #define realloc_ext(ptr, n, mv) gc_realloc(ptr, n, mv)
@@ -69,6 +70,8 @@
 #error MICROPY_ENABLE_FINALISER requires MICROPY_ENABLE_GC
 #endif
 
+#define malloc_long_lived(b) malloc(b)
+
 static void *realloc_ext(void *ptr, size_t n_bytes, bool allow_move) {
     if (allow_move) {
         return realloc(ptr, n_bytes);
@@ -132,6 +135,25 @@ void *m_malloc0(size_t num_bytes) {
     return ptr;
 }
 
+void *m_malloc_long_lived_maybe(size_t num_bytes) {
+    void *ptr = malloc_long_lived(num_bytes);
+    #if MICROPY_MEM_STATS
+    MP_STATE_MEM(total_bytes_allocated) += num_bytes;
+    MP_STATE_MEM(current_bytes_allocated) += num_bytes;
+    UPDATE_PEAK();
+    #endif
+    DEBUG_printf("malloc %d : %p\n", num_bytes, ptr);
+    return ptr;
+}
+
+void *m_malloc_long_lived(size_t num_bytes) {
+    void *ptr = m_malloc_long_lived_maybe(num_bytes);
+    if (ptr == NULL && num_bytes != 0) {
+        m_malloc_fail(num_bytes);
+    }
+    return ptr;
+}
+
 #if MICROPY_MALLOC_USES_ALLOCATED_SIZE
 void *m_realloc(void *ptr, size_t old_num_bytes, size_t new_num_bytes)
 #else
@@ -83,6 +83,107 @@ static size_t get_hash_alloc_greater_or_equal_to(size_t x) {
     return (x + x / 2) | 1;
 }
 
+#if MICROPY_MAP_COMPACT
+
+// A compact map (one that is not ordered) keeps its elements densely, in the
+// order they were added, in the first alloc slots of map->table.  Deleted
+// elements have an MP_OBJ_SENTINEL key and unused slots at the end an
+// MP_OBJ_NULL key, so code that walks map->table sees the same thing as for the
+// plain hash table layout.  After the elements, in the same allocation, is the
+// index: an open-addressed hash table of the positions of the elements, stored
+// plus one as 8, 16 or 32-bit numbers depending on alloc.  Zero marks an empty
+// index slot and the largest number a deleted one.  The extra index slot after
+// the table holds the number of element slots used so far, including deleted
+// elements which haven't been trimmed from the end.
+// Small maps whose keys are all qstrs, such as most instance members, have no
+// index and are searched linearly, so they take no more memory than with the
+// plain layout.  Other keys may have a costly or user-defined __eq__, so maps
+// holding them always keep an index and only compare keys that it leads to.
+
+#define MAP_INDEX_DELETED ((size_t)-1)
+#define MAP_LINEAR_MAX (8)
+
+// The index size is odd, so that hashes which are aligned pointers still
+// spread out, and always larger than alloc, so that it has an empty slot.
+static inline size_t map_index_size(size_t alloc) {
+    return (alloc + alloc / 2 + 1) | 1;
+}
+
+static inline size_t map_index_width(size_t alloc) {
+    return alloc < 0xff ? 1 : alloc < 0xffff ? 2 : 4;
+}
+
+static inline bool map_is_linear(size_t alloc, bool qstr_keys) {
+    return alloc <= MAP_LINEAR_MAX && qstr_keys;
+}
+
+static size_t map_table_nbytes(size_t alloc, bool qstr_keys) {
+    if (map_is_linear(alloc, qstr_keys)) {
+        return alloc * sizeof(mp_map_elem_t);
+    }
+    return alloc * sizeof(mp_map_elem_t) + (map_index_size(alloc) + 1) * map_index_width(alloc);
+}
+
+// Returns the number of element slots used, given the last slot that may be.
+static inline size_t map_linear_filled(const mp_map_t *map, size_t top) {
+    while (top > 0 && map->table[top - 1].key == MP_OBJ_NULL) {
+        --top;
+    }
+    return top;
+}
+
+// Turns deleted elements at the end into unused slots, returning the new
+// number of element slots used.
+static size_t map_trim(mp_map_t *map, size_t filled) {
+    while (filled > 0 && map->table[filled - 1].key == MP_OBJ_SENTINEL) {
+        map->table[--filled].key = MP_OBJ_NULL;
+    }
+    return filled;
+}
+
+static inline size_t map_index_get(const mp_map_t *map, size_t pos) {
+    const void *index = &map->table[map->alloc];
+    size_t i;
+    if (map->alloc < 0xff) {
+        i = ((const uint8_t *)index)[pos];
+        return i == 0xff ? MAP_INDEX_DELETED : i;
+    } else if (map->alloc < 0xffff) {
+        i = ((const uint16_t *)index)[pos];
+        return i == 0xffff ? MAP_INDEX_DELETED : i;
+    } else {
+        i = ((const uint32_t *)index)[pos];
+        return i == 0xffffffff ? MAP_INDEX_DELETED : i;
+    }
+}
+
+static inline void map_index_set(mp_map_t *map, size_t pos, size_t i) {
+    void *index = &map->table[map->alloc];
+    if (map->alloc < 0xff) {
+        ((uint8_t *)index)[pos] = i;
+    } else if (map->alloc < 0xffff) {
+        ((uint16_t *)index)[pos] = i;
+    } else {
+        ((uint32_t *)index)[pos] = i;
+    }
+}
+
+#define MAP_TABLE_NBYTES(alloc, qstr_keys) map_table_nbytes(alloc, qstr_keys)
+
+#else
+
+#define MAP_TABLE_NBYTES(alloc, qstr_keys) ((alloc) * sizeof(mp_map_elem_t))
+
+#endif
+
+static inline mp_uint_t map_hash(mp_obj_t index) {
+    // fast path for common case of qstr
+    if (mp_obj_is_qstr(index)) {
+        return qstr_hash(MP_OBJ_QSTR_VALUE(index));
+    } else {
+        return MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
+    }
+}
+
 /******************************************************************************/
 /* map                                                                        */
 
@@ -92,7 +193,7 @@ void mp_map_init(mp_map_t *map, size_t n) {
         map->table = NULL;
     } else {
         map->alloc = n;
-        map->table = m_new0(mp_map_elem_t, map->alloc);
+        map->table = m_malloc0(MAP_TABLE_NBYTES(n, true));
     }
     map->used = 0;
     map->all_keys_are_qstrs = 1;
@@ -112,14 +213,14 @@ void mp_map_init_fixed_table(mp_map_t *map, size_t n, const mp_obj_t *table) {
 // Differentiate from mp_map_clear() - semantics is different
 void mp_map_deinit(mp_map_t *map) {
     if (!map->is_fixed) {
-        m_del(mp_map_elem_t, map->table, map->alloc);
+        m_del(byte, map->table, MAP_TABLE_NBYTES(map->alloc, map->all_keys_are_qstrs));
     }
     map->used = map->alloc = 0;
 }
 
 void mp_map_clear(mp_map_t *map) {
     if (!map->is_fixed) {
-        m_del(mp_map_elem_t, map->table, map->alloc);
+        m_del(byte, map->table, MAP_TABLE_NBYTES(map->alloc, map->all_keys_are_qstrs));
     }
     map->alloc = 0;
     map->used = 0;
@@ -128,7 +229,106 @@ void mp_map_clear(mp_map_t *map) {
     map->table = NULL;
 }
 
-static void mp_map_rehash(mp_map_t *map) {
+// Initialises map as a (non-fixed) copy of src.
+void mp_map_init_copy(mp_map_t *map, const mp_map_t *src) {
+    #if MICROPY_MAP_COMPACT
+    if (src->is_ordered) {
+        // build a compact map from the array
+        mp_map_init(map, src->used);
+        for (size_t i = 0; i < src->used; i++) {
+            mp_map_lookup(map, src->table[i].key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = src->table[i].value;
+        }
+        return;
+    }
+    #endif
+    // the table layout depends on the key types, so copy it as it is
+    mp_map_init(map, 0);
+    map->alloc = src->alloc;
+    map->used = src->used;
+    map->all_keys_are_qstrs = src->all_keys_are_qstrs;
+    map->is_ordered = src->is_ordered;
+    if (src->alloc != 0) {
+        size_t nbytes = MAP_TABLE_NBYTES(src->alloc, src->all_keys_are_qstrs);
+        map->table = m_malloc(nbytes);
+        memcpy(map->table, src->table, nbytes);
+    }
+}
+
+#if MICROPY_MAP_COMPACT
+
+// Adds position i to the index, at the first free slot for hash.
+static void map_index_add(mp_map_t *map, size_t size, mp_uint_t hash, size_t i) {
+    size_t pos = hash % size;
+    while (map_index_get(map, pos) != 0) {
+        if (++pos == size) {
+            pos = 0;
+        }
+    }
+    map_index_set(map, pos, i + 1);
+}
+
+// Moves the elements to a new table, dropping deleted ones, and rebuilds the
+// index.  The table grows unless enough of it was taken by deleted elements.
+// index is the key about to be added, which decides whether it needs an index.
+static void mp_map_rehash(mp_map_t *map, mp_obj_t index) {
+    size_t old_alloc = map->alloc;
+    size_t new_alloc;
+    if (map->used + map->used / 4 >= old_alloc) {
+        new_alloc = get_hash_alloc_greater_or_equal_to(old_alloc + 1);
+    } else {
+        new_alloc = get_hash_alloc_greater_or_equal_to(map->used + 1);
+    }
+    DEBUG_printf("mp_map_rehash(%p): " UINT_FMT " -> " UINT_FMT "\n", map, old_alloc, new_alloc);
+    bool qstr_keys = mp_obj_is_qstr(index);
+    for (size_t i = 0; i < old_alloc && qstr_keys; i++) {
+        if (mp_map_slot_is_filled(map, i) && !mp_obj_is_qstr(map->table[i].key)) {
+            qstr_keys = false;
+        }
+    }
+    bool linear = map_is_linear(new_alloc, qstr_keys);
+    mp_map_t new_map = *map;
+    new_map.alloc = new_alloc;
+    new_map.all_keys_are_qstrs = qstr_keys;
+    new_map.table = m_malloc0(map_table_nbytes(new_alloc, qstr_keys));
+    // Hashing a key may raise, so only edit the old map once this is done.
+    size_t size = map_index_size(new_alloc);
+    size_t n = 0;
+    for (size_t i = 0; i < old_alloc; i++) {
+        if (mp_map_slot_is_filled(map, i)) {
+            mp_obj_t key = map->table[i].key;
+            new_map.table[n] = map->table[i];
+            if (!linear) {
+                map_index_add(&new_map, size, map_hash(key), n);
+            }
+            n++;
+        }
+    }
+    if (!linear) {
+        map_index_set(&new_map, size, n);
+    }
+    m_del(byte, map->table, map_table_nbytes(old_alloc, map->all_keys_are_qstrs));
+    *map = new_map;
+}
+
+// Returns the most recently added element, or NULL if the map is empty.
+mp_map_elem_t *mp_map_last(mp_map_t *map) {
+    if (map->used == 0) {
+        return NULL;
+    }
+    if (map->is_ordered) {
+        return &map->table[map->used - 1];
+    }
+    // deleted elements are trimmed from the end, so the last one is filled
+    if (map_is_linear(map->alloc, map->all_keys_are_qstrs)) {
+        return &map->table[map_linear_filled(map, map->alloc) - 1];
+    }
+    return &map->table[map_index_get(map, map_index_size(map->alloc)) - 1];
+}
+
+#else
+
+static void mp_map_rehash(mp_map_t *map, mp_obj_t index) {
+    (void)index;
     size_t old_alloc = map->alloc;
     size_t new_alloc = get_hash_alloc_greater_or_equal_to(map->alloc + 1);
     DEBUG_printf("mp_map_rehash(%p): " UINT_FMT " -> " UINT_FMT "\n", map, old_alloc, new_alloc);
@@ -147,6 +347,8 @@ static void mp_map_rehash(mp_map_t *map) {
     m_del(mp_map_elem_t, old_table, old_alloc);
 }
 
+#endif
+
 // MP_MAP_LOOKUP behaviour:
 //  - returns NULL if not found, else the slot it was found in with key,value non-null
 // MP_MAP_LOOKUP_ADD_IF_NOT_FOUND behaviour:
@@ -235,20 +437,116 @@ mp_map_elem_t *MICROPY_WRAP_MP_MAP_LOOKUP(mp_map_lookup)(mp_map_t * map, mp_obj_
 
     if (map->alloc == 0) {
         if (lookup_kind == MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
-            mp_map_rehash(map);
+            mp_map_rehash(map, index);
         } else {
             return NULL;
         }
     }
 
-    // get hash of index, with fast path for common case of qstr
-    mp_uint_t hash;
-    if (mp_obj_is_qstr(index)) {
-        hash = qstr_hash(MP_OBJ_QSTR_VALUE(index));
-    } else {
-        hash = MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
+    mp_uint_t hash = map_hash(index);
+
+    #if MICROPY_MAP_COMPACT
+
+    for (;;) {
+        if (map_is_linear(map->alloc, map->all_keys_are_qstrs)) {
+            // small map of qstrs without an index, so search it like an ordered one
+            mp_map_elem_t *elem = &map->table[0], *top = &map->table[map->alloc];
+            for (; elem < top && elem->key != MP_OBJ_NULL; elem++) {
+                if (elem->key == index || (!compare_only_ptrs && elem->key != MP_OBJ_SENTINEL && mp_obj_equal(elem->key, index))) {
+                    if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
+                        // delete element, keeping its value so that caller can access it if needed
+                        map->used--;
+                        elem->key = MP_OBJ_SENTINEL;
+                        map_trim(map, map_linear_filled(map, map->alloc));
+                    }
+                    MAP_CACHE_SET(index, elem - map->table);
+                    return elem;
+                }
+            }
+            if (lookup_kind != MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+                return NULL;
+            }
+            if (elem < top && mp_obj_is_qstr(index)) {
+                // add index as a new element at the end
+                map->used++;
+                elem->key = index;
+                elem->value = MP_OBJ_NULL;
+                return elem;
+            }
+            // full, or index needs the map to have an index
+            mp_map_rehash(map, index);
+            continue;
+        }
+
+        size_t size = map_index_size(map->alloc);
+        size_t pos = hash % size;
+        size_t start_pos = pos;
+        size_t avail_pos = MAP_INDEX_DELETED;
+        for (;;) {
+            size_t i = map_index_get(map, pos);
+            if (i == 0) {
+                // found empty slot, so index is not in table
+                avail_pos = avail_pos == MAP_INDEX_DELETED ? pos : avail_pos;
+                break;
+            } else if (i == MAP_INDEX_DELETED) {
+                // found deleted slot, remember for later
+                if (avail_pos == MAP_INDEX_DELETED) {
+                    avail_pos = pos;
+                }
+            } else {
+                mp_map_elem_t *elem = &map->table[i - 1];
+                if (elem->key == index || (!compare_only_ptrs && mp_obj_equal(elem->key, index))) {
+                    // found index
+                    // Note: CPython does not replace the index; try x={True:'true'};x[1]='one';x
+                    if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
+                        // delete element, keeping its value so that caller can access it if needed
+                        map->used--;
+                        map_index_set(map, pos, MAP_INDEX_DELETED);
+                        elem->key = MP_OBJ_SENTINEL;
+                        // trim deleted elements from the end, so that slots are reused
+                        // when the last element is removed, eg by popitem()
+                        map_index_set(map, size, map_trim(map, map_index_get(map, size)));
+                    }
+                    MAP_CACHE_SET(index, i - 1);
+                    return elem;
+                }
+            }
+
+            // not yet found, keep searching in this table
+            if (++pos == size) {
+                pos = 0;
+            }
+            if (pos == start_pos) {
+                // search got back to starting position, so index is not in table
+                break;
+            }
+        }
+
+        if (lookup_kind != MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+            return NULL;
+        }
+
+        // add index as a new element at the end, if there is room
+        size_t filled = map_index_get(map, size);
+        if (filled < map->alloc) {
+            map_index_set(map, avail_pos, filled + 1);
+            map_index_set(map, size, filled + 1);
+            map->used++;
+            mp_map_elem_t *elem = &map->table[filled];
+            elem->key = index;
+            elem->value = MP_OBJ_NULL;
+            if (!mp_obj_is_qstr(index)) {
+                map->all_keys_are_qstrs = 0;
+            }
+            return elem;
+        }
+
+        // not enough room in table, rehash it and restart the search
+        mp_map_rehash(map, index);
     }
 
+    #else
+
     size_t pos = hash % map->alloc;
     size_t start_pos = pos;
     mp_map_elem_t *avail_slot = NULL;
@@ -310,7 +608,7 @@ mp_map_elem_t *MICROPY_WRAP_MP_MAP_LOOKUP(mp_map_lookup)(mp_map_t * map, mp_obj_
                     return avail_slot;
                 } else {
                     // not enough room in table, rehash it
-                    mp_map_rehash(map);
+                    mp_map_rehash(map, index);
                     // restart the search for the new element
                     start_pos = pos = hash % map->alloc;
                 }
@@ -319,6 +617,8 @@ mp_map_elem_t *MICROPY_WRAP_MP_MAP_LOOKUP(mp_map_lookup)(mp_map_t * map, mp_obj_
             }
         }
     }
+
+    #endif
 }
 
 /******************************************************************************/
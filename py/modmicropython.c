@@ -31,6 +31,7 @@
 #include "py/runtime.h"
 #include "py/gc.h"
 #include "py/mphal.h"
+#include "py/profile.h"
 
 #if MICROPY_PY_MICROPYTHON
 
@@ -163,6 +164,19 @@ static MP_DEFINE_CONST_FUN_OBJ_1(mp_micropython_kbd_intr_obj, mp_micropython_kbd
 #endif
 
 #if MICROPY_ENABLE_SCHEDULER
+#if MICROPY_SCHEDULER_PRIORITIES > 1
+static mp_obj_t mp_micropython_schedule(size_t n_args, const mp_obj_t *args) {
+    mp_int_t priority = 0;
+    if (n_args > 2) {
+        priority = mp_arg_validate_int_range(mp_obj_get_int(args[2]), 0, MICROPY_SCHEDULER_PRIORITIES - 1, MP_QSTR_priority);
+    }
+    if (!mp_sched_schedule_priority(args[0], args[1], priority)) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("schedule queue full"));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_schedule_obj, 2, 3, mp_micropython_schedule);
+#else
 static mp_obj_t mp_micropython_schedule(mp_obj_t function, mp_obj_t arg) {
     if (!mp_sched_schedule(function, arg)) {
         mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("schedule queue full"));
@@ -171,6 +185,29 @@ static mp_obj_t mp_micropython_schedule(mp_obj_t function, mp_obj_t arg) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_2(mp_micropython_schedule_obj, mp_micropython_schedule);
 #endif
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROF_SAMPLING
+static mp_obj_t mp_micropython_prof_start(size_t n_args, const mp_obj_t *args) {
+    mp_int_t interval_us = n_args == 0 ? 1000 : mp_obj_get_int(args[0]);
+    if (interval_us <= 0) {
+        mp_raise_ValueError(NULL);
+    }
+    mp_prof_sample_start(interval_us);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_prof_start_obj, 0, 1, mp_micropython_prof_start);
+
+static mp_obj_t mp_micropython_prof_stop(void) {
+    return mp_obj_new_int_from_uint(mp_prof_sample_stop());
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_prof_stop_obj, mp_micropython_prof_stop);
+
+static mp_obj_t mp_micropython_prof_dump(size_t n_args, const mp_obj_t *args) {
+    return mp_prof_sample_dump(n_args > 0 && mp_obj_is_true(args[0]));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_prof_dump_obj, 0, 1, mp_micropython_prof_dump);
+#endif
 
 static const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_micropython) },
@@ -216,6 +253,11 @@ static const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     #if MICROPY_ENABLE_SCHEDULER
     { MP_ROM_QSTR(MP_QSTR_schedule), MP_ROM_PTR(&mp_micropython_schedule_obj) },
     #endif
+    #if MICROPY_PY_MICROPYTHON_PROF_SAMPLING
+    { MP_ROM_QSTR(MP_QSTR_prof_start), MP_ROM_PTR(&mp_micropython_prof_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_prof_stop), MP_ROM_PTR(&mp_micropython_prof_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_prof_dump), MP_ROM_PTR(&mp_micropython_prof_dump_obj) },
+    #endif
 };
 
 static MP_DEFINE_CONST_DICT(mp_module_micropython_globals, mp_module_micropython_globals_table);
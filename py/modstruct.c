@@ -32,9 +32,11 @@
 #include "py/builtin.h"
 #include "py/objtuple.h"
 #include "py/binary.h"
+#include "py/modstruct.h"
 #include "py/parsenum.h"
 
-#if MICROPY_PY_STRUCT
+// CIRCUITPY-CHANGE: the parsed formats are also used by shared-module/struct
+#if MICROPY_PY_STRUCT || CIRCUITPY_STRUCT
 
 /*
     This module implements most of character typecodes from CPython, with
@@ -82,191 +84,303 @@ static mp_uint_t get_fmt_num(const char **p) {
     return val;
 }
 
-static size_t calc_size_items(const char *fmt, size_t *total_sz) {
-    char fmt_type = get_fmt_type(&fmt);
-    size_t total_cnt = 0;
-    size_t size;
-    for (size = 0; *fmt; fmt++) {
+// Parses fmt, setting the size and number of items of self and storing the
+// fields in self->fields if they have been allocated.  Returns the number of
+// fields.
+static size_t struct_parse(mp_obj_struct_t *self, const char *fmt, bool store) {
+    self->fmt_type = get_fmt_type(&fmt);
+    size_t size = 0;
+    size_t num_items = 0;
+    size_t num_fields = 0;
+    for (; *fmt; fmt++) {
         mp_uint_t cnt = 1;
         if (unichar_isdigit(*fmt)) {
             cnt = get_fmt_num(&fmt);
         }
 
+        size_t offset = size;
         if (*fmt == 'x') {
             size += cnt;
         } else if (*fmt == 's') {
-            total_cnt += 1;
+            num_items += 1;
             size += cnt;
         } else {
-            total_cnt += cnt;
+            // All the types have a size that is a multiple of their alignment,
+            // so only the first item of a run needs aligning.
             size_t align;
-            size_t sz = mp_binary_get_size(fmt_type, *fmt, &align);
-            while (cnt--) {
-                // Apply alignment
-                size = (size + align - 1) & ~(align - 1);
-                size += sz;
+            size_t sz = mp_binary_get_size(self->fmt_type, *fmt, &align);
+            offset = (size + align - 1) & ~(align - 1);
+            num_items += cnt;
+            size = offset + sz * cnt;
+            if (cnt == 0) {
+                continue;
             }
         }
+        if (store) {
+            struct_field_t *f = &self->fields[num_fields];
+            f->offset = offset;
+            f->count = cnt;
+            f->type = *fmt;
+        }
+        num_fields += 1;
     }
-    *total_sz = size;
-    return total_cnt;
+    self->size = size;
+    self->num_items = num_items;
+    return num_fields;
 }
 
-static mp_obj_t struct_calcsize(mp_obj_t fmt_in) {
+mp_obj_struct_t *mp_struct_new(const mp_obj_type_t *type, mp_obj_t fmt_in) {
     const char *fmt = mp_obj_str_get_str(fmt_in);
-    size_t size;
-    calc_size_items(fmt, &size);
-    return MP_OBJ_NEW_SMALL_INT(size);
+    mp_obj_struct_t parsed;
+    size_t num_fields = struct_parse(&parsed, fmt, false);
+    mp_obj_struct_t *self = mp_obj_malloc_var(mp_obj_struct_t, fields, struct_field_t, num_fields, type);
+    self->format = fmt_in;
+    self->num_fields = num_fields;
+    struct_parse(self, fmt, true);
+    return self;
 }
-MP_DEFINE_CONST_FUN_OBJ_1(struct_calcsize_obj, struct_calcsize);
 
-static mp_obj_t struct_unpack_from(size_t n_args, const mp_obj_t *args) {
-    // unpack requires that the buffer be exactly the right size.
-    // unpack_from requires that the buffer be "big enough".
-    // Since we implement unpack and unpack_from using the same function
-    // we relax the "exact" requirement, and only implement "big enough".
-    const char *fmt = mp_obj_str_get_str(args[0]);
-    size_t total_sz;
-    size_t num_items = calc_size_items(fmt, &total_sz);
-    char fmt_type = get_fmt_type(&fmt);
-    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(num_items, NULL));
-    mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_READ);
-    byte *p = bufinfo.buf;
-    byte *end_p = &p[bufinfo.len];
-    mp_int_t offset = 0;
-
-    if (n_args > 2) {
-        // offset arg provided
-        offset = mp_obj_get_int(args[2]);
-        if (offset < 0) {
-            // negative offsets are relative to the end of the buffer
-            offset = bufinfo.len + offset;
-            if (offset < 0) {
-                mp_raise_ValueError(MP_ERROR_TEXT("buffer too small"));
+mp_obj_t mp_struct_unpack_internal(mp_obj_struct_t *self, byte *p_base) {
+    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(self->num_items, NULL));
+    mp_obj_t *items = res->items;
+    for (size_t i = 0; i < self->num_fields; ++i) {
+        const struct_field_t *f = &self->fields[i];
+        byte *p = p_base + f->offset;
+        if (f->type == 's') {
+            *items++ = mp_obj_new_bytes(p, f->count);
+        } else if (f->type != 'x') {
+            for (size_t j = 0; j < f->count; ++j) {
+                *items++ = mp_binary_get_val(self->fmt_type, f->type, p_base, &p);
             }
         }
-        p += offset;
-    }
-    byte *p_base = p;
-
-    // Check that the input buffer is big enough to unpack all the values
-    if (p + total_sz > end_p) {
-        mp_raise_ValueError(MP_ERROR_TEXT("buffer too small"));
-    }
-
-    for (size_t i = 0; i < num_items;) {
-        mp_uint_t cnt = 1;
-        if (unichar_isdigit(*fmt)) {
-            cnt = get_fmt_num(&fmt);
-        }
-        mp_obj_t item;
-        if (*fmt == 'x') {
-            p += cnt;
-        } else if (*fmt == 's') {
-            item = mp_obj_new_bytes(p, cnt);
-            p += cnt;
-            res->items[i++] = item;
-        } else {
-            while (cnt--) {
-                item = mp_binary_get_val(fmt_type, *fmt, p_base, &p);
-                res->items[i++] = item;
-            }
-        }
-        fmt++;
     }
     return MP_OBJ_FROM_PTR(res);
 }
-MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_unpack_from_obj, 2, 3, struct_unpack_from);
-
-// This function assumes there is enough room in p to store all the values
-static void struct_pack_into_internal(mp_obj_t fmt_in, byte *p, size_t n_args, const mp_obj_t *args) {
-    // CIRCUITPY-CHANGE: additional error checking
-    size_t size;
-    size_t count = calc_size_items(mp_obj_str_get_str(fmt_in), &size);
-    if (count != n_args) {
-        #if MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_TERSE
-        mp_raise_ValueError(NULL);
-        #else
-        mp_raise_ValueError_varg(MP_ERROR_TEXT("pack expected %d items for packing (got %d)"), count, n_args);
-        #endif
-    }
-    const char *fmt = mp_obj_str_get_str(fmt_in);
-    char fmt_type = get_fmt_type(&fmt);
 
-    byte *p_base = p;
-    size_t i;
-    for (i = 0; i < n_args;) {
-        mp_uint_t cnt = 1;
-        if (*fmt == '\0') {
-            // more arguments given than used by format string; CPython raises struct.error here
-            break;
-        }
-        if (unichar_isdigit(*fmt)) {
-            cnt = get_fmt_num(&fmt);
-        }
-
-        if (*fmt == 'x') {
-            memset(p, 0, cnt);
-            p += cnt;
-        } else if (*fmt == 's') {
+void mp_struct_pack_into_internal(mp_obj_struct_t *self, byte *p_base, size_t n_args, const mp_obj_t *args) {
+    for (size_t i = 0; i < self->num_fields; ++i) {
+        const struct_field_t *f = &self->fields[i];
+        byte *p = p_base + f->offset;
+        if (f->type == 'x') {
+            memset(p, 0, f->count);
+        } else if (f->type == 's') {
             mp_buffer_info_t bufinfo;
-            mp_get_buffer_raise(args[i++], &bufinfo, MP_BUFFER_READ);
-            mp_uint_t to_copy = cnt;
+            mp_get_buffer_raise(*args++, &bufinfo, MP_BUFFER_READ);
+            mp_uint_t to_copy = f->count;
             if (bufinfo.len < to_copy) {
                 to_copy = bufinfo.len;
             }
             memcpy(p, bufinfo.buf, to_copy);
-            memset(p + to_copy, 0, cnt - to_copy);
-            p += cnt;
+            memset(p + to_copy, 0, f->count - to_copy);
         } else {
-            // If we run out of args then we just finish; CPython would raise struct.error
-            while (cnt-- && i < n_args) {
-                mp_binary_set_val(fmt_type, *fmt, args[i++], p_base, &p);
+            for (size_t j = 0; j < f->count; ++j) {
+                mp_binary_set_val(self->fmt_type, f->type, *args++, p_base, &p);
             }
         }
-        fmt++;
     }
 }
 
-static mp_obj_t struct_pack(size_t n_args, const mp_obj_t *args) {
-    // TODO: "The arguments must match the values required by the format exactly."
-    mp_int_t size = MP_OBJ_SMALL_INT_VALUE(struct_calcsize(args[0]));
-    vstr_t vstr;
-    vstr_init_len(&vstr, size);
-    byte *p = (byte *)vstr.buf;
-    memset(p, 0, size);
-    struct_pack_into_internal(args[0], p, n_args - 1, &args[1]);
-    return mp_obj_new_bytes_from_vstr(&vstr);
-}
-MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_pack);
+typedef struct _struct_iter_unpack_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_struct_t *s;
+    mp_obj_t buf;
+    size_t offset;
+} struct_iter_unpack_t;
 
-static mp_obj_t struct_pack_into(size_t n_args, const mp_obj_t *args) {
+static mp_obj_t struct_iter_unpack_iternext(mp_obj_t self_in) {
+    struct_iter_unpack_t *self = MP_OBJ_TO_PTR(self_in);
     mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
-    mp_int_t offset = mp_obj_get_int(args[2]);
+    mp_get_buffer_raise(self->buf, &bufinfo, MP_BUFFER_READ);
+    if (self->offset + self->s->size > bufinfo.len) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    mp_obj_t res = mp_struct_unpack_internal(self->s, (byte *)bufinfo.buf + self->offset);
+    self->offset += self->s->size;
+    return res;
+}
+
+mp_obj_t mp_struct_iter_unpack_new(mp_obj_struct_t *self, mp_obj_t buf_in) {
+    struct_iter_unpack_t *o = mp_obj_malloc(struct_iter_unpack_t, &mp_type_polymorph_iter);
+    o->iternext = struct_iter_unpack_iternext;
+    o->s = self;
+    o->buf = buf_in;
+    o->offset = 0;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+#endif // MICROPY_PY_STRUCT || CIRCUITPY_STRUCT
+
+#if MICROPY_PY_STRUCT
+
+static const mp_obj_type_t mp_type_struct;
+
+// The module-level functions reuse the compiled form of the last format they
+// were given, so that calling them repeatedly with the same format only parses
+// it once.
+static mp_obj_struct_t *struct_get_cached(mp_obj_t fmt_in) {
+    mp_obj_struct_t *self = MP_STATE_VM(struct_format_cache);
+    if (self == NULL || (self->format != fmt_in && !mp_obj_equal(self->format, fmt_in))) {
+        self = mp_struct_new(&mp_type_struct, fmt_in);
+        MP_STATE_VM(struct_format_cache) = self;
+    }
+    return self;
+}
+
+static mp_obj_t struct_calcsize(mp_obj_t fmt_in) {
+    return MP_OBJ_NEW_SMALL_INT(struct_get_cached(fmt_in)->size);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(struct_calcsize_obj, struct_calcsize);
+
+// Returns a pointer into the buffer at the given offset, which may be negative
+// to count from the end, checking that there is room for a record of size bytes.
+static byte *struct_get_ptr(mp_buffer_info_t *bufinfo, mp_int_t offset, size_t size) {
     if (offset < 0) {
         // negative offsets are relative to the end of the buffer
-        offset = (mp_int_t)bufinfo.len + offset;
+        offset = (mp_int_t)bufinfo->len + offset;
         if (offset < 0) {
             mp_raise_ValueError(MP_ERROR_TEXT("buffer too small"));
         }
     }
-    byte *p = (byte *)bufinfo.buf;
-    byte *end_p = &p[bufinfo.len];
-    p += offset;
-
-    // Check that the output buffer is big enough to hold all the values
-    mp_int_t sz = MP_OBJ_SMALL_INT_VALUE(struct_calcsize(args[0]));
-    if (p + sz > end_p) {
+    // Check that the buffer is big enough for all the values
+    if ((size_t)offset > bufinfo->len || size > bufinfo->len - offset) {
         mp_raise_ValueError(MP_ERROR_TEXT("buffer too small"));
     }
+    return (byte *)bufinfo->buf + offset;
+}
+
+// unpack requires that the buffer be exactly the right size.
+// unpack_from requires that the buffer be "big enough".
+// Since we implement unpack and unpack_from using the same function
+// we relax the "exact" requirement, and only implement "big enough".
+static mp_obj_t struct_unpack_from_helper(mp_obj_struct_t *self, size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_READ);
+    mp_int_t offset = n_args > 1 ? mp_obj_get_int(args[1]) : 0;
+    return mp_struct_unpack_internal(self, struct_get_ptr(&bufinfo, offset, self->size));
+}
 
-    struct_pack_into_internal(args[0], p, n_args - 3, &args[3]);
+static mp_obj_t struct_unpack_from(size_t n_args, const mp_obj_t *args) {
+    return struct_unpack_from_helper(struct_get_cached(args[0]), n_args - 1, args + 1);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_unpack_from_obj, 2, 3, struct_unpack_from);
+
+// CIRCUITPY-CHANGE: additional error checking
+static void struct_check_num_items(mp_obj_struct_t *self, size_t n_args) {
+    if (self->num_items != n_args) {
+        #if MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_TERSE
+        mp_raise_ValueError(NULL);
+        #else
+        mp_raise_ValueError_varg(MP_ERROR_TEXT("pack expected %d items for packing (got %d)"), self->num_items, n_args);
+        #endif
+    }
+}
+
+static mp_obj_t struct_pack_helper(mp_obj_struct_t *self, size_t n_args, const mp_obj_t *args) {
+    struct_check_num_items(self, n_args);
+    vstr_t vstr;
+    vstr_init_len(&vstr, self->size);
+    byte *p = (byte *)vstr.buf;
+    memset(p, 0, self->size);
+    mp_struct_pack_into_internal(self, p, n_args, args);
+    return mp_obj_new_bytes_from_vstr(&vstr);
+}
+
+static mp_obj_t struct_pack(size_t n_args, const mp_obj_t *args) {
+    return struct_pack_helper(struct_get_cached(args[0]), n_args - 1, args + 1);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_pack);
+
+static mp_obj_t struct_pack_into_helper(mp_obj_struct_t *self, size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_WRITE);
+    byte *p = struct_get_ptr(&bufinfo, mp_obj_get_int(args[1]), self->size);
+    struct_check_num_items(self, n_args - 2);
+    mp_struct_pack_into_internal(self, p, n_args - 2, args + 2);
     return mp_const_none;
 }
+
+static mp_obj_t struct_pack_into(size_t n_args, const mp_obj_t *args) {
+    return struct_pack_into_helper(struct_get_cached(args[0]), n_args - 1, args + 1);
+}
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_pack_into);
 
+static mp_obj_t struct_iter_unpack_helper(mp_obj_struct_t *self, mp_obj_t buf_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    if (self->size == 0 || bufinfo.len % self->size != 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer size must be a multiple of the format size"));
+    }
+    return mp_struct_iter_unpack_new(self, buf_in);
+}
+
+static mp_obj_t struct_iter_unpack(mp_obj_t fmt_in, mp_obj_t buf_in) {
+    return struct_iter_unpack_helper(struct_get_cached(fmt_in), buf_in);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(struct_iter_unpack_obj, struct_iter_unpack);
+
+/******************************************************************************/
+// Struct type
+
+static mp_obj_t struct_Struct_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    return MP_OBJ_FROM_PTR(mp_struct_new(type, args[0]));
+}
+
+static mp_obj_t struct_Struct_pack(size_t n_args, const mp_obj_t *args) {
+    return struct_pack_helper(MP_OBJ_TO_PTR(args[0]), n_args - 1, args + 1);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_Struct_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_Struct_pack);
+
+static mp_obj_t struct_Struct_pack_into(size_t n_args, const mp_obj_t *args) {
+    return struct_pack_into_helper(MP_OBJ_TO_PTR(args[0]), n_args - 1, args + 1);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_Struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_Struct_pack_into);
+
+static mp_obj_t struct_Struct_unpack_from(size_t n_args, const mp_obj_t *args) {
+    return struct_unpack_from_helper(MP_OBJ_TO_PTR(args[0]), n_args - 1, args + 1);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_Struct_unpack_from_obj, 2, 3, struct_Struct_unpack_from);
+
+static mp_obj_t struct_Struct_iter_unpack(mp_obj_t self_in, mp_obj_t buf_in) {
+    return struct_iter_unpack_helper(MP_OBJ_TO_PTR(self_in), buf_in);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(struct_Struct_iter_unpack_obj, struct_Struct_iter_unpack);
+
+static void struct_Struct_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    if (dest[0] != MP_OBJ_NULL) {
+        // not load attribute
+        return;
+    }
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(self_in);
+    if (attr == MP_QSTR_format) {
+        dest[0] = self->format;
+    } else if (attr == MP_QSTR_size) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->size);
+    } else {
+        // continue lookup in locals_dict
+        dest[1] = MP_OBJ_SENTINEL;
+    }
+}
+
+static const mp_rom_map_elem_t struct_Struct_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_pack), MP_ROM_PTR(&struct_Struct_pack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_Struct_pack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_Struct_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_Struct_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_Struct_iter_unpack_obj) },
+};
+static MP_DEFINE_CONST_DICT(struct_Struct_locals_dict, struct_Struct_locals_dict_table);
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+    mp_type_struct,
+    MP_QSTR_Struct,
+    MP_TYPE_FLAG_NONE,
+    make_new, struct_Struct_make_new,
+    attr, struct_Struct_attr,
+    locals_dict, &struct_Struct_locals_dict
+    );
+
 static const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_struct) },
     { MP_ROM_QSTR(MP_QSTR_calcsize), MP_ROM_PTR(&struct_calcsize_obj) },
@@ -274,6 +388,8 @@ static const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_pack_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_unpack_from_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_iter_unpack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Struct), MP_ROM_PTR(&mp_type_struct) },
 };
 
 static MP_DEFINE_CONST_DICT(mp_module_struct_globals, mp_module_struct_globals_table);
@@ -285,4 +401,6 @@ const mp_obj_module_t mp_module_struct = {
 
 MP_REGISTER_EXTENSIBLE_MODULE(MP_QSTR_struct, mp_module_struct);
 
+MP_REGISTER_ROOT_POINTER(struct _mp_obj_struct_t *struct_format_cache);
+
 #endif
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013, 2014 Damien P. George
+ * Copyright (c) 2014 Paul Sokolovsky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_PY_MODSTRUCT_H
+#define MICROPY_INCLUDED_PY_MODSTRUCT_H
+
+#include "py/obj.h"
+
+// The parsed formats of the struct module, also used by CircuitPython's
+// struct module in shared-bindings/struct.
+
+// A run of items of the same type in a compiled format.  Pad bytes ('x') are
+// kept as runs so that pack_into can zero them, but don't produce items.
+typedef struct _struct_field_t {
+    uint32_t offset; // offset of the first item from the start of the record
+    uint32_t count; // number of items, or number of bytes for 's' and 'x'
+    char type;
+} struct_field_t;
+
+// A format string parsed once into its size, number of items and fields.
+typedef struct _mp_obj_struct_t {
+    mp_obj_base_t base;
+    mp_obj_t format;
+    char fmt_type;
+    size_t size;
+    size_t num_items;
+    size_t num_fields;
+    struct_field_t fields[];
+} mp_obj_struct_t;
+
+// Parse fmt_in into a new object of the given type.
+mp_obj_struct_t *mp_struct_new(const mp_obj_type_t *type, mp_obj_t fmt_in);
+
+// Pack args into the record at p_base.  The caller must check that there are
+// self->num_items args, and that there is room for self->size bytes.
+void mp_struct_pack_into_internal(mp_obj_struct_t *self, byte *p_base, size_t n_args, const mp_obj_t *args);
+
+// Unpack the record at p_base into a tuple of self->num_items items.
+mp_obj_t mp_struct_unpack_internal(mp_obj_struct_t *self, byte *p_base);
+
+// Return an iterator unpacking the records of buf_in one after another.  The
+// caller must check that the buffer size is a multiple of a non-zero size.
+mp_obj_t mp_struct_iter_unpack_new(mp_obj_struct_t *self, mp_obj_t buf_in);
+
+#endif // MICROPY_INCLUDED_PY_MODSTRUCT_H
@@ -212,6 +212,88 @@
 #define MICROPY_GC_ALLOC_THRESHOLD (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_CORE_FEATURES)
 #endif
 
+// Whether the sweep phase of the GC handles a whole allocation table byte at
+// once when it contains nothing to free (only free, marked and tail blocks).
+// This makes the sweep of long-lived and unused parts of the heap several
+// times cheaper, which matters most for large heaps.
+#ifndef MICROPY_GC_FAST_SWEEP
+#define MICROPY_GC_FAST_SWEEP (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
+// Whether a collection started by gc_alloc (when it runs out of memory or
+// reaches the allocation threshold) leaves its sweep phase pending, to be
+// done a slice at a time by the following allocations.  This bounds the
+// pause of such a collection to the mark phase plus one slice of the sweep.
+// Explicit calls to gc_collect() still sweep the whole heap.
+#ifndef MICROPY_GC_INCREMENTAL_SWEEP
+#define MICROPY_GC_INCREMENTAL_SWEEP (0)
+#endif
+
+// Number of blocks each allocation sweeps while an incremental sweep is pending.
+#ifndef MICROPY_GC_INCREMENTAL_SWEEP_SLICE
+#define MICROPY_GC_INCREMENTAL_SWEEP_SLICE (1024)
+#endif
+
+// Whether the GC can trace the heap with several threads at once.  The roots
+// are still found by the collecting thread, then the port's
+// mp_thread_gc_parallel() runs the tracing on up to
+// MICROPY_GC_PARALLEL_MARK_THREADS threads.  Requires MICROPY_PY_THREAD.
+#ifndef MICROPY_GC_PARALLEL_MARK
+#define MICROPY_GC_PARALLEL_MARK (0)
+#endif
+
+// Maximum number of threads, including the collecting one, for parallel marking.
+#ifndef MICROPY_GC_PARALLEL_MARK_THREADS
+#define MICROPY_GC_PARALLEL_MARK_THREADS (4)
+#endif
+
+// Heaps smaller than this many bytes are always marked by a single thread,
+// because starting the other threads would cost more than it saves.
+#ifndef MICROPY_GC_PARALLEL_MARK_MIN_HEAP
+#define MICROPY_GC_PARALLEL_MARK_MIN_HEAP (16 * 1024 * 1024)
+#endif
+
+// Number of entries in the mark stack of each thread, and in the pool through
+// which the threads share work, for parallel marking.  If both fill up, the
+// heap is rescanned for marked blocks afterwards, as with the GC stack.
+#ifndef MICROPY_ALLOC_GC_MARK_STACK_SIZE
+#define MICROPY_ALLOC_GC_MARK_STACK_SIZE (1024)
+#endif
+#ifndef MICROPY_ALLOC_GC_MARK_POOL_SIZE
+#define MICROPY_ALLOC_GC_MARK_POOL_SIZE (16384)
+#endif
+
+// How parallel marking allocates and frees the buffer for its pool and mark
+// stacks, which is only needed while a collection is being marked.  This must
+// not use the GC heap.  If it returns NULL the heap is marked by one thread.
+#ifndef MICROPY_GC_PARALLEL_MARK_MALLOC
+#define MICROPY_GC_PARALLEL_MARK_MALLOC(n) malloc(n)
+#endif
+#ifndef MICROPY_GC_PARALLEL_MARK_FREE
+#define MICROPY_GC_PARALLEL_MARK_FREE(ptr) free(ptr)
+#endif
+
+// Whether allocations flagged as long-lived (GC_ALLOC_FLAG_LONG_LIVED, used for
+// bytecode and interned strings) are placed from the end of the heap downward.
+// Keeping them away from short-lived objects at the start of the heap leaves
+// larger contiguous free runs after the short-lived objects are collected.
+#ifndef MICROPY_GC_LONG_LIVED
+#define MICROPY_GC_LONG_LIVED (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
+// Number of power-of-two allocation size classes (2, 4, 8, ... blocks) for
+// which each heap area remembers where free runs of that size can start.
+// This lets gc_alloc skip over fragmented parts of the heap that only have
+// smaller holes, instead of rescanning them for every allocation.  Set to 0
+// to only remember the first free block (used for 1-block allocations).
+#ifndef MICROPY_GC_ALLOC_SIZE_CLASSES
+#if MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES
+#define MICROPY_GC_ALLOC_SIZE_CLASSES (6)
+#else
+#define MICROPY_GC_ALLOC_SIZE_CLASSES (0)
+#endif
+#endif
+
 // Number of bytes to allocate initially when creating new chunks to store
 // interned string data.  Smaller numbers lead to more chunks being needed
 // and more wastage at the end of the chunk.  Larger numbers lead to wasted
@@ -311,6 +393,14 @@
 #endif
 #endif
 
+// Whether qstr_find_strn looks up qstrs through hash indexes instead of
+// searching each qstr pool: a table generated by makeqstrdata.py for the
+// firmware's qstrs, and one on the heap for the qstrs interned at runtime.
+// Requires MICROPY_QSTR_BYTES_IN_HASH.
+#ifndef MICROPY_QSTR_HASH_INDEX
+#define MICROPY_QSTR_HASH_INDEX (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES && MICROPY_QSTR_BYTES_IN_HASH)
+#endif
+
 // Avoid using C stack when making Python function calls. C stack still
 // may be used if there's no free heap.
 #ifndef MICROPY_STACKLESS
@@ -342,6 +432,13 @@
 #define MICROPY_PERSISTENT_CODE_LOAD (0)
 #endif
 
+// Whether loading persistent code from memory that stays valid for the life of
+// the program (see MP_READER_IS_ROM) uses its bytecode and strings in place,
+// rather than copying them to the heap.
+#ifndef MICROPY_PERSISTENT_CODE_LOAD_XIP
+#define MICROPY_PERSISTENT_CODE_LOAD_XIP (MICROPY_PERSISTENT_CODE_LOAD && MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Whether to support saving of persistent code, i.e. for mpy-cross to
 // generate .mpy files. Enabling this enables additional metadata on raw code
 // objects which is also required for sys.settrace.
@@ -432,6 +529,23 @@
 // Convenience definition for whether any native or inline assembler emitter is enabled
 #define MICROPY_EMIT_MACHINE_CODE (MICROPY_EMIT_NATIVE || MICROPY_EMIT_INLINE_ASM)
 
+// Whether the native emitter gives its registers for locals to the locals that are
+// used most (especially in loops), based on their live ranges, which also lets
+// viper locals whose live ranges don't overlap share a register.  Otherwise the
+// registers go to the first few locals.
+#ifndef MICROPY_EMIT_NATIVE_REG_ALLOC
+#define MICROPY_EMIT_NATIVE_REG_ALLOC (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
+// Whether viper code can use the simd_add, simd_add_sat, simd_mulhi and simd_bswap
+// intrinsics to operate on whole ptr8/ptr16/ptr32 buffers.  The x64 emitter uses
+// SSE2 instructions for these, other emitters call a helper function.
+// The helper is only in mp_fun_table when this is enabled, so code using them
+// can't be saved to .mpy files, which must run on any build.
+#ifndef MICROPY_EMIT_NATIVE_SIMD
+#define MICROPY_EMIT_NATIVE_SIMD (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Whether native relocatable code loaded from .mpy files is explicitly tracked
 // so that the GC cannot reclaim it.  Needed on architectures that allocate
 // executable memory on the MicroPython heap and don't explicitly track this
@@ -458,6 +572,10 @@
 #define MICROPY_DYNAMIC_COMPILER (0)
 #endif
 
+#if MICROPY_DYNAMIC_COMPILER && MICROPY_EMIT_NATIVE_SIMD
+#error "MICROPY_EMIT_NATIVE_SIMD is not part of the .mpy native ABI"
+#endif
+
 // Whether the compiler allows compiling top-level await expressions
 #ifndef MICROPY_COMP_ALLOW_TOP_LEVEL_AWAIT
 #define MICROPY_COMP_ALLOW_TOP_LEVEL_AWAIT (0)
@@ -507,6 +625,12 @@
 #define MICROPY_COMP_RETURN_IF_EXPR (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
 
+// Whether to compile file input one top-level statement at a time as it's parsed,
+// so the parse tree of only one statement is in memory, instead of the whole file
+#ifndef MICROPY_COMP_STREAMING
+#define MICROPY_COMP_STREAMING (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 /*****************************************************************************/
 /* Internal debugging stuff                                                  */
 
@@ -593,12 +717,54 @@
 #define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (128)
 #endif
 
+// Whether mutable maps (eg dicts and instance members) store their elements
+// densely in insertion order, with a separate small hash index into them,
+// instead of in the hash table itself.  This makes iteration follow insertion
+// order, as in CPython, and makes OrderedDict a hash map rather than an array
+// that must be searched linearly.
+#ifndef MICROPY_MAP_COMPACT
+#define MICROPY_MAP_COMPACT (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
+// Use extra RAM (2 bytes per qstr used by a module) to remember, for each name
+// in a module's bytecode, the map slot where it was last found by LOAD_GLOBAL,
+// LOAD_ATTR, LOAD_METHOD or STORE_ATTR. A hit only costs a key comparison.
+// Requires MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE.
+#ifndef MICROPY_OPT_INLINE_CACHE
+#define MICROPY_OPT_INLINE_CACHE (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES && MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE)
+#endif
+
+// Whether the bytecode emitter fuses common opcode sequences (pairs of local
+// loads, compare-and-branch, local increments and the test of an optimised
+// range loop) into superinstructions, to reduce VM dispatch overhead.
+// Superinstructions are not part of the .mpy format, so this can't be enabled
+// together with MICROPY_PERSISTENT_CODE_SAVE.
+#ifndef MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+#define MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES && !MICROPY_PERSISTENT_CODE_SAVE)
+#endif
+
+// Whether to compile "for x in range(...)" in bytecode to a counted loop, which
+// keeps a small-int counter on the value stack, if at runtime range is the
+// builtin and its arguments are small ints.  Like superinstructions, the
+// opcodes for this are not part of the .mpy format.
+#ifndef MICROPY_OPT_COUNTED_RANGE_LOOP
+#define MICROPY_OPT_COUNTED_RANGE_LOOP (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES && !MICROPY_PERSISTENT_CODE_SAVE)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
 #define MICROPY_OPT_MPZ_BITWISE (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
 
+// Whether to multiply large mpz integers with Karatsuba's method, and divide them
+// by recursive division, instead of the quadratic schoolbook methods.  The sizes
+// at which these are used are set by MPZ_KARATSUBA_THRESHOLD and
+// MPZ_DIV_RECURSIVE_THRESHOLD in py/mpz.h.  Increases x64 code size by about 2k.
+#ifndef MICROPY_OPT_MPZ_KARATSUBA
+#define MICROPY_OPT_MPZ_KARATSUBA (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 
 // Whether math.factorial is large, fast and recursive (1) or small and slow (0).
 #ifndef MICROPY_OPT_MATH_FACTORIAL
@@ -659,7 +825,8 @@
 #endif
 
 // Hook for mp_sched_schedule when a function gets scheduled on sched_queue
-// (this macro executes within an atomic section)
+// (this macro executes within an atomic section, unless
+// MICROPY_SCHEDULER_LOCK_FREE is enabled)
 #ifndef MICROPY_SCHED_HOOK_SCHEDULED
 #define MICROPY_SCHED_HOOK_SCHEDULED
 #endif
@@ -896,6 +1063,13 @@ typedef double mp_float_t;
 #define MICROPY_FLOAT_HIGH_QUALITY_HASH (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
 #endif
 
+// Whether conversions between floats and strings are correctly rounded, with
+// repr giving the shortest string that converts back to the same float.
+// Otherwise they are approximate, which takes less code.
+#ifndef MICROPY_FLOAT_EXACT_CONVERSION
+#define MICROPY_FLOAT_EXACT_CONVERSION (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Enable features which improve CPython compatibility
 // but may lead to more code size/memory usage.
 // TODO: Originally intended as generic category to not
@@ -1026,6 +1200,21 @@ typedef double mp_float_t;
 #define MICROPY_SCHEDULER_DEPTH (4)
 #endif
 
+// Number of priority classes for scheduled functions, see
+// mp_sched_schedule_priority().  Each has its own queue of
+// MICROPY_SCHEDULER_DEPTH entries.
+#ifndef MICROPY_SCHEDULER_PRIORITIES
+#define MICROPY_SCHEDULER_PRIORITIES (1)
+#endif
+
+// Whether the scheduler queues and state are updated with lock-free atomic
+// operations instead of within MICROPY_BEGIN_ATOMIC_SECTION, so that
+// producers (hard IRQs, other threads) never wait on each other.  Needs
+// compare-and-swap support from the target.
+#ifndef MICROPY_SCHEDULER_LOCK_FREE
+#define MICROPY_SCHEDULER_LOCK_FREE (0)
+#endif
+
 // Support for generic VFS sub-system
 #ifndef MICROPY_VFS
 #define MICROPY_VFS (0)
@@ -1214,6 +1403,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_BUILTINS_RANGE_BINOP (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
 #endif
 
+// Whether list.sort and sorted() use a stable, adaptive merge sort (timsort),
+// which calls the key function once per element, instead of a quicksort.
+// Costs ~4k of code (x64), and a temporary buffer of up to half the list length.
+#ifndef MICROPY_PY_LIST_SORT_STABLE
+#define MICROPY_PY_LIST_SORT_STABLE (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Support for calling next() with second argument
 #ifndef MICROPY_PY_BUILTINS_NEXT2
 #define MICROPY_PY_BUILTINS_NEXT2 (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
@@ -1334,6 +1530,23 @@ typedef double mp_float_t;
 #define MICROPY_PY_MICROPYTHON_HEAP_LOCKED (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
 #endif
 
+// Whether to provide the "micropython.prof_*" sampling profiler functions.
+// The port must provide mp_hal_prof_sample_timer() to call mp_prof_sample()
+// periodically, eg from a timer signal.
+#ifndef MICROPY_PY_MICROPYTHON_PROF_SAMPLING
+#define MICROPY_PY_MICROPYTHON_PROF_SAMPLING (0)
+#endif
+
+// Size in words of the sampling profiler's ring buffer (must be a power of 2)
+#ifndef MICROPY_PY_MICROPYTHON_PROF_SAMPLING_BUF_SIZE
+#define MICROPY_PY_MICROPYTHON_PROF_SAMPLING_BUF_SIZE (16384)
+#endif
+
+// Maximum number of frames recorded per sample by the sampling profiler
+#ifndef MICROPY_PY_MICROPYTHON_PROF_SAMPLING_DEPTH
+#define MICROPY_PY_MICROPYTHON_PROF_SAMPLING_DEPTH (32)
+#endif
+
 // Whether to provide "array" module. Note that large chunk of the
 // underlying code is shared with "bytearray" builtin type, so to
 // get real savings, it should be disabled too.
@@ -1554,6 +1767,10 @@ typedef double mp_float_t;
 #define MICROPY_PY_SYS_SETTRACE (0)
 #endif
 
+// Whether the VM links active bytecode frames via code_state->prev_state,
+// with the innermost one in MP_STATE_THREAD(current_code_state)
+#define MICROPY_CODE_STATE_CHAIN (MICROPY_PY_SYS_SETTRACE || MICROPY_PY_MICROPYTHON_PROF_SAMPLING)
+
 // Whether to provide "sys.getsizeof" function
 #ifndef MICROPY_PY_SYS_GETSIZEOF
 #define MICROPY_PY_SYS_GETSIZEOF (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
@@ -1682,6 +1899,18 @@ typedef double mp_float_t;
 #define MICROPY_PY_DEFLATE_COMPRESS (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_FULL_FEATURES)
 #endif
 
+// Whether the CRC32 used by zlib, deflate and binascii is computed 8 bytes at
+// a time with 8KiB of tables, instead of a nibble at a time with 64 bytes
+#ifndef MICROPY_UZLIB_CRC32_SLICE8
+#define MICROPY_UZLIB_CRC32_SLICE8 (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_FULL_FEATURES)
+#endif
+
+// Whether the zlib checksums use SIMD instructions (only on x86_64: SSE2 for
+// Adler32, and PCLMULQDQ for CRC32 when the CPU supports it)
+#ifndef MICROPY_UZLIB_SIMD
+#define MICROPY_UZLIB_SIMD (0)
+#endif
+
 #ifndef MICROPY_PY_JSON
 #define MICROPY_PY_JSON (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
@@ -1719,6 +1948,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_RE_SUB (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
 
+// Size in bytes of the C stack buffer used to run a pattern with the bit-state
+// backtracker, which is fastest on short subjects.  Patterns and subjects that
+// don't fit run with the Pike VM instead.  Set to 0 to always use the Pike VM.
+#ifndef MICROPY_PY_RE_BACKTRACK_MEM
+#define MICROPY_PY_RE_BACKTRACK_MEM (1024)
+#endif
+
 #ifndef MICROPY_PY_HEAPQ
 #define MICROPY_PY_HEAPQ (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
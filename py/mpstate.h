@@ -84,6 +84,11 @@ extern mp_dynamic_compiler_t mp_dynamic_compiler;
 #define MP_SCHED_PENDING (0) // 0 so it's a quick check in the VM
 
 typedef struct _mp_sched_item_t {
+    #if MICROPY_SCHEDULER_LOCK_FREE
+    // The queue position this slot can be filled at, or that plus one once
+    // it has been filled.
+    mp_uint_t seq;
+    #endif
     mp_obj_t func;
     mp_obj_t arg;
 } mp_sched_item_t;
@@ -105,8 +110,38 @@ typedef struct _mp_state_mem_area_t {
 
     size_t gc_last_free_atb_index;
     size_t gc_last_used_block; // The block ID of the highest block allocated in the area
+
+    #if MICROPY_GC_ALLOC_SIZE_CLASSES
+    // Entry k-1 is an ATB index such that every free run of at least 2**k
+    // blocks starts at or after it, so gc_alloc can begin its search there.
+    size_t gc_size_class_atb_index[MICROPY_GC_ALLOC_SIZE_CLASSES];
+    #endif
+
+    #if MICROPY_GC_LONG_LIVED
+    // An ATB index such that no block at or after it is free, where the
+    // search down from the end of the area for a long-lived allocation starts.
+    size_t gc_long_lived_atb_index;
+    #endif
+
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    // Block where a pending incremental sweep of this area continues (all
+    // blocks before it have been swept), or SIZE_MAX if there is none.
+    size_t gc_sweep_block;
+    // The highest block found in use so far by the pending sweep.
+    size_t gc_sweep_last_used;
+    #endif
 } mp_state_mem_area_t;
 
+#if MICROPY_GC_PARALLEL_MARK
+// A marked block that still needs its children traced.
+typedef struct _gc_mark_entry_t {
+    #if MICROPY_GC_SPLIT_HEAP
+    mp_state_mem_area_t *area;
+    #endif
+    MICROPY_GC_STACK_ENTRY_TYPE block;
+} gc_mark_entry_t;
+#endif
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
@@ -138,6 +173,13 @@ typedef struct _mp_state_mem_t {
     mp_state_mem_area_t *gc_last_free_area;
     #endif
 
+    #if MICROPY_GC_INCREMENTAL_SWEEP
+    // Whether the next gc_collect_end should leave the sweep pending.
+    bool gc_sweep_incremental;
+    // Whether any area has an incremental sweep pending.
+    bool gc_sweep_pending;
+    #endif
+
     #if MICROPY_PY_GC_COLLECT_RETVAL
     size_t gc_collected;
     #endif
@@ -146,6 +188,21 @@ typedef struct _mp_state_mem_t {
     // This is a global mutex used to make the GC thread-safe.
     mp_thread_mutex_t gc_mutex;
     #endif
+
+    #if MICROPY_GC_PARALLEL_MARK
+    // Whether the current collection defers tracing to gc_trace_parallel.
+    bool gc_mark_parallel;
+    // Marked blocks whose children still need tracing, shared between the
+    // marking threads, and protected by gc_mark_mutex.  The pool is followed
+    // by the private mark stack of each marking thread, all in one buffer that
+    // is only allocated (outside the heap) for a parallel collection.
+    size_t gc_mark_pool_len;
+    gc_mark_entry_t *gc_mark_pool;
+    // Number of marking threads started, and the number of those with work.
+    size_t gc_mark_workers;
+    size_t gc_mark_active;
+    mp_thread_mutex_t gc_mark_mutex;
+    #endif
 } mp_state_mem_t;
 
 // This structure hold runtime and VM information.  It includes a section
@@ -160,6 +217,12 @@ typedef struct _mp_state_vm_t {
 
     qstr_pool_t *last_pool;
 
+    #if MICROPY_QSTR_HASH_INDEX
+    // Hash index of the qstrs in the dynamically allocated pools, with
+    // qstr_short_t or uint32_t entries (see qstr.c).
+    void *qstr_index;
+    #endif
+
     #if MICROPY_TRACKED_ALLOC
     struct _m_tracked_node_t *m_tracked_head;
     #endif
@@ -219,6 +282,13 @@ typedef struct _mp_state_vm_t {
     size_t qstr_last_alloc;
     size_t qstr_last_used;
 
+    #if MICROPY_QSTR_HASH_INDEX
+    // number of slots in qstr_index, a power of two (or 0 if there is no index)
+    size_t qstr_index_alloc;
+    // number of dynamic qstrs in qstr_index; these are always the oldest ones
+    size_t qstr_index_len;
+    #endif
+
     #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make qstr interning thread-safe.
     mp_thread_mutex_t qstr_mutex;
@@ -244,12 +314,24 @@ typedef struct _mp_state_vm_t {
     // traced by the GC.  They are assumed to be zero'd out before mp_init() is
     // called (usually because this struct lives in the BSS).
     struct _mp_sched_node_t *sched_head;
+    #if !MICROPY_SCHEDULER_LOCK_FREE
     struct _mp_sched_node_t *sched_tail;
     #endif
+    #endif
+
+    // These index sched_queue, for each priority class.
+    #if MICROPY_SCHEDULER_LOCK_FREE
+    // Free-running positions of the next item to add and to take.
+    mp_uint_t sched_put[MICROPY_SCHEDULER_PRIORITIES];
+    mp_uint_t sched_get[MICROPY_SCHEDULER_PRIORITIES];
+    #else
+    uint8_t sched_len[MICROPY_SCHEDULER_PRIORITIES];
+    uint8_t sched_idx[MICROPY_SCHEDULER_PRIORITIES];
+    #endif
 
-    // These index sched_queue.
-    uint8_t sched_len;
-    uint8_t sched_idx;
+    // Number of functions which could not be scheduled because the queue
+    // was full.
+    mp_uint_t sched_overflow;
     #endif
 
     #if MICROPY_ENABLE_VM_ABORT
@@ -315,6 +397,8 @@ typedef struct _mp_state_thread_t {
     #if MICROPY_PY_SYS_SETTRACE
     mp_obj_t prof_trace_callback;
     bool prof_callback_is_executing;
+    #endif
+    #if MICROPY_CODE_STATE_CHAIN
     struct _mp_code_state_t *current_code_state;
     #endif
 
@@ -48,6 +48,12 @@ void mp_thread_mutex_init(mp_thread_mutex_t *mutex);
 int mp_thread_mutex_lock(mp_thread_mutex_t *mutex, int wait);
 void mp_thread_mutex_unlock(mp_thread_mutex_t *mutex);
 
+#if MICROPY_GC_PARALLEL_MARK
+// Call worker(0) on this thread and worker(1), worker(2), ... on up to
+// max_workers - 1 other threads, and return once they have all returned.
+void mp_thread_gc_parallel(void (*worker)(size_t id), size_t max_workers);
+#endif
+
 #endif // MICROPY_PY_THREAD
 
 #if MICROPY_PY_THREAD && MICROPY_PY_THREAD_GIL
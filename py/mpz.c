@@ -432,7 +432,7 @@ static size_t mpn_mul_dig_add_dig(mpz_dig_t *idig, size_t ilen, mpz_dig_t dmul,
    assumes enough memory in i; assumes i is zeroed; assumes normalised j, k
    can have j, k point to same memory
 */
-static size_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, size_t jlen, mpz_dig_t *kdig, size_t klen) {
+static size_t mpn_mul_basecase(mpz_dig_t *idig, const mpz_dig_t *jdig, size_t jlen, const mpz_dig_t *kdig, size_t klen) {
     mpz_dig_t *oidig = idig;
     size_t ilen = 0;
 
@@ -441,7 +441,7 @@ static size_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, size_t jlen, mpz_dig_t *
         mpz_dbl_dig_t carry = 0;
 
         size_t jl = jlen;
-        for (mpz_dig_t *jd = jdig; jl > 0; --jl, ++jd, ++id) {
+        for (const mpz_dig_t *jd = jdig; jl > 0; --jl, ++jd, ++id) {
             carry += (mpz_dbl_dig_t)*id + (mpz_dbl_dig_t)*jd * (mpz_dbl_dig_t)*kdig; // will never overflow so long as DIG_SIZE <= 8*sizeof(mpz_dbl_dig_t)/2
             *id = carry & DIG_MASK;
             carry >>= DIG_SIZE;
@@ -461,6 +461,304 @@ static size_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, size_t jlen, mpz_dig_t *
     return ilen;
 }
 
+#if MICROPY_OPT_MPZ_KARATSUBA
+
+#if MPZ_KARATSUBA_THRESHOLD < 4
+#error MPZ_KARATSUBA_THRESHOLD must be at least 4
+#endif
+
+#if MPZ_DIV_RECURSIVE_THRESHOLD < 2
+#error MPZ_DIV_RECURSIVE_THRESHOLD must be at least 2
+#endif
+
+/* computes i = i + k, over the ilen digits of i
+   returns the carry out of the top digit of i
+   assumes ilen >= klen; i, k need not be normalised
+*/
+static int mpn_add_inpl(mpz_dig_t *idig, size_t ilen, const mpz_dig_t *kdig, size_t klen) {
+    mpz_dbl_dig_t carry = 0;
+
+    ilen -= klen;
+
+    for (; klen > 0; --klen, ++idig, ++kdig) {
+        carry += (mpz_dbl_dig_t)*idig + (mpz_dbl_dig_t)*kdig;
+        *idig = carry & DIG_MASK;
+        carry >>= DIG_SIZE;
+    }
+
+    for (; ilen > 0 && carry != 0; --ilen, ++idig) {
+        carry += *idig;
+        *idig = carry & DIG_MASK;
+        carry >>= DIG_SIZE;
+    }
+
+    return carry;
+}
+
+/* computes i = i - k, over the ilen digits of i
+   returns the borrow out of the top digit of i (0 or 1)
+   assumes ilen >= klen; i, k need not be normalised
+*/
+static int mpn_sub_inpl(mpz_dig_t *idig, size_t ilen, const mpz_dig_t *kdig, size_t klen) {
+    mpz_dbl_dig_signed_t borrow = 0;
+
+    ilen -= klen;
+
+    for (; klen > 0; --klen, ++idig, ++kdig) {
+        borrow += (mpz_dbl_dig_t)*idig - (mpz_dbl_dig_t)*kdig;
+        *idig = borrow & DIG_MASK;
+        borrow >>= DIG_SIZE;
+    }
+
+    for (; ilen > 0 && borrow != 0; --ilen, ++idig) {
+        borrow += *idig;
+        *idig = borrow & DIG_MASK;
+        borrow >>= DIG_SIZE;
+    }
+
+    return -borrow;
+}
+
+/* returns the number of scratch digits that mpn_mul_karatsuba needs for operands
+   of at most n digits: each level of recursion uses 4*h+4 digits, where h is half
+   of its longest operand, and recurses on operands of at most h+1 digits
+*/
+static size_t mpn_mul_karatsuba_scratch(size_t n) {
+    size_t tlen = 0;
+    while (n >= MPZ_KARATSUBA_THRESHOLD) {
+        size_t h = (n + 1) / 2;
+        tlen += 4 * h + 4;
+        n = h + 1;
+    }
+    return tlen;
+}
+
+/* computes i = j * k using Karatsuba's method, falling back to the basecase
+   below MPZ_KARATSUBA_THRESHOLD digits
+   i gets exactly jlen + klen digits, which may have trailing zeros
+   assumes i is zeroed; j, k need not be normalised
+   t is scratch space of mpn_mul_karatsuba_scratch(max(jlen, klen)) digits
+*/
+static void mpn_mul_karatsuba(mpz_dig_t *idig, const mpz_dig_t *jdig, size_t jlen, const mpz_dig_t *kdig, size_t klen, mpz_dig_t *tdig) {
+    if (jlen < klen) {
+        const mpz_dig_t *d = jdig;
+        jdig = kdig;
+        kdig = d;
+        size_t l = jlen;
+        jlen = klen;
+        klen = l;
+    }
+
+    if (klen < MPZ_KARATSUBA_THRESHOLD) {
+        mpn_mul_basecase(idig, jdig, jlen, kdig, klen);
+        return;
+    }
+
+    size_t ilen = jlen + klen;
+    size_t h = (jlen + 1) / 2;
+
+    if (klen <= h) {
+        // unbalanced operands: multiply k by slices of j that are klen digits long
+        for (size_t off = 0; off < jlen; off += klen) {
+            size_t slen = MIN(klen, jlen - off);
+            memset(tdig, 0, (slen + klen) * sizeof(mpz_dig_t));
+            mpn_mul_karatsuba(tdig, jdig + off, slen, kdig, klen, tdig + 2 * klen);
+            mpn_add_inpl(idig + off, ilen - off, tdig, slen + klen);
+        }
+        return;
+    }
+
+    // split j = j1*B^h + j0 and k = k1*B^h + k0, then
+    // j*k = z2*B^2h + ((j0+j1)*(k0+k1) - z2 - z0)*B^h + z0, with z2 = j1*k1 and z0 = j0*k0
+    size_t j1len = jlen - h;
+    size_t k1len = klen - h;
+    mpn_mul_karatsuba(idig, jdig, h, kdig, h, tdig);
+    mpn_mul_karatsuba(idig + 2 * h, jdig + h, j1len, kdig + h, k1len, tdig);
+
+    mpz_dig_t *sjdig = tdig;
+    mpz_dig_t *skdig = tdig + h + 1;
+    mpz_dig_t *zdig = tdig + 2 * h + 2;
+    size_t sjlen = mpn_add(sjdig, jdig, h, jdig + h, j1len);
+    size_t sklen = mpn_add(skdig, kdig, h, kdig + h, k1len);
+    size_t zlen = sjlen + sklen;
+    memset(zdig, 0, zlen * sizeof(mpz_dig_t));
+    mpn_mul_karatsuba(zdig, sjdig, sjlen, skdig, sklen, zdig + zlen);
+
+    mpn_sub_inpl(zdig, zlen, idig, 2 * h);
+    mpn_sub_inpl(zdig, zlen, idig + 2 * h, j1len + k1len);
+    zlen = mpn_remove_trailing_zeros(zdig, zdig + zlen);
+    mpn_add_inpl(idig + h, ilen - h, zdig, zlen);
+}
+
+#endif
+
+/* computes i = j * k
+   returns number of digits in i
+   assumes enough memory in i; assumes i is zeroed; assumes normalised j, k
+   can have j, k point to same memory
+*/
+static size_t mpn_mul(mpz_dig_t *idig, const mpz_dig_t *jdig, size_t jlen, const mpz_dig_t *kdig, size_t klen) {
+    #if MICROPY_OPT_MPZ_KARATSUBA
+    if (jlen >= MPZ_KARATSUBA_THRESHOLD && klen >= MPZ_KARATSUBA_THRESHOLD) {
+        size_t tlen = mpn_mul_karatsuba_scratch(MAX(jlen, klen));
+        mpz_dig_t *tdig = m_new(mpz_dig_t, tlen);
+        mpn_mul_karatsuba(idig, jdig, jlen, kdig, klen, tdig);
+        m_del(mpz_dig_t, tdig, tlen);
+        return mpn_remove_trailing_zeros(idig, idig + jlen + klen);
+    }
+    #endif
+    return mpn_mul_basecase(idig, jdig, jlen, kdig, klen);
+}
+
+#if MICROPY_OPT_MPZ_KARATSUBA
+
+/* computes q = a / b, a = a % b, the basecase for mpn_div_recursive
+   a has n + m digits and b has n digits, with b normalised so that the
+   leading bit of its leading digit is 1
+   q gets m digits and the quotient digit above them (0 or 1) is returned;
+   the top m digits of a become zero
+*/
+static int mpn_div_basecase(mpz_dig_t *adig, const mpz_dig_t *bdig, size_t n, size_t m, mpz_dig_t *qdig) {
+    int qhi = 0;
+    if (mpn_cmp(adig + m, n, bdig, n) >= 0) {
+        mpn_sub_inpl(adig + m, n, bdig, n);
+        qhi = 1;
+    }
+
+    for (size_t j = m; j-- > 0;) {
+        mpz_dig_t *a = adig + j;
+
+        // estimate this digit of the quotient from the top digits; it is at most 2 too large
+        mpz_dbl_dig_t quo = (((mpz_dbl_dig_t)a[n] << DIG_SIZE) | a[n - 1]) / bdig[n - 1];
+        if (quo > DIG_MASK) {
+            quo = DIG_MASK;
+        }
+
+        // subtract quo * b from the top n + 1 digits of a
+        mpz_dbl_dig_t carry = 0;
+        mpz_dbl_dig_signed_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            carry += quo * bdig[i]; // will never overflow so long as DIG_SIZE <= 8*sizeof(mpz_dbl_dig_t)/2
+            borrow += (mpz_dbl_dig_t)a[i] - (carry & DIG_MASK);
+            a[i] = borrow & DIG_MASK;
+            borrow >>= DIG_SIZE;
+            carry >>= DIG_SIZE;
+        }
+        borrow += (mpz_dbl_dig_t)a[n] - carry;
+        a[n] = borrow & DIG_MASK;
+        borrow >>= DIG_SIZE;
+
+        // add back b while quo was too large
+        for (; borrow != 0; --quo) {
+            borrow += mpn_add_inpl(a, n + 1, bdig, n);
+        }
+
+        qdig[j] = quo;
+    }
+
+    return qhi;
+}
+
+/* computes q = a / b, a = a % b, with the same conditions as mpn_div_basecase
+   and also m <= n
+   this is the recursive division of Burnikel and Ziegler (in the form given by
+   Brent and Zimmermann), which splits off half of the quotient at a time so that
+   most of the work is done by mpn_mul
+   t is scratch space of m digits
+*/
+static int mpn_div_recursive(mpz_dig_t *adig, const mpz_dig_t *bdig, size_t n, size_t m, mpz_dig_t *qdig, mpz_dig_t *tdig) {
+    static const mpz_dig_t one = 1;
+
+    if (m < MPZ_DIV_RECURSIVE_THRESHOLD) {
+        return mpn_div_basecase(adig, bdig, n, m, qdig);
+    }
+
+    // split b = b1*B^k + b0, compute the high part q1 of the quotient from the
+    // top digits of a divided by b1, then subtract q1*b0 and correct q1
+    size_t k = m / 2;
+    int qhi = mpn_div_recursive(adig + 2 * k, bdig + k, n - k, m - k, qdig + k, tdig);
+    memset(tdig, 0, m * sizeof(mpz_dig_t));
+    size_t tlen = mpn_mul(tdig, qdig + k, m - k, bdig, k);
+    int borrow = -mpn_sub_inpl(adig + k, n, tdig, tlen);
+    if (qhi) {
+        borrow -= mpn_sub_inpl(adig + m, n + k - m, bdig, k);
+    }
+    while (borrow < 0) {
+        qhi -= mpn_sub_inpl(qdig + k, m - k, &one, 1);
+        borrow += mpn_add_inpl(adig + k, n, bdig, n);
+    }
+
+    // likewise for the low part q0 of the quotient
+    int q0hi = mpn_div_recursive(adig + k, bdig + k, n - k, k, qdig, tdig);
+    memset(tdig, 0, 2 * k * sizeof(mpz_dig_t));
+    tlen = mpn_mul(tdig, qdig, k, bdig, k);
+    borrow = -mpn_sub_inpl(adig, n, tdig, tlen);
+    if (q0hi) {
+        qhi += mpn_add_inpl(qdig + k, m - k, &one, 1);
+        borrow -= mpn_sub_inpl(adig + k, n - k, bdig, k);
+    }
+    while (borrow < 0) {
+        qhi -= mpn_sub_inpl(qdig, m, &one, 1);
+        borrow += mpn_add_inpl(adig, n, bdig, n);
+    }
+
+    return qhi;
+}
+
+/* computes the same as mpn_div, for large numerator and denominator
+   assumes num >= den and the conditions of mpn_div
+*/
+static void mpn_div_large(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_dig, size_t den_len, mpz_dig_t *quo_dig, size_t *quo_len) {
+    // normalise a copy of the denominator (leading bit of leading digit is 1)
+    mpz_dig_t norm_shift = 0;
+    for (mpz_dig_t d = den_dig[den_len - 1]; (d & DIG_MSB) == 0; d <<= 1) {
+        ++norm_shift;
+    }
+    mpz_dig_t *den = m_new(mpz_dig_t, 2 * den_len);
+    mpz_dig_t *tmp = den + den_len;
+    {
+        mpz_dig_t carry = 0;
+        for (size_t i = 0; i < den_len; ++i) {
+            mpz_dig_t d = den_dig[i];
+            den[i] = ((d << norm_shift) | carry) & DIG_MASK;
+            carry = (mpz_dbl_dig_t)d >> (DIG_SIZE - norm_shift);
+        }
+    }
+
+    // shift the numerator by the same amount, extending it by one digit so that
+    // its top den_len digits are less than the denominator
+    num_dig[*num_len] = 0;
+    ++(*num_len);
+    for (mpz_dig_t *num = num_dig, carry = 0; num < num_dig + *num_len; ++num) {
+        mpz_dig_t n = *num;
+        *num = ((n << norm_shift) | carry) & DIG_MASK;
+        carry = (mpz_dbl_dig_t)n >> (DIG_SIZE - norm_shift);
+    }
+
+    // divide den_len digits of the quotient at a time, from the top down
+    size_t n = den_len;
+    size_t m = *num_len - den_len;
+    *quo_len = m;
+    for (; m > n; m -= n) {
+        mpn_div_recursive(num_dig + m - n, den, n, n, quo_dig + m - n, tmp);
+    }
+    mpn_div_recursive(num_dig, den, n, m, quo_dig, tmp);
+    m_del(mpz_dig_t, den, 2 * den_len);
+
+    // unnormalise the remainder
+    *num_len = den_len;
+    for (mpz_dig_t *num = num_dig + *num_len - 1, carry = 0; num >= num_dig; --num) {
+        mpz_dig_t d = *num;
+        *num = ((d >> norm_shift) | carry) & DIG_MASK;
+        carry = (mpz_dbl_dig_t)d << (DIG_SIZE - norm_shift);
+    }
+
+    *quo_len = mpn_remove_trailing_zeros(quo_dig, quo_dig + *quo_len);
+    *num_len = mpn_remove_trailing_zeros(num_dig, num_dig + *num_len);
+}
+
+#endif
+
 /* natural_div - quo * den + new_num = old_num (ie num is replaced with rem)
    assumes den != 0
    assumes num_dig has enough memory to be extended by 1 digit
@@ -488,6 +786,13 @@ static void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
         }
     }
 
+    #if MICROPY_OPT_MPZ_KARATSUBA
+    if (den_len >= MPZ_DIV_RECURSIVE_THRESHOLD && *num_len - den_len >= MPZ_DIV_RECURSIVE_THRESHOLD) {
+        mpn_div_large(num_dig, num_len, den_dig, den_len, quo_dig, quo_len);
+        return;
+    }
+    #endif
+
     // We need to normalise the denominator (leading bit of leading digit is 1)
     // so that the division routine works.  Since the denominator memory is
     // read-only we do the normalisation on the fly, each time a digit of the
@@ -54,6 +54,20 @@
   #endif
 #endif
 
+// With MICROPY_OPT_MPZ_KARATSUBA, products where both operands have at least
+// MPZ_KARATSUBA_THRESHOLD digits are computed with Karatsuba's method, and
+// quotients where both the denominator and the quotient have at least
+// MPZ_DIV_RECURSIVE_THRESHOLD digits are computed by recursive division.
+// Below these sizes the schoolbook methods are faster.
+
+#ifndef MPZ_KARATSUBA_THRESHOLD
+#define MPZ_KARATSUBA_THRESHOLD (32)
+#endif
+
+#ifndef MPZ_DIV_RECURSIVE_THRESHOLD
+#define MPZ_DIV_RECURSIVE_THRESHOLD (64)
+#endif
+
 #if MPZ_DIG_SIZE > 16
 #define MPZ_DBL_DIG_SIZE (64)
 typedef uint32_t mpz_dig_t;
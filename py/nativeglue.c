@@ -68,6 +68,23 @@ int mp_native_type_from_qstr(qstr qst) {
     }
 }
 
+#if MICROPY_EMIT_NATIVE_SIMD
+int mp_native_simd_from_qstr(qstr qst) {
+    switch (qst) {
+        case MP_QSTR_simd_add:
+            return MP_NATIVE_SIMD_ADD;
+        case MP_QSTR_simd_add_sat:
+            return MP_NATIVE_SIMD_ADD_SAT;
+        case MP_QSTR_simd_mulhi:
+            return MP_NATIVE_SIMD_MULHI;
+        case MP_QSTR_simd_bswap:
+            return MP_NATIVE_SIMD_BSWAP;
+        default:
+            return -1;
+    }
+}
+#endif
+
 // convert a MicroPython object to a valid native value based on type
 mp_uint_t mp_native_from_obj(mp_obj_t obj, mp_uint_t type) {
     DEBUG_printf("mp_native_from_obj(%p, " UINT_FMT ")\n", obj, type);
@@ -232,6 +249,82 @@ static bool mp_native_yield_from(mp_obj_t gen, mp_obj_t send_value, mp_obj_t *re
     return false;
 }
 
+#if MICROPY_EMIT_NATIVE_SIMD
+// Element-wise operations on buffers of unsigned 8/16/32-bit integers, called by
+// viper code for the SIMD intrinsics.  This is the whole implementation for most
+// emitters, and handles the elements left over after the vector loop on x64.
+// args holds dst, a, b, n for the arithmetic ops and dst, src, n for bswap.
+static void mp_native_viper_simd(mp_uint_t op, const mp_uint_t *args) {
+    DEBUG_printf("mp_native_viper_simd(" UINT_FMT ")\n", op);
+    size_t n = args[(op & ((1 << MP_NATIVE_SIMD_SIZE_SHIFT) - 1)) == MP_NATIVE_SIMD_BSWAP ? 2 : 3];
+    switch (op) {
+        case MP_NATIVE_SIMD_ADD | 0 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint8_t *dst = (uint8_t *)args[0], *a = (uint8_t *)args[1], *b = (uint8_t *)args[2];
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = a[i] + b[i];
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_ADD | 1 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint16_t *dst = (uint16_t *)args[0], *a = (uint16_t *)args[1], *b = (uint16_t *)args[2];
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = a[i] + b[i];
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_ADD | 2 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint32_t *dst = (uint32_t *)args[0], *a = (uint32_t *)args[1], *b = (uint32_t *)args[2];
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = a[i] + b[i];
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_ADD_SAT | 0 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint8_t *dst = (uint8_t *)args[0], *a = (uint8_t *)args[1], *b = (uint8_t *)args[2];
+            for (size_t i = 0; i < n; ++i) {
+                unsigned int v = a[i] + b[i];
+                dst[i] = v > 0xff ? 0xff : v;
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_ADD_SAT | 1 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint16_t *dst = (uint16_t *)args[0], *a = (uint16_t *)args[1], *b = (uint16_t *)args[2];
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t v = (uint32_t)a[i] + b[i];
+                dst[i] = v > 0xffff ? 0xffff : v;
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_MULHI | 1 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint16_t *dst = (uint16_t *)args[0], *a = (uint16_t *)args[1], *b = (uint16_t *)args[2];
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = ((uint32_t)a[i] * b[i]) >> 16;
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_BSWAP | 1 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint16_t *dst = (uint16_t *)args[0], *src = (uint16_t *)args[1];
+            for (size_t i = 0; i < n; ++i) {
+                uint16_t v = src[i];
+                dst[i] = v << 8 | v >> 8;
+            }
+            break;
+        }
+        case MP_NATIVE_SIMD_BSWAP | 2 << MP_NATIVE_SIMD_SIZE_SHIFT: {
+            uint32_t *dst = (uint32_t *)args[0], *src = (uint32_t *)args[1];
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t v = src[i];
+                dst[i] = v << 24 | (v & 0xff00) << 8 | (v >> 8 & 0xff00) | v >> 24;
+            }
+            break;
+        }
+        default:
+            // the emitter only generates the combinations above
+            assert(0);
+    }
+}
+#endif
+
 #if !MICROPY_PY_BUILTINS_FLOAT
 
 static mp_obj_t mp_obj_new_float_from_f(float f) {
@@ -357,6 +450,11 @@ const mp_fun_table_t mp_fun_table = {
     &mp_stream_readinto_obj,
     &mp_stream_unbuffered_readline_obj,
     &mp_stream_write_obj,
+    #if MICROPY_EMIT_NATIVE_SIMD
+    mp_native_viper_simd,
+    #else
+    NULL,
+    #endif
 };
 
 #elif MICROPY_EMIT_NATIVE && MICROPY_DYNAMIC_COMPILER
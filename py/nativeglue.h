@@ -85,6 +85,17 @@ typedef enum {
     MP_F_NUMBER_OF,
 } mp_fun_kind_t;
 
+// Viper SIMD intrinsics.  The operation passed to the viper_simd helper has the
+// log2 of the element size (in bytes) in the bits above MP_NATIVE_SIMD_SIZE_SHIFT.
+typedef enum {
+    MP_NATIVE_SIMD_ADD,
+    MP_NATIVE_SIMD_ADD_SAT,
+    MP_NATIVE_SIMD_MULHI,
+    MP_NATIVE_SIMD_BSWAP,
+} mp_native_simd_op_t;
+
+#define MP_NATIVE_SIMD_SIZE_SHIFT (2)
+
 typedef struct _mp_fun_table_t {
     mp_const_obj_t const_none;
     mp_const_obj_t const_false;
@@ -182,8 +193,13 @@ typedef struct _mp_fun_table_t {
     const mp_obj_fun_builtin_var_t *stream_readinto_obj;
     const mp_obj_fun_builtin_var_t *stream_unbuffered_readline_obj;
     const mp_obj_fun_builtin_var_t *stream_write_obj;
+    // Entries below here are only used by native code generated by the compiler.
+    void (*viper_simd)(mp_uint_t op, const mp_uint_t *args);
 } mp_fun_table_t;
 
+// Index of the viper SIMD helper, which is after the dynamic runtime entries.
+#define MP_F_VIPER_SIMD (offsetof(mp_fun_table_t, viper_simd) / sizeof(void *))
+
 #if (MICROPY_EMIT_NATIVE && !MICROPY_DYNAMIC_COMPILER) || MICROPY_ENABLE_DYNRUNTIME
 extern const mp_fun_table_t mp_fun_table;
 #elif MICROPY_EMIT_NATIVE && MICROPY_DYNAMIC_COMPILER
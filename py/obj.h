@@ -519,7 +519,11 @@ mp_map_t *mp_map_new(size_t n);
 void mp_map_deinit(mp_map_t *map);
 void mp_map_free(mp_map_t *map);
 mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t lookup_kind);
+void mp_map_init_copy(mp_map_t *map, const mp_map_t *src);
 void mp_map_clear(mp_map_t *map);
+#if MICROPY_MAP_COMPACT
+mp_map_elem_t *mp_map_last(mp_map_t *map);
+#endif
 void mp_map_dump(mp_map_t *map);
 
 // Underlying set implementation (not set object)
@@ -1080,6 +1084,7 @@ mp_obj_t mp_obj_new_set(size_t n_args, mp_obj_t *items);
 mp_obj_t mp_obj_new_slice(mp_obj_t start, mp_obj_t stop, mp_obj_t step);
 mp_obj_t mp_obj_new_bound_meth(mp_obj_t meth, mp_obj_t self);
 mp_obj_t mp_obj_new_getitem_iter(mp_obj_t *args, mp_obj_iter_buf_t *iter_buf);
+mp_obj_t mp_obj_new_range_int_iter(mp_obj_t start, mp_obj_t stop, mp_obj_t step, mp_obj_iter_buf_t *iter_buf);
 mp_obj_t mp_obj_new_module(qstr module_name);
 mp_obj_t mp_obj_new_memoryview(byte typecode, size_t nitems, void *items);
 
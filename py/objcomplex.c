@@ -60,16 +60,21 @@ static void complex_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_
     char buf[32];
     const int precision = 16;
     #endif
+    #if MICROPY_FLOAT_EXACT_CONVERSION && MICROPY_OBJ_REPR != MICROPY_OBJ_REPR_C
+    const char fmt = 'r';
+    #else
+    const char fmt = 'g';
+    #endif
     if (o->real == 0) {
-        mp_format_float(o->imag, buf, sizeof(buf), 'g', precision, '\0');
+        mp_format_float(o->imag, buf, sizeof(buf), fmt, precision, '\0');
         mp_printf(print, "%sj", buf);
     } else {
-        mp_format_float(o->real, buf, sizeof(buf), 'g', precision, '\0');
+        mp_format_float(o->real, buf, sizeof(buf), fmt, precision, '\0');
         mp_printf(print, "(%s", buf);
         if (o->imag >= 0 || isnan(o->imag)) {
             mp_print_str(print, "+");
         }
-        mp_format_float(o->imag, buf, sizeof(buf), 'g', precision, '\0');
+        mp_format_float(o->imag, buf, sizeof(buf), fmt, precision, '\0');
         mp_printf(print, "%sj)", buf);
     }
 }
@@ -135,7 +135,7 @@ static mp_obj_t dict_new_typed(const mp_obj_type_t *type, const size_t n) {
     mp_obj_t dict_out = mp_obj_new_dict(n);
     mp_obj_dict_t *dict = MP_OBJ_TO_PTR(dict_out);
     dict->base.type = type;
-    #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
+    #if MICROPY_PY_COLLECTIONS_ORDEREDDICT && !MICROPY_MAP_COMPACT
     if (type == &mp_type_ordereddict) {
         dict->map.is_ordered = 1;
     }
@@ -147,7 +147,7 @@ mp_obj_t mp_obj_dict_make_new(const mp_obj_type_t *type, size_t n_args, size_t n
     mp_obj_t dict_out = mp_obj_new_dict(0);
     mp_obj_dict_t *dict = MP_OBJ_TO_PTR(dict_out);
     dict->base.type = type;
-    #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
+    #if MICROPY_PY_COLLECTIONS_ORDEREDDICT && !MICROPY_MAP_COMPACT
     if (type == &mp_type_ordereddict) {
         dict->map.is_ordered = 1;
     }
@@ -301,15 +301,11 @@ mp_obj_t mp_obj_dict_copy(mp_obj_t self_in) {
     mp_check_self(mp_obj_is_dict_or_ordereddict(self_in));
     // CIRCUITPY-CHANGE
     mp_obj_dict_t *self = native_dict(self_in);
-    mp_obj_t other_out = mp_obj_new_dict(self->map.alloc);
+    mp_obj_t other_out = mp_obj_new_dict(0);
     // CIRCUITPY-CHANGE
     mp_obj_dict_t *other = native_dict(other_out);
     other->base.type = self->base.type;
-    other->map.used = self->map.used;
-    other->map.all_keys_are_qstrs = self->map.all_keys_are_qstrs;
-    other->map.is_fixed = 0;
-    other->map.is_ordered = self->map.is_ordered;
-    memcpy(other->map.table, self->map.table, self->map.alloc * sizeof(mp_map_elem_t));
+    mp_map_init_copy(&other->map, &self->map);
     return other_out;
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(dict_copy_obj, mp_obj_dict_copy);
@@ -404,6 +400,12 @@ static mp_obj_t dict_popitem(mp_obj_t self_in) {
         // CIRCUITPY-CHANGE: different message
         mp_raise_msg_varg(&mp_type_KeyError, MP_ERROR_TEXT("pop from empty %q"), MP_QSTR_dict);
     }
+    #if MICROPY_MAP_COMPACT
+    // remove the most recently added element, as CPython does
+    mp_map_elem_t *last = mp_map_last(&self->map);
+    mp_obj_t items[] = {last->key, last->value};
+    mp_map_lookup(&self->map, last->key, MP_MAP_LOOKUP_REMOVE_IF_FOUND)->value = MP_OBJ_NULL;
+    #else
     size_t cur = 0;
     #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
     if (self->map.is_ordered) {
@@ -416,6 +418,7 @@ static mp_obj_t dict_popitem(mp_obj_t self_in) {
     mp_obj_t items[] = {next->key, next->value};
     next->key = MP_OBJ_SENTINEL; // must mark key as sentinel to indicate that it was deleted
     next->value = MP_OBJ_NULL;
+    #endif
     mp_obj_t tuple = mp_obj_new_tuple(2, items);
 
     return tuple;
@@ -496,6 +499,27 @@ static mp_obj_t dict_move_to_end(size_t n_args, const mp_obj_t *pos_args, mp_map
         mp_raise_type_arg(&mp_type_KeyError, key);
     }
 
+    #if MICROPY_MAP_COMPACT
+    mp_obj_t elem_key = elem->key;
+    mp_obj_t value = elem->value;
+    if (last) {
+        // remove and add again, which appends it
+        mp_map_lookup(&self->map, elem_key, MP_MAP_LOOKUP_REMOVE_IF_FOUND)->value = MP_OBJ_NULL;
+        mp_map_lookup(&self->map, elem_key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+    } else {
+        // build a new map starting with this element
+        mp_map_t map;
+        mp_map_init(&map, self->map.alloc);
+        mp_map_lookup(&map, elem_key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+        for (size_t i = 0; i < self->map.alloc; i++) {
+            if (mp_map_slot_is_filled(&self->map, i) && &self->map.table[i] != elem) {
+                mp_map_lookup(&map, self->map.table[i].key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = self->map.table[i].value;
+            }
+        }
+        mp_map_deinit(&self->map);
+        self->map = map;
+    }
+    #else
     mp_map_elem_t tmp = *elem;
     mp_map_elem_t *table = self->map.table;
     mp_map_elem_t *dest, *move_begin, *move_dest;
@@ -515,6 +539,7 @@ static mp_obj_t dict_move_to_end(size_t n_args, const mp_obj_t *pos_args, mp_map
     }
     memmove(move_dest, move_begin, move_count * sizeof(*elem));
     *dest = tmp;
+    #endif
 
     return mp_const_none;
 }
@@ -120,7 +120,12 @@ static void float_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_t
     char buf[32];
     const int precision = 16;
     #endif
+    #if MICROPY_FLOAT_EXACT_CONVERSION && MICROPY_OBJ_REPR != MICROPY_OBJ_REPR_C
+    // the shortest string that converts back to the same float
+    mp_format_float(o_val, buf, sizeof(buf), 'r', precision, '\0');
+    #else
     mp_format_float(o_val, buf, sizeof(buf), 'g', precision, '\0');
+    #endif
     mp_print_str(print, buf);
     if (strchr(buf, '.') == NULL && strchr(buf, 'e') == NULL && strchr(buf, 'n') == NULL) {
         // Python floats always have decimal point (unless inf or nan)
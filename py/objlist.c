@@ -311,6 +311,555 @@ static mp_obj_t list_pop(size_t n_args, const mp_obj_t *args) {
     return mp_obj_list_pop(self, index);
 }
 
+#if MICROPY_PY_LIST_SORT_STABLE
+
+// A stable, adaptive merge sort along the lines of CPython's listsort: natural
+// runs are found (and short ones extended with binary insertion sort), then
+// merged using galloping and a temporary buffer no bigger than the smaller run,
+// with the merge order decided by the powersort policy.  Elements are either
+// single objects, or (key, value) pairs when there is a key function, so that
+// the key function is called once per element.
+
+// Number of consecutive wins from one run before a merge switches to galloping.
+#define SORT_MIN_GALLOP (7)
+
+// Each pending run has a greater power than the one before it, and the power is
+// at most the number of bits in the list length, which bounds the run stack.
+#define SORT_MAX_RUNS (sizeof(size_t) * 8 + 1)
+
+typedef struct _sort_run_t {
+    size_t start;
+    size_t len;
+    size_t power;
+} sort_run_t;
+
+typedef struct _sort_state_t {
+    mp_obj_t *base;
+    size_t len;
+    size_t width; // number of mp_obj_t in each element, 1 or 2
+    size_t min_gallop;
+    mp_obj_t *tmp;
+    size_t tmp_alloc; // in elements
+    // Elements held in tmp during a merge, which are put back into the gap at
+    // dest if a comparison raises.  With hi set the gap ends at dest instead.
+    // These are volatile so they're up to date when the nlr handler reads them.
+    mp_obj_t *volatile dest;
+    mp_obj_t *volatile src;
+    volatile size_t n_src;
+    volatile bool hi;
+    size_t n_runs;
+    sort_run_t runs[SORT_MAX_RUNS];
+} sort_state_t;
+
+static bool sort_lt(mp_obj_t a, mp_obj_t b) {
+    if (mp_obj_is_small_int(a) && mp_obj_is_small_int(b)) {
+        return MP_OBJ_SMALL_INT_VALUE(a) < MP_OBJ_SMALL_INT_VALUE(b);
+    }
+    return mp_obj_is_true(mp_binary_op(MP_BINARY_OP_LESS, a, b));
+}
+
+static inline void sort_move(size_t w, mp_obj_t *dest, const mp_obj_t *src, size_t n) {
+    memmove(dest, src, n * w * sizeof(mp_obj_t));
+}
+
+static inline void sort_move1(size_t w, mp_obj_t *dest, const mp_obj_t *src) {
+    dest[0] = src[0];
+    if (w == 2) {
+        dest[1] = src[1];
+    }
+}
+
+static void sort_reverse(size_t w, mp_obj_t *lo, size_t n) {
+    mp_obj_t *hi = lo + (n - 1) * w;
+    while (lo < hi) {
+        for (size_t i = 0; i < w; ++i) {
+            mp_obj_t t = lo[i];
+            lo[i] = hi[i];
+            hi[i] = t;
+        }
+        lo += w;
+        hi -= w;
+    }
+}
+
+// Sort lo[0:n] given that lo[0:start] is already sorted.
+static void sort_binary_insertion(size_t w, mp_obj_t *lo, size_t n, size_t start) {
+    for (; start < n; ++start) {
+        mp_obj_t *p = lo + start * w;
+        size_t l = 0;
+        size_t r = start;
+        while (l < r) {
+            size_t m = l + (r - l) / 2;
+            if (sort_lt(p[0], lo[m * w])) {
+                r = m;
+            } else {
+                l = m + 1;
+            }
+        }
+        if (l < start) {
+            mp_obj_t pivot[2];
+            sort_move1(w, pivot, p);
+            sort_move(w, lo + (l + 1) * w, lo + l * w, start - l);
+            sort_move1(w, lo + l * w, pivot);
+        }
+    }
+}
+
+// Return the length of the run at the start of lo[0:n], reversing it in place if
+// it's strictly descending (strictly, so that reversing it keeps it stable).
+static size_t sort_count_run(size_t w, mp_obj_t *lo, size_t n) {
+    size_t k = 1;
+    if (n > 1) {
+        if (sort_lt(lo[w], lo[0])) {
+            for (k = 2; k < n && sort_lt(lo[k * w], lo[(k - 1) * w]); ++k) {
+            }
+            sort_reverse(w, lo, k);
+        } else {
+            for (k = 2; k < n && !sort_lt(lo[k * w], lo[(k - 1) * w]); ++k) {
+            }
+        }
+    }
+    return k;
+}
+
+// Return the index k in the sorted a[0:n] such that a[k-1] < key <= a[k],
+// starting the search from a[hint].
+static size_t sort_gallop_left(size_t w, mp_obj_t key, mp_obj_t *a, size_t n, size_t hint) {
+    size_t lastofs = 0;
+    size_t ofs = 1;
+    size_t lo, hi;
+    if (sort_lt(a[hint * w], key)) {
+        // gallop right until a[hint + lastofs] < key <= a[hint + ofs]
+        size_t maxofs = n - hint;
+        while (ofs < maxofs && sort_lt(a[(hint + ofs) * w], key)) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) {
+            ofs = maxofs;
+        }
+        lo = hint + lastofs + 1;
+        hi = hint + ofs;
+    } else {
+        // gallop left until a[hint - ofs] < key <= a[hint - lastofs]
+        size_t maxofs = hint + 1;
+        while (ofs < maxofs && !sort_lt(a[(hint - ofs) * w], key)) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) {
+            ofs = maxofs;
+        }
+        lo = hint + 1 - ofs;
+        hi = hint - lastofs;
+    }
+    while (lo < hi) {
+        size_t m = lo + (hi - lo) / 2;
+        if (sort_lt(a[m * w], key)) {
+            lo = m + 1;
+        } else {
+            hi = m;
+        }
+    }
+    return hi;
+}
+
+// Return the index k in the sorted a[0:n] such that a[k-1] <= key < a[k],
+// starting the search from a[hint].
+static size_t sort_gallop_right(size_t w, mp_obj_t key, mp_obj_t *a, size_t n, size_t hint) {
+    size_t lastofs = 0;
+    size_t ofs = 1;
+    size_t lo, hi;
+    if (sort_lt(key, a[hint * w])) {
+        // gallop left until a[hint - ofs] <= key < a[hint - lastofs]
+        size_t maxofs = hint + 1;
+        while (ofs < maxofs && sort_lt(key, a[(hint - ofs) * w])) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) {
+            ofs = maxofs;
+        }
+        lo = hint + 1 - ofs;
+        hi = hint - lastofs;
+    } else {
+        // gallop right until a[hint + lastofs] <= key < a[hint + ofs]
+        size_t maxofs = n - hint;
+        while (ofs < maxofs && !sort_lt(key, a[(hint + ofs) * w])) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) {
+            ofs = maxofs;
+        }
+        lo = hint + lastofs + 1;
+        hi = hint + ofs;
+    }
+    while (lo < hi) {
+        size_t m = lo + (hi - lo) / 2;
+        if (sort_lt(key, a[m * w])) {
+            hi = m;
+        } else {
+            lo = m + 1;
+        }
+    }
+    return hi;
+}
+
+static mp_obj_t *sort_get_tmp(sort_state_t *ms, size_t n) {
+    if (n > ms->tmp_alloc) {
+        m_del(mp_obj_t, ms->tmp, ms->tmp_alloc * ms->width);
+        ms->tmp = NULL;
+        ms->tmp_alloc = 0;
+        ms->tmp = m_new(mp_obj_t, n * ms->width);
+        ms->tmp_alloc = n;
+    }
+    return ms->tmp;
+}
+
+// Merge the adjacent runs a[0:na] and b[0:nb] with na <= nb, given that b[0]
+// belongs before a[0] and a[na-1] belongs after b[nb-1].  a is copied to tmp
+// and merged from the front.
+static void sort_merge_lo(sort_state_t *ms, mp_obj_t *a, size_t na, mp_obj_t *b, size_t nb) {
+    size_t w = ms->width;
+    sort_move(w, sort_get_tmp(ms, na), a, na);
+    ms->dest = a;
+    ms->src = ms->tmp;
+    ms->n_src = na;
+    ms->hi = false;
+
+    sort_move1(w, ms->dest, b);
+    ms->dest += w;
+    b += w;
+    if (--nb == 0) {
+        goto done;
+    }
+    if (ms->n_src == 1) {
+        goto copy_b;
+    }
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+        // one element at a time until one run wins consistently
+        for (;;) {
+            if (sort_lt(b[0], ms->src[0])) {
+                sort_move1(w, ms->dest, b);
+                ms->dest += w;
+                b += w;
+                ++bcount;
+                acount = 0;
+                if (--nb == 0) {
+                    goto done;
+                }
+                if (bcount >= ms->min_gallop) {
+                    break;
+                }
+            } else {
+                sort_move1(w, ms->dest, ms->src);
+                ms->dest += w;
+                ms->src += w;
+                ++acount;
+                bcount = 0;
+                if (--ms->n_src == 1) {
+                    goto copy_b;
+                }
+                if (acount >= ms->min_gallop) {
+                    break;
+                }
+            }
+        }
+        // gallop until neither run wins consistently
+        ++ms->min_gallop;
+        do {
+            ms->min_gallop -= ms->min_gallop > 1;
+            size_t k = sort_gallop_right(w, b[0], ms->src, ms->n_src, 0);
+            acount = k;
+            if (k) {
+                sort_move(w, ms->dest, ms->src, k);
+                ms->dest += k * w;
+                ms->src += k * w;
+                ms->n_src -= k;
+                if (ms->n_src == 1) {
+                    goto copy_b;
+                }
+                // possible only with an inconsistent comparison
+                if (ms->n_src == 0) {
+                    goto done;
+                }
+            }
+            sort_move1(w, ms->dest, b);
+            ms->dest += w;
+            b += w;
+            if (--nb == 0) {
+                goto done;
+            }
+
+            k = sort_gallop_left(w, ms->src[0], b, nb, 0);
+            bcount = k;
+            if (k) {
+                sort_move(w, ms->dest, b, k);
+                ms->dest += k * w;
+                b += k * w;
+                nb -= k;
+                if (nb == 0) {
+                    goto done;
+                }
+            }
+            sort_move1(w, ms->dest, ms->src);
+            ms->dest += w;
+            ms->src += w;
+            if (--ms->n_src == 1) {
+                goto copy_b;
+            }
+        } while (acount >= SORT_MIN_GALLOP || bcount >= SORT_MIN_GALLOP);
+        ++ms->min_gallop;
+    }
+
+copy_b:
+    // the last element of a belongs at the end of the merge
+    sort_move(w, ms->dest, b, nb);
+    ms->dest += nb * w;
+done:
+    sort_move(w, ms->dest, ms->src, ms->n_src);
+    ms->n_src = 0;
+}
+
+// As sort_merge_lo, but with na >= nb, copying b to tmp and merging from the back.
+static void sort_merge_hi(sort_state_t *ms, mp_obj_t *a, size_t na, mp_obj_t *b, size_t nb) {
+    size_t w = ms->width;
+    mp_obj_t *base_a = a;
+    mp_obj_t *base_b = sort_get_tmp(ms, nb);
+    sort_move(w, base_b, b, nb);
+    ms->dest = b + (nb - 1) * w;
+    ms->src = base_b;
+    ms->n_src = nb;
+    ms->hi = true;
+    mp_obj_t *pa = a + (na - 1) * w;
+    mp_obj_t *pb = base_b + (nb - 1) * w;
+
+    sort_move1(w, ms->dest, pa);
+    ms->dest -= w;
+    pa -= w;
+    if (--na == 0) {
+        goto done;
+    }
+    if (ms->n_src == 1) {
+        goto copy_a;
+    }
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+        // one element at a time until one run wins consistently
+        for (;;) {
+            if (sort_lt(pb[0], pa[0])) {
+                sort_move1(w, ms->dest, pa);
+                ms->dest -= w;
+                pa -= w;
+                ++acount;
+                bcount = 0;
+                if (--na == 0) {
+                    goto done;
+                }
+                if (acount >= ms->min_gallop) {
+                    break;
+                }
+            } else {
+                sort_move1(w, ms->dest, pb);
+                ms->dest -= w;
+                pb -= w;
+                ++bcount;
+                acount = 0;
+                if (--ms->n_src == 1) {
+                    goto copy_a;
+                }
+                if (bcount >= ms->min_gallop) {
+                    break;
+                }
+            }
+        }
+        // gallop until neither run wins consistently
+        ++ms->min_gallop;
+        do {
+            ms->min_gallop -= ms->min_gallop > 1;
+            size_t k = na - sort_gallop_right(w, pb[0], base_a, na, na - 1);
+            acount = k;
+            if (k) {
+                ms->dest -= k * w;
+                pa -= k * w;
+                sort_move(w, ms->dest + w, pa + w, k);
+                na -= k;
+                if (na == 0) {
+                    goto done;
+                }
+            }
+            sort_move1(w, ms->dest, pb);
+            ms->dest -= w;
+            pb -= w;
+            if (--ms->n_src == 1) {
+                goto copy_a;
+            }
+
+            k = ms->n_src - sort_gallop_left(w, pa[0], base_b, ms->n_src, ms->n_src - 1);
+            bcount = k;
+            if (k) {
+                ms->dest -= k * w;
+                pb -= k * w;
+                sort_move(w, ms->dest + w, pb + w, k);
+                ms->n_src -= k;
+                if (ms->n_src == 1) {
+                    goto copy_a;
+                }
+                // possible only with an inconsistent comparison
+                if (ms->n_src == 0) {
+                    goto done;
+                }
+            }
+            sort_move1(w, ms->dest, pa);
+            ms->dest -= w;
+            pa -= w;
+            if (--na == 0) {
+                goto done;
+            }
+        } while (acount >= SORT_MIN_GALLOP || bcount >= SORT_MIN_GALLOP);
+        ++ms->min_gallop;
+    }
+
+copy_a:
+    // the first element of b belongs at the front of the merge
+    ms->dest -= na * w;
+    pa -= na * w;
+    sort_move(w, ms->dest + w, pa + w, na);
+done:
+    sort_move(w, ms->dest + w - ms->n_src * w, base_b, ms->n_src);
+    ms->n_src = 0;
+}
+
+// Merge the runs at i and i + 1 on the run stack.
+static void sort_merge_at(sort_state_t *ms, size_t i) {
+    size_t w = ms->width;
+    sort_run_t *runs = ms->runs;
+    mp_obj_t *a = ms->base + runs[i].start * w;
+    size_t na = runs[i].len;
+    mp_obj_t *b = ms->base + runs[i + 1].start * w;
+    size_t nb = runs[i + 1].len;
+
+    runs[i].len = na + nb;
+    if (i + 3 == ms->n_runs) {
+        runs[i + 1] = runs[i + 2];
+    }
+    --ms->n_runs;
+
+    // elements of a that are before b[0] are already in place
+    size_t k = sort_gallop_right(w, b[0], a, na, 0);
+    a += k * w;
+    na -= k;
+    if (na == 0) {
+        return;
+    }
+    // and so are elements of b after a[na - 1]
+    nb = sort_gallop_left(w, a[(na - 1) * w], b, nb, nb - 1);
+    if (nb == 0) {
+        return;
+    }
+    if (na <= nb) {
+        sort_merge_lo(ms, a, na, b, nb);
+    } else {
+        sort_merge_hi(ms, a, na, b, nb);
+    }
+}
+
+// The powersort power of the boundary between the adjacent runs at s1 (of
+// length n1) and s1 + n1 (of length n2), in a list of length n.
+static size_t sort_power(size_t s1, size_t n1, size_t n2, size_t n) {
+    size_t result = 0;
+    size_t a = 2 * s1 + n1;
+    size_t b = a + n1 + n2;
+    for (;;) {
+        ++result;
+        if (a >= n) {
+            a -= n;
+            b -= n;
+        } else if (b >= n) {
+            break;
+        }
+        a <<= 1;
+        b <<= 1;
+    }
+    return result;
+}
+
+static void sort_runs(sort_state_t *ms) {
+    size_t w = ms->width;
+    size_t n = ms->len;
+
+    // runs shorter than minrun, in [32, 64], are extended so that the list is
+    // split into a number of runs that's equal to or just under a power of 2
+    size_t minrun = n;
+    size_t r = 0;
+    while (minrun >= 64) {
+        r |= minrun & 1;
+        minrun >>= 1;
+    }
+    minrun += r;
+
+    for (size_t lo = 0; lo < n;) {
+        mp_obj_t *p = ms->base + lo * w;
+        size_t run = sort_count_run(w, p, n - lo);
+        if (run < minrun) {
+            size_t force = MIN(minrun, n - lo);
+            sort_binary_insertion(w, p, force, run);
+            run = force;
+        }
+        if (ms->n_runs > 0) {
+            sort_run_t *top = &ms->runs[ms->n_runs - 1];
+            size_t power = sort_power(top->start, top->len, run, n);
+            while (ms->n_runs > 1 && ms->runs[ms->n_runs - 2].power > power) {
+                sort_merge_at(ms, ms->n_runs - 2);
+            }
+            ms->runs[ms->n_runs - 1].power = power;
+        }
+        assert(ms->n_runs < SORT_MAX_RUNS);
+        ms->runs[ms->n_runs].start = lo;
+        ms->runs[ms->n_runs].len = run;
+        ++ms->n_runs;
+        lo += run;
+    }
+    while (ms->n_runs > 1) {
+        sort_merge_at(ms, ms->n_runs - 2);
+    }
+}
+
+// Sort n elements of the given width, in place.  If a comparison raises then the
+// elements are left in some order, but none are lost or duplicated.
+static void mp_timsort(mp_obj_t *base, size_t n, size_t width) {
+    sort_state_t ms;
+    ms.base = base;
+    ms.len = n;
+    ms.width = width;
+    ms.min_gallop = SORT_MIN_GALLOP;
+    ms.tmp = NULL;
+    ms.tmp_alloc = 0;
+    ms.n_src = 0;
+    ms.n_runs = 0;
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        sort_runs(&ms);
+        nlr_pop();
+    } else {
+        if (ms.n_src > 0) {
+            mp_obj_t *dest = ms.hi ? ms.dest + width - ms.n_src * width : ms.dest;
+            sort_move(width, dest, ms.src, ms.n_src);
+        }
+        m_del(mp_obj_t, ms.tmp, ms.tmp_alloc * width);
+        nlr_jump(nlr.ret_val);
+    }
+    m_del(mp_obj_t, ms.tmp, ms.tmp_alloc * width);
+}
+
+#else
+
+// TODO Python defines sort to be stable but ours is not
 static void mp_quicksort(mp_obj_t *head, mp_obj_t *tail, mp_obj_t key_fn, mp_obj_t binop_less_result) {
     MP_STACK_CHECK();
     while (head < tail) {
@@ -343,7 +892,8 @@ static void mp_quicksort(mp_obj_t *head, mp_obj_t *tail, mp_obj_t key_fn, mp_obj
     }
 }
 
-// TODO Python defines sort to be stable but ours is not
+#endif
+
 mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_key, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
@@ -361,11 +911,75 @@ mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_
     // CIRCUITPY-CHANGE
     mp_obj_list_t *self = native_list(pos_args[0]);
 
+    #if MICROPY_PY_LIST_SORT_STABLE
+    size_t n = self->len;
+    if (n > 1) {
+        // Sorting the reversed list and then reversing the result keeps equal
+        // elements in their original order.
+        bool reverse = args.reverse.u_bool;
+        if (args.key.u_obj == mp_const_none) {
+            // Sort the items in place, but detach them from the list while doing
+            // so, because comparisons can run arbitrary code that may modify it.
+            mp_obj_t *items = self->items;
+            size_t alloc = self->alloc;
+            mp_obj_t *detached_items = m_new0(mp_obj_t, LIST_MIN_ALLOC);
+            self->items = detached_items;
+            self->alloc = LIST_MIN_ALLOC;
+            self->len = 0;
+            nlr_buf_t nlr;
+            bool ok = nlr_push(&nlr) == 0;
+            if (ok) {
+                if (reverse) {
+                    sort_reverse(1, items, n);
+                }
+                mp_timsort(items, n, 1);
+                if (reverse) {
+                    sort_reverse(1, items, n);
+                }
+                nlr_pop();
+            }
+            bool modified = self->items != detached_items || self->len != 0;
+            m_del(mp_obj_t, self->items, self->alloc);
+            self->items = items;
+            self->alloc = alloc;
+            self->len = n;
+            if (!ok) {
+                nlr_jump(nlr.ret_val);
+            }
+            if (modified) {
+                mp_raise_ValueError(MP_ERROR_TEXT("list modified during sort"));
+            }
+        } else {
+            // sort (key, value) pairs, so each key is computed once
+            mp_obj_t *pairs = m_new(mp_obj_t, 2 * n);
+            for (size_t i = 0; i < n; ++i) {
+                pairs[2 * i + 1] = self->items[i];
+            }
+            for (size_t i = 0; i < n; ++i) {
+                pairs[2 * i] = mp_call_function_1(args.key.u_obj, pairs[2 * i + 1]);
+            }
+            if (reverse) {
+                sort_reverse(2, pairs, n);
+            }
+            mp_timsort(pairs, n, 2);
+            if (reverse) {
+                sort_reverse(2, pairs, n);
+            }
+            // the key function may have changed the length of the list
+            size_t len = MIN(n, self->len);
+            for (size_t i = 0; i < len; ++i) {
+                self->items[i] = pairs[2 * i + 1];
+            }
+            m_del(mp_obj_t, pairs, 2 * n);
+        }
+    }
+    #else
     if (self->len > 1) {
         mp_quicksort(self->items, self->items + self->len - 1,
             args.key.u_obj == mp_const_none ? MP_OBJ_NULL : args.key.u_obj,
             args.reverse.u_bool ? mp_const_false : mp_const_true);
     }
+    #endif
 
     return mp_const_none;
 }
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 
 #include "py/runtime.h"
+#include "py/objint.h"
 
 /******************************************************************************/
 /* range iterator                                                             */
@@ -42,8 +43,11 @@ typedef struct _mp_obj_range_it_t {
 static mp_obj_t range_it_iternext(mp_obj_t o_in) {
     mp_obj_range_it_t *o = MP_OBJ_TO_PTR(o_in);
     if ((o->step > 0 && o->cur < o->stop) || (o->step < 0 && o->cur > o->stop)) {
-        mp_obj_t o_out = MP_OBJ_NEW_SMALL_INT(o->cur);
-        o->cur += o->step;
+        mp_obj_t o_out = mp_obj_new_int(o->cur);
+        // Go to the end if the step reaches it, so cur doesn't overflow.
+        mp_uint_t left = o->step > 0 ? (mp_uint_t)o->stop - (mp_uint_t)o->cur : (mp_uint_t)o->cur - (mp_uint_t)o->stop;
+        mp_uint_t step = o->step > 0 ? (mp_uint_t)o->step : -(mp_uint_t)o->step;
+        o->cur = step < left ? o->cur + o->step : o->stop;
         return o_out;
     } else {
         return MP_OBJ_STOP_ITERATION;
@@ -67,6 +71,48 @@ static mp_obj_t mp_obj_new_range_iterator(mp_int_t cur, mp_int_t stop, mp_int_t
     return MP_OBJ_FROM_PTR(o);
 }
 
+#if MICROPY_OPT_COUNTED_RANGE_LOOP
+// An iterator over range(start, stop, step) for int objects of any size, used
+// by a counted range loop when they don't all fit in a small int.  It counts
+// with generic binary operations so it never overflows.
+
+typedef struct _mp_obj_range_int_it_t {
+    mp_obj_base_t base;
+    mp_obj_t cur;
+    mp_obj_t stop;
+    mp_obj_t step;
+} mp_obj_range_int_it_t;
+
+static mp_obj_t range_int_it_iternext(mp_obj_t o_in) {
+    mp_obj_range_int_it_t *o = MP_OBJ_TO_PTR(o_in);
+    mp_binary_op_t op = mp_obj_int_sign(o->step) > 0 ? MP_BINARY_OP_LESS : MP_BINARY_OP_MORE;
+    if (mp_obj_is_true(mp_binary_op(op, o->cur, o->stop))) {
+        mp_obj_t o_out = o->cur;
+        o->cur = mp_binary_op(MP_BINARY_OP_ADD, o->cur, o->step);
+        return o_out;
+    } else {
+        return MP_OBJ_STOP_ITERATION;
+    }
+}
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+    mp_type_range_int_it,
+    MP_QSTR_iterator,
+    MP_TYPE_FLAG_ITER_IS_ITERNEXT,
+    iter, range_int_it_iternext
+    );
+
+mp_obj_t mp_obj_new_range_int_iter(mp_obj_t start, mp_obj_t stop, mp_obj_t step, mp_obj_iter_buf_t *iter_buf) {
+    assert(sizeof(mp_obj_range_int_it_t) <= sizeof(mp_obj_iter_buf_t));
+    mp_obj_range_int_it_t *o = (mp_obj_range_int_it_t *)iter_buf;
+    o->base.type = &mp_type_range_int_it;
+    o->cur = start;
+    o->stop = stop;
+    o->step = step;
+    return MP_OBJ_FROM_PTR(o);
+}
+#endif
+
 /******************************************************************************/
 /* range                                                                      */
 
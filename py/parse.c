@@ -240,6 +240,11 @@ typedef struct _parser_t {
     #if MICROPY_COMP_CONST
     mp_map_t consts;
     #endif
+
+    #if MICROPY_COMP_STREAMING
+    mp_parse_stmt_callback_t stmt_callback;
+    void *stmt_callback_env;
+    #endif
 } parser_t;
 
 static void push_result_rule(parser_t *parser, size_t src_line, uint8_t rule_id, size_t num_args);
@@ -1028,7 +1033,30 @@ static void push_result_rule(parser_t *parser, size_t src_line, uint8_t rule_id,
     push_result_node(parser, (mp_parse_node_t)pn);
 }
 
+#if MICROPY_COMP_STREAMING
+// Called when the file_input_2 rule has matched another item, to pass that item to
+// the statement callback and then free all the parse nodes, which belong to it.
+// A null node is left on the result stack in place of all the items handed over.
+static void pass_stmt_to_callback(parser_t *parser, size_t num_items) {
+    mp_parse_node_t pn = pop_result(parser);
+    if (num_items == 1) {
+        push_result_node(parser, MP_PARSE_NODE_NULL);
+    }
+    if (!MP_PARSE_NODE_IS_TOKEN_KIND(pn, MP_TOKEN_NEWLINE)) {
+        parser->stmt_callback(parser->stmt_callback_env, pn);
+    }
+    mp_parse_tree_clear(&parser->tree);
+    if (parser->cur_chunk != NULL) {
+        parser->cur_chunk->union_.used = 0;
+    }
+}
+#endif
+
+#if MICROPY_COMP_STREAMING
+static mp_parse_tree_t parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind, mp_parse_stmt_callback_t stmt_callback, void *stmt_callback_env) {
+#else
 mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
+#endif
     // Set exception handler to free the lexer if an exception is raised.
     MP_DEFINE_NLR_JUMP_CALLBACK_FUNCTION_1(ctx, mp_lexer_free, lex);
     nlr_push_jump_callback(&ctx.callback, mp_call_function_1_from_nlr_jump_callback);
@@ -1075,6 +1103,11 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     mp_map_init(&parser.consts, 0);
     #endif
 
+    #if MICROPY_COMP_STREAMING
+    parser.stmt_callback = stmt_callback;
+    parser.stmt_callback_env = stmt_callback_env;
+    #endif
+
     // work out the top-level rule to use, and push it on the stack
     size_t top_level_rule;
     switch (input_kind) {
@@ -1296,6 +1329,14 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                         }
                     }
                 } else {
+                    #if MICROPY_COMP_STREAMING
+                    if (rule_id == RULE_file_input_2 && i > 0 && parser.stmt_callback != NULL) {
+                        // another top-level statement is complete; the list keeps a single
+                        // placeholder item for all those that are handed over
+                        pass_stmt_to_callback(&parser, i);
+                        i = 1;
+                    }
+                    #endif
                     for (;;) {
                         size_t arg = rule_arg[i & 1 & n];
                         if ((arg & RULE_ARG_KIND_MASK) == RULE_ARG_TOK) {
@@ -1406,6 +1447,17 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
     return parser.tree;
 }
 
+#if MICROPY_COMP_STREAMING
+mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
+    return parse(lex, input_kind, NULL, NULL);
+}
+
+void mp_parse_streaming(mp_lexer_t *lex, mp_parse_stmt_callback_t callback, void *env) {
+    mp_parse_tree_t tree = parse(lex, MP_PARSE_FILE_INPUT, callback, env);
+    mp_parse_tree_clear(&tree);
+}
+#endif
+
 void mp_parse_tree_clear(mp_parse_tree_t *tree) {
     mp_parse_chunk_t *chunk = tree->chunk;
     while (chunk != NULL) {
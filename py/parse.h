@@ -113,4 +113,13 @@ typedef struct _mp_parse_t {
 mp_parse_tree_t mp_parse(struct _mp_lexer_t *lex, mp_parse_input_kind_t input_kind);
 void mp_parse_tree_clear(mp_parse_tree_t *tree);
 
+#if MICROPY_COMP_STREAMING
+typedef void (*mp_parse_stmt_callback_t)(void *env, mp_parse_node_t pn);
+
+// parse file input, passing each top-level statement to the callback as soon as
+// it's complete; the parse nodes of the statement are freed when the callback
+// returns, and otherwise this behaves like mp_parse with MP_PARSE_FILE_INPUT
+void mp_parse_streaming(struct _mp_lexer_t *lex, mp_parse_stmt_callback_t callback, void *env);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_PARSE_H
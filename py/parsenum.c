@@ -31,6 +31,7 @@
 #include "py/parsenumbase.h"
 #include "py/parsenum.h"
 #include "py/smallint.h"
+#include "py/formatfloat.h"
 
 #if MICROPY_PY_BUILTINS_FLOAT
 #include <math.h>
@@ -275,6 +276,9 @@ parse_start:
         parse_dec_in_t in = PARSE_DEC_IN_INTG;
         bool exp_neg = false;
         int exp_val = 0;
+        #if MICROPY_FLOAT_EXACT_CONVERSION
+        const char *dec_top = NULL;
+        #endif
         int exp_extra = 0;
         int trailing_zeros_intg = 0, trailing_zeros_frac = 0;
         while (str < top) {
@@ -288,7 +292,7 @@ parse_start:
                     if (exp_val < (INT_MAX / 2 - 9) / 10) {
                         exp_val = 10 * exp_val + dig;
                     }
-                } else {
+                } else if (!MICROPY_FLOAT_EXACT_CONVERSION) {
                     if (dig == 0 || dec_val >= DEC_VAL_MAX) {
                         // Defer treatment of zeros in fractional part.  If nothing comes afterwards, ignore them.
                         // Also, once we reach DEC_VAL_MAX, treat every additional digit as a trailing zero.
@@ -314,6 +318,9 @@ parse_start:
                 in = PARSE_DEC_IN_FRAC;
             } else if (in != PARSE_DEC_IN_EXP && ((dig | 0x20) == 'e')) {
                 in = PARSE_DEC_IN_EXP;
+                #if MICROPY_FLOAT_EXACT_CONVERSION
+                dec_top = str - 1;
+                #endif
                 if (str < top) {
                     if (str[0] == '+') {
                         str++;
@@ -339,6 +346,10 @@ parse_start:
             exp_val = -exp_val;
         }
 
+        #if MICROPY_FLOAT_EXACT_CONVERSION
+        // convert all the digits at once, correctly rounded
+        dec_val = mp_parse_float_digits(str_val_start, dec_top != NULL ? dec_top : str, exp_val);
+        #else
         // apply the exponent, making sure it's not a subnormal value
         exp_val += exp_extra + trailing_zeros_intg;
         if (exp_val < SMALL_NORMAL_EXP) {
@@ -356,6 +367,7 @@ parse_start:
         } else {
             dec_val *= MICROPY_FLOAT_C_FUN(pow)(10, exp_val);
         }
+        #endif
     }
 
     if (allow_imag && str < top && (*str | 0x20) == 'j') {
@@ -174,6 +174,12 @@ static qstr load_qstr(mp_reader_t *reader) {
         return len >> 1;
     }
     len >>= 1;
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    const char *rom_str = (const char *)mp_reader_try_read_rom(reader, len + 1, true);
+    if (rom_str != NULL) {
+        return qstr_from_strn_static(rom_str, len);
+    }
+    #endif
     char *str = m_new(char, len);
     read_bytes(reader, (byte *)str, len);
     read_byte(reader); // read and discard null terminator
@@ -182,6 +188,22 @@ static qstr load_qstr(mp_reader_t *reader) {
     return qst;
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+static mp_obj_t load_str_in_place(const mp_obj_type_t *type, const byte *data, size_t len) {
+    if (type == &mp_type_str) {
+        qstr q = qstr_find_strn((const char *)data, len);
+        if (q != MP_QSTRnull) {
+            return MP_OBJ_NEW_QSTR(q);
+        }
+    }
+    mp_obj_str_t *o = mp_obj_malloc(mp_obj_str_t, type);
+    o->hash = qstr_compute_hash(data, len);
+    o->len = len;
+    o->data = data;
+    return MP_OBJ_FROM_PTR(o);
+}
+#endif
+
 static mp_obj_t load_obj(mp_reader_t *reader) {
     byte obj_type = read_byte(reader);
     #if MICROPY_EMIT_MACHINE_CODE
@@ -209,6 +231,15 @@ static mp_obj_t load_obj(mp_reader_t *reader) {
             }
             return MP_OBJ_FROM_PTR(tuple);
         }
+        #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+        if (obj_type == MP_PERSISTENT_OBJ_STR || obj_type == MP_PERSISTENT_OBJ_BYTES) {
+            // use the string data, including its null terminator, in place
+            const byte *data = mp_reader_try_read_rom(reader, len + 1, false);
+            if (data != NULL) {
+                return load_str_in_place(obj_type == MP_PERSISTENT_OBJ_STR ? &mp_type_str : &mp_type_bytes, data, len);
+            }
+        }
+        #endif
         vstr_t vstr;
         vstr_init_len(&vstr, len);
         read_bytes(reader, (byte *)vstr.buf, len);
@@ -228,7 +259,7 @@ static mp_obj_t load_obj(mp_reader_t *reader) {
     }
 }
 
-static mp_raw_code_t *load_raw_code(mp_reader_t *reader, mp_module_context_t *context) {
+static mp_raw_code_t *load_raw_code(mp_reader_t *reader, mp_module_context_t *context, bool is_module) {
     // Load function kind and data length
     size_t kind_len = read_uint(reader);
     int kind = (kind_len & 3) + MP_CODE_BYTECODE;
@@ -250,10 +281,18 @@ static mp_raw_code_t *load_raw_code(mp_reader_t *reader, mp_module_context_t *co
     #endif
 
     if (kind == MP_CODE_BYTECODE) {
-        // Allocate memory for the bytecode
-        fun_data = m_new(uint8_t, fun_data_len);
-        // Load bytecode
-        read_bytes(reader, fun_data, fun_data_len);
+        #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+        // Execute the bytecode in place if possible; it's never written to.
+        fun_data = (uint8_t *)mp_reader_try_read_rom(reader, fun_data_len, false);
+        if (fun_data == NULL)
+        #endif
+        {
+            // Allocate memory for the bytecode.  Module-level code is run once,
+            // but functions usually live as long as their module.
+            fun_data = is_module ? m_new(uint8_t, fun_data_len) : m_new_long_lived(uint8_t, fun_data_len);
+            // Load bytecode
+            read_bytes(reader, fun_data, fun_data_len);
+        }
 
     #if MICROPY_EMIT_MACHINE_CODE
     } else {
@@ -320,7 +359,7 @@ static mp_raw_code_t *load_raw_code(mp_reader_t *reader, mp_module_context_t *co
         n_children = read_uint(reader);
         children = m_new(mp_raw_code_t *, n_children + (kind == MP_CODE_NATIVE_PY));
         for (size_t i = 0; i < n_children; ++i) {
-            children[i] = load_raw_code(reader, context);
+            children[i] = load_raw_code(reader, context, false);
         }
     }
 
@@ -400,9 +439,23 @@ static mp_raw_code_t *load_raw_code(mp_reader_t *reader, mp_module_context_t *co
     return rc;
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+// Called if loading fails.  Nothing loaded will be used, so the data of the
+// reader needn't stay valid after it's closed.
+static void mp_raw_code_load_abandon(void *reader_in) {
+    mp_reader_t *reader = reader_in;
+    mp_reader_rom_abandon(reader);
+    reader->close(reader->data);
+}
+#endif
+
 void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *cm) {
     // Set exception handler to close the reader if an exception is raised.
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    MP_DEFINE_NLR_JUMP_CALLBACK_FUNCTION_1(ctx, mp_raw_code_load_abandon, reader);
+    #else
     MP_DEFINE_NLR_JUMP_CALLBACK_FUNCTION_1(ctx, reader->close, reader->data);
+    #endif
     nlr_push_jump_callback(&ctx.callback, mp_call_function_1_from_nlr_jump_callback);
 
     byte header[4];
@@ -425,6 +478,11 @@ void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *cm) {
                 mp_raise_ValueError(MP_ERROR_TEXT("incompatible .mpy arch"));
             }
         }
+        #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+        // Native code is copied and relocated, so it's not worth keeping the
+        // reader's data valid just for some of the other parts.
+        mp_reader_rom_abandon(reader);
+        #endif
     }
 
     size_t n_qstr = read_uint(reader);
@@ -442,7 +500,7 @@ void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *cm) {
     }
 
     // Load top-level module.
-    cm->rc = load_raw_code(reader, cm->context);
+    cm->rc = load_raw_code(reader, cm->context, true);
 
     #if MICROPY_PERSISTENT_CODE_SAVE
     cm->has_native = MPY_FEATURE_DECODE_ARCH(header[2]) != MP_NATIVE_ARCH_NONE;
@@ -451,7 +509,8 @@ void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *cm) {
     #endif
 
     // Deregister exception handler and close the reader.
-    nlr_pop_jump_callback(true);
+    nlr_pop_jump_callback(false);
+    reader->close(reader->data);
 }
 
 void mp_raw_code_load_mem(const byte *buf, size_t len, mp_compiled_module_t *context) {
@@ -464,7 +523,11 @@ void mp_raw_code_load_mem(const byte *buf, size_t len, mp_compiled_module_t *con
 
 void mp_raw_code_load_file(qstr filename, mp_compiled_module_t *context) {
     mp_reader_t reader;
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP && MICROPY_READER_VFS
+    mp_reader_new_file_rom(&reader, filename);
+    #else
     mp_reader_new_file(&reader, filename);
+    #endif
     mp_raw_code_load(&reader, context);
 }
 
@@ -474,6 +537,13 @@ void mp_raw_code_load_file(qstr filename, mp_compiled_module_t *context) {
 
 #if MICROPY_PERSISTENT_CODE_SAVE
 
+#if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+#error "MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS requires MICROPY_PERSISTENT_CODE_SAVE to be disabled"
+#endif
+#if MICROPY_OPT_COUNTED_RANGE_LOOP
+#error "MICROPY_OPT_COUNTED_RANGE_LOOP requires MICROPY_PERSISTENT_CODE_SAVE to be disabled"
+#endif
+
 #include "py/objstr.h"
 
 static void mp_print_bytes(mp_print_t *print, const byte *data, size_t len) {
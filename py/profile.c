@@ -975,3 +975,111 @@ void mp_prof_print_instr(const byte *ip, mp_code_state_t *code_state) {
 #endif // MICROPY_PROF_INSTR_DEBUG_PRINT_ENABLE
 
 #endif // MICROPY_PY_SYS_SETTRACE
+
+#if MICROPY_PY_MICROPYTHON_PROF_SAMPLING
+
+// Samples are stored in a single-producer single-consumer ring buffer of
+// words.  Each sample is a frame count n followed by n (name, offset) pairs,
+// innermost frame first.  The producer is mp_prof_sample(), which may run in
+// a signal handler, so it only reads the frame chain and writes into static
+// memory; it publishes a sample by advancing prof_head.  The consumer is
+// mp_prof_sample_dump(), running in the VM, which advances prof_tail.
+
+#define PROF_BUF_SIZE (MICROPY_PY_MICROPYTHON_PROF_SAMPLING_BUF_SIZE)
+#define PROF_BUF_MASK (PROF_BUF_SIZE - 1)
+
+static uint32_t prof_buf[PROF_BUF_SIZE];
+static size_t prof_head;
+static size_t prof_tail;
+static size_t prof_dropped;
+static bool prof_busy;
+
+void mp_prof_sample(void) {
+    // Another thread may be taking a sample at the same time; there is only
+    // room for one producer, so skip this one.
+    if (__atomic_exchange_n(&prof_busy, true, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&prof_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    #if MICROPY_PY_THREAD
+    // The signal may be delivered to a thread that does not run Python code.
+    if (mp_thread_get_state() == NULL) {
+        goto done;
+    }
+    #endif
+
+    const mp_code_state_t *code_state = MP_STATE_THREAD(current_code_state);
+    if (code_state == NULL) {
+        goto done;
+    }
+
+    size_t head = prof_head;
+    size_t avail = PROF_BUF_SIZE - (head - __atomic_load_n(&prof_tail, __ATOMIC_ACQUIRE));
+    size_t pos = head + 1;
+    size_t n = 0;
+    for (; code_state != NULL && n < MICROPY_PY_MICROPYTHON_PROF_SAMPLING_DEPTH; code_state = code_state->prev_state) {
+        if (pos + 2 - head > avail) {
+            __atomic_fetch_add(&prof_dropped, 1, __ATOMIC_RELAXED);
+            goto done;
+        }
+        const mp_obj_fun_bc_t *fun = code_state->fun_bc;
+        prof_buf[pos++ & PROF_BUF_MASK] = mp_obj_fun_get_name(MP_OBJ_FROM_PTR(fun));
+        prof_buf[pos++ & PROF_BUF_MASK] = code_state->ip - fun->bytecode;
+        ++n;
+    }
+    prof_buf[head & PROF_BUF_MASK] = n;
+    __atomic_store_n(&prof_head, pos, __ATOMIC_RELEASE);
+
+done:
+    __atomic_store_n(&prof_busy, false, __ATOMIC_RELEASE);
+}
+
+void mp_prof_sample_start(mp_uint_t interval_us) {
+    MP_STATIC_ASSERT((PROF_BUF_SIZE & PROF_BUF_MASK) == 0);
+    // Discard samples from a previous run.
+    __atomic_store_n(&prof_tail, __atomic_load_n(&prof_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    __atomic_store_n(&prof_dropped, 0, __ATOMIC_RELAXED);
+    mp_hal_prof_sample_timer(interval_us);
+}
+
+mp_uint_t mp_prof_sample_stop(void) {
+    mp_hal_prof_sample_timer(0);
+    return __atomic_load_n(&prof_dropped, __ATOMIC_RELAXED);
+}
+
+mp_obj_t mp_prof_sample_dump(bool offsets) {
+    mp_obj_t dict = mp_obj_new_dict(0);
+    mp_map_t *map = mp_obj_dict_get_map(dict);
+    vstr_t vstr;
+    vstr_init(&vstr, 64);
+    size_t tail = prof_tail;
+    size_t head = __atomic_load_n(&prof_head, __ATOMIC_ACQUIRE);
+    while (tail != head) {
+        // Build the folded stack, outermost frame first, separated by ';'.
+        size_t n = prof_buf[tail & PROF_BUF_MASK];
+        vstr_reset(&vstr);
+        for (size_t i = n; i-- > 0;) {
+            size_t pos = tail + 1 + 2 * i;
+            if (i + 1 < n) {
+                vstr_add_byte(&vstr, ';');
+            }
+            vstr_add_str(&vstr, qstr_str(prof_buf[pos & PROF_BUF_MASK]));
+            if (offsets) {
+                vstr_printf(&vstr, "+%u", (unsigned)prof_buf[(pos + 1) & PROF_BUF_MASK]);
+            }
+        }
+
+        // Release the space before allocating, which may take a while.
+        tail += 1 + 2 * n;
+        __atomic_store_n(&prof_tail, tail, __ATOMIC_RELEASE);
+
+        mp_map_elem_t *elem = mp_map_lookup(map, mp_obj_new_str(vstr.buf, vstr.len), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+        mp_int_t count = elem->value == MP_OBJ_NULL ? 0 : MP_OBJ_SMALL_INT_VALUE(elem->value);
+        elem->value = MP_OBJ_NEW_SMALL_INT(count + 1);
+    }
+    vstr_clear(&vstr);
+    return dict;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_PROF_SAMPLING
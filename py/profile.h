@@ -78,4 +78,24 @@ void mp_prof_print_instr(const byte *ip, mp_code_state_t *code_state);
 #endif
 
 #endif // MICROPY_PY_SYS_SETTRACE
+
+#if MICROPY_PY_MICROPYTHON_PROF_SAMPLING
+
+// Sampling profiler.  The port implements mp_hal_prof_sample_timer() to start
+// (interval_us > 0) or stop (interval_us == 0) a timer which calls
+// mp_prof_sample(), possibly from a signal handler.
+void mp_hal_prof_sample_timer(mp_uint_t interval_us);
+
+// Record the chain of active bytecode frames of the current thread.  This is
+// safe to call asynchronously: it does not allocate or take locks.
+void mp_prof_sample(void);
+
+void mp_prof_sample_start(mp_uint_t interval_us);
+mp_uint_t mp_prof_sample_stop(void);
+
+// Drain the recorded samples into a dict mapping folded stacks to counts.
+mp_obj_t mp_prof_sample_dump(bool offsets);
+
+#endif // MICROPY_PY_MICROPYTHON_PROF_SAMPLING
+
 #endif // MICROPY_INCLUDED_PY_PROFILING_H
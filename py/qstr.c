@@ -193,6 +193,27 @@ const qstr_pool_t mp_qstr_const_pool = {
     },
 };
 
+#if MICROPY_QSTR_HASH_INDEX
+// Hash index of the two pools above, generated by makeqstrdata.py.  A lookup
+// probes linearly from slot (hash & (size - 1)) until it finds the qstr or an
+// empty (zero) slot.  The size is a power of two.
+static const qstr_short_t mp_qstr_const_index[] = {
+    #ifndef NO_QSTR
+#define QDEF0(id, hash, len, str)
+#define QDEF1(id, hash, len, str)
+// CIRCUITPY-CHANGE: translations
+#define TRANSLATION(id, length, compressed ...)
+#define QINDEX(id) id,
+    #include "genhdr/qstrdefs.generated.h"
+#undef QDEF0
+#undef QDEF1
+// CIRCUITPY-CHANGE: translations
+#undef TRANSLATION
+#undef QINDEX
+    #endif
+};
+#endif
+
 // If frozen code is enabled, then there is an additional, sorted, ROM pool
 // containing additional qstrs required by the frozen code.
 #ifdef MICROPY_QSTR_EXTRA_POOL
@@ -206,6 +227,11 @@ extern const qstr_pool_t MICROPY_QSTR_EXTRA_POOL;
 void qstr_reset(void) {
     MP_STATE_VM(last_pool) = (qstr_pool_t *)&CONST_POOL; // we won't modify the const_pool since it has no allocated room left
     MP_STATE_VM(qstr_last_chunk) = NULL;
+    #if MICROPY_QSTR_HASH_INDEX
+    MP_STATE_VM(qstr_index) = NULL;
+    MP_STATE_VM(qstr_index_alloc) = 0;
+    MP_STATE_VM(qstr_index_len) = 0;
+    #endif
 }
 
 void qstr_init(void) {
@@ -228,6 +254,138 @@ static const qstr_pool_t *find_qstr(qstr *q) {
     return pool;
 }
 
+#if MICROPY_QSTR_HASH_INDEX
+
+// Initial number of slots in the hash index of the dynamic qstrs.
+#define MICROPY_ALLOC_QSTR_INDEX_INIT (32)
+
+// The id of the first qstr that is allocated at runtime.
+#define QSTR_DYNAMIC_BASE (CONST_POOL.total_prev_len + CONST_POOL.len)
+
+static bool qstr_pool_entry_eq(const qstr_pool_t *pool, size_t at, const char *str, size_t str_len, size_t str_hash) {
+    return pool->hashes[at] == str_hash
+           && pool->lengths[at] == str_len
+           && memcmp(pool->qstrs[at], str, str_len) == 0;
+}
+
+static qstr qstr_const_index_find(const char *str, size_t str_len, size_t str_hash) {
+    const size_t mask = MP_ARRAY_SIZE(mp_qstr_const_index) - 1;
+    for (size_t slot = str_hash & mask;; slot = (slot + 1) & mask) {
+        qstr q = mp_qstr_const_index[slot];
+        if (q == MP_QSTRnull) {
+            return MP_QSTRnull;
+        }
+        if (q < MP_QSTRnumber_of_static) {
+            if (qstr_pool_entry_eq(&mp_qstr_const_pool_static, q, str, str_len, str_hash)) {
+                return q;
+            }
+        } else if (qstr_pool_entry_eq(&mp_qstr_const_pool, q - MP_QSTRnumber_of_static, str, str_len, str_hash)) {
+            return q;
+        }
+    }
+}
+
+// The dynamic index stores each qstr as its offset from QSTR_DYNAMIC_BASE plus
+// one, so that zero is an empty slot.  At most 3/4 of the slots are used, so
+// the entries fit in a qstr_short_t until the index has more slots than that
+// can count, and only then are they widened to 32 bits.
+#define QSTR_INDEX_IS_WIDE(alloc) ((alloc) > ((size_t)1 << (8 * sizeof(qstr_short_t))))
+#define QSTR_INDEX_ENTRY_SIZE(alloc) (QSTR_INDEX_IS_WIDE(alloc) ? sizeof(uint32_t) : sizeof(qstr_short_t))
+
+static inline size_t qstr_index_get(const void *index, size_t alloc, size_t slot) {
+    if (QSTR_INDEX_IS_WIDE(alloc)) {
+        return ((const uint32_t *)index)[slot];
+    }
+    return ((const qstr_short_t *)index)[slot];
+}
+
+static qstr qstr_dynamic_find(const char *str, size_t str_len, size_t str_hash) {
+    const void *index = MP_STATE_VM(qstr_index);
+    if (index != NULL) {
+        const size_t alloc = MP_STATE_VM(qstr_index_alloc);
+        for (size_t slot = str_hash & (alloc - 1);; slot = (slot + 1) & (alloc - 1)) {
+            size_t entry = qstr_index_get(index, alloc, slot);
+            if (entry == 0) {
+                break;
+            }
+            qstr at = QSTR_DYNAMIC_BASE + entry - 1;
+            const qstr_pool_t *pool = find_qstr(&at);
+            if (qstr_pool_entry_eq(pool, at, str, str_len, str_hash)) {
+                return QSTR_DYNAMIC_BASE + entry - 1;
+            }
+        }
+    }
+
+    // sequential search for the qstrs added since the index last failed to grow
+    qstr first = QSTR_DYNAMIC_BASE + MP_STATE_VM(qstr_index_len);
+    for (const qstr_pool_t *pool = MP_STATE_VM(last_pool); pool->total_prev_len + pool->len > first; pool = pool->prev) {
+        for (size_t at = first > pool->total_prev_len ? first - pool->total_prev_len : 0; at < pool->len; at++) {
+            if (qstr_pool_entry_eq(pool, at, str, str_len, str_hash)) {
+                return pool->total_prev_len + at;
+            }
+        }
+    }
+
+    return MP_QSTRnull;
+}
+
+static void qstr_index_insert(void *index, size_t alloc, qstr q, size_t hash) {
+    size_t slot = hash & (alloc - 1);
+    while (qstr_index_get(index, alloc, slot) != 0) {
+        slot = (slot + 1) & (alloc - 1);
+    }
+    size_t entry = q - QSTR_DYNAMIC_BASE + 1;
+    if (QSTR_INDEX_IS_WIDE(alloc)) {
+        ((uint32_t *)index)[slot] = entry;
+    } else {
+        ((qstr_short_t *)index)[slot] = entry;
+    }
+}
+
+// qstr_mutex must be taken while in this function
+static void qstr_index_add(qstr q, size_t hash, bool new_pool) {
+    size_t n = q + 1 - QSTR_DYNAMIC_BASE;
+    size_t alloc = MP_STATE_VM(qstr_index_alloc);
+    bool complete = MP_STATE_VM(qstr_index_len) + 1 == n;
+
+    if (complete && n * 4 <= alloc * 3) {
+        qstr_index_insert(MP_STATE_VM(qstr_index), alloc, q, hash);
+        MP_STATE_VM(qstr_index_len) = n;
+        return;
+    }
+
+    if (!complete && !new_pool) {
+        // The index could not grow earlier.  Rather than trying again (and
+        // running a collection) for every new qstr, wait for the next pool.
+        return;
+    }
+
+    // grow the index, keeping it at most 3/4 full, and rebuild it
+    size_t new_alloc = alloc ? alloc : MICROPY_ALLOC_QSTR_INDEX_INIT;
+    while (n * 4 > new_alloc * 3) {
+        new_alloc *= 2;
+    }
+    void *index = MP_STATE_VM(qstr_index);
+    if (new_alloc != alloc) {
+        index = m_malloc_long_lived_maybe(new_alloc * QSTR_INDEX_ENTRY_SIZE(new_alloc));
+        if (index == NULL) {
+            return;
+        }
+        m_del(byte, MP_STATE_VM(qstr_index), alloc * QSTR_INDEX_ENTRY_SIZE(alloc));
+    }
+    memset(index, 0, new_alloc * QSTR_INDEX_ENTRY_SIZE(new_alloc));
+    for (const qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != &CONST_POOL; pool = pool->prev) {
+        for (size_t at = 0; at < pool->len; at++) {
+            qstr_index_insert(index, new_alloc, pool->total_prev_len + at, pool->hashes[at]);
+        }
+    }
+    MP_STATE_VM(qstr_index) = index;
+    MP_STATE_VM(qstr_index_alloc) = new_alloc;
+    MP_STATE_VM(qstr_index_len) = n;
+}
+
+#endif
+
 // qstr_mutex must be taken while in this function
 static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
     #if MICROPY_QSTR_BYTES_IN_HASH
@@ -238,6 +396,9 @@ static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
     #endif
 
     // make sure we have room in the pool for a new qstr
+    #if MICROPY_QSTR_HASH_INDEX
+    bool new_pool = false;
+    #endif
     if (MP_STATE_VM(last_pool)->len >= MP_STATE_VM(last_pool)->alloc) {
         size_t new_alloc = MP_STATE_VM(last_pool)->alloc * 2;
         #ifdef MICROPY_QSTR_EXTRA_POOL
@@ -250,7 +411,7 @@ static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
                 + sizeof(qstr_hash_t)
                 #endif
                 + sizeof(qstr_len_t)) * new_alloc;
-        qstr_pool_t *pool = (qstr_pool_t *)m_malloc_maybe(pool_size);
+        qstr_pool_t *pool = (qstr_pool_t *)m_malloc_long_lived_maybe(pool_size);
         if (pool == NULL) {
             // Keep qstr_last_chunk consistent with qstr_pool_t: qstr_last_chunk is not scanned
             // at garbage collection since it's reachable from a qstr_pool_t.  And the caller of
@@ -273,6 +434,9 @@ static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
         pool->len = 0;
         MP_STATE_VM(last_pool) = pool;
         DEBUG_printf("QSTR: allocate new pool of size %d\n", MP_STATE_VM(last_pool)->alloc);
+        #if MICROPY_QSTR_HASH_INDEX
+        new_pool = true;
+        #endif
     }
 
     // add the new qstr
@@ -284,6 +448,10 @@ static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
     MP_STATE_VM(last_pool)->qstrs[at] = q_ptr;
     MP_STATE_VM(last_pool)->len++;
 
+    #if MICROPY_QSTR_HASH_INDEX
+    qstr_index_add(MP_STATE_VM(last_pool)->total_prev_len + at, hash, new_pool);
+    #endif
+
     // return id for the newly-added qstr
     return MP_STATE_VM(last_pool)->total_prev_len + at;
 }
@@ -299,8 +467,25 @@ qstr qstr_find_strn(const char *str, size_t str_len) {
     size_t str_hash = qstr_compute_hash((const byte *)str, str_len);
     #endif
 
+    #if MICROPY_QSTR_HASH_INDEX
+    // look up the firmware's qstrs and the dynamic ones through their indexes
+    qstr q = qstr_const_index_find(str, str_len, str_hash);
+    if (q == MP_QSTRnull) {
+        q = qstr_dynamic_find(str, str_len, str_hash);
+    }
+    if (q != MP_QSTRnull) {
+        return q;
+    }
+
+    // search the remaining, unindexed, ROM pools (if any) for the data
+    const qstr_pool_t *first_pool = &CONST_POOL;
+    const qstr_pool_t *end_pool = &mp_qstr_const_pool;
+    #else
     // search pools for the data
-    for (const qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != NULL; pool = pool->prev) {
+    const qstr_pool_t *first_pool = MP_STATE_VM(last_pool);
+    const qstr_pool_t *end_pool = NULL;
+    #endif
+    for (const qstr_pool_t *pool = first_pool; pool != end_pool; pool = pool->prev) {
         size_t low = 0;
         size_t high = pool->len - 1;
 
@@ -338,7 +523,7 @@ qstr qstr_from_str(const char *str) {
     return qstr_from_strn(str, strlen(str));
 }
 
-qstr qstr_from_strn(const char *str, size_t len) {
+static qstr qstr_from_strn_helper(const char *str, size_t len, bool data_is_static) {
     QSTR_ENTER();
     qstr q = qstr_find_strn(str, len);
     if (q == 0) {
@@ -350,6 +535,14 @@ qstr qstr_from_strn(const char *str, size_t len) {
             mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("name too long"));
         }
 
+        if (data_is_static) {
+            // the given string data stays valid, so use it directly
+            assert(str[len] == '\0');
+            q = qstr_add(len, str);
+            QSTR_EXIT();
+            return q;
+        }
+
         // compute number of bytes needed to intern this string
         size_t n_bytes = len + 1;
 
@@ -372,10 +565,10 @@ qstr qstr_from_strn(const char *str, size_t len) {
             if (al < MICROPY_ALLOC_QSTR_CHUNK_INIT) {
                 al = MICROPY_ALLOC_QSTR_CHUNK_INIT;
             }
-            MP_STATE_VM(qstr_last_chunk) = m_new_maybe(char, al);
+            MP_STATE_VM(qstr_last_chunk) = m_new_long_lived_maybe(char, al);
             if (MP_STATE_VM(qstr_last_chunk) == NULL) {
                 // failed to allocate a large chunk so try with exact size
-                MP_STATE_VM(qstr_last_chunk) = m_new_maybe(char, n_bytes);
+                MP_STATE_VM(qstr_last_chunk) = m_new_long_lived_maybe(char, n_bytes);
                 if (MP_STATE_VM(qstr_last_chunk) == NULL) {
                     QSTR_EXIT();
                     m_malloc_fail(n_bytes);
@@ -399,6 +592,18 @@ qstr qstr_from_strn(const char *str, size_t len) {
     return q;
 }
 
+qstr qstr_from_strn(const char *str, size_t len) {
+    return qstr_from_strn_helper(str, len, false);
+}
+
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+// As qstr_from_strn, but the string data, which must be null terminated, stays
+// valid for the life of the program and is used in place if a new qstr is needed.
+qstr qstr_from_strn_static(const char *str, size_t len) {
+    return qstr_from_strn_helper(str, len, true);
+}
+#endif
+
 mp_uint_t qstr_hash(qstr q) {
     const qstr_pool_t *pool = find_qstr(&q);
     #if MICROPY_QSTR_BYTES_IN_HASH
@@ -447,6 +652,9 @@ void qstr_pool_info(size_t *n_pool, size_t *n_qstr, size_t *n_str_data_bytes, si
                 + sizeof(qstr_len_t)) * pool->alloc;
         #endif
     }
+    #if MICROPY_QSTR_HASH_INDEX
+    *n_total_bytes += QSTR_INDEX_ENTRY_SIZE(MP_STATE_VM(qstr_index_alloc)) * MP_STATE_VM(qstr_index_alloc);
+    #endif
     *n_total_bytes += *n_str_data_bytes;
     QSTR_EXIT();
 }
@@ -31,6 +31,7 @@
 #include "py/mperrno.h"
 #include "py/mpthread.h"
 #include "py/reader.h"
+#include "py/stream.h"
 
 typedef struct _mp_reader_mem_t {
     size_t free_len; // if >0 mem is freed on close by: m_free(beg, free_len)
@@ -50,7 +51,7 @@ static mp_uint_t mp_reader_mem_readbyte(void *data) {
 
 static void mp_reader_mem_close(void *data) {
     mp_reader_mem_t *reader = (mp_reader_mem_t *)data;
-    if (reader->free_len > 0) {
+    if (reader->free_len > 0 && reader->free_len != MP_READER_IS_ROM) {
         m_del(char, (char *)reader->beg, reader->free_len);
     }
     m_del_obj(mp_reader_mem_t, reader);
@@ -67,6 +68,77 @@ void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t
     reader->close = mp_reader_mem_close;
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+
+// A memory reader over data that a stream gave with MP_STREAM_GET_ROM_DATA.
+// The data stays valid while the stream is open, or for the life of the
+// program once the stream has been asked to keep it.
+typedef struct _mp_reader_rom_t {
+    mp_reader_mem_t mem;
+    mp_obj_t stream;
+    bool used; // whether some of the data has been used in place
+} mp_reader_rom_t;
+
+static void mp_reader_rom_close(void *data) {
+    mp_reader_rom_t *reader = (mp_reader_rom_t *)data;
+    if (reader->used) {
+        // Code loaded from the data uses it, so it must stay valid.
+        int errcode;
+        mp_get_stream(reader->stream)->ioctl(reader->stream, MP_STREAM_KEEP_ROM_DATA, 0, &errcode);
+    }
+    mp_stream_close(reader->stream);
+    m_del_obj(mp_reader_rom_t, reader);
+}
+
+void mp_reader_new_rom(mp_reader_t *reader, mp_obj_t stream, const byte *buf, size_t len) {
+    mp_reader_rom_t *rr = m_new_obj(mp_reader_rom_t);
+    rr->mem.free_len = MP_READER_IS_ROM;
+    rr->mem.beg = buf;
+    rr->mem.cur = buf;
+    rr->mem.end = buf + len;
+    rr->stream = stream;
+    rr->used = false;
+    reader->data = rr;
+    reader->readbyte = mp_reader_mem_readbyte;
+    reader->close = mp_reader_rom_close;
+}
+
+// If the reader is over memory that stays valid (see mp_reader_new_mem with
+// MP_READER_IS_ROM, and mp_reader_new_rom) then return a pointer to the next len
+// bytes and skip over them, otherwise return NULL.  If permanent is true then
+// the data must stay valid even if the load is abandoned, which only memory
+// given as MP_READER_IS_ROM does.
+const byte *mp_reader_try_read_rom(mp_reader_t *reader, size_t len, bool permanent) {
+    if (reader->readbyte != mp_reader_mem_readbyte) {
+        return NULL;
+    }
+    mp_reader_mem_t *rm = (mp_reader_mem_t *)reader->data;
+    if (rm->free_len != MP_READER_IS_ROM || (size_t)(rm->end - rm->cur) < len) {
+        return NULL;
+    }
+    if (reader->close == mp_reader_rom_close) {
+        if (permanent) {
+            return NULL;
+        }
+        ((mp_reader_rom_t *)rm)->used = true;
+    }
+    const byte *data = rm->cur;
+    rm->cur += len;
+    return data;
+}
+
+// Stop using the reader's data in place, because nothing loaded so far will be
+// used (the load failed), or nothing loaded from now on can use it.
+void mp_reader_rom_abandon(mp_reader_t *reader) {
+    if (reader->close == mp_reader_rom_close) {
+        mp_reader_rom_t *rr = (mp_reader_rom_t *)reader->data;
+        rr->mem.free_len = 0;
+        rr->used = false;
+    }
+}
+
+#endif
+
 #if MICROPY_READER_POSIX
 
 #include <sys/stat.h>
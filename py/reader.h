@@ -33,6 +33,11 @@
 // it can be called again after returning MP_READER_EOF, and in that case must return MP_READER_EOF
 #define MP_READER_EOF ((mp_uint_t)(-1))
 
+// Pass as free_len to mp_reader_new_mem if the memory stays valid and unchanged
+// for the life of the program, so that its data may be used in place.  See also
+// mp_reader_new_rom for data that a stream can keep valid.
+#define MP_READER_IS_ROM ((size_t)(-1))
+
 typedef struct _mp_reader_t {
     void *data;
     mp_uint_t (*readbyte)(void *data);
@@ -42,5 +47,9 @@ typedef struct _mp_reader_t {
 void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t free_len);
 void mp_reader_new_file(mp_reader_t *reader, qstr filename);
 void mp_reader_new_file_from_fd(mp_reader_t *reader, int fd, bool close_fd);
+void mp_reader_new_rom(mp_reader_t *reader, mp_obj_t stream, const byte *buf, size_t len);
+void mp_reader_new_file_rom(mp_reader_t *reader, qstr filename);
+const byte *mp_reader_try_read_rom(mp_reader_t *reader, size_t len, bool permanent);
+void mp_reader_rom_abandon(mp_reader_t *reader);
 
 #endif // MICROPY_INCLUDED_PY_READER_H
@@ -85,8 +85,19 @@ void mp_init(void) {
         MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
     }
     #endif
-    MP_STATE_VM(sched_idx) = 0;
-    MP_STATE_VM(sched_len) = 0;
+    for (size_t p = 0; p < MICROPY_SCHEDULER_PRIORITIES; ++p) {
+        #if MICROPY_SCHEDULER_LOCK_FREE
+        for (size_t i = 0; i < MICROPY_SCHEDULER_DEPTH; ++i) {
+            MP_STATE_VM(sched_queue)[p][i].seq = i;
+        }
+        MP_STATE_VM(sched_put)[p] = 0;
+        MP_STATE_VM(sched_get)[p] = 0;
+        #else
+        MP_STATE_VM(sched_idx)[p] = 0;
+        MP_STATE_VM(sched_len)[p] = 0;
+        #endif
+    }
+    MP_STATE_VM(sched_overflow) = 0;
     #endif
 
     #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF
@@ -140,6 +151,15 @@ void mp_init(void) {
     }
     #endif
 
+    #if MICROPY_PY_STRUCT
+    MP_STATE_VM(struct_format_cache) = NULL;
+    #endif
+
+    // CIRCUITPY-CHANGE: shared-module/struct keeps the same cache
+    #if CIRCUITPY_STRUCT
+    MP_STATE_VM(struct_struct_cache) = NULL;
+    #endif
+
     // CIRCUITPY-CHANGE: do not unmount /
     #if MICROPY_VFS && 0
     // initialise the VFS sub-system
@@ -172,6 +192,9 @@ void mp_init(void) {
     #if MICROPY_PY_SYS_SETTRACE
     MP_STATE_THREAD(prof_trace_callback) = MP_OBJ_NULL;
     MP_STATE_THREAD(prof_callback_is_executing) = false;
+    #endif
+
+    #if MICROPY_CODE_STATE_CHAIN
     MP_STATE_THREAD(current_code_state) = NULL;
     #endif
 
@@ -237,24 +260,31 @@ mp_obj_t MICROPY_WRAP_MP_LOAD_GLOBAL(mp_load_global)(qstr qst) {
     DEBUG_OP_printf("load global %s\n", qstr_str(qst));
     mp_map_elem_t *elem = mp_map_lookup(&mp_globals_get()->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
     if (elem == NULL) {
-        #if MICROPY_CAN_OVERRIDE_BUILTINS
-        if (MP_STATE_VM(mp_module_builtins_override_dict) != NULL) {
-            // lookup in additional dynamic table of builtins first
-            elem = mp_map_lookup(&MP_STATE_VM(mp_module_builtins_override_dict)->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
-            if (elem != NULL) {
-                return elem->value;
-            }
+        return mp_load_builtin(qst);
+    }
+    return elem->value;
+}
+
+mp_obj_t mp_load_builtin(qstr qst) {
+    // logic: search builtins (for a name that is not in globals)
+    mp_map_elem_t *elem;
+    #if MICROPY_CAN_OVERRIDE_BUILTINS
+    if (MP_STATE_VM(mp_module_builtins_override_dict) != NULL) {
+        // lookup in additional dynamic table of builtins first
+        elem = mp_map_lookup(&MP_STATE_VM(mp_module_builtins_override_dict)->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
+        if (elem != NULL) {
+            return elem->value;
         }
+    }
+    #endif
+    elem = mp_map_lookup((mp_map_t *)&mp_module_builtins_globals.map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
+    if (elem == NULL) {
+        #if MICROPY_ERROR_REPORTING <= MICROPY_ERROR_REPORTING_TERSE
+        mp_raise_msg(&mp_type_NameError, MP_ERROR_TEXT("name not defined"));
+        #else
+        // CIRCUITPY-CHANGE: slight message change
+        mp_raise_msg_varg(&mp_type_NameError, MP_ERROR_TEXT("name '%q' is not defined"), qst);
         #endif
-        elem = mp_map_lookup((mp_map_t *)&mp_module_builtins_globals.map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
-        if (elem == NULL) {
-            #if MICROPY_ERROR_REPORTING <= MICROPY_ERROR_REPORTING_TERSE
-            mp_raise_msg(&mp_type_NameError, MP_ERROR_TEXT("name not defined"));
-            #else
-            // CIRCUITPY-CHANGE: slight message change
-            mp_raise_msg_varg(&mp_type_NameError, MP_ERROR_TEXT("name '%q' is not defined"), qst);
-            #endif
-        }
     }
     return elem->value;
 }
@@ -1729,9 +1759,7 @@ mp_obj_t mp_parse_compile_execute(mp_lexer_t *lex, mp_parse_input_kind_t parse_i
     // set exception handler to restore context if an exception is raised
     nlr_push_jump_callback(&ctx.callback, mp_globals_locals_set_from_nlr_jump_callback);
 
-    qstr source_name = lex->source_name;
-    mp_parse_tree_t parse_tree = mp_parse(lex, parse_input_kind);
-    mp_obj_t module_fun = mp_compile(&parse_tree, source_name, parse_input_kind == MP_PARSE_SINGLE_INPUT);
+    mp_obj_t module_fun = mp_parse_compile(lex, parse_input_kind, parse_input_kind == MP_PARSE_SINGLE_INPUT);
 
     mp_obj_t ret;
     if (MICROPY_PY_BUILTINS_COMPILE && globals == NULL) {
@@ -111,8 +111,18 @@ void mp_handle_pending(bool raise_exc);
 #if MICROPY_ENABLE_SCHEDULER
 void mp_sched_lock(void);
 void mp_sched_unlock(void);
-#define mp_sched_num_pending() (MP_STATE_VM(sched_len))
+#if MICROPY_SCHEDULER_LOCK_FREE || MICROPY_SCHEDULER_PRIORITIES > 1
+size_t mp_sched_num_pending(void);
+#else
+#define mp_sched_num_pending() (MP_STATE_VM(sched_len)[0])
+#endif
+#define mp_sched_num_overflow() (MP_STATE_VM(sched_overflow))
 bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg);
+#if MICROPY_SCHEDULER_PRIORITIES > 1
+// Functions of a higher priority class run before those of a lower one, and
+// mp_sched_schedule uses the lowest, 0.
+bool mp_sched_schedule_priority(mp_obj_t function, mp_obj_t arg, size_t priority);
+#endif
 bool mp_sched_schedule_node(mp_sched_node_t *node, mp_sched_callback_t callback);
 #endif
 
@@ -186,6 +196,11 @@ void mp_call_function_1_from_nlr_jump_callback(void *ctx_in);
 
 #if MICROPY_PY_THREAD
 static inline void mp_thread_init_state(mp_state_thread_t *ts, size_t stack_size, mp_obj_dict_t *locals, mp_obj_dict_t *globals) {
+    #if MICROPY_CODE_STATE_CHAIN
+    // No bytecode is running yet (set first, the sampling profiler may look at it)
+    ts->current_code_state = NULL;
+    #endif
+
     mp_thread_set_state(ts);
 
     mp_stack_set_top(ts + 1); // need to include ts in root-pointer scan
@@ -212,6 +227,7 @@ static inline void mp_thread_init_state(mp_state_thread_t *ts, size_t stack_size
 
 mp_obj_t mp_load_name(qstr qst);
 mp_obj_t mp_load_global(qstr qst);
+mp_obj_t mp_load_builtin(qstr qst);
 mp_obj_t mp_load_build_class(void);
 void mp_store_name(qstr qst, mp_obj_t obj);
 void mp_store_global(qstr qst, mp_obj_t obj);
@@ -339,6 +355,7 @@ NORETURN void mp_raise_ZeroDivisionError(void);
 
 // helper functions for native/viper code
 int mp_native_type_from_qstr(qstr qst);
+int mp_native_simd_from_qstr(qstr qst);
 mp_uint_t mp_native_from_obj(mp_obj_t obj, mp_uint_t type);
 mp_obj_t mp_native_to_obj(mp_uint_t val, mp_uint_t type);
 
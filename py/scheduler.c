@@ -38,10 +38,16 @@ void MICROPY_WRAP_MP_SCHED_EXCEPTION(mp_sched_exception)(mp_obj_t exc) {
     // Optimisation for the case where we have scheduler but no threading.
     // Allows the VM to do a single check to exclude both pending exception
     // and queued tasks.
+    #if MICROPY_SCHEDULER_LOCK_FREE
+    int16_t state = MP_SCHED_IDLE;
+    __atomic_compare_exchange_n(&MP_STATE_VM(sched_state), &state, MP_SCHED_PENDING,
+        false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    #else
     if (MP_STATE_VM(sched_state) == MP_SCHED_IDLE) {
         MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
     }
     #endif
+    #endif
 }
 
 #if MICROPY_KBD_EXCEPTION
@@ -63,9 +69,204 @@ void MICROPY_WRAP_MP_SCHED_VM_ABORT(mp_sched_vm_abort)(void) {
 
 #define IDX_MASK(i) ((i) & (MICROPY_SCHEDULER_DEPTH - 1))
 
+#if MICROPY_SCHEDULER_LOCK_FREE
+
+// Each priority class of sched_queue is a bounded multi-producer ring (after
+// D. Vyukov) where the seq of a slot tells whether it is free for, or filled
+// at, a given position.  Producers claim a position with compare-and-swap on
+// sched_put, so one interrupted between claiming a slot and filling it only
+// delays the items after it and never blocks other producers.  There is only
+// ever one consumer, the holder of the scheduler lock, which takes items at
+// sched_get.
+//
+// Static nodes are pushed onto a list with compare-and-swap, and the consumer
+// takes the whole list at once.
+//
+// sched_state is only changed with compare-and-swap.  Producers make it
+// pending only if it is idle, and mp_sched_unlock() makes it idle before
+// checking the queues again, so work added while the scheduler is locked is
+// always seen by one of the two.
+
+static inline void mp_sched_set_pending(void) {
+    int16_t state = MP_SCHED_IDLE;
+    __atomic_compare_exchange_n(&MP_STATE_VM(sched_state), &state, MP_SCHED_PENDING,
+        false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool mp_sched_empty(void) {
+    MP_STATIC_ASSERT((IDX_MASK(MICROPY_SCHEDULER_DEPTH) == 0)); // MICROPY_SCHEDULER_DEPTH must be a power of 2
+
+    for (size_t p = 0; p < MICROPY_SCHEDULER_PRIORITIES; ++p) {
+        if (__atomic_load_n(&MP_STATE_VM(sched_put)[p], __ATOMIC_SEQ_CST)
+            != __atomic_load_n(&MP_STATE_VM(sched_get)[p], __ATOMIC_RELAXED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t mp_sched_num_pending(void) {
+    size_t n = 0;
+    for (size_t p = 0; p < MICROPY_SCHEDULER_PRIORITIES; ++p) {
+        n += __atomic_load_n(&MP_STATE_VM(sched_put)[p], __ATOMIC_RELAXED)
+            - __atomic_load_n(&MP_STATE_VM(sched_get)[p], __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+// Take the next item of the highest priority class which has one ready.
+static bool mp_sched_take(mp_sched_item_t *item_out) {
+    for (size_t p = MICROPY_SCHEDULER_PRIORITIES; p-- > 0;) {
+        mp_uint_t pos = MP_STATE_VM(sched_get)[p];
+        mp_sched_item_t *item = &MP_STATE_VM(sched_queue)[p][IDX_MASK(pos)];
+        if (__atomic_load_n(&item->seq, __ATOMIC_ACQUIRE) == pos + 1) {
+            item_out->func = item->func;
+            item_out->arg = item->arg;
+            // Free the slot for the producers' next lap.
+            __atomic_store_n(&item->seq, pos + MICROPY_SCHEDULER_DEPTH, __ATOMIC_RELEASE);
+            __atomic_store_n(&MP_STATE_VM(sched_get)[p], pos + 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline void mp_sched_run_pending(void) {
+    int16_t state = MP_SCHED_PENDING;
+    if (!__atomic_compare_exchange_n(&MP_STATE_VM(sched_state), &state, MP_SCHED_LOCKED,
+        false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        // Something else (e.g. hard IRQ) locked the scheduler first.
+        return;
+    }
+
+    #if MICROPY_SCHEDULER_STATIC_NODES
+    // Run all pending C callbacks.
+    mp_sched_node_t *node;
+    while ((node = __atomic_exchange_n(&MP_STATE_VM(sched_head), NULL, __ATOMIC_ACQUIRE)) != NULL) {
+        // The list is newest first, reverse it to run them in order.  Nodes
+        // on it can't be scheduled again until their callback is cleared.
+        mp_sched_node_t *prev = NULL;
+        while (node != NULL) {
+            mp_sched_node_t *next = node->next;
+            node->next = prev;
+            prev = node;
+            node = next;
+        }
+        for (node = prev; node != NULL;) {
+            mp_sched_node_t *next = node->next;
+            mp_sched_callback_t callback = node->callback;
+            __atomic_store_n(&node->callback, NULL, __ATOMIC_RELEASE);
+            callback(node);
+            node = next;
+        }
+    }
+    #endif
+
+    // Run at most one pending Python callback.
+    mp_sched_item_t item;
+    if (mp_sched_take(&item)) {
+        mp_call_function_1_protected(item.func, item.arg);
+    }
+
+    // Restore MP_STATE_VM(sched_state) to idle (or pending if there are still
+    // tasks in the queue).
+    mp_sched_unlock();
+}
+
+// Locking the scheduler prevents tasks from executing (does not prevent new
+// tasks from being added). We lock the scheduler while executing scheduled
+// tasks and also in hard interrupts or GC finalisers.
+void mp_sched_lock(void) {
+    int16_t state = __atomic_load_n(&MP_STATE_VM(sched_state), __ATOMIC_RELAXED);
+    int16_t new_state;
+    do {
+        // Increment the lock if already locked (recursive lock), otherwise
+        // pending or idle become locked.
+        new_state = state < 0 ? state - 1 : MP_SCHED_LOCKED;
+    } while (!__atomic_compare_exchange_n(&MP_STATE_VM(sched_state), &state, new_state,
+        true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+}
+
+void mp_sched_unlock(void) {
+    int16_t state = __atomic_load_n(&MP_STATE_VM(sched_state), __ATOMIC_RELAXED);
+    int16_t new_state;
+    do {
+        assert(state < 0);
+        new_state = state == MP_SCHED_LOCKED ? MP_SCHED_IDLE : state + 1;
+    } while (!__atomic_compare_exchange_n(&MP_STATE_VM(sched_state), &state, new_state,
+        true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+    if (new_state == MP_SCHED_IDLE) {
+        // Scheduler became unlocked. Check if there are still tasks in the
+        // queue and set sched_state accordingly.
+        if (
+            #if !MICROPY_PY_THREAD
+            // See optimisation in mp_sched_exception.
+            MP_STATE_THREAD(mp_pending_exception) != MP_OBJ_NULL ||
+            #endif
+            #if MICROPY_SCHEDULER_STATIC_NODES
+            __atomic_load_n(&MP_STATE_VM(sched_head), __ATOMIC_SEQ_CST) != NULL ||
+            #endif
+            !mp_sched_empty()) {
+            mp_sched_set_pending();
+        }
+    }
+}
+
+static inline bool mp_sched_schedule_in(size_t priority, mp_obj_t function, mp_obj_t arg) {
+    mp_uint_t pos = __atomic_load_n(&MP_STATE_VM(sched_put)[priority], __ATOMIC_RELAXED);
+    for (;;) {
+        mp_sched_item_t *item = &MP_STATE_VM(sched_queue)[priority][IDX_MASK(pos)];
+        mp_int_t diff = (mp_int_t)(__atomic_load_n(&item->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            // The slot is free, try to claim it.  On failure pos is updated
+            // to the position another producer left.
+            if (__atomic_compare_exchange_n(&MP_STATE_VM(sched_put)[priority], &pos, pos + 1,
+                true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                item->func = function;
+                item->arg = arg;
+                __atomic_store_n(&item->seq, pos + 1, __ATOMIC_RELEASE);
+                break;
+            }
+        } else if (diff < 0) {
+            // The slot still holds the item from the previous lap, so the
+            // schedule queue is full.
+            __atomic_fetch_add(&MP_STATE_VM(sched_overflow), 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            // Another producer claimed this position meanwhile.
+            pos = __atomic_load_n(&MP_STATE_VM(sched_put)[priority], __ATOMIC_RELAXED);
+        }
+    }
+    mp_sched_set_pending();
+    MICROPY_SCHED_HOOK_SCHEDULED;
+    return true;
+}
+
+#if MICROPY_SCHEDULER_STATIC_NODES
+bool mp_sched_schedule_node(mp_sched_node_t *node, mp_sched_callback_t callback) {
+    mp_sched_callback_t expected = NULL;
+    if (!__atomic_compare_exchange_n(&node->callback, &expected, callback,
+        false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        // already scheduled
+        return false;
+    }
+    mp_sched_node_t *head = __atomic_load_n(&MP_STATE_VM(sched_head), __ATOMIC_RELAXED);
+    do {
+        node->next = head;
+    } while (!__atomic_compare_exchange_n(&MP_STATE_VM(sched_head), &head, node,
+        true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    mp_sched_set_pending();
+    MICROPY_SCHED_HOOK_SCHEDULED;
+    return true;
+}
+#endif
+
+#else
+
 // This is a macro so it is guaranteed to be inlined in functions like
 // mp_sched_schedule that may be located in a special memory region.
-#define mp_sched_full() (mp_sched_num_pending() == MICROPY_SCHEDULER_DEPTH)
+#define mp_sched_full(priority) (MP_STATE_VM(sched_len)[priority] == MICROPY_SCHEDULER_DEPTH)
 
 static inline bool mp_sched_empty(void) {
     MP_STATIC_ASSERT(MICROPY_SCHEDULER_DEPTH <= 255); // MICROPY_SCHEDULER_DEPTH must fit in 8 bits
@@ -74,6 +275,16 @@ static inline bool mp_sched_empty(void) {
     return mp_sched_num_pending() == 0;
 }
 
+#if MICROPY_SCHEDULER_PRIORITIES > 1
+size_t mp_sched_num_pending(void) {
+    size_t n = 0;
+    for (size_t p = 0; p < MICROPY_SCHEDULER_PRIORITIES; ++p) {
+        n += MP_STATE_VM(sched_len)[p];
+    }
+    return n;
+}
+#endif
+
 static inline void mp_sched_run_pending(void) {
     mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
     if (MP_STATE_VM(sched_state) != MP_SCHED_PENDING) {
@@ -103,11 +314,16 @@ static inline void mp_sched_run_pending(void) {
     }
     #endif
 
-    // Run at most one pending Python callback.
-    if (!mp_sched_empty()) {
-        mp_sched_item_t item = MP_STATE_VM(sched_queue)[MP_STATE_VM(sched_idx)];
-        MP_STATE_VM(sched_idx) = IDX_MASK(MP_STATE_VM(sched_idx) + 1);
-        --MP_STATE_VM(sched_len);
+    // Run at most one pending Python callback, from the highest priority
+    // class that has one.
+    size_t p = MICROPY_SCHEDULER_PRIORITIES;
+    do {
+        --p;
+    } while (p > 0 && MP_STATE_VM(sched_len)[p] == 0);
+    if (MP_STATE_VM(sched_len)[p] != 0) {
+        mp_sched_item_t item = MP_STATE_VM(sched_queue)[p][MP_STATE_VM(sched_idx)[p]];
+        MP_STATE_VM(sched_idx)[p] = IDX_MASK(MP_STATE_VM(sched_idx)[p] + 1);
+        --MP_STATE_VM(sched_len)[p];
         MICROPY_END_ATOMIC_SECTION(atomic_state);
         mp_call_function_1_protected(item.func, item.arg);
     } else {
@@ -148,7 +364,7 @@ void mp_sched_unlock(void) {
             #if MICROPY_SCHEDULER_STATIC_NODES
             MP_STATE_VM(sched_head) != NULL ||
             #endif
-            mp_sched_num_pending()) {
+            !mp_sched_empty()) {
             MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
         } else {
             MP_STATE_VM(sched_state) = MP_SCHED_IDLE;
@@ -157,20 +373,21 @@ void mp_sched_unlock(void) {
     MICROPY_END_ATOMIC_SECTION(atomic_state);
 }
 
-bool MICROPY_WRAP_MP_SCHED_SCHEDULE(mp_sched_schedule)(mp_obj_t function, mp_obj_t arg) {
+static inline bool mp_sched_schedule_in(size_t priority, mp_obj_t function, mp_obj_t arg) {
     mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
     bool ret;
-    if (!mp_sched_full()) {
+    if (!mp_sched_full(priority)) {
         if (MP_STATE_VM(sched_state) == MP_SCHED_IDLE) {
             MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
         }
-        uint8_t iput = IDX_MASK(MP_STATE_VM(sched_idx) + MP_STATE_VM(sched_len)++);
-        MP_STATE_VM(sched_queue)[iput].func = function;
-        MP_STATE_VM(sched_queue)[iput].arg = arg;
+        uint8_t iput = IDX_MASK(MP_STATE_VM(sched_idx)[priority] + MP_STATE_VM(sched_len)[priority]++);
+        MP_STATE_VM(sched_queue)[priority][iput].func = function;
+        MP_STATE_VM(sched_queue)[priority][iput].arg = arg;
         MICROPY_SCHED_HOOK_SCHEDULED;
         ret = true;
     } else {
         // schedule queue is full
+        ++MP_STATE_VM(sched_overflow);
         ret = false;
     }
     MICROPY_END_ATOMIC_SECTION(atomic_state);
@@ -204,7 +421,22 @@ bool mp_sched_schedule_node(mp_sched_node_t *node, mp_sched_callback_t callback)
 }
 #endif
 
-MP_REGISTER_ROOT_POINTER(mp_sched_item_t sched_queue[MICROPY_SCHEDULER_DEPTH]);
+#endif // MICROPY_SCHEDULER_LOCK_FREE
+
+bool MICROPY_WRAP_MP_SCHED_SCHEDULE(mp_sched_schedule)(mp_obj_t function, mp_obj_t arg) {
+    return mp_sched_schedule_in(0, function, arg);
+}
+
+#if MICROPY_SCHEDULER_PRIORITIES > 1
+bool mp_sched_schedule_priority(mp_obj_t function, mp_obj_t arg, size_t priority) {
+    if (priority >= MICROPY_SCHEDULER_PRIORITIES) {
+        priority = MICROPY_SCHEDULER_PRIORITIES - 1;
+    }
+    return mp_sched_schedule_in(priority, function, arg);
+}
+#endif
+
+MP_REGISTER_ROOT_POINTER(mp_sched_item_t sched_queue[MICROPY_SCHEDULER_PRIORITIES][MICROPY_SCHEDULER_DEPTH]);
 
 #endif // MICROPY_ENABLE_SCHEDULER
 
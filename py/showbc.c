@@ -210,6 +210,23 @@ const byte *mp_bytecode_print_str(const mp_print_t *print, const byte *ip_start,
             mp_printf(print, "LOAD_NULL");
             break;
 
+        #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+        case MP_BC_LOAD_FAST_PAIR:
+            mp_printf(print, "LOAD_FAST_PAIR %u %u", ip[0] >> 4, ip[0] & 0x0f);
+            ip += 1;
+            break;
+
+        case MP_BC_INCR_FAST: {
+            mp_uint_t local_num = *ip++;
+            mp_int_t num = (ip[0] & 0x40) ? -1 : 0;
+            do {
+                num = ((mp_uint_t)num << 7) | (*ip & 0x7f);
+            } while ((*ip++ & 0x80) != 0);
+            mp_printf(print, "INCR_FAST " UINT_FMT " %c" INT_FMT, local_num & 0x7f, (local_num & 0x80) ? '-' : '+', num);
+            break;
+        }
+        #endif
+
         case MP_BC_LOAD_FAST_N:
             DECODE_UINT;
             mp_printf(print, "LOAD_FAST_N " UINT_FMT, unum);
@@ -337,6 +354,33 @@ const byte *mp_bytecode_print_str(const mp_print_t *print, const byte *ip_start,
             mp_printf(print, "POP_JUMP_IF_FALSE " UINT_FMT, (mp_uint_t)(ip + unum - ip_start));
             break;
 
+        #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+        case MP_BC_COMPARE_POP_JUMP:
+            DECODE_SLABEL;
+            mp_printf(print, "COMPARE_POP_JUMP_IF_%s " UINT_FMT " %s", (*ip & MP_BC_COMPARE_POP_JUMP_IF_TRUE) ? "TRUE" : "FALSE",
+                (mp_uint_t)(ip + unum - ip_start), qstr_str(mp_binary_op_method_name[*ip & ~MP_BC_COMPARE_POP_JUMP_IF_TRUE]));
+            ip += 1;
+            break;
+
+        case MP_BC_FOR_RANGE_JUMP:
+            DECODE_SLABEL;
+            mp_printf(print, "FOR_RANGE_JUMP " UINT_FMT " %s", (mp_uint_t)(ip + unum - ip_start), qstr_str(mp_binary_op_method_name[*ip]));
+            ip += 1;
+            break;
+
+        case MP_BC_FOR_RANGE_CONST_JUMP: {
+            DECODE_SLABEL;
+            mp_uint_t label = (mp_uint_t)(ip + unum - ip_start);
+            mp_uint_t op = *ip++;
+            mp_int_t num = (ip[0] & 0x40) ? -1 : 0;
+            do {
+                num = ((mp_uint_t)num << 7) | (*ip & 0x7f);
+            } while ((*ip++ & 0x80) != 0);
+            mp_printf(print, "FOR_RANGE_CONST_JUMP " UINT_FMT " %s " INT_FMT, label, qstr_str(mp_binary_op_method_name[op]), num);
+            break;
+        }
+        #endif
+
         case MP_BC_JUMP_IF_TRUE_OR_POP:
             DECODE_ULABEL;
             mp_printf(print, "JUMP_IF_TRUE_OR_POP " UINT_FMT, (mp_uint_t)(ip + unum - ip_start));
@@ -393,6 +437,18 @@ const byte *mp_bytecode_print_str(const mp_print_t *print, const byte *ip_start,
             mp_printf(print, "FOR_ITER " UINT_FMT, (mp_uint_t)(ip + unum - ip_start));
             break;
 
+        #if MICROPY_OPT_COUNTED_RANGE_LOOP
+        case MP_BC_GET_ITER_RANGE:
+            DECODE_UINT;
+            mp_printf(print, "GET_ITER_RANGE " UINT_FMT, unum);
+            break;
+
+        case MP_BC_FOR_ITER_RANGE:
+            DECODE_ULABEL; // the jump offset if iteration finishes; for labels are always forward
+            mp_printf(print, "FOR_ITER_RANGE " UINT_FMT, (mp_uint_t)(ip + unum - ip_start));
+            break;
+        #endif
+
         case MP_BC_POP_EXCEPT_JUMP:
             DECODE_ULABEL; // these labels are always forward
             mp_printf(print, "POP_EXCEPT_JUMP " UINT_FMT, (mp_uint_t)(ip + unum - ip_start));
@@ -46,6 +46,8 @@
 #define MP_STREAM_SET_DATA_OPTS (9)  // Set data/message options
 #define MP_STREAM_GET_FILENO    (10) // Get fileno of underlying file
 #define MP_STREAM_GET_BUFFER_SIZE (11) // Get preferred buffer size for file
+#define MP_STREAM_GET_ROM_DATA  (12) // Get pointer to file data that stays valid while the file is open
+#define MP_STREAM_KEEP_ROM_DATA (13) // Keep data from MP_STREAM_GET_ROM_DATA valid for the life of the program
 
 // These poll ioctl values are compatible with Linux
 #define MP_STREAM_POLL_RD       (0x0001)
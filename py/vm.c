@@ -33,6 +33,7 @@
 #include "py/objtype.h"
 #include "py/objfun.h"
 #include "py/runtime.h"
+#include "py/smallint.h"
 #include "py/bc0.h"
 #include "py/profile.h"
 
@@ -86,6 +87,12 @@
         } \
     } while (0)
 
+#define DECODE_SINT \
+    mp_uint_t snum = (ip[0] & 0x40) ? (mp_uint_t)-1 : 0; \
+    do { \
+        snum = (snum << 7) | (*ip & 0x7f); \
+    } while ((*ip++ & 0x80) != 0)
+
 #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
 
 #define DECODE_QSTR \
@@ -187,6 +194,28 @@
     } \
 } while(0)
 
+#elif MICROPY_CODE_STATE_CHAIN
+
+// Only maintain the chain of frames, for the sampling profiler.  It may look
+// at the chain from a signal handler at any time, so make sure prev_state is
+// written before the frame becomes visible as current_code_state.
+
+#define FRAME_SETUP() do { \
+    __atomic_signal_fence(__ATOMIC_RELEASE); \
+    MP_STATE_THREAD(current_code_state) = code_state; \
+} while (0)
+
+#define FRAME_ENTER() do { \
+    code_state->prev_state = MP_STATE_THREAD(current_code_state); \
+} while (0)
+
+#define FRAME_LEAVE() do { \
+    MP_STATE_THREAD(current_code_state) = code_state->prev_state; \
+} while (0)
+
+#define FRAME_UPDATE()
+#define TRACE_TICK(current_ip, current_sp, is_exception)
+
 #else // MICROPY_PY_SYS_SETTRACE
 #define FRAME_SETUP()
 #define FRAME_ENTER()
@@ -195,6 +224,127 @@
 #define TRACE_TICK(current_ip, current_sp, is_exception)
 #endif // MICROPY_PY_SYS_SETTRACE
 
+#if MICROPY_OPT_INLINE_CACHE
+
+// Entry for a name whose method was last found outside the type's own locals
+// dict; such lookups skip the cache and go straight to mp_load_method.
+#define INLINE_CACHE_NOT_LOCAL (0xffff)
+
+// The inline cache entry for the qstr just decoded by DECODE_QSTR.  Modules
+// without an inline cache (eg frozen ones) share a single scratch entry.
+#define INLINE_CACHE_ENTRY() (inline_cache != NULL ? &inline_cache[unum] : &inline_cache_scratch)
+
+// Returns the element of map that holds key if it is in the slot given by the
+// inline cache entry, otherwise NULL.  Comparing the key validates the entry,
+// so there is nothing to invalidate when the map changes.
+static inline mp_map_elem_t *inline_cache_get(mp_map_t *map, mp_obj_t key, const uint16_t *entry) {
+    if (*entry < map->alloc && map->table[*entry].key == key) {
+        return &map->table[*entry];
+    }
+    return NULL;
+}
+
+// Looks up key in map, remembering in the inline cache entry where it was found.
+static inline mp_map_elem_t *inline_cache_lookup(mp_map_t *map, mp_obj_t key, uint16_t *entry) {
+    mp_map_elem_t *elem = inline_cache_get(map, key, entry);
+    if (elem == NULL) {
+        elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
+        if (elem != NULL) {
+            *entry = elem - map->table;
+        }
+    }
+    return elem;
+}
+
+// Loads a method that is found in the locals dict of the object's own type and
+// binds self, which is what mp_load_method would do for it.  Returns false,
+// leaving dest untouched, if the method can't be loaded this way.
+static bool inline_cache_load_method(mp_obj_t obj, qstr attr, mp_obj_t *dest, uint16_t *entry) {
+    if (*entry == INLINE_CACHE_NOT_LOCAL) {
+        return false;
+    }
+    #if MICROPY_CPYTHON_COMPAT
+    if (attr == MP_QSTR___class__ || attr == MP_QSTR___dict__) {
+        return false;
+    }
+    #endif
+    if (attr == MP_QSTR___next__) {
+        return false;
+    }
+    mp_obj_t key = MP_OBJ_NEW_QSTR(attr);
+    const mp_obj_type_t *type = mp_obj_get_type(obj);
+    bool is_instance = mp_obj_is_instance_type(type);
+    if (is_instance) {
+        // instance members and special accessors take precedence over the class
+        if (type->flags & MP_TYPE_FLAG_HAS_SPECIAL_ACCESSORS) {
+            return false;
+        }
+        mp_obj_instance_t *self = MP_OBJ_TO_PTR(obj);
+        if (mp_map_lookup(&self->members, key, MP_MAP_LOOKUP) != NULL) {
+            return false;
+        }
+    } else if (MP_OBJ_TYPE_HAS_SLOT(type, attr)) {
+        return false;
+    }
+    if (!MP_OBJ_TYPE_HAS_SLOT(type, locals_dict)) {
+        return false;
+    }
+    mp_map_t *locals_map = &MP_OBJ_TYPE_GET_SLOT(type, locals_dict)->map;
+    mp_map_elem_t *elem = inline_cache_get(locals_map, key, entry);
+    if (elem == NULL) {
+        elem = mp_map_lookup(locals_map, key, MP_MAP_LOOKUP);
+        if (elem == NULL) {
+            *entry = INLINE_CACHE_NOT_LOCAL;
+            return false;
+        }
+        *entry = elem - locals_map->table;
+    }
+    // Only plain methods, which bind self.  Built-in functions on user types
+    // behave like a staticmethod, see mp_convert_member_lookup.
+    if (!mp_obj_is_obj(elem->value)) {
+        return false;
+    }
+    const mp_obj_type_t *m_type = ((mp_obj_base_t *)MP_OBJ_TO_PTR(elem->value))->type;
+    if (!(m_type->flags & MP_TYPE_FLAG_BINDS_SELF)
+        || (is_instance && (m_type->flags & MP_TYPE_FLAG_BUILTIN_FUN))) {
+        return false;
+    }
+    dest[0] = elem->value;
+    dest[1] = obj;
+    return true;
+}
+
+#endif // MICROPY_OPT_INLINE_CACHE
+
+#if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+
+// Evaluate the comparison of a fused compare-and-jump opcode, directly if both
+// sides are small ints, to avoid the round trip through a bool object.
+static bool vm_compare(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    if (mp_obj_is_small_int(lhs) && mp_obj_is_small_int(rhs)) {
+        mp_int_t lhs_val = MP_OBJ_SMALL_INT_VALUE(lhs);
+        mp_int_t rhs_val = MP_OBJ_SMALL_INT_VALUE(rhs);
+        switch (op) {
+            case MP_BINARY_OP_LESS:
+                return lhs_val < rhs_val;
+            case MP_BINARY_OP_MORE:
+                return lhs_val > rhs_val;
+            case MP_BINARY_OP_EQUAL:
+                return lhs_val == rhs_val;
+            case MP_BINARY_OP_LESS_EQUAL:
+                return lhs_val <= rhs_val;
+            case MP_BINARY_OP_MORE_EQUAL:
+                return lhs_val >= rhs_val;
+            default:
+                assert(op == MP_BINARY_OP_NOT_EQUAL);
+                return lhs_val != rhs_val;
+        }
+    }
+    return mp_obj_is_true(mp_binary_op(op, lhs, rhs));
+}
+
+#endif // MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+
 // CIRCUITPY-CHANGE
 static mp_obj_t get_active_exception(mp_exc_stack_t *exc_sp, mp_exc_stack_t *exc_stack) {
     for (mp_exc_stack_t *e = exc_sp; e >= exc_stack; --e) {
@@ -310,6 +460,10 @@ outer_dispatch_loop:
             #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
             const qstr_short_t *qstr_table = code_state->fun_bc->context->constants.qstr_table;
             #endif
+            #if MICROPY_OPT_INLINE_CACHE
+            uint16_t *inline_cache = code_state->fun_bc->context->inline_cache;
+            uint16_t inline_cache_scratch = 0;
+            #endif
             mp_obj_t obj_shared;
             MICROPY_VM_HOOK_INIT
 
@@ -351,15 +505,8 @@ dispatch_loop:
                     DISPATCH();
 
                 ENTRY(MP_BC_LOAD_CONST_SMALL_INT): {
-                    mp_uint_t num = 0;
-                    if ((ip[0] & 0x40) != 0) {
-                        // Number is negative
-                        num--;
-                    }
-                    do {
-                        num = (num << 7) | (*ip & 0x7f);
-                    } while ((*ip++ & 0x80) != 0);
-                    PUSH(MP_OBJ_NEW_SMALL_INT(num));
+                    DECODE_SINT;
+                    PUSH(MP_OBJ_NEW_SMALL_INT(snum));
                     DISPATCH();
                 }
 
@@ -394,6 +541,42 @@ dispatch_loop:
                     DISPATCH();
                 }
 
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_LOAD_FAST_PAIR): {
+                    mp_obj_t obj1 = fastn[-(mp_int_t)(ip[0] >> 4)];
+                    mp_obj_t obj2 = fastn[-(mp_int_t)(ip[0] & 0x0f)];
+                    ip += 1;
+                    if (obj1 == MP_OBJ_NULL || obj2 == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(obj1);
+                    PUSH(obj2);
+                    DISPATCH();
+                }
+
+                ENTRY(MP_BC_INCR_FAST): {
+                    MARK_EXC_IP_SELECTIVE();
+                    // The top bit of the local number selects subtraction.
+                    byte local_num = *ip++;
+                    DECODE_SINT;
+                    mp_obj_t *local = &fastn[-(mp_int_t)(local_num & 0x7f)];
+                    if (*local == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    if (mp_obj_is_small_int(*local)) {
+                        mp_int_t val = MP_OBJ_SMALL_INT_VALUE(*local);
+                        val = (local_num & 0x80) ? val - (mp_int_t)snum : val + (mp_int_t)snum;
+                        if (MP_SMALL_INT_FITS(val)) {
+                            *local = MP_OBJ_NEW_SMALL_INT(val);
+                            DISPATCH();
+                        }
+                    }
+                    mp_binary_op_t op = (local_num & 0x80) ? MP_BINARY_OP_INPLACE_SUBTRACT : MP_BINARY_OP_INPLACE_ADD;
+                    *local = mp_binary_op(op, *local, MP_OBJ_NEW_SMALL_INT(snum));
+                    DISPATCH();
+                }
+                #endif
+
                 ENTRY(MP_BC_LOAD_DEREF): {
                     DECODE_UINT;
                     obj_shared = mp_obj_cell_get(fastn[-unum]);
@@ -410,7 +593,12 @@ dispatch_loop:
                 ENTRY(MP_BC_LOAD_GLOBAL): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
+                    #if MICROPY_OPT_INLINE_CACHE
+                    mp_map_elem_t *elem = inline_cache_lookup(&mp_globals_get()->map, MP_OBJ_NEW_QSTR(qst), INLINE_CACHE_ENTRY());
+                    PUSH(elem != NULL ? elem->value : mp_load_builtin(qst));
+                    #else
                     PUSH(mp_load_global(qst));
+                    #endif
                     DISPATCH();
                 }
 
@@ -428,7 +616,11 @@ dispatch_loop:
                     mp_map_elem_t *elem = NULL;
                     if (mp_obj_is_instance_type(mp_obj_get_type(top))) {
                         mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
+                        #if MICROPY_OPT_INLINE_CACHE
+                        elem = inline_cache_lookup(&self->members, MP_OBJ_NEW_QSTR(qst), INLINE_CACHE_ENTRY());
+                        #else
                         elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
+                        #endif
                     }
                     if (elem) {
                         obj = elem->value;
@@ -444,7 +636,12 @@ dispatch_loop:
                 ENTRY(MP_BC_LOAD_METHOD): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
-                    mp_load_method(*sp, qst, sp);
+                    #if MICROPY_OPT_INLINE_CACHE
+                    if (!inline_cache_load_method(*sp, qst, sp, INLINE_CACHE_ENTRY()))
+                    #endif
+                    {
+                        mp_load_method(*sp, qst, sp);
+                    }
                     sp += 1;
                     DISPATCH();
                 }
@@ -499,7 +696,26 @@ dispatch_loop:
                     FRAME_UPDATE();
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
-                    mp_store_attr(sp[0], qst, sp[-1]);
+                    #if MICROPY_OPT_INLINE_CACHE
+                    // Instances without special accessors (properties, descriptors,
+                    // __setattr__) store straight into their members map.  A null
+                    // value means delete, which takes the generic path.
+                    const mp_obj_type_t *type = mp_obj_get_type(sp[0]);
+                    if (sp[-1] != MP_OBJ_NULL && mp_obj_is_instance_type(type) && !(type->flags & MP_TYPE_FLAG_HAS_SPECIAL_ACCESSORS)) {
+                        mp_obj_instance_t *self = MP_OBJ_TO_PTR(sp[0]);
+                        mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
+                        uint16_t *entry = INLINE_CACHE_ENTRY();
+                        mp_map_elem_t *elem = inline_cache_get(&self->members, key, entry);
+                        if (elem == NULL) {
+                            elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+                            *entry = elem - self->members.table;
+                        }
+                        elem->value = sp[-1];
+                    } else
+                    #endif
+                    {
+                        mp_store_attr(sp[0], qst, sp[-1]);
+                    }
                     sp -= 2;
                     DISPATCH();
                 }
@@ -597,6 +813,47 @@ dispatch_loop:
                     DISPATCH_WITH_PEND_EXC_CHECK();
                 }
 
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_COMPARE_POP_JUMP): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_SLABEL;
+                    const byte *target = ip + slab;
+                    byte arg = *ip++;
+                    mp_obj_t rhs = POP();
+                    mp_obj_t lhs = POP();
+                    bool jump_if_true = arg & MP_BC_COMPARE_POP_JUMP_IF_TRUE;
+                    if (vm_compare(arg & ~MP_BC_COMPARE_POP_JUMP_IF_TRUE, lhs, rhs) == jump_if_true) {
+                        ip = target;
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+
+                ENTRY(MP_BC_FOR_RANGE_JUMP): {
+                    // stack: (..., end, var)
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_SLABEL;
+                    const byte *target = ip + slab;
+                    byte op = *ip++;
+                    if (vm_compare(op, TOP(), sp[-1])) {
+                        ip = target;
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+
+                ENTRY(MP_BC_FOR_RANGE_CONST_JUMP): {
+                    // stack: (..., var)
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_SLABEL;
+                    const byte *target = ip + slab;
+                    byte op = *ip++;
+                    DECODE_SINT;
+                    if (vm_compare(op, TOP(), MP_OBJ_NEW_SMALL_INT(snum))) {
+                        ip = target;
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+                #endif
+
                 ENTRY(MP_BC_JUMP_IF_TRUE_OR_POP): {
                     DECODE_ULABEL;
                     if (mp_obj_is_true(TOP())) {
@@ -789,7 +1046,83 @@ unwind_jump:;
                     DISPATCH();
                 }
 
-                ENTRY(MP_BC_FOR_ITER): {
+                #if MICROPY_OPT_COUNTED_RANGE_LOOP
+                // A counted range loop also uses MP_OBJ_ITER_BUF_NSLOTS slots, and if
+                // range was called with small-int arguments these hold the step (a
+                // small int, which can't be confused with an iter_buf or MP_OBJ_NULL),
+                // the end value and the next value of the loop variable.
+                ENTRY(MP_BC_GET_ITER_RANGE): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_UINT;
+                    mp_obj_t *slots = sp - unum;
+                    sp = slots + MP_OBJ_ITER_BUF_NSLOTS - 1;
+                    if (slots[0] == MP_OBJ_FROM_PTR(&mp_type_range)) {
+                        mp_obj_t start = MP_OBJ_NEW_SMALL_INT(0);
+                        mp_obj_t end = slots[1];
+                        mp_obj_t step = MP_OBJ_NEW_SMALL_INT(1);
+                        if (unum >= 2) {
+                            start = slots[1];
+                            end = slots[2];
+                            if (unum == 3) {
+                                step = slots[3];
+                            }
+                        }
+                        if (mp_obj_is_small_int(start) && mp_obj_is_small_int(end)
+                            && mp_obj_is_small_int(step) && step != MP_OBJ_NEW_SMALL_INT(0)) {
+                            slots[0] = step;
+                            slots[1] = end;
+                            slots[2] = start;
+                            DISPATCH();
+                        }
+                        if (mp_obj_is_int(start) && mp_obj_is_int(end)
+                            && mp_obj_is_int(step) && step != MP_OBJ_NEW_SMALL_INT(0)) {
+                            // Some of them are big ints, which a range object can't
+                            // count with, so count with an iterator over int objects.
+                            mp_obj_iter_buf_t *iter_buf = (mp_obj_iter_buf_t *)slots;
+                            mp_obj_new_range_int_iter(start, end, step, iter_buf);
+                            DISPATCH();
+                        }
+                    }
+                    // Not the builtin range with int arguments, so call it and
+                    // iterate over the result like MP_BC_GET_ITER_STACK.
+                    mp_obj_t obj = mp_call_function_n_kw(slots[0], unum, 0, slots + 1);
+                    mp_obj_iter_buf_t *iter_buf = (mp_obj_iter_buf_t *)slots;
+                    obj = mp_getiter(obj, iter_buf);
+                    if (obj != MP_OBJ_FROM_PTR(iter_buf)) {
+                        slots[0] = MP_OBJ_NULL;
+                        slots[1] = obj;
+                    }
+                    DISPATCH();
+                }
+
+                ENTRY(MP_BC_FOR_ITER_RANGE): {
+                    mp_obj_t *slots = sp - MP_OBJ_ITER_BUF_NSLOTS + 1;
+                    if (!mp_obj_is_small_int(slots[0])) {
+                        goto for_iter;
+                    }
+                    DECODE_ULABEL; // the jump offset if iteration finishes; for labels are always forward
+                    mp_int_t step = MP_OBJ_SMALL_INT_VALUE(slots[0]);
+                    mp_int_t end = MP_OBJ_SMALL_INT_VALUE(slots[1]);
+                    mp_int_t cur = MP_OBJ_SMALL_INT_VALUE(slots[2]);
+                    if (step > 0 ? cur < end : cur > end) {
+                        // The sum of two small ints can't overflow an mp_int_t, and if it
+                        // doesn't fit in a small int then it's past the end anyway.
+                        mp_int_t next = cur + step;
+                        slots[2] = MP_SMALL_INT_FITS(next) ? MP_OBJ_NEW_SMALL_INT(next) : slots[1];
+                        PUSH(MP_OBJ_NEW_SMALL_INT(cur));
+                    } else {
+                        sp -= MP_OBJ_ITER_BUF_NSLOTS; // pop the loop state
+                        ip += ulab; // jump to after for-block
+                    }
+                    DISPATCH();
+                }
+                #endif
+
+                ENTRY(MP_BC_FOR_ITER):
+                #if MICROPY_OPT_COUNTED_RANGE_LOOP
+                for_iter:
+                #endif
+                {
                     FRAME_UPDATE();
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_ULABEL; // the jump offset if iteration finishes; for labels are always forward
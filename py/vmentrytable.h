@@ -127,6 +127,17 @@ static entry_table_type const PLACE_IN_DTCM_DATA(entry_table[256]) = {
     [MP_BC_IMPORT_NAME] = COMPUTE_ENTRY(&& entry_MP_BC_IMPORT_NAME),
     [MP_BC_IMPORT_FROM] = COMPUTE_ENTRY(&& entry_MP_BC_IMPORT_FROM),
     [MP_BC_IMPORT_STAR] = COMPUTE_ENTRY(&& entry_MP_BC_IMPORT_STAR),
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    [MP_BC_LOAD_FAST_PAIR] = COMPUTE_ENTRY(&& entry_MP_BC_LOAD_FAST_PAIR),
+    [MP_BC_INCR_FAST] = COMPUTE_ENTRY(&& entry_MP_BC_INCR_FAST),
+    [MP_BC_COMPARE_POP_JUMP] = COMPUTE_ENTRY(&& entry_MP_BC_COMPARE_POP_JUMP),
+    [MP_BC_FOR_RANGE_JUMP] = COMPUTE_ENTRY(&& entry_MP_BC_FOR_RANGE_JUMP),
+    [MP_BC_FOR_RANGE_CONST_JUMP] = COMPUTE_ENTRY(&& entry_MP_BC_FOR_RANGE_CONST_JUMP),
+    #endif
+    #if MICROPY_OPT_COUNTED_RANGE_LOOP
+    [MP_BC_GET_ITER_RANGE] = COMPUTE_ENTRY(&& entry_MP_BC_GET_ITER_RANGE),
+    [MP_BC_FOR_ITER_RANGE] = COMPUTE_ENTRY(&& entry_MP_BC_FOR_ITER_RANGE),
+    #endif
     [MP_BC_LOAD_CONST_SMALL_INT_MULTI ... MP_BC_LOAD_CONST_SMALL_INT_MULTI + MP_BC_LOAD_CONST_SMALL_INT_MULTI_NUM - 1] = COMPUTE_ENTRY(&& entry_MP_BC_LOAD_CONST_SMALL_INT_MULTI),
     [MP_BC_LOAD_FAST_MULTI ... MP_BC_LOAD_FAST_MULTI + MP_BC_LOAD_FAST_MULTI_NUM - 1] = COMPUTE_ENTRY(&& entry_MP_BC_LOAD_FAST_MULTI),
     [MP_BC_STORE_FAST_MULTI ... MP_BC_STORE_FAST_MULTI + MP_BC_LOAD_FAST_MULTI_NUM - 1] = COMPUTE_ENTRY(&& entry_MP_BC_STORE_FAST_MULTI),
@@ -0,0 +1,112 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2026 Adafruit Industries LLC
+//
+// SPDX-License-Identifier: MIT
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include "shared-bindings/arrayops/__init__.h"
+
+//| """Operations on every element of an array
+//|
+//| The `arrayops` module works on a whole `array.array`, `bytearray` or
+//| `memoryview` in one call, which is much faster than a Python loop over the
+//| elements. The in-place functions are `add`, `scale`, `clamp` and `byteswap`,
+//| and `sum` and `minmax` reduce the elements to a result.
+//|
+//| Integer arithmetic wraps around like it does in C. Values are converted to
+//| the element type with the same checks as storing them in the array, so
+//| out-of-range values raise `OverflowError`.
+//| """
+//|
+
+//| def add(a: WriteableBuffer, value: float) -> None:
+//|     """Add ``value`` to every element of ``a``."""
+//|     ...
+//|
+static mp_obj_t arrayops_add(mp_obj_t a_in, mp_obj_t value_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(a_in, &bufinfo, MP_BUFFER_RW);
+    shared_module_arrayops_add(&bufinfo, value_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(arrayops_add_obj, arrayops_add);
+
+//| def scale(a: WriteableBuffer, value: float) -> None:
+//|     """Multiply every element of ``a`` by ``value``."""
+//|     ...
+//|
+static mp_obj_t arrayops_scale(mp_obj_t a_in, mp_obj_t value_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(a_in, &bufinfo, MP_BUFFER_RW);
+    shared_module_arrayops_scale(&bufinfo, value_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(arrayops_scale_obj, arrayops_scale);
+
+//| def clamp(a: WriteableBuffer, lo: float, hi: float) -> None:
+//|     """Limit every element of ``a`` to between ``lo`` and ``hi``, inclusive."""
+//|     ...
+//|
+static mp_obj_t arrayops_clamp(mp_obj_t a_in, mp_obj_t lo_in, mp_obj_t hi_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(a_in, &bufinfo, MP_BUFFER_RW);
+    shared_module_arrayops_clamp(&bufinfo, lo_in, hi_in);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(arrayops_clamp_obj, arrayops_clamp);
+
+//| def byteswap(a: WriteableBuffer) -> None:
+//|     """Reverse the order of the bytes of every element of ``a``."""
+//|     ...
+//|
+static mp_obj_t arrayops_byteswap(mp_obj_t a_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(a_in, &bufinfo, MP_BUFFER_RW);
+    shared_module_arrayops_byteswap(&bufinfo);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(arrayops_byteswap_obj, arrayops_byteswap);
+
+//| def sum(a: ReadableBuffer) -> float:
+//|     """Return the sum of the elements of ``a``. Integers are summed in 64 bits."""
+//|     ...
+//|
+static mp_obj_t arrayops_sum(mp_obj_t a_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(a_in, &bufinfo, MP_BUFFER_READ);
+    return shared_module_arrayops_sum(&bufinfo);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(arrayops_sum_obj, arrayops_sum);
+
+//| def minmax(a: ReadableBuffer) -> Tuple[float, float]:
+//|     """Return the smallest and the largest element of ``a``, which must not be empty."""
+//|     ...
+//|
+static mp_obj_t arrayops_minmax(mp_obj_t a_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(a_in, &bufinfo, MP_BUFFER_READ);
+    return shared_module_arrayops_minmax(&bufinfo);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(arrayops_minmax_obj, arrayops_minmax);
+
+static const mp_rom_map_elem_t arrayops_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_arrayops) },
+    { MP_ROM_QSTR(MP_QSTR_add), MP_ROM_PTR(&arrayops_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scale), MP_ROM_PTR(&arrayops_scale_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clamp), MP_ROM_PTR(&arrayops_clamp_obj) },
+    { MP_ROM_QSTR(MP_QSTR_byteswap), MP_ROM_PTR(&arrayops_byteswap_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sum), MP_ROM_PTR(&arrayops_sum_obj) },
+    { MP_ROM_QSTR(MP_QSTR_minmax), MP_ROM_PTR(&arrayops_minmax_obj) },
+};
+
+static MP_DEFINE_CONST_DICT(arrayops_module_globals, arrayops_module_globals_table);
+
+const mp_obj_module_t arrayops_module = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *)&arrayops_module_globals,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_arrayops, arrayops_module);
@@ -0,0 +1,16 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2026 Adafruit Industries LLC
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "py/obj.h"
+
+void shared_module_arrayops_add(mp_buffer_info_t *bufinfo, mp_obj_t value);
+void shared_module_arrayops_scale(mp_buffer_info_t *bufinfo, mp_obj_t value);
+void shared_module_arrayops_clamp(mp_buffer_info_t *bufinfo, mp_obj_t lo, mp_obj_t hi);
+void shared_module_arrayops_byteswap(mp_buffer_info_t *bufinfo);
+mp_obj_t shared_module_arrayops_sum(mp_buffer_info_t *bufinfo);
+mp_obj_t shared_module_arrayops_minmax(mp_buffer_info_t *bufinfo);
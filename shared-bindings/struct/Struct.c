@@ -0,0 +1,126 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2013, 2014 Damien P. George
+// SPDX-FileCopyrightText: Copyright (c) 2014 Paul Sokolovsky
+// SPDX-FileCopyrightText: Copyright (c) 2017 Michael McWethy
+//
+// SPDX-License-Identifier: MIT
+
+#include "py/objproperty.h"
+#include "py/runtime.h"
+#include "shared-bindings/struct/Struct.h"
+
+//| class Struct:
+//|     """A format string parsed once, to pack and unpack many records with"""
+//|
+//|     def __init__(self, format: str) -> None:
+//|         """Parse the format string, which uses the same codes as the module functions.
+//|
+//|         :param str format: The format of each record"""
+//|         ...
+//|
+static mp_obj_t struct_struct_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    return MP_OBJ_FROM_PTR(common_hal_struct_struct_new(args[0]));
+}
+
+//|     def pack(self, *values: Any) -> bytes:
+//|         """Pack the values according to the format.
+//|         The return value is a bytes object encoding the values."""
+//|         ...
+//|
+static mp_obj_t struct_struct_pack(size_t n_args, const mp_obj_t *args) {
+    return common_hal_struct_struct_pack(MP_OBJ_TO_PTR(args[0]), n_args - 1, &args[1]);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_struct_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_struct_pack);
+
+//|     def pack_into(self, buffer: WriteableBuffer, offset: int, *values: Any) -> None:
+//|         """Pack the values according to the format into a buffer starting at
+//|         offset. offset may be negative to count from the end of buffer."""
+//|         ...
+//|
+static mp_obj_t struct_struct_pack_into(size_t n_args, const mp_obj_t *args) {
+    common_hal_struct_struct_pack_into(MP_OBJ_TO_PTR(args[0]), args[1], mp_obj_get_int(args[2]), n_args - 3, &args[3]);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_struct_pack_into);
+
+//|     def unpack(self, data: ReadableBuffer) -> Tuple[Any, ...]:
+//|         """Unpack from the data according to the format. The buffer size must
+//|         match the size required by the format."""
+//|         ...
+//|
+static mp_obj_t struct_struct_unpack(mp_obj_t self_in, mp_obj_t data_in) {
+    return common_hal_struct_struct_unpack_from(MP_OBJ_TO_PTR(self_in), data_in, 0, true);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(struct_struct_unpack_obj, struct_struct_unpack);
+
+//|     def unpack_from(self, data: ReadableBuffer, offset: int = 0) -> Tuple[Any, ...]:
+//|         """Unpack from the data starting at offset according to the format.
+//|         offset may be negative to count from the end of buffer. The buffer size
+//|         must be at least as big as the size required by the format."""
+//|         ...
+//|
+static mp_obj_t struct_struct_unpack_from(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_buffer, ARG_offset };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {} },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    return common_hal_struct_struct_unpack_from(MP_OBJ_TO_PTR(pos_args[0]), args[ARG_buffer].u_obj, args[ARG_offset].u_int, false);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(struct_struct_unpack_from_obj, 1, struct_struct_unpack_from);
+
+//|     def iter_unpack(self, data: ReadableBuffer) -> Iterator[Tuple[Any, ...]]:
+//|         """Return an iterator that unpacks the data one record after another.
+//|         The buffer size must be a multiple of the size required by the format."""
+//|         ...
+//|
+static mp_obj_t struct_struct_iter_unpack(mp_obj_t self_in, mp_obj_t data_in) {
+    return common_hal_struct_struct_iter_unpack(MP_OBJ_TO_PTR(self_in), data_in);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(struct_struct_iter_unpack_obj, struct_struct_iter_unpack);
+
+//|     format: str
+//|     """The format string used to create this Struct. (read-only)"""
+static mp_obj_t struct_struct_get_format(mp_obj_t self_in) {
+    return common_hal_struct_struct_get_format(MP_OBJ_TO_PTR(self_in));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(struct_struct_get_format_obj, struct_struct_get_format);
+
+MP_PROPERTY_GETTER(struct_struct_format_obj,
+    (mp_obj_t)&struct_struct_get_format_obj);
+
+//|     size: int
+//|     """The number of bytes in each record. (read-only)"""
+//|
+static mp_obj_t struct_struct_get_size(mp_obj_t self_in) {
+    return MP_OBJ_NEW_SMALL_INT(common_hal_struct_struct_get_size(MP_OBJ_TO_PTR(self_in)));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(struct_struct_get_size_obj, struct_struct_get_size);
+
+MP_PROPERTY_GETTER(struct_struct_size_obj,
+    (mp_obj_t)&struct_struct_get_size_obj);
+
+static const mp_rom_map_elem_t struct_struct_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_pack), MP_ROM_PTR(&struct_struct_pack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_struct_pack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_struct_unpack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_struct_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_struct_iter_unpack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_format), MP_ROM_PTR(&struct_struct_format_obj) },
+    { MP_ROM_QSTR(MP_QSTR_size), MP_ROM_PTR(&struct_struct_size_obj) },
+};
+static MP_DEFINE_CONST_DICT(struct_struct_locals_dict, struct_struct_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    struct_struct_type,
+    MP_QSTR_Struct,
+    MP_TYPE_FLAG_HAS_SPECIAL_ACCESSORS,
+    make_new, struct_struct_make_new,
+    locals_dict, &struct_struct_locals_dict
+    );
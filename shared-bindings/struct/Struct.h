@@ -0,0 +1,19 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2017 Scott Shawcroft for Adafruit Industries
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "shared-module/struct/Struct.h"
+
+extern const mp_obj_type_t struct_struct_type;
+
+struct_struct_obj_t *common_hal_struct_struct_new(mp_obj_t format);
+mp_obj_t common_hal_struct_struct_get_format(struct_struct_obj_t *self);
+size_t common_hal_struct_struct_get_size(struct_struct_obj_t *self);
+mp_obj_t common_hal_struct_struct_pack(struct_struct_obj_t *self, size_t n_args, const mp_obj_t *args);
+void common_hal_struct_struct_pack_into(struct_struct_obj_t *self, mp_obj_t buffer, mp_int_t offset, size_t n_args, const mp_obj_t *args);
+mp_obj_t common_hal_struct_struct_unpack_from(struct_struct_obj_t *self, mp_obj_t buffer, mp_int_t offset, bool exact_size);
+mp_obj_t common_hal_struct_struct_iter_unpack(struct_struct_obj_t *self, mp_obj_t buffer);
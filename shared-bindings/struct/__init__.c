@@ -15,7 +15,6 @@
 #include "py/binary.h"
 #include "py/parsenum.h"
 #include "shared-bindings/struct/__init__.h"
-#include "shared-module/struct/__init__.h"
 
 //| """Manipulation of c-style data
 //|
@@ -34,8 +33,7 @@
 //|
 
 static mp_obj_t struct_calcsize(mp_obj_t fmt_in) {
-
-    return MP_OBJ_NEW_SMALL_INT(shared_modules_struct_calcsize(fmt_in));
+    return MP_OBJ_NEW_SMALL_INT(common_hal_struct_struct_get_size(shared_modules_struct_get_cached(fmt_in)));
 }
 MP_DEFINE_CONST_FUN_OBJ_1(struct_calcsize_obj, struct_calcsize);
 
@@ -46,14 +44,7 @@ MP_DEFINE_CONST_FUN_OBJ_1(struct_calcsize_obj, struct_calcsize);
 //|
 
 static mp_obj_t struct_pack(size_t n_args, const mp_obj_t *args) {
-    mp_int_t size = MP_OBJ_SMALL_INT_VALUE(struct_calcsize(args[0]));
-    vstr_t vstr;
-    vstr_init_len(&vstr, size);
-    byte *p = (byte *)vstr.buf;
-    memset(p, 0, size);
-    byte *end_p = &p[size];
-    shared_modules_struct_pack_into(args[0], p, end_p, n_args - 1, &args[1]);
-    return mp_obj_new_bytes_from_vstr(&vstr);
+    return common_hal_struct_struct_pack(shared_modules_struct_get_cached(args[0]), n_args - 1, &args[1]);
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_pack);
 
@@ -64,21 +55,8 @@ MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, str
 //|
 
 static mp_obj_t struct_pack_into(size_t n_args, const mp_obj_t *args) {
-    mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
-    mp_int_t offset = mp_obj_get_int(args[2]);
-    if (offset < 0) {
-        // negative offsets are relative to the end of the buffer
-        offset = (mp_int_t)bufinfo.len + offset;
-        if (offset < 0) {
-            mp_raise_RuntimeError(MP_ERROR_TEXT("Buffer too small"));
-        }
-    }
-    byte *p = (byte *)bufinfo.buf;
-    byte *end_p = &p[bufinfo.len];
-    p += offset;
-
-    shared_modules_struct_pack_into(args[0], p, end_p, n_args - 3, &args[3]);
+    struct_struct_obj_t *s = shared_modules_struct_get_cached(args[0]);
+    common_hal_struct_struct_pack_into(s, args[1], mp_obj_get_int(args[2]), n_args - 3, &args[3]);
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_pack_into);
@@ -91,13 +69,8 @@ MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX
 //|
 
 static mp_obj_t struct_unpack(size_t n_args, const mp_obj_t *args) {
-    mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_READ);
-    byte *p = bufinfo.buf;
-    byte *end_p = &p[bufinfo.len];
-
     // true means check the size must be exactly right.
-    return MP_OBJ_FROM_PTR(shared_modules_struct_unpack_from(args[0], p, end_p, true));
+    return common_hal_struct_struct_unpack_from(shared_modules_struct_get_cached(args[0]), args[1], 0, true);
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_unpack_obj, 2, 3, struct_unpack);
 
@@ -120,27 +93,25 @@ static mp_obj_t struct_unpack_from(size_t n_args, const mp_obj_t *pos_args, mp_m
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
-    mp_buffer_info_t bufinfo;
-    mp_get_buffer_raise(args[ARG_buffer].u_obj, &bufinfo, MP_BUFFER_READ);
-    byte *p = bufinfo.buf;
-    byte *end_p = &p[bufinfo.len];
-
-    mp_int_t offset = args[ARG_offset].u_int;
-    if (offset < 0) {
-        // negative offsets are relative to the end of the buffer
-        offset = bufinfo.len + offset;
-        if (offset < 0) {
-            mp_raise_RuntimeError(MP_ERROR_TEXT("Buffer too small"));
-        }
-    }
-    p += offset;
-
     // false means the size doesn't have to be exact. struct.unpack_from() only requires
     // that be buffer be big enough.
-    return MP_OBJ_FROM_PTR(shared_modules_struct_unpack_from(args[ARG_format].u_obj, p, end_p, false));
+    struct_struct_obj_t *s = shared_modules_struct_get_cached(args[ARG_format].u_obj);
+    return common_hal_struct_struct_unpack_from(s, args[ARG_buffer].u_obj, args[ARG_offset].u_int, false);
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(struct_unpack_from_obj, 0, struct_unpack_from);
 
+//| def iter_unpack(fmt: str, data: ReadableBuffer) -> Iterator[Tuple[Any, ...]]:
+//|     """Return an iterator that unpacks the data according to the format string fmt,
+//|     one record after another. The buffer size must be a multiple of the size
+//|     required by the format."""
+//|     ...
+//|
+
+static mp_obj_t struct_iter_unpack(mp_obj_t fmt_in, mp_obj_t data_in) {
+    return common_hal_struct_struct_iter_unpack(shared_modules_struct_get_cached(fmt_in), data_in);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(struct_iter_unpack_obj, struct_iter_unpack);
+
 static const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_struct) },
     { MP_ROM_QSTR(MP_QSTR_calcsize), MP_ROM_PTR(&struct_calcsize_obj) },
@@ -148,6 +119,8 @@ static const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_pack_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_unpack_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_iter_unpack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Struct), MP_ROM_PTR(&struct_struct_type) },
 };
 
 static MP_DEFINE_CONST_DICT(mp_module_struct_globals, mp_module_struct_globals_table);
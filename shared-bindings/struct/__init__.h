@@ -6,6 +6,6 @@
 
 #pragma once
 
-void shared_modules_struct_pack_into(mp_obj_t fmt_in, byte *p, byte *end_p, size_t n_args, const mp_obj_t *args);
-mp_uint_t shared_modules_struct_calcsize(mp_obj_t fmt_in);
-mp_obj_tuple_t *shared_modules_struct_unpack_from(mp_obj_t fmt_in, byte *p, byte *end_p, bool exact_size);
+#include "shared-bindings/struct/Struct.h"
+
+struct_struct_obj_t *shared_modules_struct_get_cached(mp_obj_t fmt_in);
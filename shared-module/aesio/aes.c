@@ -31,14 +31,34 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
         You should pad the end of the string with zeros if this is not the case.
         For AES192/256 the key size is proportionally larger.
 
+The rounds are implemented in one of three ways:
+
+  - By default with 32-bit T-tables: SubBytes, ShiftRows and MixColumns of a
+    column are folded into four lookups in a 1 KiB table of S-box values
+    pre-multiplied by the MixColumns coefficients, the other three tables
+    being rotations of the first.  Decryption uses the equivalent inverse
+    cipher (FIPS-197 5.3.5) so it has the same shape, with its own round keys.
+  - With AES_CONSTANT_TIME, the original byte-oriented rounds with the S-box
+    computed by a bitsliced circuit, so no table is indexed by secret data.
+    This is much slower than the T-tables.
+  - With AES_NI, on x86-64 CPUs which have the AES instructions, which also
+    run several independent blocks at once for CTR and CBC decryption.
+
 */
 
 /*****************************************************************************/
 /* Includes:                                                                 */
 /*****************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
 #include <string.h> // CBC mode, for memset
 #include "aes.h"
 
+#if AES_NI
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
 /*****************************************************************************/
 /* Defines:                                                                  */
 /*****************************************************************************/
@@ -81,6 +101,7 @@ typedef uint8_t state_t[4][4];
 // instead of RAM The numbers below can be computed dynamically trading ROM for
 // RAM - This can be useful in (embedded) bootloader applications, where ROM is
 // often limited.
+#if !AES_CONSTANT_TIME
 static const uint8_t sbox[256] = {
     // 0     1    2      3     4    5     6     7      8    9     A      B    C     D     E     F
     0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
@@ -120,6 +141,103 @@ static const uint8_t rsbox[256] = {
     0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
 };
 
+// T-tables for the middle rounds: Te0[x] is the column
+// (2 * sbox[x], sbox[x], sbox[x], 3 * sbox[x]) packed big-endian, and Td0[x]
+// is (14 * rsbox[x], 9 * rsbox[x], 13 * rsbox[x], 11 * rsbox[x]).  The tables
+// for the other three rows of the state are rotations of these.
+static const uint32_t Te0[256] = {
+    0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d, 0xfff2f20d, 0xd66b6bbd,
+    0xde6f6fb1, 0x91c5c554, 0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d,
+    0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a, 0x8fcaca45, 0x1f82829d,
+    0x89c9c940, 0xfa7d7d87, 0xeffafa15, 0xb25959eb, 0x8e4747c9, 0xfbf0f00b,
+    0x41adadec, 0xb3d4d467, 0x5fa2a2fd, 0x45afafea, 0x239c9cbf, 0x53a4a4f7,
+    0xe4727296, 0x9bc0c05b, 0x75b7b7c2, 0xe1fdfd1c, 0x3d9393ae, 0x4c26266a,
+    0x6c36365a, 0x7e3f3f41, 0xf5f7f702, 0x83cccc4f, 0x6834345c, 0x51a5a5f4,
+    0xd1e5e534, 0xf9f1f108, 0xe2717193, 0xabd8d873, 0x62313153, 0x2a15153f,
+    0x0804040c, 0x95c7c752, 0x46232365, 0x9dc3c35e, 0x30181828, 0x379696a1,
+    0x0a05050f, 0x2f9a9ab5, 0x0e070709, 0x24121236, 0x1b80809b, 0xdfe2e23d,
+    0xcdebeb26, 0x4e272769, 0x7fb2b2cd, 0xea75759f, 0x1209091b, 0x1d83839e,
+    0x582c2c74, 0x341a1a2e, 0x361b1b2d, 0xdc6e6eb2, 0xb45a5aee, 0x5ba0a0fb,
+    0xa45252f6, 0x763b3b4d, 0xb7d6d661, 0x7db3b3ce, 0x5229297b, 0xdde3e33e,
+    0x5e2f2f71, 0x13848497, 0xa65353f5, 0xb9d1d168, 0x00000000, 0xc1eded2c,
+    0x40202060, 0xe3fcfc1f, 0x79b1b1c8, 0xb65b5bed, 0xd46a6abe, 0x8dcbcb46,
+    0x67bebed9, 0x7239394b, 0x944a4ade, 0x984c4cd4, 0xb05858e8, 0x85cfcf4a,
+    0xbbd0d06b, 0xc5efef2a, 0x4faaaae5, 0xedfbfb16, 0x864343c5, 0x9a4d4dd7,
+    0x66333355, 0x11858594, 0x8a4545cf, 0xe9f9f910, 0x04020206, 0xfe7f7f81,
+    0xa05050f0, 0x783c3c44, 0x259f9fba, 0x4ba8a8e3, 0xa25151f3, 0x5da3a3fe,
+    0x804040c0, 0x058f8f8a, 0x3f9292ad, 0x219d9dbc, 0x70383848, 0xf1f5f504,
+    0x63bcbcdf, 0x77b6b6c1, 0xafdada75, 0x42212163, 0x20101030, 0xe5ffff1a,
+    0xfdf3f30e, 0xbfd2d26d, 0x81cdcd4c, 0x180c0c14, 0x26131335, 0xc3ecec2f,
+    0xbe5f5fe1, 0x359797a2, 0x884444cc, 0x2e171739, 0x93c4c457, 0x55a7a7f2,
+    0xfc7e7e82, 0x7a3d3d47, 0xc86464ac, 0xba5d5de7, 0x3219192b, 0xe6737395,
+    0xc06060a0, 0x19818198, 0x9e4f4fd1, 0xa3dcdc7f, 0x44222266, 0x542a2a7e,
+    0x3b9090ab, 0x0b888883, 0x8c4646ca, 0xc7eeee29, 0x6bb8b8d3, 0x2814143c,
+    0xa7dede79, 0xbc5e5ee2, 0x160b0b1d, 0xaddbdb76, 0xdbe0e03b, 0x64323256,
+    0x743a3a4e, 0x140a0a1e, 0x924949db, 0x0c06060a, 0x4824246c, 0xb85c5ce4,
+    0x9fc2c25d, 0xbdd3d36e, 0x43acacef, 0xc46262a6, 0x399191a8, 0x319595a4,
+    0xd3e4e437, 0xf279798b, 0xd5e7e732, 0x8bc8c843, 0x6e373759, 0xda6d6db7,
+    0x018d8d8c, 0xb1d5d564, 0x9c4e4ed2, 0x49a9a9e0, 0xd86c6cb4, 0xac5656fa,
+    0xf3f4f407, 0xcfeaea25, 0xca6565af, 0xf47a7a8e, 0x47aeaee9, 0x10080818,
+    0x6fbabad5, 0xf0787888, 0x4a25256f, 0x5c2e2e72, 0x381c1c24, 0x57a6a6f1,
+    0x73b4b4c7, 0x97c6c651, 0xcbe8e823, 0xa1dddd7c, 0xe874749c, 0x3e1f1f21,
+    0x964b4bdd, 0x61bdbddc, 0x0d8b8b86, 0x0f8a8a85, 0xe0707090, 0x7c3e3e42,
+    0x71b5b5c4, 0xcc6666aa, 0x904848d8, 0x06030305, 0xf7f6f601, 0x1c0e0e12,
+    0xc26161a3, 0x6a35355f, 0xae5757f9, 0x69b9b9d0, 0x17868691, 0x99c1c158,
+    0x3a1d1d27, 0x279e9eb9, 0xd9e1e138, 0xebf8f813, 0x2b9898b3, 0x22111133,
+    0xd26969bb, 0xa9d9d970, 0x078e8e89, 0x339494a7, 0x2d9b9bb6, 0x3c1e1e22,
+    0x15878792, 0xc9e9e920, 0x87cece49, 0xaa5555ff, 0x50282878, 0xa5dfdf7a,
+    0x038c8c8f, 0x59a1a1f8, 0x09898980, 0x1a0d0d17, 0x65bfbfda, 0xd7e6e631,
+    0x844242c6, 0xd06868b8, 0x824141c3, 0x299999b0, 0x5a2d2d77, 0x1e0f0f11,
+    0x7bb0b0cb, 0xa85454fc, 0x6dbbbbd6, 0x2c16163a
+};
+
+static const uint32_t Td0[256] = {
+    0x51f4a750, 0x7e416553, 0x1a17a4c3, 0x3a275e96, 0x3bab6bcb, 0x1f9d45f1,
+    0xacfa58ab, 0x4be30393, 0x2030fa55, 0xad766df6, 0x88cc7691, 0xf5024c25,
+    0x4fe5d7fc, 0xc52acbd7, 0x26354480, 0xb562a38f, 0xdeb15a49, 0x25ba1b67,
+    0x45ea0e98, 0x5dfec0e1, 0xc32f7502, 0x814cf012, 0x8d4697a3, 0x6bd3f9c6,
+    0x038f5fe7, 0x15929c95, 0xbf6d7aeb, 0x955259da, 0xd4be832d, 0x587421d3,
+    0x49e06929, 0x8ec9c844, 0x75c2896a, 0xf48e7978, 0x99583e6b, 0x27b971dd,
+    0xbee14fb6, 0xf088ad17, 0xc920ac66, 0x7dce3ab4, 0x63df4a18, 0xe51a3182,
+    0x97513360, 0x62537f45, 0xb16477e0, 0xbb6bae84, 0xfe81a01c, 0xf9082b94,
+    0x70486858, 0x8f45fd19, 0x94de6c87, 0x527bf8b7, 0xab73d323, 0x724b02e2,
+    0xe31f8f57, 0x6655ab2a, 0xb2eb2807, 0x2fb5c203, 0x86c57b9a, 0xd33708a5,
+    0x302887f2, 0x23bfa5b2, 0x02036aba, 0xed16825c, 0x8acf1c2b, 0xa779b492,
+    0xf307f2f0, 0x4e69e2a1, 0x65daf4cd, 0x0605bed5, 0xd134621f, 0xc4a6fe8a,
+    0x342e539d, 0xa2f355a0, 0x058ae132, 0xa4f6eb75, 0x0b83ec39, 0x4060efaa,
+    0x5e719f06, 0xbd6e1051, 0x3e218af9, 0x96dd063d, 0xdd3e05ae, 0x4de6bd46,
+    0x91548db5, 0x71c45d05, 0x0406d46f, 0x605015ff, 0x1998fb24, 0xd6bde997,
+    0x894043cc, 0x67d99e77, 0xb0e842bd, 0x07898b88, 0xe7195b38, 0x79c8eedb,
+    0xa17c0a47, 0x7c420fe9, 0xf8841ec9, 0x00000000, 0x09808683, 0x322bed48,
+    0x1e1170ac, 0x6c5a724e, 0xfd0efffb, 0x0f853856, 0x3daed51e, 0x362d3927,
+    0x0a0fd964, 0x685ca621, 0x9b5b54d1, 0x24362e3a, 0x0c0a67b1, 0x9357e70f,
+    0xb4ee96d2, 0x1b9b919e, 0x80c0c54f, 0x61dc20a2, 0x5a774b69, 0x1c121a16,
+    0xe293ba0a, 0xc0a02ae5, 0x3c22e043, 0x121b171d, 0x0e090d0b, 0xf28bc7ad,
+    0x2db6a8b9, 0x141ea9c8, 0x57f11985, 0xaf75074c, 0xee99ddbb, 0xa37f60fd,
+    0xf701269f, 0x5c72f5bc, 0x44663bc5, 0x5bfb7e34, 0x8b432976, 0xcb23c6dc,
+    0xb6edfc68, 0xb8e4f163, 0xd731dcca, 0x42638510, 0x13972240, 0x84c61120,
+    0x854a247d, 0xd2bb3df8, 0xaef93211, 0xc729a16d, 0x1d9e2f4b, 0xdcb230f3,
+    0x0d8652ec, 0x77c1e3d0, 0x2bb3166c, 0xa970b999, 0x119448fa, 0x47e96422,
+    0xa8fc8cc4, 0xa0f03f1a, 0x567d2cd8, 0x223390ef, 0x87494ec7, 0xd938d1c1,
+    0x8ccaa2fe, 0x98d40b36, 0xa6f581cf, 0xa57ade28, 0xdab78e26, 0x3fadbfa4,
+    0x2c3a9de4, 0x5078920d, 0x6a5fcc9b, 0x547e4662, 0xf68d13c2, 0x90d8b8e8,
+    0x2e39f75e, 0x82c3aff5, 0x9f5d80be, 0x69d0937c, 0x6fd52da9, 0xcf2512b3,
+    0xc8ac993b, 0x10187da7, 0xe89c636e, 0xdb3bbb7b, 0xcd267809, 0x6e5918f4,
+    0xec9ab701, 0x834f9aa8, 0xe6956e65, 0xaaffe67e, 0x21bccf08, 0xef15e8e6,
+    0xbae79bd9, 0x4a6f36ce, 0xea9f09d4, 0x29b07cd6, 0x31a4b2af, 0x2a3f2331,
+    0xc6a59430, 0x35a266c0, 0x744ebc37, 0xfc82caa6, 0xe090d0b0, 0x33a7d815,
+    0xf104984a, 0x41ecdaf7, 0x7fcd500e, 0x1791f62f, 0x764dd68d, 0x43efb04d,
+    0xccaa4d54, 0xe49604df, 0x9ed1b5e3, 0x4c6a881b, 0xc12c1fb8, 0x4665517f,
+    0x9d5eea04, 0x018c355d, 0xfa877473, 0xfb0b412e, 0xb3671d5a, 0x92dbd252,
+    0xe9105633, 0x6dd64713, 0x9ad7618c, 0x37a10c7a, 0x59f8148e, 0xeb133c89,
+    0xcea927ee, 0xb761c935, 0xe11ce5ed, 0x7a47b13c, 0x9cd2df59, 0x55f2733f,
+    0x1814ce79, 0x73c737bf, 0x53f7cdea, 0x5ffdaa5b, 0xdf3d6f14, 0x7844db86,
+    0xcaaff381, 0xb968c43e, 0x3824342c, 0xc2a3405f, 0x161dc372, 0xbce2250c,
+    0x283c498b, 0xff0d9541, 0x39a80171, 0x080cb3de, 0xd8b4e49c, 0x6456c190,
+    0x7bcb8461, 0xd532b670, 0x486c5c74, 0xd0b85742
+};
+#endif // !AES_CONSTANT_TIME
+
 // The round constant word array, Rcon[i], contains the values given by x to the
 // power (i-1) being powers of x (x is denoted as {02}) in the field GF(2^8)
 static const uint8_t Rcon[11] = {
@@ -161,7 +279,249 @@ static const uint8_t *GetRoundKey(const struct AES_ctx *ctx) {
     return NULL;
 }
 
+#if AES_NI
+// Checked on every call rather than cached: it only reads a flag which libgcc
+// sets up at startup.
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#define aesni_available() (__builtin_cpu_supports("aes"))
+#endif
+
+#if AES_CONSTANT_TIME
+// Bitsliced S-box: bit i of every byte of the input is gathered into word
+// q[i], and the S-box is evaluated on all of the bytes at once by a circuit
+// of only AND, XOR and NOT, which takes the same time whatever their values.
+typedef uint32_t bs_word_t;
+
+// The S-box circuit of J. Boyar and R. Peralta, "A depth-16 circuit for the
+// AES S-box" (2011), 113 gates; q[0] holds the least significant bits.
+static void bs_sbox(bs_word_t *q) {
+    bs_word_t x0, x1, x2, x3, x4, x5, x6, x7;
+    bs_word_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    bs_word_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    bs_word_t y20, y21;
+    bs_word_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    bs_word_t z10, z11, z12, z13, z14, z15, z16, z17;
+    bs_word_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    bs_word_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    bs_word_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    bs_word_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    bs_word_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    bs_word_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    bs_word_t t60, t61, t62, t63, t64, t65, t66, t67;
+    bs_word_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    // Top linear transformation.
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    // Non-linear section.
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    // Bottom linear transformation.
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+// The inverse of the affine transform of the S-box.  InvSubBytes(y) is
+// inverse(InvAffine(y)) and inverse(z) is InvAffine(SubBytes(z)), so the
+// inverse S-box is the S-box with InvAffine applied before and after.
+static void bs_inv_affine(bs_word_t *q) {
+    bs_word_t y[8];
+    unsigned i;
+    for (i = 0; i < 8; ++i)
+    {
+        y[i] = q[(i + 2) % 8] ^ q[(i + 5) % 8] ^ q[(i + 7) % 8] ^ -(bs_word_t)((0x05 >> i) & 1);
+    }
+    memcpy(q, y, sizeof(y));
+}
+
+// Transpose the 8x8 bit matrix with byte r of x as row r, so that bit c of
+// byte r swaps with bit r of byte c.
+static uint64_t bs_transpose(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+// Apply the S-box, or with inverse the inverse S-box, to n <= 16 bytes.
+static void SubBytesCT(uint8_t *bytes, unsigned n, bool inverse) {
+    uint64_t lo = 0, hi = 0;
+    bs_word_t q[8];
+    unsigned i;
 
+    for (i = 0; i < n; ++i)
+    {
+        if (i < 8) {
+            lo |= (uint64_t)bytes[i] << (i * 8);
+        } else {
+            hi |= (uint64_t)bytes[i] << ((i - 8) * 8);
+        }
+    }
+    lo = bs_transpose(lo);
+    hi = bs_transpose(hi);
+    for (i = 0; i < 8; ++i)
+    {
+        q[i] = (bs_word_t)((lo >> (i * 8)) & 0xff) | (bs_word_t)((hi >> (i * 8)) & 0xff) << 8;
+    }
+
+    if (inverse) {
+        bs_inv_affine(q);
+        bs_sbox(q);
+        bs_inv_affine(q);
+    } else {
+        bs_sbox(q);
+    }
+
+    lo = 0;
+    hi = 0;
+    for (i = 0; i < 8; ++i)
+    {
+        lo |= (uint64_t)(q[i] & 0xff) << (i * 8);
+        hi |= (uint64_t)((q[i] >> 8) & 0xff) << (i * 8);
+    }
+    lo = bs_transpose(lo);
+    hi = bs_transpose(hi);
+    for (i = 0; i < n; ++i)
+    {
+        bytes[i] = i < 8 ? lo >> (i * 8) : hi >> ((i - 8) * 8);
+    }
+}
+#else
 /*
 static uint8_t getSBoxValue(uint8_t num)
 {
@@ -177,6 +537,83 @@ static uint8_t getSBoxInvert(uint8_t num)
 */
 #define getSBoxInvert(num) (rsbox[(num)])
 
+#define GETU32(p) \
+    (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+#define PUTU32(p, v) \
+    do { (p)[0] = (v) >> 24; (p)[1] = (v) >> 16; (p)[2] = (v) >> 8; (p)[3] = (v); } while (0)
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// One column of a T-table round: the table entries for the bytes of rows 0,
+// 1, 2 and 3, taken from the columns a, b, c and d of the state.
+#define TROUND(T, a, b, c, d) \
+    (T[(a) >> 24] ^ ROR(T[((b) >> 16) & 0xff], 8) ^ ROR(T[((c) >> 8) & 0xff], 16) ^ ROR(T[(d) & 0xff], 24))
+
+// The same for the last round, which has no MixColumns.
+#define SROUND(S, a, b, c, d) \
+    (((uint32_t)S[(a) >> 24] << 24) | ((uint32_t)S[((b) >> 16) & 0xff] << 16) | \
+    ((uint32_t)S[((c) >> 8) & 0xff] << 8) | (uint32_t)S[(d) & 0xff])
+#endif // AES_CONSTANT_TIME
+
+// SubWord() is a function that takes a four-byte input word and applies
+// the S-box to each of the four bytes to produce an output word.
+static void SubWord(uint8_t *tempa) {
+    #if AES_CONSTANT_TIME
+    SubBytesCT(tempa, 4, false);
+    #else
+    tempa[0] = getSBoxValue(tempa[0]);
+    tempa[1] = getSBoxValue(tempa[1]);
+    tempa[2] = getSBoxValue(tempa[2]);
+    tempa[3] = getSBoxValue(tempa[3]);
+    #endif
+}
+
+#if defined(AES_DEC_ROUNDKEY) && (AES_DEC_ROUNDKEY == 1)
+#if AES_NI
+AESNI_TARGET
+static void aesni_dec_keys(uint8_t *drk, const uint8_t *rk, unsigned Nr) {
+    unsigned round;
+    _mm_storeu_si128((__m128i *)drk, _mm_loadu_si128((const __m128i *)(rk + Nr * 16)));
+    for (round = 1; round < Nr; ++round)
+    {
+        __m128i k = _mm_loadu_si128((const __m128i *)(rk + (Nr - round) * 16));
+        _mm_storeu_si128((__m128i *)(drk + round * 16), _mm_aesimc_si128(k));
+    }
+    _mm_storeu_si128((__m128i *)(drk + Nr * 16), _mm_loadu_si128((const __m128i *)rk));
+}
+#endif
+
+// The equivalent inverse cipher uses the round keys in reverse order, with
+// InvMixColumns applied to all but the first and last.
+static void DecKeyExpansion(struct AES_ctx *ctx) {
+    const uint8_t *RoundKey = GetRoundKey(ctx);
+    uint8_t *DecRoundKey = ctx->DecRoundKey;
+    unsigned Nr = ctx->Nr;
+
+    #if AES_NI
+    if (aesni_available()) {
+        aesni_dec_keys(DecRoundKey, RoundKey, Nr);
+        return;
+    }
+    #endif
+
+    #if !AES_CONSTANT_TIME
+    unsigned i;
+    memcpy(DecRoundKey, RoundKey + Nr * 16, 16);
+    for (i = 4; i < Nb * Nr; ++i)
+    {
+        // Td0[sbox[b]] is InvMixColumns of the column (b, 0, 0, 0).
+        uint32_t w = GETU32(RoundKey + (Nr * 4 - (i & ~3) + (i & 3)) * 4);
+        w = Td0[sbox[w >> 24]]
+            ^ ROR(Td0[sbox[(w >> 16) & 0xff]], 8)
+            ^ ROR(Td0[sbox[(w >> 8) & 0xff]], 16)
+            ^ ROR(Td0[sbox[w & 0xff]], 24);
+        PUTU32(DecRoundKey + i * 4, w);
+    }
+    memcpy(DecRoundKey + Nr * 16, RoundKey, 16);
+    #endif
+}
+#endif
+
 // This function produces Nb(Nr+1) round keys. The round keys are used in each
 // round to decrypt the states.
 static void KeyExpansion(struct AES_ctx *ctx, const uint8_t *Key) {
@@ -219,29 +656,14 @@ static void KeyExpansion(struct AES_ctx *ctx, const uint8_t *Key) {
                 tempa[3] = u8tmp;
             }
 
-            // SubWord() is a function that takes a four-byte input word and applies
-            // the S-box to each of the four bytes to produce an output word.
-
-            // Function Subword()
-            {
-                tempa[0] = getSBoxValue(tempa[0]);
-                tempa[1] = getSBoxValue(tempa[1]);
-                tempa[2] = getSBoxValue(tempa[2]);
-                tempa[3] = getSBoxValue(tempa[3]);
-            }
+            SubWord(tempa);
 
             tempa[0] = tempa[0] ^ Rcon[i / ctx->Nk];
         }
         #if defined(AES256) && (AES256 == 1)
         if (ctx->KeyLength == 32) {
             if (i % ctx->Nk == 4) {
-                // Function Subword()
-                {
-                    tempa[0] = getSBoxValue(tempa[0]);
-                    tempa[1] = getSBoxValue(tempa[1]);
-                    tempa[2] = getSBoxValue(tempa[2]);
-                    tempa[3] = getSBoxValue(tempa[3]);
-                }
+                SubWord(tempa);
             }
         }
         #endif
@@ -252,6 +674,10 @@ static void KeyExpansion(struct AES_ctx *ctx, const uint8_t *Key) {
         RoundKey[j + 2] = RoundKey[k + 2] ^ tempa[2];
         RoundKey[j + 3] = RoundKey[k + 3] ^ tempa[3];
     }
+
+    #if defined(AES_DEC_ROUNDKEY) && (AES_DEC_ROUNDKEY == 1)
+    DecKeyExpansion(ctx);
+    #endif
 }
 
 void AES_init_ctx(struct AES_ctx *ctx, const uint8_t *key, uint32_t keylen) {
@@ -292,6 +718,7 @@ void AES_ctx_set_iv(struct AES_ctx *ctx, const uint8_t *iv) {
 }
 #endif
 
+#if AES_CONSTANT_TIME
 // This function adds the round key to state. The round key is added to the
 // state by an XOR function.
 static void AddRoundKey(uint8_t round, state_t *state, const uint8_t *RoundKey) {
@@ -308,14 +735,7 @@ static void AddRoundKey(uint8_t round, state_t *state, const uint8_t *RoundKey)
 // The SubBytes Function Substitutes the values in the state matrix with values
 // in an S-box.
 static void SubBytes(state_t *state) {
-    uint8_t i, j;
-    for (i = 0; i < 4; ++i)
-    {
-        for (j = 0; j < 4; ++j)
-        {
-            (*state)[j][i] = getSBoxValue((*state)[j][i]);
-        }
-    }
+    SubBytesCT(&(*state)[0][0], AES_BLOCKLEN, false);
 }
 
 // The ShiftRows() function shifts the rows in the state to the left. Each row
@@ -422,14 +842,7 @@ static void InvMixColumns(state_t *state) {
 // The SubBytes Function Substitutes the values in the state matrix with values
 // in an S-box.
 static void InvSubBytes(state_t *state) {
-    uint8_t i, j;
-    for (i = 0; i < 4; ++i)
-    {
-        for (j = 0; j < 4; ++j)
-        {
-            (*state)[j][i] = getSBoxInvert((*state)[j][i]);
-        }
-    }
+    SubBytesCT(&(*state)[0][0], AES_BLOCKLEN, true);
 }
 
 static void InvShiftRows(state_t *state) {
@@ -508,6 +921,198 @@ static void InvCipher(state_t *state, const struct AES_ctx *ctx) {
 }
 #endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
 
+#else
+
+// Cipher is the main function that encrypts the PlainText.  The state is held
+// as four big-endian column words.
+static void Cipher(state_t *state, const struct AES_ctx *ctx) {
+    const uint8_t *rk = GetRoundKey(ctx);
+    uint8_t *buf = &(*state)[0][0];
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    unsigned round;
+
+    // Add the First round key to the state before starting the rounds.
+    s0 = GETU32(buf) ^ GETU32(rk);
+    s1 = GETU32(buf + 4) ^ GETU32(rk + 4);
+    s2 = GETU32(buf + 8) ^ GETU32(rk + 8);
+    s3 = GETU32(buf + 12) ^ GETU32(rk + 12);
+
+    // SubBytes, ShiftRows, MixColumns and AddRoundKey for the first Nr-1
+    // rounds.
+    for (round = 1; round < ctx->Nr; ++round)
+    {
+        rk += 16;
+        t0 = TROUND(Te0, s0, s1, s2, s3) ^ GETU32(rk);
+        t1 = TROUND(Te0, s1, s2, s3, s0) ^ GETU32(rk + 4);
+        t2 = TROUND(Te0, s2, s3, s0, s1) ^ GETU32(rk + 8);
+        t3 = TROUND(Te0, s3, s0, s1, s2) ^ GETU32(rk + 12);
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Last one without MixColumns()
+    rk += 16;
+    t0 = SROUND(sbox, s0, s1, s2, s3) ^ GETU32(rk);
+    t1 = SROUND(sbox, s1, s2, s3, s0) ^ GETU32(rk + 4);
+    t2 = SROUND(sbox, s2, s3, s0, s1) ^ GETU32(rk + 8);
+    t3 = SROUND(sbox, s3, s0, s1, s2) ^ GETU32(rk + 12);
+    PUTU32(buf, t0);
+    PUTU32(buf + 4, t1);
+    PUTU32(buf + 8, t2);
+    PUTU32(buf + 12, t3);
+}
+
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+// InvCipher is the equivalent inverse cipher, with InvShiftRows moving bytes
+// the other way and the decryption round keys from DecKeyExpansion().
+static void InvCipher(state_t *state, const struct AES_ctx *ctx) {
+    const uint8_t *rk = ctx->DecRoundKey;
+    uint8_t *buf = &(*state)[0][0];
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    unsigned round;
+
+    s0 = GETU32(buf) ^ GETU32(rk);
+    s1 = GETU32(buf + 4) ^ GETU32(rk + 4);
+    s2 = GETU32(buf + 8) ^ GETU32(rk + 8);
+    s3 = GETU32(buf + 12) ^ GETU32(rk + 12);
+
+    for (round = 1; round < ctx->Nr; ++round)
+    {
+        rk += 16;
+        t0 = TROUND(Td0, s0, s3, s2, s1) ^ GETU32(rk);
+        t1 = TROUND(Td0, s1, s0, s3, s2) ^ GETU32(rk + 4);
+        t2 = TROUND(Td0, s2, s1, s0, s3) ^ GETU32(rk + 8);
+        t3 = TROUND(Td0, s3, s2, s1, s0) ^ GETU32(rk + 12);
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    rk += 16;
+    t0 = SROUND(rsbox, s0, s3, s2, s1) ^ GETU32(rk);
+    t1 = SROUND(rsbox, s1, s0, s3, s2) ^ GETU32(rk + 4);
+    t2 = SROUND(rsbox, s2, s1, s0, s3) ^ GETU32(rk + 8);
+    t3 = SROUND(rsbox, s3, s2, s1, s0) ^ GETU32(rk + 12);
+    PUTU32(buf, t0);
+    PUTU32(buf + 4, t1);
+    PUTU32(buf + 8, t2);
+    PUTU32(buf + 12, t3);
+}
+#endif // #if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+
+#endif // AES_CONSTANT_TIME
+
+#if AES_NI
+// Four blocks are run through each round together so that the AES unit,
+// which takes several cycles per instruction but can start one every cycle,
+// is kept busy.
+#define AESNI_BATCH 4
+
+AESNI_TARGET
+static void aesni_encrypt_blocks(const uint8_t *rk, unsigned Nr, uint8_t *buf, size_t nblocks) {
+    const __m128i *k = (const __m128i *)rk;
+    __m128i b[AESNI_BATCH];
+    unsigned round, n, i;
+
+    while (nblocks > 0) {
+        n = nblocks < AESNI_BATCH ? nblocks : AESNI_BATCH;
+        for (i = 0; i < n; ++i) {
+            b[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)buf + i), _mm_loadu_si128(k));
+        }
+        for (round = 1; round < Nr; ++round) {
+            __m128i rkey = _mm_loadu_si128(k + round);
+            for (i = 0; i < n; ++i) {
+                b[i] = _mm_aesenc_si128(b[i], rkey);
+            }
+        }
+        for (i = 0; i < n; ++i) {
+            _mm_storeu_si128((__m128i *)buf + i, _mm_aesenclast_si128(b[i], _mm_loadu_si128(k + Nr)));
+        }
+        buf += n * AES_BLOCKLEN;
+        nblocks -= n;
+    }
+}
+
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+AESNI_TARGET
+static void aesni_decrypt_blocks(const uint8_t *drk, unsigned Nr, uint8_t *buf, size_t nblocks) {
+    const __m128i *k = (const __m128i *)drk;
+    __m128i b[AESNI_BATCH];
+    unsigned round, n, i;
+
+    while (nblocks > 0) {
+        n = nblocks < AESNI_BATCH ? nblocks : AESNI_BATCH;
+        for (i = 0; i < n; ++i) {
+            b[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)buf + i), _mm_loadu_si128(k));
+        }
+        for (round = 1; round < Nr; ++round) {
+            __m128i rkey = _mm_loadu_si128(k + round);
+            for (i = 0; i < n; ++i) {
+                b[i] = _mm_aesdec_si128(b[i], rkey);
+            }
+        }
+        for (i = 0; i < n; ++i) {
+            _mm_storeu_si128((__m128i *)buf + i, _mm_aesdeclast_si128(b[i], _mm_loadu_si128(k + Nr)));
+        }
+        buf += n * AES_BLOCKLEN;
+        nblocks -= n;
+    }
+}
+#endif
+#endif // AES_NI
+
+// Encrypt nblocks consecutive blocks of buf in place, independently of each
+// other.
+static void EncryptBlocks(const struct AES_ctx *ctx, uint8_t *buf, size_t nblocks) {
+    #if AES_NI
+    if (aesni_available()) {
+        aesni_encrypt_blocks(GetRoundKey(ctx), ctx->Nr, buf, nblocks);
+        return;
+    }
+    #endif
+    for (; nblocks > 0; --nblocks, buf += AES_BLOCKLEN)
+    {
+        Cipher((state_t *)buf, ctx);
+    }
+}
+
+#if (defined(CBC) && CBC == 1) || (defined(ECB) && ECB == 1)
+static void DecryptBlocks(const struct AES_ctx *ctx, uint8_t *buf, size_t nblocks) {
+    #if AES_NI
+    if (aesni_available()) {
+        aesni_decrypt_blocks(ctx->DecRoundKey, ctx->Nr, buf, nblocks);
+        return;
+    }
+    #endif
+    for (; nblocks > 0; --nblocks, buf += AES_BLOCKLEN)
+    {
+        InvCipher((state_t *)buf, ctx);
+    }
+}
+#endif
+
+#if (defined(CBC) && (CBC == 1)) || (defined(CTR) && (CTR == 1))
+// XOR src into dst a word at a time; memcpy keeps the accesses legal for
+// unaligned buffers and compiles to plain loads and stores.
+static void XorBytes(uint8_t *dst, const uint8_t *src, size_t len) {
+    uint32_t a, b;
+    for (; len >= 4; len -= 4, dst += 4, src += 4)
+    {
+        memcpy(&a, dst, 4);
+        memcpy(&b, src, 4);
+        a ^= b;
+        memcpy(dst, &a, 4);
+    }
+    for (; len > 0; --len)
+    {
+        *dst++ ^= *src++;
+    }
+}
+#endif
+
 /*****************************************************************************/
 /* Public functions:                                                         */
 /*****************************************************************************/
@@ -517,13 +1122,13 @@ static void InvCipher(state_t *state, const struct AES_ctx *ctx) {
 void AES_ECB_encrypt(const struct AES_ctx *ctx, uint8_t *buf) {
     // The next function call encrypts the PlainText with the Key using AES
     // algorithm.
-    Cipher((state_t *)buf, ctx);
+    EncryptBlocks(ctx, buf, 1);
 }
 
 void AES_ECB_decrypt(const struct AES_ctx *ctx, uint8_t *buf) {
     // The next function call decrypts the PlainText with the Key using AES
     // algorithm.
-    InvCipher((state_t *)buf, ctx);
+    DecryptBlocks(ctx, buf, 1);
 }
 
 
@@ -535,13 +1140,12 @@ void AES_ECB_decrypt(const struct AES_ctx *ctx, uint8_t *buf) {
 
 #if defined(CBC) && (CBC == 1)
 
+// The number of blocks decrypted together by AES_CBC_decrypt_buffer.
+#define CBC_BATCH 4
 
 static void XorWithIv(uint8_t *buf, const uint8_t *Iv) {
-    uint8_t i;
-    for (i = 0; i < AES_BLOCKLEN; ++i) // The block in AES is always 128bit no matter the key size
-    {
-        buf[i] ^= Iv[i];
-    }
+    // The block in AES is always 128bit no matter the key size
+    XorBytes(buf, Iv, AES_BLOCKLEN);
 }
 
 void AES_CBC_encrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, uint32_t length) {
@@ -550,7 +1154,7 @@ void AES_CBC_encrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, uint32_t length)
     for (i = 0; i < length; i += AES_BLOCKLEN)
     {
         XorWithIv(buf, Iv);
-        Cipher((state_t *)buf, ctx);
+        EncryptBlocks(ctx, buf, 1);
         Iv = buf;
         buf += AES_BLOCKLEN;
     }
@@ -558,18 +1162,28 @@ void AES_CBC_encrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, uint32_t length)
     memcpy(ctx->Iv, Iv, AES_BLOCKLEN);
 }
 
+// Unlike encryption, each block's decryption only depends on the ciphertext,
+// so several blocks are decrypted at once and then chained.
 void AES_CBC_decrypt_buffer(struct AES_ctx *ctx, uint8_t *buf,  uint32_t length) {
-    uintptr_t i;
-    uint8_t storeNextIv[AES_BLOCKLEN];
-    for (i = 0; i < length; i += AES_BLOCKLEN)
+    uint8_t storeNextIv[CBC_BATCH * AES_BLOCKLEN];
+    uint32_t i, n;
+    while (length >= AES_BLOCKLEN)
     {
-        memcpy(storeNextIv, buf, AES_BLOCKLEN);
-        InvCipher((state_t *)buf, ctx);
+        n = length / AES_BLOCKLEN;
+        if (n > CBC_BATCH) {
+            n = CBC_BATCH;
+        }
+        memcpy(storeNextIv, buf, n * AES_BLOCKLEN);
+        DecryptBlocks(ctx, buf, n);
         XorWithIv(buf, ctx->Iv);
-        memcpy(ctx->Iv, storeNextIv, AES_BLOCKLEN);
-        buf += AES_BLOCKLEN;
+        for (i = 1; i < n; ++i)
+        {
+            XorWithIv(buf + i * AES_BLOCKLEN, storeNextIv + (i - 1) * AES_BLOCKLEN);
+        }
+        memcpy(ctx->Iv, storeNextIv + (n - 1) * AES_BLOCKLEN, AES_BLOCKLEN);
+        buf += n * AES_BLOCKLEN;
+        length -= n * AES_BLOCKLEN;
     }
-
 }
 
 #endif // #if defined(CBC) && (CBC == 1)
@@ -578,18 +1192,23 @@ void AES_CBC_decrypt_buffer(struct AES_ctx *ctx, uint8_t *buf,  uint32_t length)
 
 #if defined(CTR) && (CTR == 1)
 
+// The number of blocks of key stream generated at once by AES_CTR_xcrypt_buffer.
+#define CTR_BATCH 4
+
 /* Symmetrical operation: same function for encrypting as for decrypting. Note
 any IV/nonce should never be reused with the same key */
 void AES_CTR_xcrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, uint32_t length) {
-    uint8_t buffer[AES_BLOCKLEN];
-
-    unsigned i;
+    uint8_t buffer[CTR_BATCH * AES_BLOCKLEN];
+    uint32_t n, len;
     int bi;
-    for (i = 0, bi = AES_BLOCKLEN; i < length; ++i, ++bi)
+
+    while (length > 0)
     {
-        if (bi == AES_BLOCKLEN) { /* we need to regen xor compliment in buffer */
-            memcpy(buffer, ctx->Iv, AES_BLOCKLEN);
-            Cipher((state_t *)buffer, ctx);
+        // Fill the buffer with successive counter blocks and encrypt them all
+        // to get the key stream.  Any of it left over at the end is dropped.
+        for (n = 0; n < CTR_BATCH && n * AES_BLOCKLEN < length; ++n)
+        {
+            memcpy(buffer + n * AES_BLOCKLEN, ctx->Iv, AES_BLOCKLEN);
 
             /* Increment Iv and handle overflow */
             for (bi = (AES_BLOCKLEN - 1); bi >= 0; --bi)
@@ -602,10 +1221,13 @@ void AES_CTR_xcrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, uint32_t length) {
                 ctx->Iv[bi] += 1;
                 break;
             }
-            bi = 0;
         }
+        EncryptBlocks(ctx, buffer, n);
 
-        buf[i] = (buf[i] ^ buffer[bi]);
+        len = n * AES_BLOCKLEN < length ? n * AES_BLOCKLEN : length;
+        XorBytes(buf, buffer, len);
+        buf += len;
+        length -= len;
     }
 }
 
@@ -27,6 +27,32 @@
   #define CTR 1
 #endif
 
+// AES_CONSTANT_TIME computes the S-box bitsliced instead of looking it up in
+// tables indexed by secret data, so the timing doesn't depend on the key or
+// the data.  It is much slower than the default T-table rounds.
+#ifndef AES_CONSTANT_TIME
+  #if defined(CIRCUITPY_AESIO_CONSTANT_TIME)
+    #define AES_CONSTANT_TIME CIRCUITPY_AESIO_CONSTANT_TIME
+  #else
+    #define AES_CONSTANT_TIME 0
+  #endif
+#endif
+
+// AES_NI uses the AES instructions of x86-64 CPUs which have them, checked at
+// run time.
+#ifndef AES_NI
+  #if defined(__x86_64__) && defined(__GNUC__)
+    #define AES_NI 1
+  #else
+    #define AES_NI 0
+  #endif
+#endif
+
+// The T-table and AES-NI decryption use their own round keys.
+#if ((defined(CBC) && (CBC == 1)) || (defined(ECB) && (ECB == 1))) && (!AES_CONSTANT_TIME || AES_NI)
+  #define AES_DEC_ROUNDKEY 1
+#endif
+
 
 #define AES128 1
 #define AES192 1
@@ -60,6 +86,9 @@ struct AES_ctx
         uint8_t RoundKey128[AES_keyExpSize128];
         #endif
     };
+    #if defined(AES_DEC_ROUNDKEY) && (AES_DEC_ROUNDKEY == 1)
+    uint8_t DecRoundKey[AES_keyExpSize256];
+    #endif
     #if (defined(CBC) && (CBC == 1)) || (defined(CTR) && (CTR == 1))
     uint8_t Iv[AES_BLOCKLEN];
     #endif
@@ -0,0 +1,266 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2026 Adafruit Industries LLC
+//
+// SPDX-License-Identifier: MIT
+
+#include "py/binary.h"
+#include "py/runtime.h"
+#include "py/smallint.h"
+
+#include "shared-bindings/arrayops/__init__.h"
+
+// Bulk operations on the elements of an array, bytearray or memoryview.  Each
+// one dispatches on the typecode to a plain C loop over the elements, which the
+// compiler can vectorise.  Integer arithmetic wraps around like it does in C,
+// including for the sum of a q/Q array.
+
+// Integer typecodes: the element type, the type arithmetic is done in (so that
+// small types don't overflow a signed int), the type the sum is kept in and the
+// function that makes an int object from the sum.
+#if MICROPY_LONGINT_IMPL != MICROPY_LONGINT_IMPL_NONE
+#define ARRAYOPS_LONG_LONG_TYPES(X) \
+    X('q', long long, unsigned long long, long long, arrayops_new_int_from_ll) \
+    X('Q', unsigned long long, unsigned long long, unsigned long long, arrayops_new_int_from_ull)
+#else
+#define ARRAYOPS_LONG_LONG_TYPES(X)
+#endif
+#define ARRAYOPS_INT_TYPES(X) \
+    X(BYTEARRAY_TYPECODE, unsigned char, unsigned int, unsigned long long, arrayops_new_int_from_ull) \
+    X('B', unsigned char, unsigned int, unsigned long long, arrayops_new_int_from_ull) \
+    X('b', signed char, unsigned int, long long, arrayops_new_int_from_ll) \
+    X('H', unsigned short, unsigned int, unsigned long long, arrayops_new_int_from_ull) \
+    X('h', short, unsigned int, long long, arrayops_new_int_from_ll) \
+    X('I', unsigned int, unsigned int, unsigned long long, arrayops_new_int_from_ull) \
+    X('i', int, unsigned int, long long, arrayops_new_int_from_ll) \
+    X('L', unsigned long, unsigned long, unsigned long long, arrayops_new_int_from_ull) \
+    X('l', long, unsigned long, long long, arrayops_new_int_from_ll) \
+    ARRAYOPS_LONG_LONG_TYPES(X)
+
+#if MICROPY_PY_BUILTINS_FLOAT
+#define ARRAYOPS_FLOAT_TYPES(X) \
+    X('f', float) \
+    X('d', double)
+#else
+#define ARRAYOPS_FLOAT_TYPES(X)
+#endif
+
+static mp_obj_t arrayops_new_int_from_ll(long long val) {
+    if ((long long)MP_SMALL_INT_MIN <= val && val <= (long long)MP_SMALL_INT_MAX) {
+        return MP_OBJ_NEW_SMALL_INT((mp_int_t)val);
+    }
+    return mp_obj_new_int_from_ll(val);
+}
+
+static mp_obj_t arrayops_new_int_from_ull(unsigned long long val) {
+    if (val <= (unsigned long long)MP_SMALL_INT_MAX) {
+        return MP_OBJ_NEW_SMALL_INT((mp_int_t)val);
+    }
+    return mp_obj_new_int_from_ull(val);
+}
+
+static size_t arrayops_len(mp_buffer_info_t *bufinfo) {
+    return bufinfo->len / mp_binary_get_size('@', bufinfo->typecode, NULL);
+}
+
+static NORETURN void arrayops_raise_typecode(void) {
+    mp_raise_TypeError_varg(MP_ERROR_TEXT("unsupported %q type"), MP_QSTR_array);
+}
+
+// Converts a value to an element, with the same checks as storing it in the array.
+#define ARRAYOPS_GET_VALUE(type, var, typecode, value_in) \
+    type var; \
+    mp_binary_set_val_array(typecode, &var, 0, value_in)
+
+void shared_module_arrayops_add(mp_buffer_info_t *bufinfo, mp_obj_t value_in) {
+    size_t n = arrayops_len(bufinfo);
+    switch (bufinfo->typecode) {
+        #define X(typecode, type, wtype, acc_type, new_int) \
+    case typecode: { \
+        ARRAYOPS_GET_VALUE(type, v, typecode, value_in); \
+        type *p = bufinfo->buf; \
+        for (size_t i = 0; i < n; ++i) { \
+            p[i] = (wtype)p[i] + (wtype)v; \
+        } \
+        break; \
+    }
+        ARRAYOPS_INT_TYPES(X)
+        #undef X
+        #define X(typecode, type) \
+    case typecode: { \
+        ARRAYOPS_GET_VALUE(type, v, typecode, value_in); \
+        type *p = bufinfo->buf; \
+        for (size_t i = 0; i < n; ++i) { \
+            p[i] += v; \
+        } \
+        break; \
+    }
+        ARRAYOPS_FLOAT_TYPES(X)
+        #undef X
+        default:
+            arrayops_raise_typecode();
+    }
+}
+
+void shared_module_arrayops_scale(mp_buffer_info_t *bufinfo, mp_obj_t value_in) {
+    size_t n = arrayops_len(bufinfo);
+    switch (bufinfo->typecode) {
+        #define X(typecode, type, wtype, acc_type, new_int) \
+    case typecode: { \
+        ARRAYOPS_GET_VALUE(type, v, typecode, value_in); \
+        type *p = bufinfo->buf; \
+        for (size_t i = 0; i < n; ++i) { \
+            p[i] = (wtype)p[i] * (wtype)v; \
+        } \
+        break; \
+    }
+        ARRAYOPS_INT_TYPES(X)
+        #undef X
+        #define X(typecode, type) \
+    case typecode: { \
+        ARRAYOPS_GET_VALUE(type, v, typecode, value_in); \
+        type *p = bufinfo->buf; \
+        for (size_t i = 0; i < n; ++i) { \
+            p[i] *= v; \
+        } \
+        break; \
+    }
+        ARRAYOPS_FLOAT_TYPES(X)
+        #undef X
+        default:
+            arrayops_raise_typecode();
+    }
+}
+
+void shared_module_arrayops_clamp(mp_buffer_info_t *bufinfo, mp_obj_t lo_in, mp_obj_t hi_in) {
+    size_t n = arrayops_len(bufinfo);
+    switch (bufinfo->typecode) {
+        #define X(typecode, type, ...) \
+    case typecode: { \
+        ARRAYOPS_GET_VALUE(type, lo, typecode, lo_in); \
+        ARRAYOPS_GET_VALUE(type, hi, typecode, hi_in); \
+        if (lo > hi) { \
+            mp_raise_ValueError_varg(MP_ERROR_TEXT("%q must be <= %q"), MP_QSTR_lo, MP_QSTR_hi); \
+        } \
+        type *p = bufinfo->buf; \
+        for (size_t i = 0; i < n; ++i) { \
+            type x = p[i]; \
+            x = x < lo ? lo : x; \
+            p[i] = x > hi ? hi : x; \
+        } \
+        break; \
+    }
+        ARRAYOPS_INT_TYPES(X)
+        ARRAYOPS_FLOAT_TYPES(X)
+        #undef X
+        default:
+            arrayops_raise_typecode();
+    }
+}
+
+static void arrayops_swap_bytes(void *buf, size_t n, size_t size) {
+    switch (size) {
+        case 1:
+            break;
+        case 2: {
+            uint16_t *p = buf;
+            for (size_t i = 0; i < n; ++i) {
+                p[i] = p[i] << 8 | p[i] >> 8;
+            }
+            break;
+        }
+        case 4: {
+            uint32_t *p = buf;
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t x = p[i];
+                x = (x & 0x00ff00ff) << 8 | (x >> 8 & 0x00ff00ff);
+                p[i] = x << 16 | x >> 16;
+            }
+            break;
+        }
+        case 8: {
+            uint64_t *p = buf;
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t x = p[i];
+                x = (x & 0x00ff00ff00ff00ff) << 8 | (x >> 8 & 0x00ff00ff00ff00ff);
+                x = (x & 0x0000ffff0000ffff) << 16 | (x >> 16 & 0x0000ffff0000ffff);
+                p[i] = x << 32 | x >> 32;
+            }
+            break;
+        }
+    }
+}
+
+void shared_module_arrayops_byteswap(mp_buffer_info_t *bufinfo) {
+    size_t n = arrayops_len(bufinfo);
+    // only numbers can be swapped, not the object pointers of an 'O' array
+    switch (bufinfo->typecode) {
+        #define X(typecode, type, ...) \
+    case typecode: \
+        arrayops_swap_bytes(bufinfo->buf, n, sizeof(type)); \
+        break;
+        ARRAYOPS_INT_TYPES(X)
+        ARRAYOPS_FLOAT_TYPES(X)
+        #undef X
+        default:
+            arrayops_raise_typecode();
+    }
+}
+
+mp_obj_t shared_module_arrayops_sum(mp_buffer_info_t *bufinfo) {
+    size_t n = arrayops_len(bufinfo);
+    switch (bufinfo->typecode) {
+        #define X(typecode, type, wtype, acc_type, new_int) \
+    case typecode: { \
+        const type *p = bufinfo->buf; \
+        acc_type sum = 0; \
+        for (size_t i = 0; i < n; ++i) { \
+            sum += p[i]; \
+        } \
+        return new_int(sum); \
+    }
+        ARRAYOPS_INT_TYPES(X)
+        #undef X
+        #define X(typecode, type) \
+    case typecode: { \
+        const type *p = bufinfo->buf; \
+        mp_float_t sum = 0; \
+        for (size_t i = 0; i < n; ++i) { \
+            sum += (mp_float_t)p[i]; \
+        } \
+        return mp_obj_new_float(sum); \
+    }
+        ARRAYOPS_FLOAT_TYPES(X)
+        #undef X
+        default:
+            arrayops_raise_typecode();
+    }
+}
+
+mp_obj_t shared_module_arrayops_minmax(mp_buffer_info_t *bufinfo) {
+    size_t n = arrayops_len(bufinfo);
+    if (n == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("arg is an empty sequence"));
+    }
+    switch (bufinfo->typecode) {
+        #define X(typecode, type, ...) \
+    case typecode: { \
+        const type *p = bufinfo->buf; \
+        type mm[2] = {p[0], p[0]}; \
+        for (size_t i = 1; i < n; ++i) { \
+            mm[0] = p[i] < mm[0] ? p[i] : mm[0]; \
+            mm[1] = p[i] > mm[1] ? p[i] : mm[1]; \
+        } \
+        mp_obj_t items[2] = { \
+            mp_binary_get_val_array(typecode, mm, 0), \
+            mp_binary_get_val_array(typecode, mm, 1), \
+        }; \
+        return mp_obj_new_tuple(2, items); \
+    }
+        ARRAYOPS_INT_TYPES(X)
+        ARRAYOPS_FLOAT_TYPES(X)
+        #undef X
+        default:
+            arrayops_raise_typecode();
+    }
+}
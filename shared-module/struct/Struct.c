@@ -0,0 +1,100 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2016 Paul Sokolovsky
+// SPDX-FileCopyrightText: Copyright (c) 2017 Scott Shawcroft for Adafruit Industries
+// SPDX-FileCopyrightText: Copyright (c) 2017 Michael McWethy
+//
+// SPDX-License-Identifier: MIT
+#include <string.h>
+
+#include "py/runtime.h"
+#include "shared-bindings/struct/Struct.h"
+
+static void struct_validate_format(char fmt) {
+    #if MICROPY_NONSTANDARD_TYPECODES
+    if (fmt == 'S' || fmt == 'O') {
+        mp_raise_RuntimeError(MP_ERROR_TEXT("'S' and 'O' are not supported format types"));
+    }
+    #endif
+}
+
+struct_struct_obj_t *common_hal_struct_struct_new(mp_obj_t format) {
+    for (const char *fmt = mp_obj_str_get_str(format); *fmt; fmt++) {
+        struct_validate_format(*fmt);
+    }
+    return mp_struct_new(&struct_struct_type, format);
+}
+
+mp_obj_t common_hal_struct_struct_get_format(struct_struct_obj_t *self) {
+    return self->format;
+}
+
+size_t common_hal_struct_struct_get_size(struct_struct_obj_t *self) {
+    return self->size;
+}
+
+// Returns a pointer into the buffer at the given offset, which may be negative
+// to count from the end.
+static byte *struct_get_ptr(mp_buffer_info_t *bufinfo, mp_int_t offset) {
+    if (offset < 0) {
+        // negative offsets are relative to the end of the buffer
+        offset = (mp_int_t)bufinfo->len + offset;
+        if (offset < 0) {
+            mp_raise_RuntimeError(MP_ERROR_TEXT("Buffer too small"));
+        }
+    }
+    if ((size_t)offset > bufinfo->len) {
+        mp_raise_RuntimeError(MP_ERROR_TEXT("Buffer too small"));
+    }
+    return (byte *)bufinfo->buf + offset;
+}
+
+mp_obj_t common_hal_struct_struct_pack(struct_struct_obj_t *self, size_t n_args, const mp_obj_t *args) {
+    (void)mp_arg_validate_length(n_args, self->num_items, MP_QSTR_values);
+    vstr_t vstr;
+    vstr_init_len(&vstr, self->size);
+    byte *p = (byte *)vstr.buf;
+    memset(p, 0, self->size);
+    mp_struct_pack_into_internal(self, p, n_args, args);
+    return mp_obj_new_bytes_from_vstr(&vstr);
+}
+
+void common_hal_struct_struct_pack_into(struct_struct_obj_t *self, mp_obj_t buffer, mp_int_t offset, size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_WRITE);
+    byte *p = struct_get_ptr(&bufinfo, offset);
+    if (self->size > bufinfo.len - (p - (byte *)bufinfo.buf)) {
+        mp_raise_RuntimeError(MP_ERROR_TEXT("Buffer too small"));
+    }
+    (void)mp_arg_validate_length(n_args, self->num_items, MP_QSTR_values);
+    mp_struct_pack_into_internal(self, p, n_args, args);
+}
+
+mp_obj_t common_hal_struct_struct_unpack_from(struct_struct_obj_t *self, mp_obj_t buffer, mp_int_t offset, bool exact_size) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_READ);
+    byte *p = struct_get_ptr(&bufinfo, offset);
+    size_t len = bufinfo.len - (p - (byte *)bufinfo.buf);
+
+    // If exact_size, make sure the buffer is exactly the right size.
+    // Otherwise just make sure it's big enough.
+    if (exact_size) {
+        if (self->size != len) {
+            mp_raise_RuntimeError(MP_ERROR_TEXT("buffer size must match format"));
+        }
+    } else {
+        if (self->size > len) {
+            mp_raise_RuntimeError(MP_ERROR_TEXT("buffer too small"));
+        }
+    }
+    return mp_struct_unpack_internal(self, p);
+}
+
+mp_obj_t common_hal_struct_struct_iter_unpack(struct_struct_obj_t *self, mp_obj_t buffer) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_READ);
+    if (self->size == 0 || bufinfo.len % self->size != 0) {
+        mp_raise_RuntimeError(MP_ERROR_TEXT("buffer size must be a multiple of the format size"));
+    }
+    return mp_struct_iter_unpack_new(self, buffer);
+}
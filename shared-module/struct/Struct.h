@@ -0,0 +1,13 @@
+// This file is part of the CircuitPython project: https://circuitpython.org
+//
+// SPDX-FileCopyrightText: Copyright (c) 2017 Scott Shawcroft for Adafruit Industries
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "py/modstruct.h"
+
+// The parsed format is the same as that of py/modstruct.c, which packs and
+// unpacks the records.
+typedef mp_obj_struct_t struct_struct_obj_t;
@@ -5,6 +5,4 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
-char get_fmt_type(const char **fmt);
-mp_uint_t get_fmt_num(const char **p);
-mp_uint_t calcsize_items(const char *fmt);
+#include "shared-module/struct/Struct.h"
@@ -105,6 +105,9 @@ static int parse_compile_execute(const void *source, mp_parse_input_kind_t input
                 mp_module_context_t *ctx = m_new_obj(mp_module_context_t);
                 ctx->module.globals = mp_globals_get();
                 ctx->constants = frozen->constants;
+                #if MICROPY_OPT_INLINE_CACHE
+                ctx->inline_cache = NULL;
+                #endif
                 module_fun = mp_make_function_from_proto_fun(frozen->proto_fun, ctx, NULL);
             } else
             #endif
@@ -130,8 +133,7 @@ static int parse_compile_execute(const void *source, mp_parse_input_kind_t input
                 }
                 #endif
 
-                mp_parse_tree_t parse_tree = mp_parse(lex, input_kind);
-                module_fun = mp_compile(&parse_tree, source_name, exec_flags & EXEC_FLAG_IS_REPL);
+                module_fun = mp_parse_compile(lex, input_kind, exec_flags & EXEC_FLAG_IS_REPL);
                 #else
                 mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("script compilation not supported"));
                 #endif
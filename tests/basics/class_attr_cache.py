@@ -0,0 +1,84 @@
+# test that attribute and method lookups repeated at the same place in the
+# code see changes to instances, classes and globals
+
+class A:
+    def f(self):
+        return "A.f"
+
+class B(A):
+    def g(self):
+        return "B.g"
+
+def lookup(o):
+    return o.f(), o.g()
+
+def load(o):
+    return o.x
+
+b = B()
+print(lookup(b))
+print(lookup(b))
+
+# instance member shadows a method
+b.g = lambda: "b.g"
+print(lookup(b))
+del b.g
+print(lookup(b))
+
+# method redefined, and inherited method overridden, after being looked up
+B.g = lambda self: "B.g2"
+B.f = lambda self: "B.f"
+print(lookup(b))
+del B.f
+print(lookup(b))
+
+# same call site used for different types
+print(lookup(b), lookup(B()))
+a = A()
+a.g = lambda: "a.g"
+print(lookup(a), lookup(b))
+
+# stores and deletes
+b.x = 1
+print(load(b))
+b.x = 2
+print(load(b))
+del b.x
+try:
+    load(b)
+except AttributeError:
+    print("AttributeError")
+b.y = 3
+b.x = 4
+print(load(b))
+
+# property added to a class after a store
+class C:
+    pass
+
+def store(o, v):
+    o.x = v
+
+c = C()
+store(c, 1)
+print(c.x)
+C.x = property(lambda self: "prop", lambda self, v: print("set", v))
+store(c, 2)
+
+# globals
+def glob():
+    return G
+
+G = 1
+print(glob())
+G = 2
+print(glob())
+del G
+try:
+    glob()
+except NameError:
+    print("NameError")
+len = lambda x: "len"
+print(len([]))
+del len
+print(len([]))
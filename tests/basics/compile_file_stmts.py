@@ -0,0 +1,58 @@
+# test compiling file input with many top-level statements, which may be compiled
+# one statement at a time, sharing constants, names and child functions between them
+
+try:
+    exec
+except NameError:
+    print("SKIP")
+    raise SystemExit
+
+src = """
+x = 3
+s = 'abc'
+def f(a):
+    return a * x
+g = lambda: s + 'd'
+class A:
+    y = x
+    def m(self):
+        return self.y + f(2)
+if x > 2:
+    z = [f(i) for i in range(3)]
+else:
+    z = None
+for i in range(3):
+    if i == 1:
+        continue
+    x += i
+try:
+    1 / 0
+except ZeroDivisionError:
+    w = 'zde'
+finally:
+    v = s * 2
+def gen():
+    yield from range(x)
+"""
+
+# a large number of statements and functions
+for i in range(200):
+    src += "def h{}(): return {} + x\n".format(i, i)
+src += "h = [h{}() for h{} in [h{}]]\n".format(199, 199, 199)
+
+d = {}
+exec(src, d)
+print(d["x"], d["s"], d["f"](2), d["g"](), d["A"]().m(), d["z"], d["w"], d["v"])
+print(list(d["gen"]()), d["h"], d["h0"](), d["h150"]())
+
+# a syntax error after a compile error takes precedence
+try:
+    exec("x = 1\nreturn\ny = (\n")
+except SyntaxError as er:
+    print("SyntaxError")
+
+# a compile error in a later statement
+try:
+    exec("x = 1\ndef f():\n    nonlocal q\n")
+except SyntaxError:
+    print("SyntaxError")
@@ -0,0 +1,84 @@
+# test that dicts keep their insertion order, which MicroPython only does
+# when maps use the compact layout
+
+d = {}
+for i in range(20):
+    d[(i * 7) % 20] = i
+if list(d) != [(i * 7) % 20 for i in range(20)]:
+    print("SKIP")
+    raise SystemExit
+
+# deleting and adding again moves a key to the end
+d = {"a": 1, "b": 2, "c": 3, 4: 4, 5.0: 5}
+del d["b"]
+d["b"] = 6
+d["a"] = 7
+print(list(d.items()))
+
+# popitem removes the most recently added item
+print(d.popitem(), d.popitem(), list(d))
+
+# order is kept as a dict grows past the size where it gets an index,
+# and as its index grows past 8 bits
+for n in (5, 9, 100, 300):
+    d = {}
+    for i in range(n):
+        d[str(n - i)] = i
+    for i in range(0, n, 3):
+        del d[str(n - i)]
+    d["x"] = -1
+    keys = list(d)
+    print(n, len(d), keys[:3], keys[-3:], list(d.values())[-3:])
+    print(d.copy() == d, list(d.copy()) == keys, list(dict(d)) == keys)
+
+# emptying a dict by popitem
+d = {i: str(i) for i in range(50)}
+while len(d) > 1:
+    d.popitem()
+print(d)
+
+
+# keys with a custom hash and equality
+class K:
+    def __init__(self, v):
+        self.v = v
+
+    def __hash__(self):
+        return self.v % 3
+
+    def __eq__(self, other):
+        return self.v == other.v
+
+    def __repr__(self):
+        return "K(%d)" % self.v
+
+
+d = {}
+for n in (4, 20):
+    for i in range(n):
+        d[K(i)] = i
+    del d[K(1)]
+    d[K(1)] = "one"
+    print(list(d.items())[:3], d[K(1)], d[K(n - 1)], K(n) in d)
+
+
+# looking up a key only compares it with keys that have the same hash
+class E:
+    calls = 0
+
+    def __init__(self, v):
+        self.v = v
+
+    def __hash__(self):
+        return self.v
+
+    def __eq__(self, other):
+        E.calls += 1
+        return isinstance(other, E) and self.v == other.v
+
+
+d = {E(i): i for i in range(6)}
+print([d[E(i)] for i in range(6)], E.calls)
+d = {"a": 1, "b": 2, "c": 3}
+E.calls = 0
+print(E(4) in d, E.calls)
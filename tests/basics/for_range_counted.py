@@ -0,0 +1,84 @@
+# test for-range loops, which the bytecode compiler may turn into counted loops
+
+
+def ranges(a, b, c):
+    r = []
+    for i in range(a):
+        r.append(i)
+    for i in range(a, b):
+        r.append(i)
+    for i in range(a, b, c):
+        r.append(i)
+    for i in range(b, a, -c):
+        r.append(i)
+    return r
+
+
+print(ranges(3, 10, 3))
+print(ranges(0, 0, 1))
+print(ranges(-2, 2, 1))
+print(ranges(5, -5, -2))
+
+# a step of zero is an error
+try:
+    ranges(1, 2, 0)
+except ValueError:
+    print("ValueError")
+
+# non-int arguments
+try:
+    for i in range("a"):
+        pass
+except TypeError:
+    print("TypeError")
+
+
+# values at the limit of a 32-bit small int, where the counter may overflow
+def near_limit():
+    n = 0
+    for i in range(0x3FFFFFFF - 2, 0x3FFFFFFF, 3):
+        n += 1
+    for i in range(-0x3FFFFFFF + 1, -0x3FFFFFFF - 1, -3):
+        n += 1
+    return n
+
+
+print(near_limit())
+
+
+# break, continue and else
+def control(n):
+    r = []
+    for i in range(n):
+        if i == 1:
+            continue
+        if i == 4:
+            break
+        r.append(i)
+    else:
+        r.append("else")
+    return r
+
+
+print(control(3), control(10))
+
+
+# nested loops
+def nested(n):
+    r = []
+    for i in range(n):
+        for j in range(i, n):
+            r.append((i, j))
+    return r
+
+
+print(nested(3))
+
+
+# a for-range loop in a generator
+def gen(n):
+    for i in range(0, n, 2):
+        yield i
+
+
+print(list(gen(7)))
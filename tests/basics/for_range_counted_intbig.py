@@ -0,0 +1,53 @@
+# test for-range loops with bounds that don't fit in a small int
+
+
+def up(a, b):
+    r = []
+    for i in range(a, b):
+        r.append(i)
+    return r
+
+
+def down(a, b):
+    r = []
+    for i in range(a, b, -1):
+        r.append(i)
+    return r
+
+
+# crossing the small-int limit on 32-bit and 64-bit targets
+for n in (30, 62):
+    print(up(2**n - 3, 2**n + 2))
+    print(down(-(2**n) + 2, -(2**n) - 3))
+print(up(2**100, 2**100 + 2))
+print(up(-(2**100), -(2**100) + 2))
+
+# steps that would overflow a machine word
+r = []
+for i in range(0, 2**63 - 1, 2**61):
+    r.append(i)
+print(r)
+r = []
+for i in range(0, -(2**63) + 1, -(2**61)):
+    r.append(i)
+print(r)
+r = []
+for i in range(2**64, 2**64 + 10, 3):
+    r.append(i)
+print(r)
+r = []
+for i in range(2**62 - 2, 2**62 + 100, 64):
+    r.append(i)
+print(r)
+
+# break and else with big bounds
+for i in range(2**64, 2**64 + 10):
+    if i == 2**64 + 3:
+        print("break", i)
+        break
+else:
+    print("else")
+for i in range(2**64, 2**64 + 2):
+    pass
+else:
+    print("else", i)
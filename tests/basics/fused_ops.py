@@ -0,0 +1,128 @@
+# test opcode sequences that the bytecode compiler may fuse into a single opcode
+
+
+class Cmp:
+    def __init__(self, v):
+        self.v = v
+
+    def __lt__(self, other):
+        print("lt", self.v, other)
+        # a non-bool result must be tested for truth
+        return [1] if self.v < other else []
+
+    def __isub__(self, other):
+        print("isub", other)
+        return Cmp(self.v - other)
+
+    def __iadd__(self, other):
+        print("iadd", other)
+        return Cmp(self.v + other)
+
+
+# compare and jump, for each comparison op and both jump directions
+def compare(a, b):
+    r = []
+    if a < b:
+        r.append("<")
+    if a > b:
+        r.append(">")
+    if a == b:
+        r.append("==")
+    if a <= b:
+        r.append("<=")
+    if a >= b:
+        r.append(">=")
+    if a != b:
+        r.append("!=")
+    if not a < b:
+        r.append("!<")
+    return r
+
+
+for a, b in ((1, 2), (2, 1), (3, 3), (-5, 2), ("a", "b"), ((1, 2), (1, 2))):
+    print(a, b, compare(a, b))
+
+if Cmp(1) < 2:
+    print("yes")
+if not Cmp(3) < 2:
+    print("no")
+try:
+    compare(1, "a")
+except TypeError:
+    print("TypeError")
+
+
+# while loop with a compare-and-jump back to the top
+def count(n):
+    i = 0
+    total = 0
+    while i < n:
+        total += i
+        i += 1
+    return i, total
+
+
+print(count(0), count(10))
+
+x = Cmp(0)
+while x < 2:
+    x += 1
+
+
+# optimised range loops, with constant and non-constant end values
+def ranges(n):
+    r = []
+    for i in range(5):
+        r.append(i)
+    for i in range(3, -3, -2):
+        r.append(i)
+    for i in range(n):
+        r.append(i)
+    for i in range(n, 0, -1):
+        r.append(i)
+    for i in range(1000, 1003):
+        r.append(i)
+    return r
+
+
+print(ranges(3))
+print(ranges(0))
+
+
+# increment of a local by a constant
+def incr(x):
+    x += 1
+    x -= 2
+    x += 1000
+    x -= -3
+    return x
+
+
+print(incr(1), incr(-1000))
+print(incr(Cmp(0)).v)
+
+
+# pairs of local loads, including an unbound local
+def pair(a, b):
+    print(a, b)
+    if a:
+        c = 1
+    return b, c
+
+
+print(pair(1, 2))
+try:
+    pair(0, 2)
+except NameError:
+    print("NameError")
+
+
+def unbound_incr():
+    x += 1
+    x = 0
+
+
+try:
+    unbound_incr()
+except NameError:
+    print("NameError")
@@ -0,0 +1,31 @@
+# test multiplication and division of large integers, of sizes where faster
+# algorithms than schoolbook may be used
+
+
+def check(a, b):
+    p = a * b
+    print(p.bit_length(), p % 1000000007, p // b == a, p % b)
+    q, r = divmod(a, b)
+    print(q.bit_length(), q % 1000000007, r % 1000000007, q * b + r == a)
+
+
+for n in (500, 1000, 1023, 1024, 1025, 2047, 4000, 10000):
+    a = 3**n - 1
+    b = (1 << n) + 12345
+    check(a, b)
+    check(a * a, b)
+    check(a, a + 1)
+    check(a * a * a, -b)
+    check(-(a**2), 7**n)
+
+# all-ones digits, which give the largest intermediate carries
+m = (1 << 8000) - 1
+check(m, m)
+check(m * m, m)
+check(m * m, (1 << 5000) - 1)
+check(m * (1 << 3000), (1 << 3000) + 1)
+print(m * m == (1 << 16000) - (1 << 8001) + 1)
+
+# very unbalanced sizes
+check(7**5000, 11**100)
+check(7**5000, 11**1400)
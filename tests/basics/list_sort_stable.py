@@ -0,0 +1,95 @@
+# test that list.sort and sorted() are stable, and call the key function once per element
+
+n_key = 0
+
+
+def key(x):
+    global n_key
+    n_key += 1
+    return x[0]
+
+
+sorted([(3,), (2,), (1,), (0,)], key=key)
+if n_key != 4:
+    print("SKIP")
+    raise SystemExit
+
+# equal keys keep their original order, also when reversed
+l = [(i % 3, i) for i in range(12)]
+print(sorted(l, key=key))
+print(sorted(l, key=key, reverse=True))
+print(n_key)
+l.sort(key=lambda x: x[0] // 2)
+print(l)
+
+
+# equal elements keep their original order, also when reversed
+class A:
+    def __init__(self, k, v):
+        self.k = k
+        self.v = v
+
+    def __lt__(self, other):
+        return self.k < other.k
+
+    def __repr__(self):
+        return "%d%s" % (self.k, self.v)
+
+
+l = [A(i % 4, chr(97 + i)) for i in range(12)]
+print(sorted(l))
+print(sorted(l, reverse=True))
+
+# already sorted, reverse sorted, and nearly sorted inputs
+for l in (list(range(300)), list(range(300, 0, -1)), list(range(200)) + list(range(100))):
+    l2 = sorted(l)
+    print(len(l2), l2[0], l2[-1], all(l2[i] <= l2[i + 1] for i in range(len(l2) - 1)))
+l = [i // 3 for i in range(100)] + [i // 3 for i in range(100, 0, -1)] + [50] * 10 + list(range(70))
+print(sorted(l) == sorted(l, key=lambda x: x) == sorted(l, reverse=True)[::-1])
+
+
+# an exception in a comparison leaves all the elements in the list
+class B:
+    n = 0
+
+    def __init__(self, v):
+        self.v = v
+
+    def __lt__(self, other):
+        B.n -= 1
+        if B.n == 0:
+            raise ValueError
+        return self.v < other.v
+
+
+l = [B(i * 37 % 101) for i in range(101)] + [B(i) for i in range(101)]
+values = sorted(x.v for x in l)
+for n in (1, 50, 200, 400, 800):
+    B.n = n
+    try:
+        l.sort()
+    except ValueError:
+        print("ValueError")
+    print(sorted(x.v for x in l) == values)
+
+
+# a comparison that changes the list doesn't affect the sort, but is reported
+class C:
+    def __init__(self, v, l, op):
+        self.v = v
+        self.l = l
+        self.op = op
+
+    def __lt__(self, other):
+        self.op(self.l, self)
+        return self.v < other.v
+
+
+for op in (list.append, lambda l, x: l.clear(), lambda l, x: l.extend(range(100))):
+    l = []
+    l.extend(C(i, l, op) for i in range(20, 0, -1))
+    try:
+        l.sort()
+    except ValueError:
+        print("ValueError")
+    print(len(l), [x.v for x in l])
@@ -0,0 +1,65 @@
+# test struct.Struct, which parses its format once
+
+try:
+    import struct
+
+    struct.Struct
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+s = struct.Struct("<HhIb3xs2H")
+print(s.format, s.size)
+data = s.pack(1, -2, 0x12345678, -3, b"a", 4, 5)
+print(data)
+print(s.unpack(data))
+print(s.unpack_from(b"xy" + data, 2))
+print(s.unpack_from(b"xy" + data, -s.size))
+
+buf = bytearray(s.size + 4)
+s.pack_into(buf, 4, 1, 2, 3, 4, b"b", 6, 7)
+print(buf)
+s.pack_into(buf, -s.size, 8, 9, 10, 11, b"c", 12, 13)
+print(buf)
+
+# native alignment
+s = struct.Struct("bi0sh")
+print(s.size == struct.calcsize("bi0sh"), s.unpack(s.pack(1, 2, b"", 3)))
+
+# empty format
+s = struct.Struct("")
+print(s.size, s.pack(), s.unpack(b""))
+
+# iter_unpack, from the Struct and the module
+s = struct.Struct(">hB")
+for values in s.iter_unpack(bytes(range(9))):
+    print(values)
+print(list(struct.iter_unpack("<H", b"\x01\x02\x03\x04")))
+
+# the format is parsed when the Struct is created
+try:
+    struct.Struct("z")
+except Exception:
+    print("Exception")
+
+# wrong number of values, or buffer too small
+try:
+    struct.Struct("<2H").pack(1)
+except Exception:
+    print("Exception")
+try:
+    struct.Struct("<2H").unpack_from(b"123")
+except Exception:
+    print("Exception")
+try:
+    struct.Struct("<2H").pack_into(bytearray(5), 2, 1, 2)
+except Exception:
+    print("Exception")
+try:
+    struct.Struct("<2H").iter_unpack(b"12345")
+except Exception:
+    print("Exception")
+
+# the module-level functions still work after switching between formats
+for fmt in ("<I", "<h", "<I"):
+    print(struct.unpack(fmt, struct.pack(fmt, 7)), struct.calcsize(fmt))
@@ -141,3 +141,39 @@ for i in range(0, len(plaintext), 16):
     output = memoryview(plaintext)[i : i + 16]
     print(str(hexlify(output), ""))
 print()
+
+print("bulk")
+# Whole buffers at once, which go through several blocks per call.
+# CBC-AES256 and CTR-AES256 test vectors from NIST Special Publication 800-38A,
+# 2001 edition, p28 and p57
+
+plaintext = unhexlify(
+    "6bc1bee22e409f96e93d7e117393172a"
+    "ae2d8a571e03ac9c9eb76fac45af8e51"
+    "30c81c46a35ce411e5fbc1191a0a52ef"
+    "f69f2445df4f9b17ad2b417be66c3710"
+)
+
+key = unhexlify("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4")
+iv = unhexlify("000102030405060708090a0b0c0d0e0f")
+counter = unhexlify("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff")
+for mode, iv in ((aesio.MODE_CBC, iv), (aesio.MODE_CTR, counter)):
+    cyphertext = bytearray(len(plaintext))
+    aesio.AES(key, mode, IV=iv).encrypt_into(plaintext, cyphertext)
+    print(str(hexlify(cyphertext), ""))
+    output = bytearray(len(plaintext))
+    aesio.AES(key, mode, IV=iv).decrypt_into(cyphertext, output)
+    print(output == plaintext)
+print()
+
+# Round trips of more blocks than are processed together, with a 192-bit key.
+plaintext = bytes(range(16 * 9 + 5))
+key = unhexlify("8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b")
+for mode, length in ((aesio.MODE_CBC, 16 * 9), (aesio.MODE_CTR, 16 * 9 + 5)):
+    cyphertext = bytearray(length)
+    aesio.AES(key, mode, IV=counter).encrypt_into(plaintext[:length], cyphertext)
+    print(str(hexlify(cyphertext[-16:]), ""))
+    output = bytearray(length)
+    aesio.AES(key, mode, IV=counter).decrypt_into(cyphertext, output)
+    print(output == plaintext[:length])
+print()
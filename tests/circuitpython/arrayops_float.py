@@ -0,0 +1,16 @@
+# test the arrayops module's bulk operations on float arrays
+
+try:
+    import array
+    import arrayops
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+for typecode in "fd":
+    a = array.array(typecode, [0.5, -1.5, 2.0, 8.25, -4.0])
+    arrayops.add(a, 1)
+    arrayops.scale(a, 2)
+    print(a, arrayops.sum(a), arrayops.minmax(a))
+    arrayops.clamp(a, -1, 10)
+    print(a, arrayops.sum(a), arrayops.minmax(a))
@@ -0,0 +1,69 @@
+# test the arrayops module's bulk operations on array, bytearray and memoryview
+
+try:
+    import array
+    import arrayops
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+for typecode in "bBhHiIlL":
+    a = array.array(typecode, [0, 1, 2, 3, 100, 50, 7, 8, 9, 10])
+    arrayops.add(a, 3)
+    arrayops.scale(a, 2)
+    print(a, arrayops.sum(a), arrayops.minmax(a))
+    arrayops.clamp(a, 10, 100)
+    print(a, arrayops.sum(a), arrayops.minmax(a))
+
+# integer arithmetic wraps around
+a = array.array("b", [100, -100, 127])
+arrayops.add(a, 100)
+print(a)
+a = array.array("H", [0x8000, 0xFFFF])
+arrayops.scale(a, 3)
+print(a)
+
+# sums don't wrap for small types
+print(arrayops.sum(array.array("B", 1000 * [255])), arrayops.sum(array.array("h", 1000 * [-32768])))
+
+# bytearray, bytes, and memoryview slices
+b = bytearray(b"\x01\x02\xfe\xff")
+arrayops.add(b, 1)
+print(b, arrayops.sum(b), arrayops.minmax(b))
+print(arrayops.sum(b"abc"), arrayops.minmax(b"abc"))
+m = memoryview(array.array("i", range(-10, 10)))
+print(arrayops.sum(m[2:5]), arrayops.minmax(m[15:]))
+arrayops.clamp(m[:10], -5, 5)
+print(list(m))
+
+# byteswap
+a = array.array("H", [0x0102, 0xAABB])
+arrayops.byteswap(a)
+print([hex(x) for x in a])
+a = array.array("i", [0x01020304, -2])
+arrayops.byteswap(a)
+print([hex(x) for x in a])
+b = bytearray(b"123")
+arrayops.byteswap(b)
+print(b)
+
+# errors
+def test(f, *args):
+    try:
+        f(*args)
+    except Exception as e:
+        print(type(e).__name__)
+
+
+test(arrayops.add, array.array("B", [1]), 256)
+test(arrayops.add, array.array("B", [1]), -1)
+test(arrayops.add, b"abc", 1)
+test(arrayops.clamp, array.array("h", [1]), 5, 1)
+test(arrayops.minmax, array.array("h"))
+test(arrayops.sum, 1)
+
+# object and pointer arrays can't be swapped
+a = array.array("O", [None, 1])
+test(arrayops.byteswap, a)
+print(a)
+test(arrayops.byteswap, array.array("P", [1]))
@@ -0,0 +1,24 @@
+# binascii.crc32 shares lib/uzlib/crc32.c with zlib, which CircuitPython builds
+# as a separate object.  Check every path through it: short tails, 8-byte
+# slices and long runs, at each alignment, in one go and in pieces.
+try:
+    import binascii
+
+    binascii.crc32
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+data = bytes((i * 197 + 11) & 0xFF for i in range(1100))
+
+for n in range(0, 41):
+    print(n, hex(binascii.crc32(data[:n])))
+
+for start in range(8):
+    for n in (63, 64, 65, 255, 256, 1024):
+        print(start, n, hex(binascii.crc32(data[start : start + n])))
+
+crc = 0
+for i in range(0, len(data), 37):
+    crc = binascii.crc32(data[i : i + 37], crc)
+print(crc == binascii.crc32(data), hex(crc))
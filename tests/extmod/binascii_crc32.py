@@ -19,6 +19,12 @@ print(hex(binascii.crc32(b" over the lazy dog", binascii.crc32(b"The quick brown
 print(hex(binascii.crc32(b"\x00" * 16, binascii.crc32(b"\x00" * 16))))
 print(hex(binascii.crc32(b"\xff" * 16, binascii.crc32(b"\xff" * 16))))
 print(hex(binascii.crc32(bytes(range(16, 32)), binascii.crc32(bytes(range(16))))))
+
+# lengths and alignments either side of the block sizes used by the fast paths
+data = bytes((i * 131 + 7) & 0xFF for i in range(300))
+for n in (7, 8, 9, 15, 16, 17, 63, 64, 65, 79, 128, 200, 299):
+    print(n, hex(binascii.crc32(data[1 : n + 1])), hex(binascii.crc32(data[n:], n)))
+
 # CIRCUITPY-CHANGE
 try:
     binascii.crc32("")
@@ -152,3 +152,13 @@ for wbits in range(5, 10):
 # at the start of the bytes.
 compressed = compress(b"1234567890abcdefghijklmnopqrstuvwxyz123123", deflate.RAW)
 print(len(compressed), compressed)
+
+# Compression levels 1-9 use hash chains to find matches, all of them should
+# round trip, and the highest level should still pick the closest match.
+data = bytes(buf) * 2 + b"1234567890" * 50
+for level in range(10):
+    result = compress(data, deflate.RAW, 10, False, level)
+    print(level, decompress(result, deflate.RAW, 10) == data)
+print(compress(b"1234567890abcdefghijklmnopqrstuvwxyz123123", deflate.RAW, 0, False, 9) == compressed)
+compress_error(unpacked, deflate.RAW, 0, False, -1)
+compress_error(unpacked, deflate.RAW, 0, False, 10)
@@ -1,10 +1,18 @@
+# Patterns which used to overflow the C stack, or take exponential time,
+# when run with a backtracking matcher.
 try:
     import re
 except ImportError:
     print("SKIP")
     raise SystemExit
 
-try:
-    re.match("(a*)*", "aaa")
-except RuntimeError:
-    print("RuntimeError")
+print(re.match("(a*)*", "aaa").group(0))
+print(re.match("(a|aa)*b", "a" * 40))
+print(re.search("(a|aa)*b", "a" * 40 + "b").group(0) == "a" * 40 + "b")
+
+# Long subjects, too long for the fast path.
+s = "x" * 2000 + "a" * 2000
+print(re.match("(x|y)*a+", s).group(0) == s)
+print(re.search("ab", s))
+print(len(re.search("a+", s).group(0)))
+print(re.sub("xx", "y", s).count("y"))
@@ -1,8 +1,12 @@
 # Test that integers format to exact values.
 # This test requires at least 32-bit floats (won't work with 30-bit).
 
+# Whether floats are single precision, which overflows at about 3.4e38.
+single_precision = float("1e39") == float("inf")
+
 # Check that powers of 10 (that fit in float32) format correctly.
 for i in range(31):
-    # It works to 12 digits on all platforms *except* qemu-arm, where
-    # 10^11 comes out as 10000000820 or something.
-    print(i, "{:.7g}".format(float("1e" + str(i))))
+    # Above 10^10 they are not exact in float32, and the nearest float32 may
+    # differ from the power of 10 in the 7th digit, eg 10^28.
+    fmt = "{:.6g}" if single_precision and i > 10 else "{:.7g}"
+    print(i, fmt.format(float("1e" + str(i))))
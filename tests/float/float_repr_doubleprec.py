@@ -0,0 +1,37 @@
+# test that repr gives the shortest string that round-trips, requiring double-precision
+
+try:
+    import struct
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+if repr(0.1 + 0.2) != "0.30000000000000004":
+    # conversions are approximate in this build
+    print("SKIP")
+    raise SystemExit
+
+# values that need all 17 digits, and ones that need few
+for x in (0.1, 0.2 + 0.1, 1 / 3, 2 / 3, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308):
+    print(repr(x), float(repr(x)) == x, "%.17g" % x)
+print(repr(1e16), repr(1e22), repr(123456789012345680.0), repr(1e-5), repr(0.0001))
+
+# strings exactly halfway between two doubles round to even
+print(float("9007199254740993"), float("9007199254740995"))
+print(float("2.4703282292062327e-324"), float("2.4703282292062328e-324"))
+print(float("1.00000000000000011102230246251565404236316680908203125"))
+print(float("1.000000000000000111022302462515654042363166809082031251"))
+
+# formatting rounds correctly
+print("%.1f %.2f %.3f" % (0.25, 0.125, 1.0005))
+print("%.20f" % 0.1, "%.16e" % 2.0**-1074)
+
+# random bit patterns
+seed = 1
+for i in range(200):
+    seed = (seed * 6364136223846793005 + 1442695040888963407) & 0xFFFFFFFFFFFFFFFF
+    x = struct.unpack("<d", struct.pack("<Q", seed & 0x7FEFFFFFFFFFFFFF))[0]
+    r = repr(x)
+    if float(r) != x:
+        print("roundtrip failed", r)
+    print(r, "%.17g" % x)
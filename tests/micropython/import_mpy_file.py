@@ -0,0 +1,66 @@
+# Test importing a .mpy file from the filesystem, which may be loaded in place.
+
+try:
+    import gc, os, sys
+
+    os.mkdir
+    sys.implementation._mpy
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# Only the unix port can map a file into memory to load it in place.
+if sys.platform not in ("linux", "darwin"):
+    print("SKIP")
+    raise SystemExit
+
+# We need a directory for testing that doesn't already exist.
+# Skip the test if it does exist.
+temp_dir = "micropy_test_mpy_dir"
+try:
+    os.stat(temp_dir)
+    print("SKIP")
+    raise SystemExit
+except OSError:
+    pass
+
+# Pre-compiled module with bytecode, qstrs, and str and bytes constants:
+#   s = "a str constant"
+#   b = b"a bytes constant"
+#   def f(x):
+#       return (x, s, b, "mpy_xip_new_name")
+# with the bytes constant then made 8192 bytes long.
+# CIRCUITPY-CHANGE: 'C' instead of 'M' mpy marker.
+mpy = (
+    b"C\x06\x00\x1f\x06\x03$/tmp/xip/mpyxip.py\x00\x0f\x02f\x00\x02s\x00\x02b\x00\x02x\x00\x05\x0ea str constant\x00"
+    + b"\x06\xc0\x00"
+    + b"a bytes constant" * 512
+    + b"\x00\x05\x10mpy_xip_new_name\x00\x81\x1c\x00\x06\x01$d#\x00\x16\x03#\x01\x16\x042\x00\x16\x02Qc\x01\x81\x00!\x08\x02\x05`@\xb0\x12\x03\x12\x04#\x02*\x04c"
+)
+
+os.mkdir(temp_dir)
+with open(temp_dir + "/mpy_xip.mpy", "wb") as f:
+    f.write(mpy)
+
+sys.path.insert(0, temp_dir)
+gc.collect()
+mem = gc.mem_alloc()
+import mpy_xip
+
+gc.collect()
+mem = gc.mem_alloc() - mem
+sys.path.pop(0)
+
+# The bytes constant is used in place, so loading allocates much less than it.
+print(mem < 8192)
+
+# The module's code and data must remain valid after its file is removed.
+os.remove(temp_dir + "/mpy_xip.mpy")
+os.rmdir(temp_dir)
+gc.collect()
+
+print(mpy_xip.s, len(mpy_xip.b), mpy_xip.b[:20])
+print(mpy_xip.f(1)[:2], mpy_xip.f(1)[2] is mpy_xip.b)
+print(mpy_xip.f(2)[3] == "mpy_xip_new_name")
+print(hash(mpy_xip.s) == hash("a str constant"), hash(mpy_xip.b) == hash(b"a bytes constant" * 512))
+print(mpy_xip.s + "!", mpy_xip.b[2:7])
@@ -0,0 +1,51 @@
+# test the sampling profiler
+
+import micropython
+
+try:
+    micropython.prof_start
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+import time
+
+
+def spin(ms):
+    t = time.ticks_ms()
+    while time.ticks_diff(time.ticks_ms(), t) < ms:
+        pass
+
+
+def run():
+    spin(300)
+
+
+# invalid interval
+try:
+    micropython.prof_start(0)
+except ValueError:
+    print("ValueError")
+
+# nothing recorded before starting
+print(micropython.prof_dump())
+
+micropython.prof_start(1000)
+run()
+print(micropython.prof_stop())
+
+# the busy loop is sampled with its full call stack, outermost first
+stacks = micropython.prof_dump()
+print(sum(stacks.values()) > 0)
+print(all(k.startswith("<module>") for k in stacks))
+print(any(k.endswith(";run;spin") for k in stacks))
+
+# samples are drained by prof_dump
+print(micropython.prof_dump())
+
+# with bytecode offsets
+micropython.prof_start(1000)
+run()
+micropython.prof_stop()
+stacks = micropython.prof_dump(True)
+print(all(f.split("+")[1].isdigit() for k in stacks for f in k.split(";")))
@@ -0,0 +1,71 @@
+# test micropython.schedule() with priority classes
+
+import micropython
+
+try:
+    micropython.schedule
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+done = False
+
+
+def callback_done(arg):
+    global done
+    done = True
+
+
+try:
+    micropython.schedule(callback_done, None, 0)
+except TypeError:
+    print("SKIP")
+    raise SystemExit
+while not done:
+    pass
+
+# Callbacks of a higher priority run first, and in order within a priority.
+# Schedule them from within a callback so they all queue up before any runs.
+
+order = []
+
+
+def callback(arg):
+    order.append(arg)
+
+
+def callback_outer(arg):
+    for i in range(3):
+        micropython.schedule(callback, "normal %d" % i)
+        micropython.schedule(callback, "high %d" % i, 1)
+
+
+micropython.schedule(callback_outer, None)
+while len(order) < 6:
+    pass
+for arg in order:
+    print(arg)
+
+# Each priority has its own queue, so a full queue doesn't stop the others.
+
+
+def callback_fill(arg):
+    try:
+        for i in range(100):
+            micropython.schedule(lambda x: x, None)
+    except RuntimeError:
+        print("RuntimeError")
+    micropython.schedule(callback, "high", 1)
+
+
+order = []
+micropython.schedule(callback_fill, None)
+while not order:
+    pass
+print(order)
+
+# Invalid priorities.
+try:
+    micropython.schedule(callback, None, -1)
+except ValueError:
+    print("ValueError")
@@ -0,0 +1,84 @@
+# test viper functions with more locals than registers, whose locals may share
+# registers when their live ranges don't overlap
+import micropython
+
+
+# locals used in successive loops
+@micropython.viper
+def f1(buf: ptr8, n: int) -> int:
+    s = 0
+    for i in range(n):
+        s += buf[i]
+    t = 1
+    j = 0
+    while j < n:
+        t = t * 3 + buf[j]
+        j += 1
+    u = s
+    for k in range(n):
+        u ^= buf[k] << k
+    return s + t + u
+
+
+print(f1(b"\x01\x02\x03\x04\x05", 5))
+
+
+# more arguments than registers, used in a nested loop
+@micropython.viper
+def f2(a: int, b: int, c: int, d: int) -> int:
+    x = 0
+    for i in range(a):
+        for j in range(b):
+            x += i * c + j * d
+    return x + a + b + c + d
+
+
+print(f2(3, 4, 5, 6))
+
+
+# a local used before and after a loop must keep its value across the loop
+@micropython.viper
+def f3(n: int) -> int:
+    a = 7
+    b = 0
+    for i in range(n):
+        b += i
+    c = 0
+    for i in range(n):
+        c += 2
+    return a + b + c
+
+
+print(f3(10))
+
+
+# a local written late in a loop body and read early in the next iteration
+@micropython.viper
+def f4(n: int) -> int:
+    prev = 0
+    acc = 0
+    for i in range(n):
+        acc += prev
+        tmp = i * i
+        prev = tmp
+    return acc
+
+
+print(f4(6))
+
+
+# object and pointer locals mixed with integer ones
+@micropython.viper
+def f5(lst, buf: ptr32, n: int):
+    total = 0
+    for i in range(n):
+        buf[i] = int(lst[i]) * 2
+    for i in range(n):
+        total += buf[i]
+    lst.append(total)
+
+
+l = [1, 2, 3, 4]
+b = bytearray(16)
+f5(l, b, 4)
+print(l)
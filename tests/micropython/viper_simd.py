@@ -0,0 +1,122 @@
+# test viper SIMD intrinsics over ptr8/ptr16/ptr32 buffers
+import array
+
+try:
+    exec("@micropython.viper\ndef f(p: ptr8):\n    simd_add(p, p, p, 0)")
+except (NameError, ViperTypeError):
+    print("SKIP")
+    raise SystemExit
+
+
+@micropython.viper
+def add8(dst: ptr8, a: ptr8, b: ptr8, n: int):
+    simd_add(dst, a, b, n)
+
+
+# .mpy files can't use the intrinsics, so mpy-cross compiles them as globals
+try:
+    add8(bytearray(1), b"\x00", b"\x00", 1)
+except NameError:
+    print("SKIP")
+    raise SystemExit
+
+
+@micropython.viper
+def add16(dst: ptr16, a: ptr16, b: ptr16, n: int):
+    simd_add(dst, a, b, n)
+
+
+@micropython.viper
+def add32(dst: ptr32, a: ptr32, b: ptr32, n: uint):
+    simd_add(dst, a, b, n)
+
+
+@micropython.viper
+def add_sat8(dst: ptr8, a: ptr8, b: ptr8, n: int):
+    simd_add_sat(dst, a, b, n)
+
+
+@micropython.viper
+def add_sat16(dst: ptr16, a: ptr16, b: ptr16, n: int):
+    simd_add_sat(dst, a, b, n)
+
+
+@micropython.viper
+def mulhi16(dst: ptr16, a: ptr16, b: ptr16, n: int):
+    simd_mulhi(dst, a, b, n)
+
+
+@micropython.viper
+def bswap16(dst: ptr16, src: ptr16, n: int):
+    simd_bswap(dst, src, n)
+
+
+@micropython.viper
+def bswap32(dst: ptr32, src: ptr32, n: int):
+    simd_bswap(dst, src, n)
+
+
+# offset into the buffers, and a local that must survive the call
+@micropython.viper
+def add8_offset(dst: ptr8, a: ptr8, n: int) -> int:
+    x = n + 1
+    simd_add(ptr8(uint(dst) + 1), ptr8(uint(a) + 1), a, n)
+    return x
+
+
+def check(name, fun, typecode, mask, lens, ref):
+    for n in lens:
+        a = array.array(typecode, ((i * 77 + 200) & mask for i in range(n + 3)))
+        b = array.array(typecode, ((i * 1031 + 60000) & mask for i in range(n + 3)))
+        dst = array.array(typecode, (mask for _ in range(n + 3)))
+        fun(dst, a, b, n)
+        ok = all(dst[i] == ref(a[i], b[i]) & mask for i in range(n))
+        ok = ok and all(dst[i] == mask for i in range(n, n + 3))
+        # in place, with dst the same as a
+        fun(a, a, b, n)
+        ok = ok and list(a[:n]) == list(dst[:n])
+        print(name, n, ok)
+
+
+lens = (0, 1, 7, 8, 15, 16, 17, 40)
+check("add8", add8, "B", 0xFF, lens, lambda x, y: x + y)
+check("add16", add16, "H", 0xFFFF, lens, lambda x, y: x + y)
+check("add32", add32, "I", 0xFFFFFFFF, lens, lambda x, y: x + y)
+check("add_sat8", add_sat8, "B", 0xFF, lens, lambda x, y: min(x + y, 0xFF))
+check("add_sat16", add_sat16, "H", 0xFFFF, lens, lambda x, y: min(x + y, 0xFFFF))
+check("mulhi16", mulhi16, "H", 0xFFFF, lens, lambda x, y: x * y >> 16)
+
+# add32 with values that carry into the top bit
+a = array.array("I", (0x7FFFFFFF + i for i in range(9)))
+dst = array.array("I", 9 * [0])
+add32(dst, a, a, 9)
+print([hex(x) for x in dst])
+
+for n in (0, 3, 8, 9, 20):
+    src = bytearray(range(1, 4 * n + 1))
+    dst = bytearray(4 * n)
+    bswap16(dst, src, 2 * n)
+    print(bytes(dst))
+    bswap32(dst, src, n)
+    print(bytes(dst))
+
+buf = bytearray(range(20))
+dst = bytearray(21)
+print(add8_offset(dst, buf, 19), list(dst))
+
+
+# type errors
+def test(code):
+    try:
+        exec(code)
+    except ViperTypeError as e:
+        print(repr(e))
+
+
+test("@micropython.viper\ndef f(p: ptr8, q: ptr16):\n    simd_add(p, p, q, 1)")
+test("@micropython.viper\ndef f(p: ptr32):\n    simd_add_sat(p, p, p, 1)")
+test("@micropython.viper\ndef f(p: ptr8):\n    simd_mulhi(p, p, p, 1)")
+test("@micropython.viper\ndef f(p: ptr8):\n    simd_bswap(p, p, 1)")
+test("@micropython.viper\ndef f(p: ptr16):\n    simd_bswap(p, p, p, 1)")
+test("@micropython.viper\ndef f(p: ptr16, n):\n    simd_add(p, p, p, n)")
+test("@micropython.viper\ndef f(p):\n    simd_add(p, p, p, 1)")
@@ -0,0 +1,46 @@
+# Calculating many digits of the square root of 2.
+# This benchmark stresses multiplication and division of large integers,
+# using Newton's method with the precision doubling at each step.
+
+
+def isqrt(n):
+    c = (n.bit_length() - 1) // 2
+    a = 1
+    d = 0
+    for s in range(c.bit_length() - 1, -1, -1):
+        e = d
+        d = c >> s
+        a = (a << d - e - 1) + (n >> 2 * c - e - d + 1) // a
+    return a - (a * a > n)
+
+
+def sqrt2_digits(ndig):
+    return isqrt(2 * 10 ** (2 * ndig))
+
+
+###########################################################################
+# Benchmark interface
+
+bm_params = {
+    (32, 10): (1, 100),
+    (50, 25): (1, 300),
+    (100, 100): (1, 1000),
+    (1000, 1000): (2, 5000),
+    (5000, 1000): (3, 20000),
+}
+
+
+def bm_setup(params):
+    state = None
+
+    def run():
+        nonlocal state
+        nloop, ndig = params
+        for _ in range(nloop):
+            state = None  # free previous result
+            state = sqrt2_digits(ndig)
+
+    def result():
+        return params[0] * params[1], state % 10**40
+
+    return run, result
@@ -0,0 +1,46 @@
+# test that data stays intact when allocation triggers collections, including
+# while the heap is only partially swept (with incremental sweeping enabled)
+
+try:
+    import gc
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+seed = 1
+
+
+def rand():
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+    return seed >> 8
+
+
+def check(o):
+    return o == bytes([o[0]]) * len(o)
+
+
+objs = []
+grow = [bytearray() for _ in range(8)]
+ok = True
+for i in range(100000):
+    r = rand() & 255
+    if r < 100 or not objs:
+        # mix of small and larger objects to fragment the heap
+        n = (rand() & 31) + 1 if r & 1 else (rand() & 511) + 1
+        objs.append(bytes([i & 255]) * n)
+    elif r < 180:
+        objs.pop(rand() % len(objs))
+    elif r < 210:
+        # grow a bytearray in place (or by moving it)
+        k = rand() & 7
+        g = grow[k]
+        if len(g) > 1000:
+            ok = ok and g == bytes([k]) * len(g)
+            g[:] = b""
+        g.extend(bytes([k]) * 16)
+    else:
+        ok = ok and check(objs[rand() % len(objs)])
+    if len(objs) > 200:
+        del objs[:100]
+print(ok and all(check(o) for o in objs))